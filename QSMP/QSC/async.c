@@ -1,19 +1,179 @@
 #include "cpuidex.h"
 #include "async.h"
+#include "memutils.h"
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+static volatile qsc_mutex m_async_mutex = NULL;
+#else
+static pthread_mutex_t m_async_mutex;
+static pthread_once_t m_async_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t m_async_suspend = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t m_async_condition = PTHREAD_COND_INITIALIZER;
+static bool m_async_suspended = false;
+#endif
+
+#if defined(QSC_SYSTEM_OS_POSIX)
+struct qsc_async_posix_semaphore
+{
+	pthread_mutex_t mtx;
+	pthread_cond_t cnd;
+	uint32_t count;
+};
+#endif
+
+static qsc_async_mutex_statistics m_async_statistics;
+
+static qsc_mutex async_global_mutex()
+{
+	qsc_mutex mtx;
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	if (m_async_mutex == NULL)
+	{
+		mtx = CreateMutex(NULL, FALSE, NULL);
+
+		/* the first thread to publish its handle wins, the others release theirs */
+		if (InterlockedCompareExchangePointer((PVOID volatile*)&m_async_mutex, mtx, NULL) != NULL)
+		{
+			CloseHandle(mtx);
+		}
+	}
+
+	mtx = m_async_mutex;
+#else
+	mtx = &m_async_mutex;
+#endif
+
+	return mtx;
+}
+
+#if defined(QSC_SYSTEM_OS_POSIX)
+static void async_global_mutex_initialize()
+{
+	pthread_mutexattr_t attr;
+
+	/* recursive, to match the semantics of a windows mutex */
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&m_async_mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+#endif
+
+int32_t qsc_async_atomic_add(volatile int32_t* target, int32_t value)
+{
+	assert(target != NULL);
+
+	int32_t res;
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	res = (int32_t)InterlockedAdd((LONG volatile*)target, (LONG)value);
+#else
+	res = __atomic_add_fetch(target, value, __ATOMIC_SEQ_CST);
+#endif
+
+	return res;
+}
+
+bool qsc_async_atomic_compare_exchange(volatile int32_t* target, int32_t value, int32_t expected)
+{
+	assert(target != NULL);
+
+	bool res;
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	res = ((int32_t)InterlockedCompareExchange((LONG volatile*)target, (LONG)value, (LONG)expected) == expected);
+#else
+	res = __atomic_compare_exchange_n(target, &expected, value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+
+	return res;
+}
+
+int32_t qsc_async_atomic_exchange(volatile int32_t* target, int32_t value)
+{
+	assert(target != NULL);
+
+	int32_t res;
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	res = (int32_t)InterlockedExchange((LONG volatile*)target, (LONG)value);
+#else
+	res = __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+#endif
+
+	return res;
+}
+
+bool qsc_async_atomic_compare_exchange_pointer(void* volatile* target, void* value, void* expected)
+{
+	assert(target != NULL);
+
+	bool res;
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	res = (InterlockedCompareExchangePointer((PVOID volatile*)target, value, expected) == expected);
+#else
+	res = __atomic_compare_exchange_n(target, &expected, value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+
+	return res;
+}
+
+void* qsc_async_atomic_exchange_pointer(void* volatile* target, void* value)
+{
+	assert(target != NULL);
+
+	void* res;
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	res = InterlockedExchangePointer((PVOID volatile*)target, value);
+#else
+	res = __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+#endif
+
+	return res;
+}
+
+void* qsc_async_atomic_load_pointer(void* volatile* target)
+{
+	assert(target != NULL);
+
+	void* res;
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	/* a volatile read has acquire semantics with the default msvc memory model, the barrier covers /volatile:iso */
+	res = *target;
+	MemoryBarrier();
+#else
+	res = __atomic_load_n(target, __ATOMIC_ACQUIRE);
+#endif
+
+	return res;
+}
+
+void qsc_async_atomic_store_pointer(void* volatile* target, void* value)
+{
+	assert(target != NULL);
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	MemoryBarrier();
+	*target = value;
+#else
+	__atomic_store_n(target, value, __ATOMIC_RELEASE);
+#endif
+}
 
 void qsc_async_launch_thread(void (*func)(void*), void* state)
 {
 	assert(func != NULL);
 
-	qsc_mutex mtx;
 	qsc_thread thd;
 
 	if (func != NULL)
 	{
-		mtx = qsc_async_mutex_lock_ex();
 		thd = qsc_async_thread_create(func, state);
 		qsc_async_thread_wait(thd);
-		qsc_async_mutex_unlock_ex(mtx);
 	}
 }
 
@@ -22,13 +182,11 @@ void qsc_async_launch_parallel_threads(void (*func)(void*), size_t count, ...)
 	assert(func != NULL);
 	assert(count <= QSC_ASYNC_PARALLEL_MAX);
 
-	qsc_mutex mtx;
 	qsc_thread thds[QSC_ASYNC_PARALLEL_MAX] = { 0 };
 	va_list list;
 
 	if (func != NULL)
 	{
-		mtx = qsc_async_mutex_lock_ex();
 		va_start(list, count);
 
 		for (size_t i = 0; i < count; ++i)
@@ -38,7 +196,6 @@ void qsc_async_launch_parallel_threads(void (*func)(void*), size_t count, ...)
 
 		qsc_async_thread_wait_all(thds, count);
 		va_end(list);
-		qsc_async_mutex_unlock_ex(mtx);
 	}
 }
 
@@ -49,7 +206,16 @@ qsc_mutex qsc_async_mutex_create()
 #if defined(QSC_SYSTEM_OS_WINDOWS)
 	mtx = CreateMutex(NULL, FALSE, NULL);
 #else
-	pthread_mutex_init(&mtx, NULL);
+	mtx = (pthread_mutex_t*)qsc_memutils_malloc(sizeof(pthread_mutex_t));
+
+	if (mtx != NULL)
+	{
+		if (pthread_mutex_init(mtx, NULL) != 0)
+		{
+			qsc_memutils_alloc_free(mtx);
+			mtx = NULL;
+		}
+	}
 #endif
 
 	return mtx;
@@ -61,47 +227,126 @@ bool qsc_async_mutex_destroy(qsc_mutex mtx)
 
 	res = false;
 
+	if (mtx != NULL)
+	{
 #if defined(QSC_SYSTEM_OS_WINDOWS)
-	res = (bool)CloseHandle(mtx);
+		res = (bool)CloseHandle(mtx);
 #else
-	res = (pthread_mutex_destroy(&mtx) == 0);
+		res = (pthread_mutex_destroy(mtx) == 0);
+		qsc_memutils_alloc_free(mtx);
 #endif
+	}
 
 	return res;
 }
 
 void qsc_async_mutex_lock(qsc_mutex mtx)
 {
+	assert(mtx != NULL);
+
+	if (mtx != NULL)
+	{
 #if defined(QSC_SYSTEM_OS_WINDOWS)
-	WaitForSingleObject(mtx, INFINITE);
+		WaitForSingleObject(mtx, INFINITE);
 #else
-	pthread_mutex_lock(&mtx);
+		pthread_mutex_lock(mtx);
 #endif
+	}
+}
+
+void qsc_async_mutex_lock_counted(qsc_mutex mtx, qsc_async_mutex_statistics* stats)
+{
+	assert(mtx != NULL);
+	assert(stats != NULL);
+
+	bool cntd;
+
+	if (mtx != NULL)
+	{
+		cntd = false;
+
+		if (qsc_async_mutex_try_lock(mtx) == false)
+		{
+			cntd = true;
+			qsc_async_mutex_lock(mtx);
+		}
+
+		/* the counters are protected by the lock they measure */
+		if (stats != NULL)
+		{
+			++stats->acquired;
+
+			if (cntd == true)
+			{
+				++stats->contended;
+			}
+		}
+	}
 }
 
 qsc_mutex qsc_async_mutex_lock_ex()
 {
 	qsc_mutex mtx;
 
-	mtx = qsc_async_mutex_create();
-	qsc_async_mutex_lock(mtx);
+#if defined(QSC_SYSTEM_OS_POSIX)
+	pthread_once(&m_async_once, &async_global_mutex_initialize);
+#endif
+
+	mtx = async_global_mutex();
+	qsc_async_mutex_lock_counted(mtx, &m_async_statistics);
 
 	return mtx;
 }
 
+void qsc_async_mutex_statistics_ex(qsc_async_mutex_statistics* stats)
+{
+	assert(stats != NULL);
+
+	if (stats != NULL)
+	{
+		stats->acquired = m_async_statistics.acquired;
+		stats->contended = m_async_statistics.contended;
+	}
+}
+
+bool qsc_async_mutex_try_lock(qsc_mutex mtx)
+{
+	assert(mtx != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (mtx != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+		res = (WaitForSingleObject(mtx, 0) == WAIT_OBJECT_0);
+#else
+		res = (pthread_mutex_trylock(mtx) == 0);
+#endif
+	}
+
+	return res;
+}
+
 void qsc_async_mutex_unlock(qsc_mutex mtx)
 {
+	assert(mtx != NULL);
+
+	if (mtx != NULL)
+	{
 #if defined(QSC_SYSTEM_OS_WINDOWS)
-	ReleaseMutex(mtx);
+		ReleaseMutex(mtx);
 #else
-	pthread_mutex_unlock(&mtx);
+		pthread_mutex_unlock(mtx);
 #endif
+	}
 }
 
 void qsc_async_mutex_unlock_ex(qsc_mutex mtx)
 {
+	/* the process-wide mutex is never destroyed */
 	qsc_async_mutex_unlock(mtx);
-	qsc_async_mutex_destroy(mtx);
 }
 
 size_t qsc_async_processor_count()
@@ -120,6 +365,96 @@ size_t qsc_async_processor_count()
 	return cpus;
 }
 
+qsc_semaphore qsc_async_semaphore_create(uint32_t count)
+{
+	qsc_semaphore sem;
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	sem = CreateSemaphore(NULL, (LONG)count, LONG_MAX, NULL);
+#else
+	sem = (qsc_semaphore)qsc_memutils_malloc(sizeof(struct qsc_async_posix_semaphore));
+
+	if (sem != NULL)
+	{
+		sem->count = count;
+
+		if (pthread_mutex_init(&sem->mtx, NULL) != 0)
+		{
+			qsc_memutils_alloc_free(sem);
+			sem = NULL;
+		}
+		else if (pthread_cond_init(&sem->cnd, NULL) != 0)
+		{
+			pthread_mutex_destroy(&sem->mtx);
+			qsc_memutils_alloc_free(sem);
+			sem = NULL;
+		}
+	}
+#endif
+
+	return sem;
+}
+
+bool qsc_async_semaphore_destroy(qsc_semaphore sem)
+{
+	bool res;
+
+	res = false;
+
+	if (sem != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+		res = (CloseHandle(sem) != 0);
+#else
+		pthread_cond_destroy(&sem->cnd);
+		res = (pthread_mutex_destroy(&sem->mtx) == 0);
+		qsc_memutils_alloc_free(sem);
+#endif
+	}
+
+	return res;
+}
+
+void qsc_async_semaphore_post(qsc_semaphore sem)
+{
+	assert(sem != NULL);
+
+	if (sem != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+		ReleaseSemaphore(sem, 1, NULL);
+#else
+		pthread_mutex_lock(&sem->mtx);
+		sem->count += 1;
+		pthread_cond_signal(&sem->cnd);
+		pthread_mutex_unlock(&sem->mtx);
+#endif
+	}
+}
+
+void qsc_async_semaphore_wait(qsc_semaphore sem)
+{
+	assert(sem != NULL);
+
+	if (sem != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+		WaitForSingleObject(sem, INFINITE);
+#else
+		pthread_mutex_lock(&sem->mtx);
+
+		/* the condition can wake without a post, so the count is tested again */
+		while (sem->count == 0)
+		{
+			pthread_cond_wait(&sem->cnd, &sem->mtx);
+		}
+
+		sem->count -= 1;
+		pthread_mutex_unlock(&sem->mtx);
+#endif
+	}
+}
+
 qsc_thread qsc_async_thread_create(void (*func)(void*), void* state)
 {
 	assert(func != NULL);
@@ -183,16 +518,25 @@ int32_t qsc_async_thread_resume(qsc_thread handle)
 		res = ResumeThread(handle);
 	}
 #else
-	pthread_mutex_lock(&tsusp);
-	suspended = false;
-	pthread_cond_signal(&tcond);
-	pthread_mutex_unlock(&tsusp);
+	pthread_mutex_lock(&m_async_suspend);
+	m_async_suspended = false;
+	pthread_cond_signal(&m_async_condition);
+	pthread_mutex_unlock(&m_async_suspend);
 	res = 0;
 #endif
 
 	return res;
 }
 
+void qsc_async_thread_yield()
+{
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	SwitchToThread();
+#elif defined(QSC_SYSTEM_OS_POSIX)
+	sched_yield();
+#endif
+}
+
 void qsc_async_thread_sleep(uint32_t msec)
 {
 	assert(msec != 0);
@@ -204,7 +548,15 @@ void qsc_async_thread_sleep(uint32_t msec)
 		hthd = GetCurrentThread();
 		WaitForSingleObject(hthd, msec);
 #elif defined(QSC_SYSTEM_OS_POSIX)
-		sleep(msec * 1000);
+		struct timespec ts;
+
+		/* the interval is in milliseconds, a sleep interrupted by a signal resumes with the remaining time */
+		ts.tv_sec = (time_t)(msec / 1000);
+		ts.tv_nsec = (long)((msec % 1000) * 1000000UL);
+
+		while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+		{
+		}
 #endif
 	}
 }
@@ -221,14 +573,14 @@ int32_t qsc_async_thread_suspend(qsc_thread handle)
 		res = SuspendThread(handle);
 	}
 #else
-	pthread_mutex_lock(&tsusp);
+	pthread_mutex_lock(&m_async_suspend);
 
 	do
 	{
-		pthread_cond_wait(&tcond, &tsusp);
-	} while (suspended == true);
+		pthread_cond_wait(&m_async_condition, &m_async_suspend);
+	} while (m_async_suspended == true);
 
-	pthread_mutex_unlock(&tsusp);
+	pthread_mutex_unlock(&m_async_suspend);
 #endif
 
 	return res;
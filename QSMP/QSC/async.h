@@ -34,16 +34,18 @@ QSC_SYSTEM_CONDITION_IGNORE(5105)
 #	include <process.h>
 #	include <Windows.h>
 	typedef HANDLE qsc_mutex;
+	typedef HANDLE qsc_semaphore;
 	typedef HANDLE qsc_thread;
 #elif defined(QSC_SYSTEM_OS_POSIX)
 #	include <sys/types.h>
 #	include <unistd.h>
 #	include <pthread.h>
-	typedef pthread_mutex_t qsc_mutex;
+#	include <sched.h>
+#	include <errno.h>
+#	include <time.h>
+	typedef pthread_mutex_t* qsc_mutex;
+	typedef struct qsc_async_posix_semaphore* qsc_semaphore;
 	typedef pthread_t qsc_thread;
-	qsc_mutex tsusp;
-	pthread_cond_t tcond;
-	bool suspended;
 #else
 #	error your operating system is not supported!
 #endif
@@ -60,6 +62,79 @@ QSC_SYSTEM_CONDITION_IGNORE(5105)
 */
 #define QSC_ASYNC_PARALLEL_MAX 128
 
+/*! \struct qsc_async_mutex_statistics
+* Contains the lock acquisition and contention counters of a mutex.
+* The counters are updated while the lock is held, and are read without synchronization.
+*/
+QSC_EXPORT_API typedef struct qsc_async_mutex_statistics
+{
+	uint64_t acquired;					/*!< The number of times the lock was acquired */
+	uint64_t contended;					/*!< The number of acquisitions that had to wait for another thread to release the lock */
+} qsc_async_mutex_statistics;
+
+/**
+* \brief Atomically add a value to a 32-bit integer
+*
+* \param target: [volatile] The integer to update
+* \param value: The signed value to add
+* \return: Returns the value of the integer after the addition
+*/
+QSC_EXPORT_API int32_t qsc_async_atomic_add(volatile int32_t* target, int32_t value);
+
+/**
+* \brief Atomically replace a 32-bit integer if it holds an expected value
+*
+* \param target: [volatile] The integer to update
+* \param value: The replacement value
+* \param expected: The value the integer must hold to be replaced
+* \return: Returns true if the integer was replaced
+*/
+QSC_EXPORT_API bool qsc_async_atomic_compare_exchange(volatile int32_t* target, int32_t value, int32_t expected);
+
+/**
+* \brief Atomically replace a 32-bit integer, with a full memory barrier
+*
+* \param target: [volatile] The integer to update
+* \param value: The replacement value
+* \return: Returns the previous value of the integer
+*/
+QSC_EXPORT_API int32_t qsc_async_atomic_exchange(volatile int32_t* target, int32_t value);
+
+/**
+* \brief Atomically replace a pointer if it holds an expected value
+*
+* \param target: [volatile] The pointer to update
+* \param value: The replacement pointer
+* \param expected: The value the pointer must hold to be replaced
+* \return: Returns true if the pointer was replaced
+*/
+QSC_EXPORT_API bool qsc_async_atomic_compare_exchange_pointer(void* volatile* target, void* value, void* expected);
+
+/**
+* \brief Atomically replace a pointer, with a full memory barrier
+*
+* \param target: [volatile] The pointer to update
+* \param value: The replacement pointer
+* \return: Returns the previous value of the pointer
+*/
+QSC_EXPORT_API void* qsc_async_atomic_exchange_pointer(void* volatile* target, void* value);
+
+/**
+* \brief Read a pointer with acquire ordering, writes made before it was stored are visible to the caller
+*
+* \param target: [volatile] The pointer to read
+* \return: Returns the pointer value
+*/
+QSC_EXPORT_API void* qsc_async_atomic_load_pointer(void* volatile* target);
+
+/**
+* \brief Store a pointer with release ordering, writes made before the store are visible to a thread that loads it
+*
+* \param target: [volatile] The pointer to update
+* \param value: The pointer value
+*/
+QSC_EXPORT_API void qsc_async_atomic_store_pointer(void* volatile* target, void* value);
+
 /**
 * \brief Launch a function on a new thread
 *
@@ -100,12 +175,36 @@ QSC_EXPORT_API bool qsc_async_mutex_destroy(qsc_mutex mtx);
 QSC_EXPORT_API void qsc_async_mutex_lock(qsc_mutex mtx);
 
 /**
-* \brief Creates and locks a mutex.
+* \brief Lock a mutex, and update the lock acquisition and contention counters
+*
+* \param mtx: The mutex to lock
+* \param stats: A pointer to the statistics structure updated by the lock
+*/
+QSC_EXPORT_API void qsc_async_mutex_lock_counted(qsc_mutex mtx, qsc_async_mutex_statistics* stats);
+
+/**
+* \brief Locks the process-wide mutex.
+* The process-wide mutex is recursive, it is shared by every caller of this function.
 *
 * \return Returns the locked mutex
 */
 QSC_EXPORT_API qsc_mutex qsc_async_mutex_lock_ex(void);
 
+/**
+* \brief Copy the acquisition and contention counters of the process-wide mutex
+*
+* \param stats: A pointer to the output statistics structure
+*/
+QSC_EXPORT_API void qsc_async_mutex_statistics_ex(qsc_async_mutex_statistics* stats);
+
+/**
+* \brief Try to lock a mutex without waiting
+*
+* \param mtx: The mutex to lock
+* \return Returns true if the mutex was acquired
+*/
+QSC_EXPORT_API bool qsc_async_mutex_try_lock(qsc_mutex mtx);
+
 /**
 * \brief Unlock a mutex
 *
@@ -114,10 +213,9 @@ QSC_EXPORT_API qsc_mutex qsc_async_mutex_lock_ex(void);
 QSC_EXPORT_API void qsc_async_mutex_unlock(qsc_mutex mtx);
 
 /**
-* \brief Unlocks and destroys a mutex.
-* The mutex must be initialized and destroyed.
+* \brief Unlocks the process-wide mutex.
 *
-* \param mtx: The mutex to unlock
+* \param mtx: The mutex returned by qsc_async_mutex_lock_ex
 */
 QSC_EXPORT_API void qsc_async_mutex_unlock_ex(qsc_mutex mtx);
 
@@ -126,6 +224,36 @@ QSC_EXPORT_API void qsc_async_mutex_unlock_ex(qsc_mutex mtx);
 */
 QSC_EXPORT_API size_t qsc_async_processor_count(void);
 
+/**
+* \brief Create a counting semaphore
+*
+* \param count: The initial count
+* \return Returns the semaphore handle, or NULL on failure
+*/
+QSC_EXPORT_API qsc_semaphore qsc_async_semaphore_create(uint32_t count);
+
+/**
+* \brief Destroy a semaphore
+*
+* \param sem: The semaphore handle
+* \return Returns true on success
+*/
+QSC_EXPORT_API bool qsc_async_semaphore_destroy(qsc_semaphore sem);
+
+/**
+* \brief Increment the semaphore count, releasing one waiting thread
+*
+* \param sem: The semaphore handle
+*/
+QSC_EXPORT_API void qsc_async_semaphore_post(qsc_semaphore sem);
+
+/**
+* \brief Wait until the semaphore count is not zero, then decrement it
+*
+* \param sem: The semaphore handle
+*/
+QSC_EXPORT_API void qsc_async_semaphore_wait(qsc_semaphore sem);
+
 /**
 * \brief Create a thread with one parameter
 *
@@ -151,6 +279,11 @@ QSC_EXPORT_API qsc_thread qsc_async_thread_create_ex(void (*func)(void**), void*
 */
 QSC_EXPORT_API int32_t qsc_async_thread_resume(qsc_thread handle);
 
+/**
+* \brief Give up the remainder of the threads time slice to another ready thread
+*/
+QSC_EXPORT_API void qsc_async_thread_yield(void);
+
 /**
 * \brief Pause the thread for a number of milliseconds
 *
@@ -625,6 +625,14 @@
 	*/
 #	define QSC_SYSTEM_HAS_AVX512
 #endif
+
+#if defined(__VAES__)
+	/*!
+	\def QSC_SYSTEM_HAS_VAES
+	* \brief The system supports the VAES vector AES instructions
+	*/
+#	define QSC_SYSTEM_HAS_VAES
+#endif
 #if defined(__XOP__)
 #	define QSC_SYSTEM_HAS_XOP
 #endif
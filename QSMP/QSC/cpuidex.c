@@ -398,6 +398,8 @@ static void cpuidex_arm_features(qsc_cpuidex_cpu_features* features)
 
 #	define CPUID_EBX_AVX2 0x00000020UL
 #	define CPUID_EBX_AVX512F 0x00010000UL
+#	define CPUID_EBX_AVX512BW 0x40000000UL
+#	define CPUID_ECX_VAES 0x00000200UL
 #	define CPUID_EBX_ADX 0x00080000UL
 #	define CPUID_ECX_PCLMUL 0x00000002UL
 #	define CPUID_ECX_AESNI 0x02000000UL
@@ -422,6 +424,25 @@ static void cpuidex_cpu_info(uint32_t info[4], const uint32_t infotype)
 #endif
 }
 
+static void cpuidex_cpu_info_ex(uint32_t info[4], const uint32_t infotype, const uint32_t subtype)
+{
+	/* the extended feature leaf is indexed by a sub-leaf in ecx, which __get_cpuid leaves unset */
+#if defined(QSC_SYSTEM_COMPILER_MSC)
+	__cpuidex((int*)info, infotype, subtype);
+#elif defined(QSC_SYSTEM_COMPILER_GCC)
+	__get_cpuid_count(infotype, subtype, &info[0], &info[1], &info[2], &info[3]);
+#endif
+}
+
+#if defined(QSC_SYSTEM_COMPILER_GCC)
+__attribute__((target("xsave")))
+#endif
+static uint32_t cpuidex_xgetbv()
+{
+	/* reads the os enabled register state, the intrinsic is compiled for this function alone */
+	return (uint32_t)_xgetbv(0);
+}
+
 static uint32_t cpuidex_read_bits(uint32_t value, int index, int length)
 {
 	int mask = ((1L << length) - 1) << index;
@@ -470,6 +491,9 @@ static void cpuidex_cpu_cache(qsc_cpuidex_cpu_features* features)
 static void cpuidex_cpu_topology(qsc_cpuidex_cpu_features* features)
 {
 	uint32_t info[4] = { 0 };
+	uint32_t xcr0;
+
+	xcr0 = 0;
 
 	/* total cpu cores */
 	features->cores = cpuidex_cpu_count();
@@ -488,29 +512,17 @@ static void cpuidex_cpu_topology(qsc_cpuidex_cpu_features* features)
 	features->rdrand = ((info[2] & CPUID_ECX_RDRAND) != 0x00000000UL);
 	features->rdtcsp = ((info[3] & CPUID_EDX_RDTCSP) != 0x00000000UL);
 
-#if defined(QSC_SYSTEM_HAS_AVX)
-	bool havx;
-
-	havx = (info[2] & CPUID_ECX_AVX) != 0x00000000UL;
-
-	if (havx == true)
+	/* the vector extensions are detected on every build, so a portable binary can select the kernels the host supports */
+	if ((info[2] & (CPUID_ECX_AVX | CPUID_ECX_XSAVE | CPUID_ECX_OSXSAVE)) ==
+		(CPUID_ECX_AVX | CPUID_ECX_XSAVE | CPUID_ECX_OSXSAVE))
 	{
-		uint32_t xcr0;
-
-		xcr0 = 0;
-
-		if ((info[2] & (CPUID_ECX_AVX | CPUID_ECX_XSAVE | CPUID_ECX_OSXSAVE)) ==
-			(CPUID_ECX_AVX | CPUID_ECX_XSAVE | CPUID_ECX_OSXSAVE))
-		{
-			xcr0 = (uint32_t)_xgetbv(0);
-		}
+		xcr0 = cpuidex_xgetbv();
 
 		if ((xcr0 & (XCR0_SSE | XCR0_AVX)) == (XCR0_SSE | XCR0_AVX))
 		{
 			features->avx = true;
 		}
 	}
-#endif
 
 	if (features->cputype == qsc_cpuid_intel)
 	{
@@ -524,42 +536,21 @@ static void cpuidex_cpu_topology(qsc_cpuidex_cpu_features* features)
 
 	if (features->avx == true)
 	{
-#if defined(QSC_SYSTEM_HAS_AVX2)
-		bool havx2;
-
 		qsc_memutils_clear(info, sizeof(info));
-		cpuidex_cpu_info(info, 0x00000007UL);
-
-#	if defined(QSC_SYSTEM_COMPILER_GCC)
-		__builtin_cpu_init();
-		havx2 = __builtin_cpu_supports("avx2") != 0;
-#	else
-		havx2 = ((info[1] & CPUID_EBX_AVX2) != 0x00000000UL);
-#	endif
+		cpuidex_cpu_info_ex(info, 0x00000007UL, 0x00000000UL);
 
 		features->adx = ((info[1] & CPUID_EBX_ADX) != 0x00000000UL);
-		features->avx2 = havx2 && ((uint32_t)_xgetbv(0) & 0x000000E6UL) != 0x00000000UL;
+		features->avx2 = ((info[1] & CPUID_EBX_AVX2) != 0x00000000UL);
 		features->sha256 = ((info[1] & CPUID_EBX_SHA2) != 0x00000000UL);
-#endif
+		features->vaes = ((info[2] & CPUID_ECX_VAES) != 0x00000000UL);
 
-#if defined(QSC_SYSTEM_HAS_AVX512)
-		bool havx512;
-#	if defined(QSC_SYSTEM_COMPILER_GCC)
-		havx512 = __builtin_cpu_supports("avx512f") != 0;
-#	else
-		havx512 = ((info[1] & CPUID_EBX_AVX512F) != 0x00000000UL);
-#	endif
-		if (havx512 == true)
+		/* the avx-512 flags require the os to save the opmask and upper zmm registers */
+		if ((xcr0 & (XCR0_OPMASK | XCR0_ZMM_HI256 | XCR0_HI16_ZMM)) ==
+			(XCR0_OPMASK | XCR0_ZMM_HI256 | XCR0_HI16_ZMM))
 		{
-			uint32_t xcr2 = (uint32_t)_xgetbv(0);
-
-			if ((xcr2 & (XCR0_OPMASK | XCR0_ZMM_HI256 | XCR0_HI16_ZMM)) ==
-				(XCR0_OPMASK | XCR0_ZMM_HI256 | XCR0_HI16_ZMM))
-			{
-				features->avx512f = true;
-			}
+			features->avx512f = ((info[1] & CPUID_EBX_AVX512F) != 0x00000000UL);
+			features->avx512bw = ((info[1] & CPUID_EBX_AVX512BW) != 0x00000000UL);
 		}
-#endif
 	}
 }
 
@@ -887,6 +878,8 @@ bool qsc_cpuidex_features_set(qsc_cpuidex_cpu_features* features)
     features->avx = false;
     features->avx2 = false;
     features->avx512f = false;
+    features->avx512bw = false;
+    features->vaes = false;
     features->hyperthread = false;
     features->rdrand = false;
     features->rdtcsp = false;
@@ -974,6 +967,12 @@ void qsc_cpuidex_print_stats()
 		qsc_consoleutils_print_safe("AVX512: ");
 		qsc_consoleutils_print_line(cfeat.avx512f == true ? st : sf);
 
+		qsc_consoleutils_print_safe("AVX512BW: ");
+		qsc_consoleutils_print_line(cfeat.avx512bw == true ? st : sf);
+
+		qsc_consoleutils_print_safe("VAES: ");
+		qsc_consoleutils_print_line(cfeat.vaes == true ? st : sf);
+
 		qsc_consoleutils_print_safe("Hyperthread: ");
 		qsc_consoleutils_print_line(cfeat.hyperthread == true ? st : sf);
 
@@ -80,6 +80,8 @@ QSC_EXPORT_API typedef struct qsc_cpuidex_cpu_features
     bool avx;                               	/*!< The AVX flag */
     bool avx2;                              	/*!< The AVX2 flag */
     bool avx512f;                           	/*!< The AVX512F flag */
+    bool avx512bw;                          	/*!< The AVX512BW flag */
+    bool vaes;                              	/*!< The VAES vector AES flag */
     bool hyperthread;                       	/*!< The hyper-thread flag */
     bool rdrand;                            	/*!< The RDRAND flag */
     bool rdtcsp;                            	/*!< The RDTCSP flag */
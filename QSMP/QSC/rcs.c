@@ -1,12 +1,14 @@
 #include "rcs.h"
+#include "async.h"
+#include "cpuidex.h"
 #include "intutils.h"
 #include "memutils.h"
 
 /*!
-\def QSC_RCS_SBOX_SIZE
-* The Rijndael S-Box interger count.
+\def RCS_BITSLICE_SIZE
+* The number of bytes processed by one pass of the bitsliced kernel; two blocks share each 64-bit slice.
 */
-#define RCS_SBOX_SIZE 256
+#define RCS_BITSLICE_SIZE (QSC_RCS_BLOCK_SIZE * 2)
 
 /*!
 \def RCS_256_ROUND_COUNT
@@ -27,9 +29,29 @@
 #ifdef QSC_RCS_AESNI_ENABLED
 #	define RCS_ROUNDKEY_ELEMENT_SIZE 16
 #	define RCS_AVX512_BLOCK 64
+#	define RCS_PARALLEL4_BLOCK (QSC_RCS_BLOCK_SIZE * 4)
+#	define RCS_PARALLEL8_BLOCK (QSC_RCS_BLOCK_SIZE * 8)
 #else
 #	define RCS_ROUNDKEY_ELEMENT_SIZE 4
-#	define RCS_PREFETCH_TABLES
+#endif
+
+/*!
+\def RCS_TARGET_AESNI
+* The instruction sets a kernel is compiled for.
+* The vector kernels are built into every AES-NI enabled binary, and are selected at run-time by the cpu features of the host.
+*/
+#if defined(QSC_RCS_AESNI_ENABLED) && defined(QSC_SYSTEM_COMPILER_GCC)
+#	define RCS_TARGET_AESNI __attribute__((target("sse4.1,aes")))
+#	define RCS_TARGET_VAES __attribute__((target("avx2,aes,vaes")))
+#	define RCS_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,aes,vaes")))
+#	define RCS_TARGET_MACX4 __attribute__((target("avx2")))
+#	define RCS_TARGET_MACX8 __attribute__((target("avx512f")))
+#else
+#	define RCS_TARGET_AESNI
+#	define RCS_TARGET_VAES
+#	define RCS_TARGET_AVX512
+#	define RCS_TARGET_MACX4
+#	define RCS_TARGET_MACX8
 #endif
 
 /*!
@@ -74,6 +96,27 @@
 */
 #define RCS_INFO_DEFLEN 9
 
+/*!
+\def RCS_FUSED_CHUNK
+* The number of bytes encrypted and then absorbed by the mac in one step, a block multiple sized to stay in the l1 cache.
+*/
+#define RCS_FUSED_CHUNK 4096
+
+/*!
+\def RCS_MULTI_BATCH
+* The number of sessions, and of counter blocks, processed together by the multi-session transform.
+*/
+#define RCS_MULTI_BATCH 16
+
+/*!
+\def RCS_MAC_LANES
+* The largest number of MAC states permuted together by the multi-session transform.
+* The lane permutations are compiled for their own instruction sets, and the lane count is selected at run-time from the detected cpu features.
+*/
+#if defined(QSC_RCS_AUTHENTICATED) && defined(QSC_RCS_AESNI_ENABLED)
+#	define RCS_MAC_LANES 8
+#endif
+
 #if defined(QSC_RCS_AUTHENTICATED)
 
 static const uint8_t rcs_256_name[RCS_NAME_SIZE] =
@@ -107,15 +150,383 @@ static const uint8_t rcs_512_name[RCS_NAME_SIZE] =
 
 #endif
 
-/* aes-ni and table-based fallback functions */
+/* bitsliced functions, the constant-time fallback on a host without aes-ni */
+
+static void rcs_bitslice_swap(uint64_t* x, uint64_t* y, uint64_t mask, size_t shift)
+{
+	uint64_t a;
+	uint64_t b;
+
+	a = *x;
+	b = *y;
+	*x = (a & mask) | ((b & mask) << shift);
+	*y = ((a & ~mask) >> shift) | (b & ~mask);
+}
+
+static void rcs_bitslice_ortho(uint64_t q[8])
+{
+	/* transpose the 8x8 bit matrices; word i then holds bit i of every byte, the transform is its own inverse */
+	rcs_bitslice_swap(&q[0], &q[1], 0x5555555555555555ULL, 1);
+	rcs_bitslice_swap(&q[2], &q[3], 0x5555555555555555ULL, 1);
+	rcs_bitslice_swap(&q[4], &q[5], 0x5555555555555555ULL, 1);
+	rcs_bitslice_swap(&q[6], &q[7], 0x5555555555555555ULL, 1);
+	rcs_bitslice_swap(&q[0], &q[2], 0x3333333333333333ULL, 2);
+	rcs_bitslice_swap(&q[1], &q[3], 0x3333333333333333ULL, 2);
+	rcs_bitslice_swap(&q[4], &q[6], 0x3333333333333333ULL, 2);
+	rcs_bitslice_swap(&q[5], &q[7], 0x3333333333333333ULL, 2);
+	rcs_bitslice_swap(&q[0], &q[4], 0x0F0F0F0F0F0F0F0FULL, 4);
+	rcs_bitslice_swap(&q[1], &q[5], 0x0F0F0F0F0F0F0F0FULL, 4);
+	rcs_bitslice_swap(&q[2], &q[6], 0x0F0F0F0F0F0F0F0FULL, 4);
+	rcs_bitslice_swap(&q[3], &q[7], 0x0F0F0F0F0F0F0F0FULL, 4);
+}
+
+static size_t rcs_bitslice_index(size_t block, size_t position)
+{
+	size_t p;
+
+	/* state byte (row r, column c) of block b is bit 16r + 2c + b of each word,
+	the transpose moves byte 8j + k of the buffer to bit 8k + j */
+	p = ((position & 3) << 4) | ((position >> 2) << 1) | block;
+
+	return ((p & 7) << 3) | (p >> 3);
+}
+
+static void rcs_bitslice_load(uint64_t q[8], const uint8_t* block0, const uint8_t* block1)
+{
+	uint8_t buf[RCS_BITSLICE_SIZE];
+
+	for (size_t i = 0; i < QSC_RCS_BLOCK_SIZE; ++i)
+	{
+		buf[rcs_bitslice_index(0, i)] = block0[i];
+		buf[rcs_bitslice_index(1, i)] = block1[i];
+	}
+
+	for (size_t i = 0; i < 8; ++i)
+	{
+		q[i] = qsc_intutils_le8to64(buf + (i * sizeof(uint64_t)));
+	}
+
+	rcs_bitslice_ortho(q);
+	qsc_memutils_clear(buf, sizeof(buf));
+}
+
+static void rcs_bitslice_store(uint8_t* block0, uint8_t* block1, uint64_t q[8])
+{
+	uint8_t buf[RCS_BITSLICE_SIZE];
+
+	rcs_bitslice_ortho(q);
+
+	for (size_t i = 0; i < 8; ++i)
+	{
+		qsc_intutils_le64to8(buf + (i * sizeof(uint64_t)), q[i]);
+	}
+
+	for (size_t i = 0; i < QSC_RCS_BLOCK_SIZE; ++i)
+	{
+		block0[i] = buf[rcs_bitslice_index(0, i)];
+		block1[i] = buf[rcs_bitslice_index(1, i)];
+	}
+
+	qsc_memutils_clear(buf, sizeof(buf));
+}
+
+static void rcs_bitslice_sub_bytes(uint64_t q[8])
+{
+	/* the Boyar-Peralta S-box circuit; 113 logic gates and no memory lookups */
+	uint64_t x0, x1, x2, x3, x4, x5, x6, x7;
+	uint64_t y1, y2, y3, y4, y5, y6, y7, y8, y9, y10, y11;
+	uint64_t y12, y13, y14, y15, y16, y17, y18, y19, y20, y21;
+	uint64_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+	uint64_t z10, z11, z12, z13, z14, z15, z16, z17;
+	uint64_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+	uint64_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+	uint64_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+	uint64_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+	uint64_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+	uint64_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+	uint64_t t60, t61, t62, t63, t64, t65, t66, t67;
+	uint64_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+	x0 = q[7];
+	x1 = q[6];
+	x2 = q[5];
+	x3 = q[4];
+	x4 = q[3];
+	x5 = q[2];
+	x6 = q[1];
+	x7 = q[0];
+
+	/* top linear transformation */
+	y14 = x3 ^ x5;
+	y13 = x0 ^ x6;
+	y9 = x0 ^ x3;
+	y8 = x0 ^ x5;
+	t0 = x1 ^ x2;
+	y1 = t0 ^ x7;
+	y4 = y1 ^ x3;
+	y12 = y13 ^ y14;
+	y2 = y1 ^ x0;
+	y5 = y1 ^ x6;
+	y3 = y5 ^ y8;
+	t1 = x4 ^ y12;
+	y15 = t1 ^ x5;
+	y20 = t1 ^ x1;
+	y6 = y15 ^ x7;
+	y10 = y15 ^ t0;
+	y11 = y20 ^ y9;
+	y7 = x7 ^ y11;
+	y17 = y10 ^ y11;
+	y19 = y10 ^ y8;
+	y16 = t0 ^ y11;
+	y21 = y13 ^ y16;
+	y18 = x0 ^ y16;
+
+	/* non-linear section, the inversion in GF(2^4)^2 */
+	t2 = y12 & y15;
+	t3 = y3 & y6;
+	t4 = t3 ^ t2;
+	t5 = y4 & x7;
+	t6 = t5 ^ t2;
+	t7 = y13 & y16;
+	t8 = y5 & y1;
+	t9 = t8 ^ t7;
+	t10 = y2 & y7;
+	t11 = t10 ^ t7;
+	t12 = y9 & y11;
+	t13 = y14 & y17;
+	t14 = t13 ^ t12;
+	t15 = y8 & y10;
+	t16 = t15 ^ t12;
+	t17 = t4 ^ t14;
+	t18 = t6 ^ t16;
+	t19 = t9 ^ t14;
+	t20 = t11 ^ t16;
+	t21 = t17 ^ y20;
+	t22 = t18 ^ y19;
+	t23 = t19 ^ y21;
+	t24 = t20 ^ y18;
+
+	t25 = t21 ^ t22;
+	t26 = t21 & t23;
+	t27 = t24 ^ t26;
+	t28 = t25 & t27;
+	t29 = t28 ^ t22;
+	t30 = t23 ^ t24;
+	t31 = t22 ^ t26;
+	t32 = t31 & t30;
+	t33 = t32 ^ t24;
+	t34 = t23 ^ t33;
+	t35 = t27 ^ t33;
+	t36 = t24 & t35;
+	t37 = t36 ^ t34;
+	t38 = t27 ^ t36;
+	t39 = t29 & t38;
+	t40 = t25 ^ t39;
+
+	t41 = t40 ^ t37;
+	t42 = t29 ^ t33;
+	t43 = t29 ^ t40;
+	t44 = t33 ^ t37;
+	t45 = t42 ^ t41;
+	z0 = t44 & y15;
+	z1 = t37 & y6;
+	z2 = t33 & x7;
+	z3 = t43 & y16;
+	z4 = t40 & y1;
+	z5 = t29 & y7;
+	z6 = t42 & y11;
+	z7 = t45 & y17;
+	z8 = t41 & y10;
+	z9 = t44 & y12;
+	z10 = t37 & y3;
+	z11 = t33 & y4;
+	z12 = t43 & y13;
+	z13 = t40 & y5;
+	z14 = t29 & y2;
+	z15 = t42 & y9;
+	z16 = t45 & y14;
+	z17 = t41 & y8;
+
+	/* bottom linear transformation */
+	t46 = z15 ^ z16;
+	t47 = z10 ^ z11;
+	t48 = z5 ^ z13;
+	t49 = z9 ^ z10;
+	t50 = z2 ^ z12;
+	t51 = z2 ^ z5;
+	t52 = z7 ^ z8;
+	t53 = z0 ^ z3;
+	t54 = z6 ^ z7;
+	t55 = z16 ^ z17;
+	t56 = z12 ^ t48;
+	t57 = t50 ^ t53;
+	t58 = z4 ^ t46;
+	t59 = z3 ^ t54;
+	t60 = t46 ^ t57;
+	t61 = z14 ^ t57;
+	t62 = t52 ^ t58;
+	t63 = t49 ^ t58;
+	t64 = z4 ^ t59;
+	t65 = t61 ^ t62;
+	t66 = z1 ^ t63;
+	s0 = t59 ^ t63;
+	s6 = t56 ^ ~t62;
+	s7 = t48 ^ ~t60;
+	t67 = t64 ^ t65;
+	s3 = t53 ^ t66;
+	s4 = t51 ^ t66;
+	s5 = t47 ^ t65;
+	s1 = t64 ^ ~s3;
+	s2 = t55 ^ ~t67;
+
+	q[7] = s0;
+	q[6] = s1;
+	q[5] = s2;
+	q[4] = s3;
+	q[3] = s4;
+	q[2] = s5;
+	q[1] = s6;
+	q[0] = s7;
+}
+
+static void rcs_bitslice_shift_rows(uint64_t q[8])
+{
+	uint64_t x;
+
+	/* each row is a 16-bit field, rows 1, 2 and 3 rotate left by 1, 3 and 4 of the 8 columns */
+	for (size_t i = 0; i < 8; ++i)
+	{
+		x = q[i];
+		q[i] = (x & 0x000000000000FFFFULL)
+			| ((x >> 2) & 0x000000003FFF0000ULL)
+			| ((x << 14) & 0x00000000C0000000ULL)
+			| ((x >> 6) & 0x000003FF00000000ULL)
+			| ((x << 10) & 0x0000FC0000000000ULL)
+			| ((x >> 8) & 0x00FF000000000000ULL)
+			| ((x << 8) & 0xFF00000000000000ULL);
+	}
+}
+
+static void rcs_bitslice_mix_columns(uint64_t q[8])
+{
+	uint64_t r[8];
+	uint64_t t[8];
+	uint64_t u[8];
+
+	/* r is the column rotated up one row, u the sum of the two rows, and t that sum rotated by two rows;
+	each output row is 2(a + b) + b + c + d, the doubling shifts the bit planes and folds bit 7 into bits 0, 1, 3 and 4 */
+	for (size_t i = 0; i < 8; ++i)
+	{
+		r[i] = (q[i] >> 16) | (q[i] << 48);
+		u[i] = q[i] ^ r[i];
+		t[i] = (u[i] >> 32) | (u[i] << 32);
+	}
+
+	q[0] = u[7] ^ r[0] ^ t[0];
+	q[1] = u[0] ^ u[7] ^ r[1] ^ t[1];
+	q[2] = u[1] ^ r[2] ^ t[2];
+	q[3] = u[2] ^ u[7] ^ r[3] ^ t[3];
+	q[4] = u[3] ^ u[7] ^ r[4] ^ t[4];
+	q[5] = u[4] ^ r[5] ^ t[5];
+	q[6] = u[5] ^ r[6] ^ t[6];
+	q[7] = u[6] ^ r[7] ^ t[7];
+}
+
+static void rcs_bitslice_add_roundkey(uint64_t q[8], const uint64_t* skeys)
+{
+	for (size_t i = 0; i < 8; ++i)
+	{
+		q[i] ^= skeys[i];
+	}
+}
+
+static void rcs_bitslice_expand(const qsc_rcs_state* ctx, uint64_t* skeys)
+{
+	const uint8_t* prk;
+
+	prk = (const uint8_t*)ctx->roundkeys;
+
+	/* the round keys are sliced once per call, the same key is loaded into both block positions */
+	for (size_t i = 0; i <= ctx->rounds; ++i)
+	{
+		rcs_bitslice_load(skeys + (i * 8), prk + (i * QSC_RCS_BLOCK_SIZE), prk + (i * QSC_RCS_BLOCK_SIZE));
+	}
+}
+
+static void rcs_transform_256_bitslice(const uint64_t* skeys, size_t rounds, uint64_t q[8])
+{
+	rcs_bitslice_add_roundkey(q, skeys);
+
+	for (size_t i = 1; i < rounds; ++i)
+	{
+		rcs_bitslice_sub_bytes(q);
+		rcs_bitslice_shift_rows(q);
+		rcs_bitslice_mix_columns(q);
+		rcs_bitslice_add_roundkey(q, skeys + (i * 8));
+	}
+
+	rcs_bitslice_sub_bytes(q);
+	rcs_bitslice_shift_rows(q);
+	rcs_bitslice_add_roundkey(q, skeys + (rounds * 8));
+}
+
+static void rcs_ctr_transform_bitslice(qsc_rcs_state* ctx, uint8_t* output, const uint8_t* input, size_t length)
+{
+	assert(ctx != NULL);
+	assert(input != NULL);
+	assert(output != NULL);
+
+	uint64_t skeys[(RCS_512_ROUND_COUNT + 1) * 8];
+	uint64_t q[8];
+	uint8_t ctrb[RCS_BITSLICE_SIZE] = { 0 };
+	uint8_t tmpb[RCS_BITSLICE_SIZE] = { 0 };
+	size_t blen;
+	size_t oft;
+
+	oft = 0;
+	rcs_bitslice_expand(ctx, skeys);
+
+	/* two counter blocks are encrypted per pass; the key-stream is generated to a temporary block so the input and output may overlap */
+	while (length != 0)
+	{
+		blen = qsc_intutils_min(length, RCS_BITSLICE_SIZE);
+		qsc_memutils_copy(ctrb, ctx->nonce, QSC_RCS_BLOCK_SIZE);
+		qsc_intutils_le8increment(ctx->nonce, QSC_RCS_BLOCK_SIZE);
+
+		/* the nonce is incremented once for every block used, including a partial final block */
+		if (blen > QSC_RCS_BLOCK_SIZE)
+		{
+			qsc_memutils_copy(ctrb + QSC_RCS_BLOCK_SIZE, ctx->nonce, QSC_RCS_BLOCK_SIZE);
+			qsc_intutils_le8increment(ctx->nonce, QSC_RCS_BLOCK_SIZE);
+		}
+
+		rcs_bitslice_load(q, ctrb, ctrb + QSC_RCS_BLOCK_SIZE);
+		rcs_transform_256_bitslice(skeys, ctx->rounds, q);
+		rcs_bitslice_store(tmpb, tmpb + QSC_RCS_BLOCK_SIZE, q);
+
+		for (size_t i = 0; i < blen; ++i)
+		{
+			output[oft + i] = tmpb[i] ^ input[oft + i];
+		}
+
+		length -= blen;
+		oft += blen;
+	}
+
+	qsc_memutils_clear((uint8_t*)skeys, sizeof(skeys));
+	qsc_memutils_clear((uint8_t*)q, sizeof(q));
+	qsc_memutils_clear(tmpb, sizeof(tmpb));
+}
+
+/* aes-ni functions */
 
 #if defined(QSC_RCS_AESNI_ENABLED)
 
-static void rcs_transform_256(qsc_rcs_state* ctx, __m128i output[2], const __m128i input[2])
+RCS_TARGET_AESNI
+static void rcs_transform_256(const qsc_rcs_state* ctx, __m128i output[2], const __m128i input[2])
 {
 	const __m128i BLEND_MASK = _mm_set_epi32(0x80000000UL, 0x80800000UL, 0x80800000UL, 0x80808000UL);
-	const __m128i SHIFT_MASK = _mm_set_epi8(0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 2, 3);
-	const size_t HLFBLK = QSC_RCS_BLOCK_SIZE / 2;
+	const __m128i SHIFT_MASK = _mm_setr_epi8(0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 2, 3);
 	const size_t RNDCNT = ctx->roundkeylen - 3;
 	size_t kctr;
 
@@ -160,33 +571,191 @@ static void rcs_transform_256(qsc_rcs_state* ctx, __m128i output[2], const __m12
 	_mm_storeu_si128(&output[1], blk2);
 }
 
-#if defined(QSC_SYSTEM_HAS_AVX512)
+RCS_TARGET_AESNI
+static void rcs_transform_256x4(const qsc_rcs_state* ctx, __m128i output[8], const __m128i input[8])
+{
+	const __m128i BLEND_MASK = _mm_set_epi32(0x80000000UL, 0x80800000UL, 0x80800000UL, 0x80808000UL);
+	const __m128i SHIFT_MASK = _mm_setr_epi8(0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 2, 3);
+	const size_t RNDCNT = ctx->roundkeylen - 3;
+	__m128i blk[8];
+	__m128i tmp[8];
+	__m128i rk1;
+	__m128i rk2;
+	size_t i;
+	size_t kctr;
+
+	/* four blocks are interleaved, so each aesenc overlaps the latency of the others */
+	rk1 = ctx->roundkeys[0];
+	rk2 = ctx->roundkeys[1];
+
+	for (i = 0; i < 8; i += 2)
+	{
+		blk[i] = _mm_xor_si128(input[i], rk1);
+		blk[i + 1] = _mm_xor_si128(input[i + 1], rk2);
+	}
+
+	kctr = 1;
+
+	while (kctr != RNDCNT)
+	{
+		rk1 = ctx->roundkeys[kctr + 1];
+		rk2 = ctx->roundkeys[kctr + 2];
+
+		for (i = 0; i < 8; i += 2)
+		{
+			/* mix and shuffle the half-blocks */
+			tmp[i] = _mm_shuffle_epi8(_mm_blendv_epi8(blk[i], blk[i + 1], BLEND_MASK), SHIFT_MASK);
+			tmp[i + 1] = _mm_shuffle_epi8(_mm_blendv_epi8(blk[i + 1], blk[i], BLEND_MASK), SHIFT_MASK);
+			blk[i] = _mm_aesenc_si128(tmp[i], rk1);
+			blk[i + 1] = _mm_aesenc_si128(tmp[i + 1], rk2);
+		}
+
+		kctr += 2;
+	}
+
+	rk1 = ctx->roundkeys[kctr + 1];
+	rk2 = ctx->roundkeys[kctr + 2];
+
+	for (i = 0; i < 8; i += 2)
+	{
+		tmp[i] = _mm_shuffle_epi8(_mm_blendv_epi8(blk[i], blk[i + 1], BLEND_MASK), SHIFT_MASK);
+		tmp[i + 1] = _mm_shuffle_epi8(_mm_blendv_epi8(blk[i + 1], blk[i], BLEND_MASK), SHIFT_MASK);
+		output[i] = _mm_aesenclast_si128(tmp[i], rk1);
+		output[i + 1] = _mm_aesenclast_si128(tmp[i + 1], rk2);
+	}
+}
+
+RCS_TARGET_AESNI
+static void rcs_transform_256x8(const qsc_rcs_state* ctx, __m128i output[16], const __m128i input[16])
+{
+	const __m128i BLEND_MASK = _mm_set_epi32(0x80000000UL, 0x80800000UL, 0x80800000UL, 0x80808000UL);
+	const __m128i SHIFT_MASK = _mm_setr_epi8(0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 2, 3);
+	const size_t RNDCNT = ctx->roundkeylen - 3;
+	__m128i blk[16];
+	__m128i tmp[16];
+	__m128i rk1;
+	__m128i rk2;
+	size_t i;
+	size_t kctr;
+
+	/* eight blocks cover the aesenc latency on cores that issue two per cycle */
+	rk1 = ctx->roundkeys[0];
+	rk2 = ctx->roundkeys[1];
+
+	for (i = 0; i < 16; i += 2)
+	{
+		blk[i] = _mm_xor_si128(input[i], rk1);
+		blk[i + 1] = _mm_xor_si128(input[i + 1], rk2);
+	}
+
+	kctr = 1;
+
+	while (kctr != RNDCNT)
+	{
+		rk1 = ctx->roundkeys[kctr + 1];
+		rk2 = ctx->roundkeys[kctr + 2];
+
+		for (i = 0; i < 16; i += 2)
+		{
+			tmp[i] = _mm_shuffle_epi8(_mm_blendv_epi8(blk[i], blk[i + 1], BLEND_MASK), SHIFT_MASK);
+			tmp[i + 1] = _mm_shuffle_epi8(_mm_blendv_epi8(blk[i + 1], blk[i], BLEND_MASK), SHIFT_MASK);
+			blk[i] = _mm_aesenc_si128(tmp[i], rk1);
+			blk[i + 1] = _mm_aesenc_si128(tmp[i + 1], rk2);
+		}
+
+		kctr += 2;
+	}
+
+	rk1 = ctx->roundkeys[kctr + 1];
+	rk2 = ctx->roundkeys[kctr + 2];
+
+	for (i = 0; i < 16; i += 2)
+	{
+		tmp[i] = _mm_shuffle_epi8(_mm_blendv_epi8(blk[i], blk[i + 1], BLEND_MASK), SHIFT_MASK);
+		tmp[i + 1] = _mm_shuffle_epi8(_mm_blendv_epi8(blk[i + 1], blk[i], BLEND_MASK), SHIFT_MASK);
+		output[i] = _mm_aesenclast_si128(tmp[i], rk1);
+		output[i + 1] = _mm_aesenclast_si128(tmp[i + 1], rk2);
+	}
+}
+
+RCS_TARGET_VAES
+static void rcs_transform_256w8(const qsc_rcs_state* ctx, __m256i output[8], const __m256i input[8])
+{
+	const __m256i BLEND_MASK = _mm256_broadcastsi128_si256(_mm_set_epi32(0x80000000UL, 0x80800000UL, 0x80800000UL, 0x80808000UL));
+	const __m256i SHIFT_MASK = _mm256_broadcastsi128_si256(_mm_setr_epi8(0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 2, 3));
+	const size_t RNDCNT = ctx->roundkeylen - 3;
+	__m256i blk[8];
+	__m256i rkw;
+	size_t i;
+	size_t kctr;
+
+	/* a 256-bit lane holds a whole block, the two half-block round keys are adjacent and load as one vector */
+	rkw = _mm256_loadu_si256((const __m256i*)&ctx->roundkeys[0]);
+
+	for (i = 0; i < 8; ++i)
+	{
+		blk[i] = _mm256_xor_si256(input[i], rkw);
+	}
+
+	kctr = 1;
+
+	while (kctr != RNDCNT)
+	{
+		rkw = _mm256_loadu_si256((const __m256i*)&ctx->roundkeys[kctr + 1]);
+
+		for (i = 0; i < 8; ++i)
+		{
+			/* the half-block blend is a blend with the lane-swapped block */
+			blk[i] = _mm256_blendv_epi8(blk[i], _mm256_permute2x128_si256(blk[i], blk[i], 0x01), BLEND_MASK);
+			blk[i] = _mm256_aesenc_epi128(_mm256_shuffle_epi8(blk[i], SHIFT_MASK), rkw);
+		}
+
+		kctr += 2;
+	}
+
+	rkw = _mm256_loadu_si256((const __m256i*)&ctx->roundkeys[kctr + 1]);
+
+	for (i = 0; i < 8; ++i)
+	{
+		blk[i] = _mm256_blendv_epi8(blk[i], _mm256_permute2x128_si256(blk[i], blk[i], 0x01), BLEND_MASK);
+		output[i] = _mm256_aesenclast_epi128(_mm256_shuffle_epi8(blk[i], SHIFT_MASK), rkw);
+	}
+}
+
+RCS_TARGET_AVX512
+static __m512i rcs_load_roundkey512(const qsc_rcs_state* ctx, size_t index)
+{
+	/* the two half-block keys of a round are adjacent, and are repeated for the second block in the vector */
+	return _mm512_broadcast_i64x4(_mm256_loadu_si256((const __m256i*)&ctx->roundkeys[index * 2]));
+}
 
-static void rcs_load2x128to512(const __m128i* k1, const __m128i* k2, __m512i* output)
+RCS_TARGET_AVX512
+static __m512i rcs_load_roundkey512x2(const qsc_rcs_state* ctx0, const qsc_rcs_state* ctx1, size_t index)
 {
-	*output = _mm512_setzero_si512();
-	*output = _mm512_inserti32x4(*output, *k1, 0);
-	*output = _mm512_inserti32x4(*output, *k2, 1);
-	*output = _mm512_inserti32x4(*output, *k1, 2);
-	*output = _mm512_inserti32x4(*output, *k2, 3);
+	/* the low block in the vector is keyed by the first state, the high block by the second */
+	return _mm512_inserti64x4(_mm512_castsi256_si512(_mm256_loadu_si256((const __m256i*)&ctx0->roundkeys[index * 2])),
+		_mm256_loadu_si256((const __m256i*)&ctx1->roundkeys[index * 2]), 1);
 }
 
-__m512i rcs_shuffle512(const __m512i* value, const __m512i* k0, const __m512i* k1, const __m512i* mask)
+RCS_TARGET_AVX512
+static __m512i rcs_shuffle512(const __m512i* value, const __m512i* k0, const __m512i* k1, const __m512i* mask)
 {
 	return _mm512_or_si512(_mm512_shuffle_epi8(*value, _mm512_add_epi8(*mask, *k0)),
 		_mm512_shuffle_epi8(_mm512_permutex_epi64(*value, 0x4E), _mm512_add_epi8(*mask, *k1)));
 }
 
-static void rcs_transform_512(qsc_rcs_state* ctx, __m512i* output, const __m512i* input)
+RCS_TARGET_AVX512
+static void rcs_transform_512(const qsc_rcs_state* ctx, __m512i* output, const __m512i* input)
 {
-	const __m512i NI512K0 = _mm512_set_epi64(17361641481138401520, 17361641481138401520, 8102099357864587376, 8102099357864587376,
-		17361641481138401520, 17361641481138401520, 8102099357864587376, 8102099357864587376);
-	const __m512i NI512K1 = _mm512_set_epi64(8102099357864587376, 8102099357864587376, 17361641481138401520, 17361641481138401520,
-		8102099357864587376, 8102099357864587376, 17361641481138401520, 17361641481138401520);
-	const __m512i SWMASKL = _mm512_setr_epi8(0, 17, 22, 23, 4, 5, 26, 27, 8, 9, 14, 31, 12, 13, 18, 19,
-		16, 1, 6, 7, 20, 21, 10, 11, 24, 25, 30, 15, 28, 29, 2, 3,
-		0, 17, 22, 23, 4, 5, 26, 27, 8, 9, 14, 31, 12, 13, 18, 19, 
-		16, 1, 6, 7, 20, 21, 10, 11, 24, 25, 30, 15, 28, 29, 2, 3);
+	const __m512i NI512K0 = _mm512_set_epi64((int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0x7070707070707070ULL, (int64_t)0x7070707070707070ULL,
+		(int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0x7070707070707070ULL, (int64_t)0x7070707070707070ULL);
+	const __m512i NI512K1 = _mm512_set_epi64((int64_t)0x7070707070707070ULL, (int64_t)0x7070707070707070ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL,
+		(int64_t)0x7070707070707070ULL, (int64_t)0x7070707070707070ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL);
+	/* _mm512_setr_epi8 is not available on every compiler, the mask is set in reverse order */
+	const __m512i SWMASKL = _mm512_set_epi8(3, 2, 29, 28, 15, 30, 25, 24, 11, 10, 21, 20, 7, 6, 1, 16,
+		19, 18, 13, 12, 31, 14, 9, 8, 27, 26, 5, 4, 23, 22, 17, 0,
+		3, 2, 29, 28, 15, 30, 25, 24, 11, 10, 21, 20, 7, 6, 1, 16,
+		19, 18, 13, 12, 31, 14, 9, 8, 27, 26, 5, 4, 23, 22, 17, 0);
 
 	const size_t RNDCNT = (ctx->roundkeylen / 2) - 2;
 	size_t kctr;
@@ -194,370 +763,1039 @@ static void rcs_transform_512(qsc_rcs_state* ctx, __m512i* output, const __m512i
 
 	kctr = 0;
 	x = *input;
-	x = _mm512_xor_si512(x, ctx->roundkeysw[kctr]);
+	x = _mm512_xor_si512(x, rcs_load_roundkey512(ctx, kctr));
 
 	while (kctr < RNDCNT)
 	{
 		++kctr;
 		x = rcs_shuffle512(&x, &NI512K0, &NI512K1, &SWMASKL);
-		x = _mm512_aesenc_epi128(x, ctx->roundkeysw[kctr]);
+		x = _mm512_aesenc_epi128(x, rcs_load_roundkey512(ctx, kctr));
 	}
 
 	++kctr;
 	x = rcs_shuffle512(&x, &NI512K0, &NI512K1, &SWMASKL);
-	*output = _mm512_aesenclast_epi128(x, ctx->roundkeysw[kctr]);
+	*output = _mm512_aesenclast_epi128(x, rcs_load_roundkey512(ctx, kctr));
 }
 
-#endif
-
-static void rcs_ctr_transform(qsc_rcs_state* ctx, uint8_t* output, const uint8_t* input, size_t length)
+RCS_TARGET_AVX512
+static void rcs_transform_512x8(const qsc_rcs_state* ctx, __m512i output[8], const __m512i input[8])
 {
-	assert(ctx != NULL);
-	assert(input != NULL);
-	assert(output != NULL);
+	const __m512i NI512K0 = _mm512_set_epi64((int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0x7070707070707070ULL, (int64_t)0x7070707070707070ULL,
+		(int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0x7070707070707070ULL, (int64_t)0x7070707070707070ULL);
+	const __m512i NI512K1 = _mm512_set_epi64((int64_t)0x7070707070707070ULL, (int64_t)0x7070707070707070ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL,
+		(int64_t)0x7070707070707070ULL, (int64_t)0x7070707070707070ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL);
+	const __m512i SWMASKL = _mm512_set_epi8(3, 2, 29, 28, 15, 30, 25, 24, 11, 10, 21, 20, 7, 6, 1, 16,
+		19, 18, 13, 12, 31, 14, 9, 8, 27, 26, 5, 4, 23, 22, 17, 0,
+		3, 2, 29, 28, 15, 30, 25, 24, 11, 10, 21, 20, 7, 6, 1, 16,
+		19, 18, 13, 12, 31, 14, 9, 8, 27, 26, 5, 4, 23, 22, 17, 0);
 
-	const size_t HLFBLK = QSC_RCS_BLOCK_SIZE / 2;
+	const size_t RNDCNT = (ctx->roundkeylen / 2) - 2;
 	size_t i;
-	size_t oft;
+	size_t kctr;
+	__m512i x[8];
 
-	oft = 0;
+	/* eight independent vectors of two blocks each keep the aes units busy */
+	kctr = 0;
 
-#if defined(QSC_SYSTEM_HAS_AVX512)
+	for (i = 0; i < 8; ++i)
+	{
+		x[i] = _mm512_xor_si512(input[i], rcs_load_roundkey512(ctx, kctr));
+	}
 
-	if (length >= RCS_AVX512_BLOCK)
+	while (kctr < RNDCNT)
 	{
-		uint8_t ctrblk[64];
-		__m512i ctrw;
-		__m512i inpw;
-		__m512i otpw;
-
-		/* initialize and pre-set the nonce */
-		ctrw = _mm512_set1_epi64(0);
-		qsc_memutils_copy(ctrblk, ctx->nonce, QSC_RCS_BLOCK_SIZE);
-		qsc_memutils_copy(((uint8_t*)ctrblk + QSC_RCS_BLOCK_SIZE), ctx->nonce, QSC_RCS_BLOCK_SIZE);
-		ctrw = _mm512_load_si512(ctrblk);
-		ctrw = _mm512_add_epi64(ctrw, _mm512_set_epi64(0, 0, 0, 1, 0, 0, 0, 0));
+		++kctr;
 
-		/* process 2 blocks in parallel */
-		while (length >= RCS_AVX512_BLOCK)
+		for (i = 0; i < 8; ++i)
 		{
-			/* encrypt the nonce */
-			rcs_transform_512(ctx, &otpw, &ctrw);
-			/* load the input */
-			inpw = _mm512_loadu_si512((const __m512i*)((uint8_t*)input + oft));
-			/* xor encrypted encrypted nonce with the input */
-			otpw = _mm512_xor_si512(otpw, inpw);
-			/* increments only the first 64 bits of the nonce; with ulong rollover that is 2^64 output blocks available */
-			ctrw = _mm512_add_epi64(ctrw, _mm512_set_epi64(0, 0, 0, 2, 0, 0, 0, 2));
-			/* store in output */
-			_mm512_storeu_si512((__m512i*)((uint8_t*)output + oft), otpw);
-
-			oft += RCS_AVX512_BLOCK;
-			length -= RCS_AVX512_BLOCK;
+			x[i] = rcs_shuffle512(&x[i], &NI512K0, &NI512K1, &SWMASKL);
+			x[i] = _mm512_aesenc_epi128(x[i], rcs_load_roundkey512(ctx, kctr));
 		}
-
-		/* store the last position of the nonce */
-		_mm512_storeu_si512((__m512i*)ctrblk, ctrw);
-		qsc_memutils_copy(ctx->nonce, ctrblk, QSC_RCS_BLOCK_SIZE);
 	}
 
-#endif
+	++kctr;
 
-	while (length >= QSC_RCS_BLOCK_SIZE)
+	for (i = 0; i < 8; ++i)
 	{
-		__m128i tmpn[2] = { _mm_loadu_si128((const __m128i*)ctx->nonce), _mm_loadu_si128((const __m128i*)((uint8_t*)ctx->nonce + HLFBLK)) };
-		__m128i tmpo[2] = { 0 };
+		x[i] = rcs_shuffle512(&x[i], &NI512K0, &NI512K1, &SWMASKL);
+		output[i] = _mm512_aesenclast_epi128(x[i], rcs_load_roundkey512(ctx, kctr));
+	}
+}
 
-		rcs_transform_256(ctx, tmpo, tmpn);
+RCS_TARGET_AVX512
+static void rcs_transform_512x8_multi(const qsc_rcs_state* const ctx[RCS_MULTI_BATCH], __m512i output[8], const __m512i input[8])
+{
+	const __m512i NI512K0 = _mm512_set_epi64((int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0x7070707070707070ULL, (int64_t)0x7070707070707070ULL,
+		(int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0x7070707070707070ULL, (int64_t)0x7070707070707070ULL);
+	const __m512i NI512K1 = _mm512_set_epi64((int64_t)0x7070707070707070ULL, (int64_t)0x7070707070707070ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL,
+		(int64_t)0x7070707070707070ULL, (int64_t)0x7070707070707070ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL, (int64_t)0xF0F0F0F0F0F0F0F0ULL);
+	const __m512i SWMASKL = _mm512_set_epi8(3, 2, 29, 28, 15, 30, 25, 24, 11, 10, 21, 20, 7, 6, 1, 16,
+		19, 18, 13, 12, 31, 14, 9, 8, 27, 26, 5, 4, 23, 22, 17, 0,
+		3, 2, 29, 28, 15, 30, 25, 24, 11, 10, 21, 20, 7, 6, 1, 16,
+		19, 18, 13, 12, 31, 14, 9, 8, 27, 26, 5, 4, 23, 22, 17, 0);
+
+	const size_t RNDCNT = (ctx[0]->roundkeylen / 2) - 2;
+	size_t i;
+	size_t kctr;
+	__m512i x[8];
 
-		__m128i tmpi[2] = { _mm_loadu_si128((const __m128i*)((uint8_t*)input + oft)) , _mm_loadu_si128((const __m128i*)((uint8_t*)input + HLFBLK + oft)) };
+	/* the 16 blocks may belong to 16 sessions, each vector loads the keys of its two states;
+	the states must share a cipher type */
+	kctr = 0;
 
-		tmpo[0] = _mm_xor_si128(tmpo[0], tmpi[0]);
-		tmpo[1] = _mm_xor_si128(tmpo[1], tmpi[1]);
+	for (i = 0; i < 8; ++i)
+	{
+		x[i] = _mm512_xor_si512(input[i], rcs_load_roundkey512x2(ctx[i * 2], ctx[(i * 2) + 1], kctr));
+	}
 
-		qsc_intutils_le8increment(ctx->nonce, QSC_RCS_BLOCK_SIZE);
+	while (kctr < RNDCNT)
+	{
+		++kctr;
 
-		/* store in output */
-		_mm_storeu_si128((__m128i*)((uint8_t*)output + oft), tmpo[0]);
-		_mm_storeu_si128((__m128i*)((uint8_t*)output + HLFBLK + oft), tmpo[1]);
+		for (i = 0; i < 8; ++i)
+		{
+			x[i] = rcs_shuffle512(&x[i], &NI512K0, &NI512K1, &SWMASKL);
+			x[i] = _mm512_aesenc_epi128(x[i], rcs_load_roundkey512x2(ctx[i * 2], ctx[(i * 2) + 1], kctr));
+		}
+	}
 
-		length -= QSC_RCS_BLOCK_SIZE;
-		oft += QSC_RCS_BLOCK_SIZE;
+	++kctr;
+
+	for (i = 0; i < 8; ++i)
+	{
+		x[i] = rcs_shuffle512(&x[i], &NI512K0, &NI512K1, &SWMASKL);
+		output[i] = _mm512_aesenclast_epi128(x[i], rcs_load_roundkey512x2(ctx[i * 2], ctx[(i * 2) + 1], kctr));
 	}
+}
 
-	if (length != 0)
+RCS_TARGET_AESNI
+static void rcs_ctr_transform_aesni(qsc_rcs_state* ctx, uint8_t* output, const uint8_t* input, size_t length)
+{
+	assert(ctx != NULL);
+	assert(input != NULL);
+	assert(output != NULL);
+
+	const size_t HLFBLK = QSC_RCS_BLOCK_SIZE / 2;
+	uint64_t ctrlo;
+	size_t i;
+	size_t oft;
+
+	oft = 0;
+	/* the parallel paths keep the counter in registers and add to its low 64 bits;
+	a run that would carry out of them is left to the single block path, which increments the whole nonce */
+	ctrlo = qsc_intutils_le8to64(ctx->nonce);
+
+	if (length >= RCS_PARALLEL4_BLOCK && UINT64_MAX - ctrlo >= (length / QSC_RCS_BLOCK_SIZE))
 	{
-		__m128i tmpn[2] = { _mm_loadu_si128((const __m128i*)ctx->nonce), _mm_loadu_si128((const __m128i*)((uint8_t*)ctx->nonce + HLFBLK)) };
+		__m128i ctrl;
+		__m128i ctrh;
+		__m128i otp[16];
+		__m128i ctrv[16];
+
+		ctrl = _mm_loadu_si128((const __m128i*)ctx->nonce);
+		ctrh = _mm_loadu_si128((const __m128i*)(ctx->nonce + HLFBLK));
+
+		/* process 8 blocks in parallel */
+		while (length >= RCS_PARALLEL8_BLOCK)
+		{
+			for (i = 0; i < 16; i += 2)
+			{
+				ctrv[i] = _mm_add_epi64(ctrl, _mm_set_epi64x(0, (int64_t)(i / 2)));
+				ctrv[i + 1] = ctrh;
+			}
+
+			rcs_transform_256x8(ctx, otp, ctrv);
+
+			for (i = 0; i < 16; ++i)
+			{
+				otp[i] = _mm_xor_si128(otp[i], _mm_loadu_si128((const __m128i*)(input + oft + (i * HLFBLK))));
+				_mm_storeu_si128((__m128i*)(output + oft + (i * HLFBLK)), otp[i]);
+			}
+
+			ctrl = _mm_add_epi64(ctrl, _mm_set_epi64x(0, 8));
+			ctrlo += 8;
+			oft += RCS_PARALLEL8_BLOCK;
+			length -= RCS_PARALLEL8_BLOCK;
+		}
+
+		/* process the remaining run of 4 blocks */
+		if (length >= RCS_PARALLEL4_BLOCK)
+		{
+			for (i = 0; i < 8; i += 2)
+			{
+				ctrv[i] = _mm_add_epi64(ctrl, _mm_set_epi64x(0, (int64_t)(i / 2)));
+				ctrv[i + 1] = ctrh;
+			}
+
+			rcs_transform_256x4(ctx, otp, ctrv);
+
+			for (i = 0; i < 8; ++i)
+			{
+				otp[i] = _mm_xor_si128(otp[i], _mm_loadu_si128((const __m128i*)(input + oft + (i * HLFBLK))));
+				_mm_storeu_si128((__m128i*)(output + oft + (i * HLFBLK)), otp[i]);
+			}
+
+			ctrlo += 4;
+			oft += RCS_PARALLEL4_BLOCK;
+			length -= RCS_PARALLEL4_BLOCK;
+		}
+
+		qsc_intutils_le64to8(ctx->nonce, ctrlo);
+	}
+
+	while (length >= QSC_RCS_BLOCK_SIZE)
+	{
+		__m128i tmpn[2] = { _mm_loadu_si128((const __m128i*)ctx->nonce), _mm_loadu_si128((const __m128i*)((uint8_t*)ctx->nonce + HLFBLK)) };
+		__m128i tmpo[2] = { 0 };
+
+		rcs_transform_256(ctx, tmpo, tmpn);
+
+		__m128i tmpi[2] = { _mm_loadu_si128((const __m128i*)((uint8_t*)input + oft)) , _mm_loadu_si128((const __m128i*)((uint8_t*)input + HLFBLK + oft)) };
+
+		tmpo[0] = _mm_xor_si128(tmpo[0], tmpi[0]);
+		tmpo[1] = _mm_xor_si128(tmpo[1], tmpi[1]);
+
+		qsc_intutils_le8increment(ctx->nonce, QSC_RCS_BLOCK_SIZE);
+
+		/* store in output */
+		_mm_storeu_si128((__m128i*)((uint8_t*)output + oft), tmpo[0]);
+		_mm_storeu_si128((__m128i*)((uint8_t*)output + HLFBLK + oft), tmpo[1]);
+
+		length -= QSC_RCS_BLOCK_SIZE;
+		oft += QSC_RCS_BLOCK_SIZE;
+	}
+
+	if (length != 0)
+	{
+		__m128i tmpn[2] = { _mm_loadu_si128((const __m128i*)ctx->nonce), _mm_loadu_si128((const __m128i*)((uint8_t*)ctx->nonce + HLFBLK)) };
 		__m128i tmpo[2] = { 0 };
 		uint8_t tmpb[QSC_RCS_BLOCK_SIZE] = { 0 };
 
-		rcs_transform_256(ctx, tmpo, tmpn);
+		rcs_transform_256(ctx, tmpo, tmpn);
+
+		/* store in tmp */
+		_mm_storeu_si128((__m128i*)tmpb, tmpo[0]);
+		_mm_storeu_si128((__m128i*)((uint8_t*)tmpb + HLFBLK), tmpo[1]);
+
+		for (i = 0; i < length; ++i)
+		{
+			output[oft + i] = tmpb[i] ^ input[oft + i];
+		}
+
+		qsc_intutils_le8increment(ctx->nonce, QSC_RCS_BLOCK_SIZE);
+		qsc_memutils_clear(tmpb, sizeof(tmpb));
+	}
+}
+
+RCS_TARGET_VAES
+static void rcs_ctr_transform_vaes(qsc_rcs_state* ctx, uint8_t* output, const uint8_t* input, size_t length)
+{
+	assert(ctx != NULL);
+	assert(input != NULL);
+	assert(output != NULL);
+
+	uint64_t ctrlo;
+	size_t i;
+	size_t oft;
+
+	oft = 0;
+	ctrlo = qsc_intutils_le8to64(ctx->nonce);
+
+	if (length >= RCS_PARALLEL4_BLOCK && UINT64_MAX - ctrlo >= (length / QSC_RCS_BLOCK_SIZE))
+	{
+		__m256i ctrw;
+		__m256i otpw[8];
+		__m256i ctrv[8];
+
+		ctrw = _mm256_loadu_si256((const __m256i*)ctx->nonce);
+
+		/* process 8 blocks in parallel, one block to a vector */
+		while (length >= RCS_PARALLEL8_BLOCK)
+		{
+			for (i = 0; i < 8; ++i)
+			{
+				ctrv[i] = _mm256_add_epi64(ctrw, _mm256_set_epi64x(0, 0, 0, (int64_t)i));
+			}
+
+			rcs_transform_256w8(ctx, otpw, ctrv);
+
+			for (i = 0; i < 8; ++i)
+			{
+				otpw[i] = _mm256_xor_si256(otpw[i], _mm256_loadu_si256((const __m256i*)(input + oft + (i * QSC_RCS_BLOCK_SIZE))));
+				_mm256_storeu_si256((__m256i*)(output + oft + (i * QSC_RCS_BLOCK_SIZE)), otpw[i]);
+			}
+
+			ctrw = _mm256_add_epi64(ctrw, _mm256_set_epi64x(0, 0, 0, 8));
+			ctrlo += 8;
+			oft += RCS_PARALLEL8_BLOCK;
+			length -= RCS_PARALLEL8_BLOCK;
+		}
+
+		qsc_intutils_le64to8(ctx->nonce, ctrlo);
+	}
+
+	/* the remaining blocks are processed by the aes-ni kernel */
+	rcs_ctr_transform_aesni(ctx, output + oft, input + oft, length);
+}
+
+RCS_TARGET_AVX512
+static void rcs_ctr_transform_avx512(qsc_rcs_state* ctx, uint8_t* output, const uint8_t* input, size_t length)
+{
+	assert(ctx != NULL);
+	assert(input != NULL);
+	assert(output != NULL);
+
+	uint64_t ctrlo;
+	size_t i;
+	size_t oft;
+
+	oft = 0;
+	ctrlo = qsc_intutils_le8to64(ctx->nonce);
+
+	if (length >= RCS_AVX512_BLOCK && UINT64_MAX - ctrlo >= (length / QSC_RCS_BLOCK_SIZE))
+	{
+		__m512i ctrw;
+		__m512i otpw[8];
+		__m512i ctrv[8];
+
+		/* two copies of the nonce, the second is one block ahead */
+		ctrw = _mm512_broadcast_i64x4(_mm256_loadu_si256((const __m256i*)ctx->nonce));
+		ctrw = _mm512_add_epi64(ctrw, _mm512_set_epi64(0, 0, 0, 1, 0, 0, 0, 0));
+
+		/* process 16 blocks in parallel */
+		while (length >= RCS_AVX512_BLOCK * 8)
+		{
+			for (i = 0; i < 8; ++i)
+			{
+				ctrv[i] = _mm512_add_epi64(ctrw, _mm512_set_epi64(0, 0, 0, (int64_t)(i * 2), 0, 0, 0, (int64_t)(i * 2)));
+			}
+
+			rcs_transform_512x8(ctx, otpw, ctrv);
+
+			for (i = 0; i < 8; ++i)
+			{
+				otpw[i] = _mm512_xor_si512(otpw[i], _mm512_loadu_si512((const __m512i*)(input + oft + (i * RCS_AVX512_BLOCK))));
+				_mm512_storeu_si512((__m512i*)(output + oft + (i * RCS_AVX512_BLOCK)), otpw[i]);
+			}
+
+			ctrw = _mm512_add_epi64(ctrw, _mm512_set_epi64(0, 0, 0, 16, 0, 0, 0, 16));
+			ctrlo += 16;
+			oft += RCS_AVX512_BLOCK * 8;
+			length -= RCS_AVX512_BLOCK * 8;
+		}
+
+		/* process 2 blocks in parallel */
+		while (length >= RCS_AVX512_BLOCK)
+		{
+			rcs_transform_512(ctx, &otpw[0], &ctrw);
+			otpw[0] = _mm512_xor_si512(otpw[0], _mm512_loadu_si512((const __m512i*)(input + oft)));
+			_mm512_storeu_si512((__m512i*)(output + oft), otpw[0]);
+
+			ctrw = _mm512_add_epi64(ctrw, _mm512_set_epi64(0, 0, 0, 2, 0, 0, 0, 2));
+			ctrlo += 2;
+			oft += RCS_AVX512_BLOCK;
+			length -= RCS_AVX512_BLOCK;
+		}
+
+		/* store the last position of the nonce */
+		qsc_intutils_le64to8(ctx->nonce, ctrlo);
+	}
+
+	/* the remaining blocks are processed by the aes-ni kernel */
+	rcs_ctr_transform_aesni(ctx, output + oft, input + oft, length);
+}
+
+typedef struct
+{
+	const qsc_rcs_state* ctx[RCS_MULTI_BATCH];
+	const uint8_t* input[RCS_MULTI_BATCH];
+	uint8_t* output[RCS_MULTI_BATCH];
+	size_t length[RCS_MULTI_BATCH];
+	__m256i nonce[RCS_MULTI_BATCH];
+	size_t count;
+} rcs_multi_jobs;
+
+RCS_TARGET_AVX512
+static void rcs_multi_jobs_flush(rcs_multi_jobs* jobs)
+{
+	__m512i ctrv[8];
+	__m512i otpw[8];
+	__m256i otp;
+	uint8_t tmpb[QSC_RCS_BLOCK_SIZE] = { 0 };
+	size_t i;
+	size_t j;
+
+	/* unused lanes repeat the first job, and their output is discarded */
+	for (i = jobs->count; i < RCS_MULTI_BATCH; ++i)
+	{
+		jobs->ctx[i] = jobs->ctx[0];
+		jobs->nonce[i] = jobs->nonce[0];
+	}
+
+	for (i = 0; i < 8; ++i)
+	{
+		ctrv[i] = _mm512_inserti64x4(_mm512_castsi256_si512(jobs->nonce[i * 2]), jobs->nonce[(i * 2) + 1], 1);
+	}
+
+	rcs_transform_512x8_multi(jobs->ctx, otpw, ctrv);
+
+	for (i = 0; i < jobs->count; ++i)
+	{
+		otp = ((i & 1) == 0) ? _mm512_castsi512_si256(otpw[i / 2]) : _mm512_extracti64x4_epi64(otpw[i / 2], 1);
+
+		if (jobs->length[i] == QSC_RCS_BLOCK_SIZE)
+		{
+			otp = _mm256_xor_si256(otp, _mm256_loadu_si256((const __m256i*)jobs->input[i]));
+			_mm256_storeu_si256((__m256i*)jobs->output[i], otp);
+		}
+		else
+		{
+			_mm256_storeu_si256((__m256i*)tmpb, otp);
+
+			for (j = 0; j < jobs->length[i]; ++j)
+			{
+				jobs->output[i][j] = tmpb[j] ^ jobs->input[i][j];
+			}
+		}
+	}
+
+	qsc_memutils_clear(tmpb, sizeof(tmpb));
+	jobs->count = 0;
+}
+
+RCS_TARGET_AVX512
+static void rcs_ctr_transform_multi_avx512(qsc_rcs_state* ctx[], uint8_t* output[], const uint8_t* input[], const size_t length[], size_t count)
+{
+	rcs_multi_jobs jobs;
+	__m256i ctrw;
+	uint64_t ctrlo;
+	size_t blks;
+	size_t i;
+	size_t j;
+	size_t oft;
+
+	/* the counter blocks of every session are gathered into batches of 16, keyed block by block */
+	jobs.count = 0;
+
+	for (i = 0; i < count; ++i)
+	{
+		blks = (length[i] + QSC_RCS_BLOCK_SIZE - 1) / QSC_RCS_BLOCK_SIZE;
+		ctrlo = qsc_intutils_le8to64(ctx[i]->nonce);
+
+		if (UINT64_MAX - ctrlo < blks)
+		{
+			/* a run that would carry out of the low counter word is left to the single session kernel */
+			rcs_ctr_transform_avx512(ctx[i], output[i], input[i], length[i]);
+		}
+		else
+		{
+			ctrw = _mm256_loadu_si256((const __m256i*)ctx[i]->nonce);
+
+			for (j = 0; j < blks; ++j)
+			{
+				if (jobs.count != 0 && jobs.ctx[0]->roundkeylen != ctx[i]->roundkeylen)
+				{
+					rcs_multi_jobs_flush(&jobs);
+				}
+
+				oft = j * QSC_RCS_BLOCK_SIZE;
+				jobs.ctx[jobs.count] = ctx[i];
+				jobs.input[jobs.count] = input[i] + oft;
+				jobs.output[jobs.count] = output[i] + oft;
+				jobs.length[jobs.count] = (length[i] - oft < QSC_RCS_BLOCK_SIZE) ? length[i] - oft : QSC_RCS_BLOCK_SIZE;
+				jobs.nonce[jobs.count] = _mm256_add_epi64(ctrw, _mm256_set_epi64x(0, 0, 0, (int64_t)j));
+				++jobs.count;
+
+				if (jobs.count == RCS_MULTI_BATCH)
+				{
+					rcs_multi_jobs_flush(&jobs);
+				}
+			}
+
+			qsc_intutils_le64to8(ctx[i]->nonce, ctrlo + blks);
+		}
+	}
+
+	if (jobs.count != 0)
+	{
+		rcs_multi_jobs_flush(&jobs);
+	}
+}
+
+#endif
+
+/* kernel dispatch */
+
+typedef struct rcs_kernel_entry
+{
+	void (*transform)(qsc_rcs_state*, uint8_t*, const uint8_t*, size_t);
+	qsc_rcs_kernels type;
+} rcs_kernel_entry;
+
+static const rcs_kernel_entry rcs_kernel_portable_entry = { &rcs_ctr_transform_bitslice, qsc_rcs_kernel_portable };
+#if defined(QSC_RCS_AESNI_ENABLED)
+static const rcs_kernel_entry rcs_kernel_aesni_entry = { &rcs_ctr_transform_aesni, qsc_rcs_kernel_aesni };
+static const rcs_kernel_entry rcs_kernel_vaes_entry = { &rcs_ctr_transform_vaes, qsc_rcs_kernel_vaes };
+static const rcs_kernel_entry rcs_kernel_avx512_entry = { &rcs_ctr_transform_avx512, qsc_rcs_kernel_avx512 };
+#endif
+
+/* the selected kernel, published once with release ordering */
+static const rcs_kernel_entry* volatile rcs_kernel_selected = NULL;
+
+static const rcs_kernel_entry* rcs_kernel_select(void)
+{
+	const rcs_kernel_entry* pknl;
+
+	pknl = &rcs_kernel_portable_entry;
+
+#if defined(QSC_RCS_AESNI_ENABLED)
+	qsc_cpuidex_cpu_features cfeat;
+
+	qsc_cpuidex_features_set(&cfeat);
+
+	if (cfeat.avx512f == true && cfeat.avx512bw == true && cfeat.vaes == true)
+	{
+		pknl = &rcs_kernel_avx512_entry;
+	}
+	else if (cfeat.avx2 == true && cfeat.vaes == true)
+	{
+		pknl = &rcs_kernel_vaes_entry;
+	}
+	else if (cfeat.aesni == true)
+	{
+		pknl = &rcs_kernel_aesni_entry;
+	}
+#endif
+
+	return pknl;
+}
+
+static const rcs_kernel_entry* rcs_kernel_get(void)
+{
+	const rcs_kernel_entry* pknl;
+
+	pknl = (const rcs_kernel_entry*)qsc_async_atomic_load_pointer((void* volatile*)&rcs_kernel_selected);
+
+	if (pknl == NULL)
+	{
+		/* concurrent first calls select the same constant entry, the kernel and its type are published together */
+		pknl = rcs_kernel_select();
+		qsc_async_atomic_store_pointer((void* volatile*)&rcs_kernel_selected, (void*)pknl);
+	}
+
+	return pknl;
+}
+
+static void rcs_ctr_transform(qsc_rcs_state* ctx, uint8_t* output, const uint8_t* input, size_t length)
+{
+	rcs_kernel_get()->transform(ctx, output, input, length);
+}
+
+static void rcs_ctr_transform_multi(qsc_rcs_state* ctx[], uint8_t* output[], const uint8_t* input[], const size_t length[], size_t count)
+{
+	const rcs_kernel_entry* pknl;
+
+	pknl = rcs_kernel_get();
+
+#if defined(QSC_RCS_AESNI_ENABLED)
+	if (pknl->type == qsc_rcs_kernel_avx512)
+	{
+		rcs_ctr_transform_multi_avx512(ctx, output, input, length, count);
+	}
+	else
+#endif
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			pknl->transform(ctx[i], output[i], input[i], length[i]);
+		}
+	}
+}
+
+static void rcs_mac_finalize(qsc_rcs_state* ctx, uint8_t* output)
+{
+	uint8_t ctr[sizeof(uint64_t)] = { 0 };
+	uint64_t mctr = QSC_RCS_BLOCK_SIZE + ctx->counter + sizeof(uint64_t);
+
+	qsc_intutils_le64to8(ctr, mctr);
+
+	if (ctx->ctype == qsc_rcs_cipher_256)
+	{
+#if defined(QSC_RCS_KMACR12)
+		/* update the counter */
+		qsc_keccak_update(&ctx->kstate, qsc_keccak_rate_256, ctr, sizeof(ctr), QSC_KECCAK_PERMUTATION_MIN_ROUNDS);
+		/* finalize the mac and append code to output */
+		qsc_keccak_finalize(&ctx->kstate, qsc_keccak_rate_256, output, QSC_RCS_256_MAC_SIZE, QSC_KECCAK_KMAC_DOMAIN_ID, QSC_KECCAK_PERMUTATION_MIN_ROUNDS);
+#else
+		/* update the counter */
+		qsc_kmac_update(&ctx->kstate, qsc_keccak_rate_256, ctr, sizeof(ctr));
+		/* finalize the mac and append code to output */
+		qsc_kmac_finalize(&ctx->kstate, qsc_keccak_rate_256, output, QSC_RCS_256_MAC_SIZE);
+#endif
+	}
+	else
+	{
+#if defined(QSC_RCS_KMACR12)
+		qsc_keccak_update(&ctx->kstate, qsc_keccak_rate_512, ctr, sizeof(ctr), QSC_KECCAK_PERMUTATION_MIN_ROUNDS);
+		qsc_keccak_finalize(&ctx->kstate, qsc_keccak_rate_512, output, QSC_RCS_512_MAC_SIZE, QSC_KECCAK_KMAC_DOMAIN_ID, QSC_KECCAK_PERMUTATION_MIN_ROUNDS);
+#else
+		qsc_kmac_update(&ctx->kstate, qsc_keccak_rate_512, ctr, sizeof(ctr));
+		qsc_kmac_finalize(&ctx->kstate, qsc_keccak_rate_512, output, QSC_RCS_512_MAC_SIZE);
+#endif
+	}
+}
+
+static void rcs_mac_update(qsc_rcs_state* ctx, const uint8_t* input, size_t length)
+{
+	if (ctx->ctype == qsc_rcs_cipher_256)
+	{
+#if defined(QSC_RCS_KMACR12)
+		qsc_keccak_update(&ctx->kstate, qsc_keccak_rate_256, input, length, QSC_KECCAK_PERMUTATION_MIN_ROUNDS);
+#else
+		qsc_kmac_update(&ctx->kstate, qsc_keccak_rate_256, input, length);
+#endif
+	}
+	else
+	{
+#if defined(QSC_RCS_KMACR12)
+		qsc_keccak_update(&ctx->kstate, qsc_keccak_rate_512, input, length, QSC_KECCAK_PERMUTATION_MIN_ROUNDS);
+#else
+		qsc_kmac_update(&ctx->kstate, qsc_keccak_rate_512, input, length);
+#endif
+	}
+}
+
+#if defined(RCS_MAC_LANES)
+
+/* the lanes permute with the round count of qsc_keccak_permute, which is fixed when the permutation is unrolled */
+#if defined(QSC_RCS_KMACR12) && !defined(QSC_KECCAK_UNROLLED_PERMUTATION)
+#	define RCS_MAC_ROUNDS QSC_KECCAK_PERMUTATION_MIN_ROUNDS
+#else
+#	define RCS_MAC_ROUNDS QSC_KECCAK_PERMUTATION_ROUNDS
+#endif
+
+static const uint64_t rcs_mac_round_constants[QSC_KECCAK_PERMUTATION_MAX_ROUNDS] =
+{
+	0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL, 0x8000000080008000ULL,
+	0x000000000000808BULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+	0x000000000000008AULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+	0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+	0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800AULL, 0x800000008000000AULL,
+	0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+/* the rho rotations and pi lane order, walked from lane 1 */
+static const uint8_t rcs_mac_rho[24] = { 1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44 };
+static const uint8_t rcs_mac_pi[24] = { 10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1 };
+
+static void rcs_mac_stream_read(const uint8_t* const seg[3], const size_t seglen[3], size_t offset, uint8_t* output, size_t length)
+{
+	size_t clen;
+
+	/* copy a range of the concatenated mac input segments */
+	for (size_t i = 0; i < 3 && length != 0; ++i)
+	{
+		if (offset >= seglen[i])
+		{
+			offset -= seglen[i];
+		}
+		else
+		{
+			clen = (seglen[i] - offset < length) ? seglen[i] - offset : length;
+			qsc_memutils_copy(output, seg[i] + offset, clen);
+			output += clen;
+			length -= clen;
+			offset = 0;
+		}
+	}
+}
+
+RCS_TARGET_MACX4
+static __m256i rcs_mac_rotl_x4(__m256i x, int shift)
+{
+	return _mm256_or_si256(_mm256_sll_epi64(x, _mm_cvtsi32_si128(shift)), _mm256_srl_epi64(x, _mm_cvtsi32_si128(64 - shift)));
+}
+
+RCS_TARGET_MACX4
+static void rcs_mac_permute_x4(uint64_t state[RCS_MAC_LANES][QSC_KECCAK_STATE_SIZE])
+{
+	__m256i a[QSC_KECCAK_STATE_SIZE];
+	__m256i c[5];
+	__m256i d;
+	__m256i t;
+	__m256i u;
+	uint64_t tmpw[4];
+	size_t i;
+	size_t j;
+
+	for (i = 0; i < QSC_KECCAK_STATE_SIZE; ++i)
+	{
+		a[i] = _mm256_set_epi64x((int64_t)state[3][i], (int64_t)state[2][i], (int64_t)state[1][i], (int64_t)state[0][i]);
+	}
+
+	for (size_t r = 0; r < RCS_MAC_ROUNDS; ++r)
+	{
+		/* theta */
+		for (i = 0; i < 5; ++i)
+		{
+			c[i] = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[i], a[i + 5]), _mm256_xor_si256(a[i + 10], a[i + 15])), a[i + 20]);
+		}
+
+		for (i = 0; i < 5; ++i)
+		{
+			d = _mm256_xor_si256(c[(i + 4) % 5], rcs_mac_rotl_x4(c[(i + 1) % 5], 1));
+
+			for (j = 0; j < QSC_KECCAK_STATE_SIZE; j += 5)
+			{
+				a[j + i] = _mm256_xor_si256(a[j + i], d);
+			}
+		}
+
+		/* rho and pi */
+		t = a[1];
+
+		for (i = 0; i < 24; ++i)
+		{
+			u = a[rcs_mac_pi[i]];
+			a[rcs_mac_pi[i]] = rcs_mac_rotl_x4(t, rcs_mac_rho[i]);
+			t = u;
+		}
+
+		/* chi */
+		for (j = 0; j < QSC_KECCAK_STATE_SIZE; j += 5)
+		{
+			for (i = 0; i < 5; ++i)
+			{
+				c[i] = a[j + i];
+			}
+
+			for (i = 0; i < 5; ++i)
+			{
+				a[j + i] = _mm256_xor_si256(c[i], _mm256_andnot_si256(c[(i + 1) % 5], c[(i + 2) % 5]));
+			}
+		}
+
+		/* iota */
+		a[0] = _mm256_xor_si256(a[0], _mm256_set1_epi64x((int64_t)rcs_mac_round_constants[r]));
+	}
 
-		/* store in tmp */
-		_mm_storeu_si128((__m128i*)tmpb, tmpo[0]);
-		_mm_storeu_si128((__m128i*)((uint8_t*)tmpb + HLFBLK), tmpo[1]);
+	for (i = 0; i < QSC_KECCAK_STATE_SIZE; ++i)
+	{
+		_mm256_storeu_si256((__m256i*)tmpw, a[i]);
 
-		for (i = 0; i < length; ++i)
+		for (j = 0; j < 4; ++j)
 		{
-			output[oft + i] = tmpb[i] ^ input[oft + i];
+			state[j][i] = tmpw[j];
 		}
-
-		qsc_intutils_le8increment(ctx->nonce, QSC_RCS_BLOCK_SIZE);
 	}
 }
 
-#else
-
-/* rijndael rcs_rcon, and s-box constant tables */
-
-static const uint8_t rcs_sbox[RCS_SBOX_SIZE] =
-{
-	0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
-	0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
-	0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
-	0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
-	0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
-	0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
-	0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
-	0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
-	0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
-	0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
-	0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
-	0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
-	0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
-	0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
-	0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
-	0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
-};
-
-static void rcs_add_roundkey(uint8_t* state, const uint32_t *skeys)
+RCS_TARGET_MACX8
+static void rcs_mac_permute_x8(uint64_t state[RCS_MAC_LANES][QSC_KECCAK_STATE_SIZE])
 {
-	uint32_t k;
+	__m512i a[QSC_KECCAK_STATE_SIZE];
+	__m512i c[5];
+	__m512i d;
+	__m512i t;
+	__m512i u;
+	uint64_t tmpw[8];
+	size_t i;
+	size_t j;
 
-	for (size_t i = 0; i < QSC_RCS_BLOCK_SIZE; i += sizeof(uint32_t))
+	for (i = 0; i < QSC_KECCAK_STATE_SIZE; ++i)
 	{
-		k = *skeys;
-		state[i] ^= (uint8_t)(k >> 24);
-		state[i + 1] ^= (uint8_t)(k >> 16) & 0xFFU;
-		state[i + 2] ^= (uint8_t)(k >> 8) & 0xFFU;
-		state[i + 3] ^= (uint8_t)k & 0xFFU;
-		++skeys;
+		a[i] = _mm512_set_epi64((int64_t)state[7][i], (int64_t)state[6][i], (int64_t)state[5][i], (int64_t)state[4][i],
+			(int64_t)state[3][i], (int64_t)state[2][i], (int64_t)state[1][i], (int64_t)state[0][i]);
 	}
-}
-
-static void rcs_mix_columns(uint8_t* state)
-{
-	uint32_t s0;
-	uint32_t s1;
-	uint32_t s2;
-	uint32_t s3;
-	uint32_t t0;
-	uint32_t t1;
-	uint32_t t2;
-	uint32_t t3;
 
-	for (size_t i = 0; i < QSC_RCS_BLOCK_SIZE; i += sizeof(uint32_t))
+	for (size_t r = 0; r < RCS_MAC_ROUNDS; ++r)
 	{
-		s0 = state[i];
-		s1 = state[i + 1];
-		s2 = state[i + 2];
-		s3 = state[i + 3];
+		/* theta */
+		for (i = 0; i < 5; ++i)
+		{
+			c[i] = _mm512_xor_si512(_mm512_xor_si512(_mm512_xor_si512(a[i], a[i + 5]), _mm512_xor_si512(a[i + 10], a[i + 15])), a[i + 20]);
+		}
 
-		t0 = (s0 << 1) ^ s1 ^ (s1 << 1) ^ s2 ^ s3;
-		t1 = s0 ^ (s1 << 1) ^ s2 ^ (s2 << 1) ^ s3;
-		t2 = s0 ^ s1 ^ (s2 << 1) ^ s3 ^ (s3 << 1);
-		t3 = s0 ^ (s0 << 1) ^ s1 ^ s2 ^ (s3 << 1);
+		for (i = 0; i < 5; ++i)
+		{
+			d = _mm512_xor_si512(c[(i + 4) % 5], _mm512_rolv_epi64(c[(i + 1) % 5], _mm512_set1_epi64(1)));
 
-		state[i] = (uint8_t)(t0 ^ ((~(t0 >> 8) + 1) & 0x0000011BUL));
-		state[i + 1] = (uint8_t)(t1 ^ ((~(t1 >> 8) + 1) & 0x0000011BUL));
-		state[i + 2] = (uint8_t)(t2 ^ ((~(t2 >> 8) + 1) & 0x0000011BUL));
-		state[i + 3] = (uint8_t)(t3 ^ ((~(t3 >> 8) + 1) & 0x0000011BUL));
-	}
-}
+			for (j = 0; j < QSC_KECCAK_STATE_SIZE; j += 5)
+			{
+				a[j + i] = _mm512_xor_si512(a[j + i], d);
+			}
+		}
 
-static void rcs_prefetch_sbox()
-{
-#if defined(QSC_SYSTEM_HAS_AVX)
-	qsc_memutils_prefetch_l1((uint8_t*)rcs_sbox, RCS_SBOX_SIZE);
-#else
-	size_t i;
-	volatile uint32_t dmy;
+		/* rho and pi */
+		t = a[1];
+
+		for (i = 0; i < 24; ++i)
+		{
+			u = a[rcs_mac_pi[i]];
+			a[rcs_mac_pi[i]] = _mm512_rolv_epi64(t, _mm512_set1_epi64(rcs_mac_rho[i]));
+			t = u;
+		}
+
+		/* chi */
+		for (j = 0; j < QSC_KECCAK_STATE_SIZE; j += 5)
+		{
+			for (i = 0; i < 5; ++i)
+			{
+				c[i] = a[j + i];
+			}
+
+			for (i = 0; i < 5; ++i)
+			{
+				a[j + i] = _mm512_xor_si512(c[i], _mm512_andnot_si512(c[(i + 1) % 5], c[(i + 2) % 5]));
+			}
+		}
 
-	dmy = 0;
+		/* iota */
+		a[0] = _mm512_xor_si512(a[0], _mm512_set1_epi64((int64_t)rcs_mac_round_constants[r]));
+	}
 
-	for (i = 0; i < 256; ++i)
+	for (i = 0; i < QSC_KECCAK_STATE_SIZE; ++i)
 	{
-		dmy |= rcs_sbox[i];
+		_mm512_storeu_si512((__m512i*)tmpw, a[i]);
+
+		for (j = 0; j < 8; ++j)
+		{
+			state[j][i] = tmpw[j];
+		}
 	}
-#endif
 }
 
-static void rcs_shift_rows(uint8_t* state)
-{
-	uint8_t tmp;
-
-	tmp = state[1];
-	state[1] = state[5];
-	state[5] = state[9];
-	state[9] = state[13];
-	state[13] = state[17];
-	state[17] = state[21];
-	state[21] = state[25];
-	state[25] = state[29];
-	state[29] = tmp;
+/* mac lane dispatch */
 
-	tmp = state[2];
-	state[2] = state[14];
-	state[14] = state[26];
-	state[26] = state[6];
-	state[6] = state[18];
-	state[18] = state[30];
-	state[30] = state[10];
-	state[10] = state[22];
-	state[22] = tmp;
+typedef struct rcs_mac_lane_entry
+{
+	void (*permute)(uint64_t state[RCS_MAC_LANES][QSC_KECCAK_STATE_SIZE]);
+	size_t lanes;
+} rcs_mac_lane_entry;
 
-	tmp = state[3];
-	state[3] = state[19];
-	state[19] = tmp;
+static const rcs_mac_lane_entry rcs_mac_lane_scalar_entry = { NULL, 1 };
+static const rcs_mac_lane_entry rcs_mac_lane_x4_entry = { &rcs_mac_permute_x4, 4 };
+static const rcs_mac_lane_entry rcs_mac_lane_x8_entry = { &rcs_mac_permute_x8, 8 };
 
-	tmp = state[7];
-	state[7] = state[23];
-	state[23] = tmp;
+/* the selected lane width, published once with release ordering */
+static const rcs_mac_lane_entry* volatile rcs_mac_lane_selected = NULL;
 
-	tmp = state[11];
-	state[11] = state[27];
-	state[27] = tmp;
+static const rcs_mac_lane_entry* rcs_mac_lane_select(void)
+{
+	qsc_cpuidex_cpu_features cfeat;
+	const rcs_mac_lane_entry* plne;
 
-	tmp = state[15];
-	state[15] = state[31];
-	state[31] = tmp;
-}
+	qsc_cpuidex_features_set(&cfeat);
 
-static void rcs_sub_bytes(uint8_t* state, const uint8_t* sbox)
-{
-	for (size_t i = 0; i < QSC_RCS_BLOCK_SIZE; ++i)
+	/* the widest lane permutation the processor supports, otherwise the sessions are authenticated one at a time */
+	if (cfeat.avx512f == true)
+	{
+		plne = &rcs_mac_lane_x8_entry;
+	}
+	else if (cfeat.avx2 == true)
+	{
+		plne = &rcs_mac_lane_x4_entry;
+	}
+	else
 	{
-		state[i] = sbox[state[i]];
+		plne = &rcs_mac_lane_scalar_entry;
 	}
+
+	return plne;
 }
 
-static void rcs_transform_256(const qsc_rcs_state* ctx, uint8_t* output, const uint8_t* input)
+static const rcs_mac_lane_entry* rcs_mac_lane_get(void)
 {
-	uint8_t buf[QSC_RCS_BLOCK_SIZE];
+	const rcs_mac_lane_entry* plne;
 
-	qsc_memutils_copy(buf, input, QSC_RCS_BLOCK_SIZE);
-	rcs_add_roundkey(buf, ctx->roundkeys);
-	rcs_prefetch_sbox();
+	plne = (const rcs_mac_lane_entry*)qsc_async_atomic_load_pointer((void* volatile*)&rcs_mac_lane_selected);
 
-	for (size_t i = 1; i < ctx->rounds; ++i)
+	if (plne == NULL)
 	{
-		rcs_sub_bytes(buf, rcs_sbox);
-		rcs_shift_rows(buf);
-		rcs_mix_columns(buf);
-		rcs_add_roundkey(buf, ctx->roundkeys + (i << 3));
+		plne = rcs_mac_lane_select();
+		qsc_async_atomic_store_pointer((void* volatile*)&rcs_mac_lane_selected, (void*)plne);
 	}
 
-	rcs_sub_bytes(buf, rcs_sbox);
-	rcs_shift_rows(buf);
-	rcs_add_roundkey(buf, ctx->roundkeys + (ctx->rounds << 3));
-	qsc_memutils_copy(output, buf, QSC_RCS_BLOCK_SIZE);
+	return plne;
 }
 
-static void rcs_ctr_transform(qsc_rcs_state* ctx, uint8_t* output, const uint8_t* input, size_t length)
+static void rcs_mac_lanes(const rcs_mac_lane_entry* plne, qsc_rcs_state* ctx[], const uint8_t* nonce[], const uint8_t* data[], const size_t length[], uint8_t* code[], size_t count)
 {
-	assert(ctx != NULL);
-	assert(input != NULL);
-	assert(output != NULL);
-
-	size_t oft;
+	/* the full rate blocks of the buffered bytes, nonce, and message are absorbed in parallel, as rcs_mac_update absorbs them;
+	the tail is left in the keccak buffer, and the counter, padding, and squeeze are done by rcs_mac_finalize */
+	const size_t RATE = (ctx[0]->ctype == qsc_rcs_cipher_256) ? (size_t)qsc_keccak_rate_256 : (size_t)qsc_keccak_rate_512;
+	uint64_t state[RCS_MAC_LANES][QSC_KECCAK_STATE_SIZE] = { 0 };
+	uint8_t blk[QSC_KECCAK_STATE_BYTE_SIZE] = { 0 };
+	const uint8_t* seg[RCS_MAC_LANES][3];
+	size_t seglen[RCS_MAC_LANES][3];
+	size_t nblk[RCS_MAC_LANES];
+	size_t rmd[RCS_MAC_LANES];
+	size_t blen;
+	size_t i;
+	size_t mblk;
+	size_t t;
 
-	oft = 0;
+	mblk = 0;
 
-	while (length >= QSC_RCS_BLOCK_SIZE)
+	for (i = 0; i < count; ++i)
 	{
-		rcs_transform_256(ctx, output + oft, ctx->nonce);
-		qsc_memutils_xor(output + oft, input + oft, QSC_RCS_BLOCK_SIZE);
-		qsc_intutils_le8increment(ctx->nonce, QSC_RCS_BLOCK_SIZE);
-
-		length -= QSC_RCS_BLOCK_SIZE;
-		oft += QSC_RCS_BLOCK_SIZE;
+		seg[i][0] = ctx[i]->kstate.buffer;
+		seglen[i][0] = ctx[i]->kstate.position;
+		seg[i][1] = nonce[i];
+		seglen[i][1] = QSC_RCS_NONCE_SIZE;
+		seg[i][2] = data[i];
+		seglen[i][2] = length[i];
+
+		blen = ctx[i]->kstate.position + QSC_RCS_NONCE_SIZE + length[i];
+		nblk[i] = blen / RATE;
+		rmd[i] = blen % RATE;
+		mblk = (nblk[i] > mblk) ? nblk[i] : mblk;
+		qsc_memutils_copy((uint8_t*)state[i], (const uint8_t*)ctx[i]->kstate.state, sizeof(state[i]));
 	}
 
-	if (length != 0)
+	for (t = 0; t < mblk; ++t)
 	{
-		uint8_t tmpb[QSC_RCS_BLOCK_SIZE] = { 0 };
+		for (i = 0; i < count; ++i)
+		{
+			if (t < nblk[i])
+			{
+				rcs_mac_stream_read(seg[i], seglen[i], t * RATE, blk, RATE);
+				qsc_memutils_xor((uint8_t*)state[i], blk, RATE);
+			}
+		}
 
-		rcs_transform_256(ctx, tmpb, ctx->nonce);
+		plne->permute(state);
 
-		for (size_t i = 0; i < length; ++i)
+		for (i = 0; i < count; ++i)
 		{
-			output[oft + i] = tmpb[i] ^ input[oft + i];
+			if (t + 1 == nblk[i])
+			{
+				qsc_memutils_copy((uint8_t*)ctx[i]->kstate.state, (const uint8_t*)state[i], sizeof(state[i]));
+			}
 		}
+	}
 
-		qsc_intutils_le8increment(ctx->nonce, QSC_RCS_BLOCK_SIZE);
+	for (i = 0; i < count; ++i)
+	{
+		/* the tail is read before the buffer it may come from is overwritten */
+		rcs_mac_stream_read(seg[i], seglen[i], nblk[i] * RATE, blk, rmd[i]);
+		qsc_memutils_copy(ctx[i]->kstate.buffer, blk, rmd[i]);
+		ctx[i]->kstate.position = rmd[i];
+		rcs_mac_finalize(ctx[i], code[i]);
 	}
+
+	qsc_memutils_clear(blk, sizeof(blk));
+	qsc_memutils_clear((uint8_t*)state, sizeof(state));
 }
 
 #endif
 
-static void rcs_mac_finalize(qsc_rcs_state* ctx, uint8_t* output)
+static void rcs_mac_multi(qsc_rcs_state* ctx[], const uint8_t* nonce[], const uint8_t* data[], const size_t length[], uint8_t* code[], size_t count)
 {
-	uint8_t ctr[sizeof(uint64_t)] = { 0 };
-	uint64_t mctr = QSC_RCS_BLOCK_SIZE + ctx->counter + sizeof(uint64_t);
+#if defined(RCS_MAC_LANES)
+	const rcs_mac_lane_entry* plne;
+#endif
+	size_t i;
+	size_t n;
 
-	qsc_intutils_le64to8(ctr, mctr);
+#if defined(RCS_MAC_LANES)
+	plne = rcs_mac_lane_get();
+#endif
+	i = 0;
 
-	if (ctx->ctype == qsc_rcs_cipher_256)
+	while (i < count)
 	{
-#if defined(QSC_RCS_KMACR12)
-		/* update the counter */
-		qsc_keccak_update(&ctx->kstate, qsc_keccak_rate_256, ctr, sizeof(ctr), QSC_KECCAK_PERMUTATION_MIN_ROUNDS);
-		/* finalize the mac and append code to output */
-		qsc_keccak_finalize(&ctx->kstate, qsc_keccak_rate_256, output, QSC_RCS_256_MAC_SIZE, QSC_KECCAK_KMAC_DOMAIN_ID, QSC_KECCAK_PERMUTATION_MIN_ROUNDS);
-#else
-		/* update the counter */
-		qsc_kmac_update(&ctx->kstate, qsc_keccak_rate_256, ctr, sizeof(ctr));
-		/* finalize the mac and append code to output */
-		qsc_kmac_finalize(&ctx->kstate, qsc_keccak_rate_256, output, QSC_RCS_256_MAC_SIZE);
+		n = 1;
+
+#if defined(RCS_MAC_LANES)
+		/* a lane group shares one keccak rate */
+		while (n < plne->lanes && i + n < count && ctx[i + n]->ctype == ctx[i]->ctype)
+		{
+			++n;
+		}
+
+		if (n > 1)
+		{
+			rcs_mac_lanes(plne, ctx + i, nonce + i, data + i, length + i, code + i, n);
+		}
+		else
 #endif
+		{
+			rcs_mac_update(ctx[i], nonce[i], QSC_RCS_NONCE_SIZE);
+			rcs_mac_update(ctx[i], data[i], length[i]);
+			rcs_mac_finalize(ctx[i], code[i]);
+		}
+
+		i += n;
 	}
-	else
+}
+
+static void rcs_fused_decrypt(qsc_rcs_state* ctx, uint8_t* output, const uint8_t* input, size_t length)
+{
+	size_t clen;
+
+	/* each chunk of cipher-text is absorbed by the mac, and decrypted while it is still in the cache */
+	while (length != 0)
 	{
-#if defined(QSC_RCS_KMACR12)
-		qsc_keccak_update(&ctx->kstate, qsc_keccak_rate_512, ctr, sizeof(ctr), QSC_KECCAK_PERMUTATION_MIN_ROUNDS);
-		qsc_keccak_finalize(&ctx->kstate, qsc_keccak_rate_512, output, QSC_RCS_512_MAC_SIZE, QSC_KECCAK_KMAC_DOMAIN_ID, QSC_KECCAK_PERMUTATION_MIN_ROUNDS);
-#else
-		qsc_kmac_update(&ctx->kstate, qsc_keccak_rate_512, ctr, sizeof(ctr));
-		qsc_kmac_finalize(&ctx->kstate, qsc_keccak_rate_512, output, QSC_RCS_512_MAC_SIZE);
-#endif
+		clen = (length > RCS_FUSED_CHUNK) ? RCS_FUSED_CHUNK : length;
+		rcs_mac_update(ctx, input, clen);
+		rcs_ctr_transform(ctx, output, input, clen);
+		input += clen;
+		output += clen;
+		length -= clen;
 	}
 }
 
-static void rcs_mac_update(qsc_rcs_state* ctx, const uint8_t* input, size_t length)
+static void rcs_fused_encrypt(qsc_rcs_state* ctx, uint8_t* output, const uint8_t* input, size_t length)
 {
-	if (ctx->ctype == qsc_rcs_cipher_256)
+	size_t clen;
+
+	/* each chunk is encrypted, and the cipher-text absorbed by the mac while it is still in the cache */
+	while (length != 0)
 	{
-#if defined(QSC_RCS_KMACR12)
-		qsc_keccak_update(&ctx->kstate, qsc_keccak_rate_256, input, length, QSC_KECCAK_PERMUTATION_MIN_ROUNDS);
-#else
-		qsc_kmac_update(&ctx->kstate, qsc_keccak_rate_256, input, length);
-#endif
+		clen = (length > RCS_FUSED_CHUNK) ? RCS_FUSED_CHUNK : length;
+		rcs_ctr_transform(ctx, output, input, clen);
+		rcs_mac_update(ctx, output, clen);
+		input += clen;
+		output += clen;
+		length -= clen;
 	}
-	else
+}
+
+static bool rcs_fused_safe(const uint8_t* output, const uint8_t* input, size_t length)
+{
+	/* a chunk must be absorbed before a preceding chunk of output can overwrite it */
+	return (output == input || output + length <= input || input + length <= output);
+}
+
+static bool rcs_authenticated_decrypt(qsc_rcs_state* ctx, uint8_t* output, const uint8_t* input, size_t length)
+{
+	const size_t MACLEN = (ctx->ctype == qsc_rcs_cipher_256) ? QSC_RCS_256_MAC_SIZE : QSC_RCS_512_MAC_SIZE;
+	uint8_t code[QSC_RCS_512_MAC_SIZE] = { 0 };
+	bool res;
+
+	res = false;
+
+	/* mac the cipher-text to a temp array for comparison */
+	rcs_mac_update(ctx, input, length);
+	rcs_mac_finalize(ctx, code);
+
+	/* test the mac for equality, the output is not written unless the cipher-text is authenticated */
+	if (qsc_intutils_verify(code, input + length, MACLEN) == 0)
 	{
-#if defined(QSC_RCS_KMACR12)
-		qsc_keccak_update(&ctx->kstate, qsc_keccak_rate_512, input, length, QSC_KECCAK_PERMUTATION_MIN_ROUNDS);
-#else
-		qsc_kmac_update(&ctx->kstate, qsc_keccak_rate_512, input, length);
-#endif
+		rcs_ctr_transform(ctx, output, input, length);
+		res = true;
 	}
+
+	qsc_memutils_clear(code, sizeof(code));
+
+	return res;
 }
 
 static void rcs_secure_expand(qsc_rcs_state* ctx, const qsc_rcs_keyparams* keyparams)
 {
 	uint8_t sbuf[QSC_KECCAK_STATE_SIZE * sizeof(uint64_t)] = { 0 };
 	qsc_keccak_state kstate;
-	size_t i;
 	size_t oft;
 	size_t rlen;
 
@@ -581,22 +1819,8 @@ static void rcs_secure_expand(qsc_rcs_state* ctx, const qsc_rcs_keyparams* keypa
 			rlen -= BLKLEN;
 		}
 
-#if defined(QSC_RCS_AESNI_ENABLED)
-		const size_t RNKLEN = (QSC_RCS_BLOCK_SIZE / sizeof(__m128i)) * (ctx->rounds + 1);
-
-		/* copy p-rand bytes to round keys */
-		for (i = 0; i < RNKLEN; ++i)
-		{
-			ctx->roundkeys[i] = _mm_loadu_si128((const __m128i*)(tmpr + (i * sizeof(__m128i))));
-		}
-
-#else
-		/* realign in big endian format for ACS test vectors; RCS is the fallback to the AES-NI implementation */
-		for (i = 0; i < RCS_256_ROUNDKEY_SIZE; ++i)
-		{
-			ctx->roundkeys[i] = qsc_intutils_be8to32(tmpr + (i * sizeof(uint32_t)));
-		}
-#endif
+		/* copy p-rand bytes to round keys; the bitsliced and aes-ni kernels share the byte layout */
+		qsc_memutils_copy((uint8_t*)ctx->roundkeys, tmpr, sizeof(tmpr));
 
 #if defined(QSC_RCS_AUTHENTICATED)
 		/* use two permutation calls to seperate the cipher/mac key outputs to match the CEX implementation */
@@ -633,21 +1857,8 @@ static void rcs_secure_expand(qsc_rcs_state* ctx, const qsc_rcs_keyparams* keypa
 			rlen -= BLKLEN;
 		}
 
-#if defined(QSC_RCS_AESNI_ENABLED)
-		const size_t RNKLEN = (QSC_RCS_BLOCK_SIZE / sizeof(__m128i)) * (ctx->rounds + 1);
-
-		/* copy p-rand bytes to round keys */
-		for (i = 0; i < RNKLEN; ++i)
-		{
-			ctx->roundkeys[i] = _mm_loadu_si128((const __m128i*)(tmpr + (i * sizeof(__m128i))));
-		}
-#else
-		/* realign in big endian format for ACS test vectors; RCS is the fallback to the AES-NI implementation */
-		for (i = 0; i < RCS_512_ROUNDKEY_SIZE; ++i)
-		{
-			ctx->roundkeys[i] = qsc_intutils_be8to32(tmpr + (i * sizeof(uint32_t)));
-		}
-#endif
+		/* copy p-rand bytes to round keys; the bitsliced and aes-ni kernels share the byte layout */
+		qsc_memutils_copy((uint8_t*)ctx->roundkeys, tmpr, sizeof(tmpr));
 
 #if defined(QSC_RCS_AUTHENTICATED)
 		uint8_t mkey[RCS_512_MACKEY_SIZE];
@@ -666,17 +1877,6 @@ static void rcs_secure_expand(qsc_rcs_state* ctx, const qsc_rcs_keyparams* keypa
 #endif
 	}
 
-#if defined(QSC_RCS_AESNI_ENABLED)
-#	if defined(QSC_SYSTEM_HAS_AVX512)
-	/* store the avx-512 round keys */
-	qsc_memutils_clear((uint8_t*)ctx->roundkeysw, sizeof(ctx->roundkeysw));
-
-	for (i = 0; i < ctx->roundkeylen; i += 2)
-	{
-		rcs_load2x128to512(&ctx->roundkeys[i], &ctx->roundkeys[i + 1], &ctx->roundkeysw[i / 2]);
-	}
-#	endif
-#endif
 }
 
 /* rcs common */
@@ -700,12 +1900,6 @@ void qsc_rcs_dispose(qsc_rcs_state* ctx)
 		qsc_keccak_dispose(&ctx->kstate);
 #endif
 
-#if defined(QSC_RCS_AESNI_ENABLED)
-#	if defined(QSC_SYSTEM_HAS_AVX512)
-		qsc_memutils_clear((uint8_t*)ctx->roundkeysw, sizeof(ctx->roundkeysw));
-#	endif
-#endif
-
 		qsc_memutils_clear((uint8_t*)ctx->roundkeys, sizeof(ctx->roundkeys));
 		qsc_memutils_clear(ctx->nonce, sizeof(ctx->nonce));
 		ctx->counter = 0;
@@ -744,6 +1938,13 @@ void qsc_rcs_initialize(qsc_rcs_state* ctx, const qsc_rcs_keyparams* keyparams,
 
 	/* generate the cipher and mac keys */
 	rcs_secure_expand(ctx, keyparams);
+	/* the kernel is selected from the cpu features once, on first use */
+	rcs_kernel_get();
+}
+
+qsc_rcs_kernels qsc_rcs_kernel(void)
+{
+	return rcs_kernel_get()->type;
 }
 
 void qsc_rcs_set_associated(qsc_rcs_state* ctx, const uint8_t* data, size_t length)
@@ -784,11 +1985,8 @@ bool qsc_rcs_transform(qsc_rcs_state* ctx, uint8_t* output, const uint8_t* input
 
 	if (ctx->encrypt)
 	{
-		/* transform the plain-text with the counter-mode cipher */
-		rcs_ctr_transform(ctx, output, input, length);
-
-		/* update the mac with the cipher-text */
-		rcs_mac_update(ctx, output, length);
+		/* transform the plain-text with the counter-mode cipher, and update the mac with the cipher-text */
+		rcs_fused_encrypt(ctx, output, input, length);
 
 		/* mac the cipher-text appending the code to the end of the array */
 		rcs_mac_finalize(ctx, output + length);
@@ -796,44 +1994,141 @@ bool qsc_rcs_transform(qsc_rcs_state* ctx, uint8_t* output, const uint8_t* input
 	}
 	else
 	{
-		/* update the mac with the cipher-text */
-		rcs_mac_update(ctx, input, length);
+		/* authenticate the cipher-text, the output is only released if the mac check succeeds */
+		res = rcs_authenticated_decrypt(ctx, output, input, length);
+	}
 
-		if (ctx->ctype == qsc_rcs_cipher_256)
-		{
-			uint8_t code[QSC_RCS_256_MAC_SIZE] = { 0 };
+#else
+
+	rcs_ctr_transform(ctx, output, input, length);
+	res = true;
+
+#endif
+
+	return res;
+}
+
+bool qsc_rcs_transform_multi(qsc_rcs_state* ctx[], uint8_t* output[], const uint8_t* input[], const size_t length[], size_t count)
+{
+	assert(ctx != NULL);
+	assert(output != NULL);
+	assert(input != NULL);
+	assert(length != NULL);
+
+	qsc_rcs_state* cctx[RCS_MULTI_BATCH];
+	uint8_t* cout[RCS_MULTI_BATCH];
+	const uint8_t* cinp[RCS_MULTI_BATCH];
+	size_t clen[RCS_MULTI_BATCH];
+	size_t bcnt;
+	size_t ccnt;
+	size_t i;
+	size_t j;
+	bool res;
+
+	res = true;
 
-			/* mac the cipher-text to a temp array for comparison */
-			rcs_mac_finalize(ctx, code);
+	for (i = 0; i < count; i += bcnt)
+	{
+		bcnt = (count - i < RCS_MULTI_BATCH) ? count - i : RCS_MULTI_BATCH;
+		ccnt = 0;
+
+#if defined(QSC_RCS_AUTHENTICATED)
+		qsc_rcs_state* mctx[RCS_MULTI_BATCH];
+		const uint8_t* mnce[RCS_MULTI_BATCH];
+		const uint8_t* mdat[RCS_MULTI_BATCH];
+		uint8_t* mcde[RCS_MULTI_BATCH];
+		size_t mlen[RCS_MULTI_BATCH];
+		uint8_t nonce[RCS_MULTI_BATCH][QSC_RCS_NONCE_SIZE];
+		uint8_t code[RCS_MULTI_BATCH][QSC_RCS_512_MAC_SIZE];
+		size_t mcnt;
+
+		mcnt = 0;
+
+		/* decryption authenticates the cipher-text before any of it is transformed */
+		for (j = i; j < i + bcnt; ++j)
+		{
+			ctx[j]->counter += length[j];
 
-			/* test the mac for equality, bypassing the transform if the mac check fails */
-			if (qsc_intutils_verify(code, input + length, QSC_RCS_256_MAC_SIZE) == 0)
+			if (ctx[j]->encrypt == false)
 			{
-				/* transform the plain-text with the counter-mode cipher */
-				rcs_ctr_transform(ctx, output, input, length);
-				res = true;
+				mctx[mcnt] = ctx[j];
+				mnce[mcnt] = ctx[j]->nonce;
+				mdat[mcnt] = input[j];
+				mcde[mcnt] = code[mcnt];
+				mlen[mcnt] = length[j];
+				++mcnt;
 			}
 		}
-		else
+
+		rcs_mac_multi(mctx, mnce, mdat, mlen, mcde, mcnt);
+		mcnt = 0;
+
+		for (j = i; j < i + bcnt; ++j)
 		{
-			uint8_t code[QSC_RCS_512_MAC_SIZE] = { 0 };
+			if (ctx[j]->encrypt == true)
+			{
+				/* the mac absorbs the nonce position at the start of the message */
+				qsc_memutils_copy(nonce[ccnt], ctx[j]->nonce, QSC_RCS_NONCE_SIZE);
+				cctx[ccnt] = ctx[j];
+				cout[ccnt] = output[j];
+				cinp[ccnt] = input[j];
+				clen[ccnt] = length[j];
+				++ccnt;
+			}
+			else
+			{
+				const size_t MACLEN = (ctx[j]->ctype == qsc_rcs_cipher_256) ? QSC_RCS_256_MAC_SIZE : QSC_RCS_512_MAC_SIZE;
+
+				/* bypass the transform of a message that fails authentication */
+				if (qsc_intutils_verify(code[mcnt], input[j] + length[j], MACLEN) == 0)
+				{
+					cctx[ccnt] = ctx[j];
+					cout[ccnt] = output[j];
+					cinp[ccnt] = input[j];
+					clen[ccnt] = length[j];
+					++ccnt;
+				}
+				else
+				{
+					res = false;
+				}
+
+				++mcnt;
+			}
+		}
 
-			rcs_mac_finalize(ctx, code);
+		rcs_ctr_transform_multi(cctx, cout, cinp, clen, ccnt);
+		mcnt = 0;
 
-			if (qsc_intutils_verify(code, input + length, QSC_RCS_512_MAC_SIZE) == 0)
+		/* encryption macs the cipher-text, appending the code to the output */
+		for (j = 0; j < ccnt; ++j)
+		{
+			if (cctx[j]->encrypt == true)
 			{
-				rcs_ctr_transform(ctx, output, input, length);
-				res = true;
+				mctx[mcnt] = cctx[j];
+				mnce[mcnt] = nonce[j];
+				mdat[mcnt] = cout[j];
+				mcde[mcnt] = cout[j] + clen[j];
+				mlen[mcnt] = clen[j];
+				++mcnt;
 			}
 		}
-	}
 
+		rcs_mac_multi(mctx, mnce, mdat, mlen, mcde, mcnt);
+		qsc_memutils_clear((uint8_t*)code, sizeof(code));
 #else
+		for (j = i; j < i + bcnt; ++j)
+		{
+			cctx[ccnt] = ctx[j];
+			cout[ccnt] = output[j];
+			cinp[ccnt] = input[j];
+			clen[ccnt] = length[j];
+			++ccnt;
+		}
 
-	rcs_ctr_transform(ctx, output, input, length);
-	res = true;
-
+		rcs_ctr_transform_multi(cctx, cout, cinp, clen, ccnt);
 #endif
+	}
 
 	return res;
 }
@@ -858,11 +2153,8 @@ bool qsc_rcs_extended_transform(qsc_rcs_state* ctx, uint8_t* output, const uint8
 
 	if (ctx->encrypt == true)
 	{
-		/* transform the plain-text with the counter-mode cipher */
-		rcs_ctr_transform(ctx, output, input, length);
-
-		/* update the mac with the cipher-text */
-		rcs_mac_update(ctx, output, length);
+		/* transform the plain-text with the counter-mode cipher, and update the mac with the cipher-text */
+		rcs_fused_encrypt(ctx, output, input, length);
 
 		if (finalize == true)
 		{
@@ -874,43 +2166,24 @@ bool qsc_rcs_extended_transform(qsc_rcs_state* ctx, uint8_t* output, const uint8
 	}
 	else
 	{
-		/* update the mac with the cipher-text */
-		rcs_mac_update(ctx, input, length);
-
 		if (finalize == true)
 		{
-			if (ctx->ctype == qsc_rcs_cipher_256)
+			/* authenticate the cipher-text, the output is only released if the mac check succeeds */
+			res = rcs_authenticated_decrypt(ctx, output, input, length);
+		}
+		else
+		{
+			if (rcs_fused_safe(output, input, length) == true)
 			{
-				uint8_t code[QSC_RCS_256_MAC_SIZE] = { 0 };
-
-				/* mac the cipher-text to a temp array for comparison */
-				rcs_mac_finalize(ctx, code);
-
-				/* test the mac for equality, bypassing the transform if the mac check fails */
-				if (qsc_intutils_verify(code, input + length, QSC_RCS_256_MAC_SIZE) == 0)
-				{
-					/* transform the plain-text with the counter-mode cipher */
-					rcs_ctr_transform(ctx, output, input, length);
-					res = true;
-				}
+				/* update the mac with the cipher-text, and transform it with the counter-mode cipher */
+				rcs_fused_decrypt(ctx, output, input, length);
 			}
 			else
 			{
-				uint8_t code[QSC_RCS_512_MAC_SIZE] = { 0 };
-
-				rcs_mac_finalize(ctx, code);
-
-				if (qsc_intutils_verify(code, input + length, QSC_RCS_512_MAC_SIZE) == 0)
-				{
-					rcs_ctr_transform(ctx, output, input, length);
-					res = true;
-				}
+				rcs_mac_update(ctx, input, length);
+				rcs_ctr_transform(ctx, output, input, length);
 			}
-		}
-		else
-		{
-			/* transform the plain-text with the counter-mode cipher */
-			rcs_ctr_transform(ctx, output, input, length);
+
 			res = true;
 		}
 	}
@@ -116,10 +116,14 @@
 *
 * \par
 * This implementation has both a C reference code, and an implementation that uses the AES-NI instructions that are used in the AES and RCS cipher variants. \n
+* The C reference code is a constant-time bitsliced implementation; it uses no table lookups, and processes two blocks per pass. \n
 * The AES-NI implementation can be enabled by adding the QSC_RCS_AESNI_ENABLED constant to your preprocessor definitions. \n
+* Counter mode interleaves 8 blocks with AES-NI, 8 blocks in 256-bit vectors when VAES is available, or 16 blocks in 512-bit vectors with AVX-512. \n
+* Encryption works through a message in 4KB chunks, each chunk is encrypted and absorbed by the MAC in a single pass through the cache. \n
+* Decryption authenticates the whole message before the cipher-text is transformed, the output buffer is not written if the MAC check fails. \n
 * The RCS-256, RCS-512, known answer vectors are taken from the CEX++ cryptographic library <a href="https://github.com/Steppenwolfe65/CEX">The CEX++ Cryptographic Library</a>. \n
 * See the documentation and the rcs_test.h tests for usage examples.
-* To enable the AES-NI implementation, uncomment the definition in this file or add QSC_RCS_AESNI_ENABLED or add it to the compiler preprocessor definitions. \n
+* The AES-NI implementation is enabled by default on x86 and x64, the kernel is chosen once from the cpu features of the host; see qsc_rcs_kernel. \n
 */
 
 /* TODO: Test KPA on small block AVX2 */
@@ -153,10 +157,13 @@
 /*!
 * \def QSC_RCS_AESNI_ENABLED
 * \brief Enable the use of intrinsics and the AES-NI implementation.
-* Just for testing, add the QSC_RCS_AESNI_ENABLED preprocessor definition and enable SIMD and AES-NI.
+* Enabled by default on x86 and x64 builds; the vector kernels are compiled for their own instruction sets,
+* and the best kernel supported by the host is selected at run-time, falling back to the bitsliced C implementation.
 */
 #if !defined(QSC_RCS_AESNI_ENABLED)
-//#	define QSC_RCS_AESNI_ENABLED
+#	if defined(QSC_SYSTEM_ARCH_IX86) && (defined(QSC_SYSTEM_COMPILER_MSC) || defined(QSC_SYSTEM_COMPILER_GCC))
+#		define QSC_RCS_AESNI_ENABLED
+#	endif
 #endif
 
 /***********************************
@@ -213,6 +220,17 @@ typedef enum rcs_cipher_type
 	qsc_rcs_cipher_512 = 2,	/*!< The RCS-512 cipher */
 } rcs_cipher_type;
 
+/*! \enum qsc_rcs_kernels
+* \brief The counter-mode kernel selected at run-time
+*/
+typedef enum qsc_rcs_kernels
+{
+	qsc_rcs_kernel_portable = 0,		/*!< The constant-time bitsliced C implementation, 2 blocks per pass */
+	qsc_rcs_kernel_aesni = 1,			/*!< The AES-NI implementation, 8 blocks interleaved */
+	qsc_rcs_kernel_vaes = 2,			/*!< The AVX2 and VAES implementation, 8 blocks in 256-bit vectors */
+	qsc_rcs_kernel_avx512 = 3,			/*!< The AVX-512 and VAES implementation, 16 blocks in 512-bit vectors */
+} qsc_rcs_kernels;
+
 /*!
 * \struct qsc_rcs_keyparams
 * \brief The key parameters structure containing key, nonce, and info arrays and lengths.
@@ -239,9 +257,6 @@ QSC_EXPORT_API typedef struct
 	rcs_cipher_type ctype;				/*!< The cipher type; RCS-256 or RCS-512 */
 #if defined(QSC_RCS_AESNI_ENABLED)
 	__m128i roundkeys[62];				/*!< The 128-bit integer round-key array */
-#	if defined(QSC_SYSTEM_HAS_AVX512)
-		__m512i roundkeysw[31];			/*!< The 512-bit integer round-key array */
-#	endif
 #else
 	uint32_t roundkeys[248];			/*!< The round-keys 32-bit subkey array */
 #endif
@@ -286,6 +301,14 @@ QSC_EXPORT_API void qsc_rcs_dispose(qsc_rcs_state* ctx);
 */
 QSC_EXPORT_API void qsc_rcs_initialize(qsc_rcs_state* ctx, const qsc_rcs_keyparams* keyparams, bool encryption);
 
+/**
+* \brief Get the counter-mode kernel used by this process.
+* The kernel is selected once from the cpu features of the host, on the first call to this function or to qsc_rcs_initialize.
+*
+* \return: Returns the selected kernel type
+*/
+QSC_EXPORT_API qsc_rcs_kernels qsc_rcs_kernel(void);
+
 /**
 * \brief Set the associated data string used in authenticating the message.
 * The associated data may be packet header information, domain specific data, or a secret shared by a group.
@@ -317,6 +340,23 @@ QSC_EXPORT_API void qsc_rcs_set_associated(qsc_rcs_state* ctx, const uint8_t* da
 */
 QSC_EXPORT_API bool qsc_rcs_transform(qsc_rcs_state* ctx, uint8_t* output, const uint8_t* input, size_t length);
 
+/**
+* \brief Transform a batch of independent messages, each with its own cipher state.
+* The result is identical to calling qsc_rcs_transform on each state and message in turn.
+* Counter blocks from up to 16 sessions share the AVX-512 vectors, and the full rate blocks of the MAC inputs are absorbed
+* together with a 4 or 8 lane Keccak permutation chosen at run-time, so a message sent to many sessions scales with the vector width.
+*
+* \warning Each state must be initialized. An output array must not overlap the input of another session.
+*
+* \param ctx: [struct] The array of cipher state pointers
+* \param output: The array of output pointers; in encryption mode, each output must hold the message and the MAC code
+* \param input: [const] The array of input pointers; the same message may be passed to every session
+* \param length: [const] The array of message lengths, not including the MAC code
+* \param count: The number of states in the batch
+* \return: Returns false if any message fails authentication, the output of that message is not transformed
+*/
+QSC_EXPORT_API bool qsc_rcs_transform_multi(qsc_rcs_state* ctx[], uint8_t* output[], const uint8_t* input[], const size_t length[], size_t count);
+
 /**
 * \brief A multi-call transform for a large array of bytes, such as required by file encryption.
 * This call can be used to transform and authenticate a very large array of bytes (+1GB).
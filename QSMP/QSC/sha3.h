@@ -865,6 +865,16 @@ QSC_EXPORT_API void qsc_kpa_dispose(qsc_kpa_state* ctx);
 void qsc_keccakx4_absorb(__m256i state[QSC_KECCAK_STATE_SIZE], qsc_keccak_rate rate,
 	const uint8_t* inp0, const uint8_t* inp1, const uint8_t* inp2, const uint8_t* inp3, size_t inplen, uint8_t domain);
 
+/**
+* \brief The Keccak permutation applied to 4 interleaved states.
+*
+* \warning This function requires the AVX2 instruction set.
+*
+* \param state: The Keccak state array, one state to each 64-bit lane
+* \param rounds: The number of permutation rounds, the default and maximum is 24
+*/
+void qsc_keccak_permute_p4x1600(__m256i state[QSC_KECCAK_STATE_SIZE], size_t rounds);
+
 /**
 * \brief Squeeze 4 Keccak instances simultaneously using SIMD instructions.
 *
@@ -911,6 +921,16 @@ void qsc_keccakx8_absorb(__m512i state[QSC_KECCAK_STATE_SIZE], qsc_keccak_rate r
 	const uint8_t* inp0, const uint8_t* inp1, const uint8_t* inp2, const uint8_t* inp3,
 	const uint8_t* inp4, const uint8_t* inp5, const uint8_t* inp6, const uint8_t* inp7, size_t inplen, uint8_t domain);
 
+/**
+* \brief The Keccak permutation applied to 8 interleaved states.
+*
+* \warning This function requires the AVX512 instruction set.
+*
+* \param state: The Keccak state array, one state to each 64-bit lane
+* \param rounds: The number of permutation rounds, the default and maximum is 24
+*/
+void qsc_keccak_permute_p8x1600(__m512i state[QSC_KECCAK_STATE_SIZE], size_t rounds);
+
 /**
 * \brief Squeeze 4 Keccak instances simultaneously using SIMD instructions.
 *
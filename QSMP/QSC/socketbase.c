@@ -11,6 +11,13 @@
 #	endif
 #endif
 
+/* a send to a closed connection returns an error, rather than raising a signal that terminates the process */
+#if defined(MSG_NOSIGNAL)
+#	define QSC_SOCKET_SEND_NOSIGNAL MSG_NOSIGNAL
+#else
+#	define QSC_SOCKET_SEND_NOSIGNAL 0
+#endif
+
 static qsc_socket_exceptions qsc_socket_acceptv4(const qsc_socket* source, qsc_socket* target)
 {
 	assert(source != NULL);
@@ -336,6 +343,8 @@ qsc_socket_exceptions qsc_socket_close_socket(const qsc_socket* sock)
 			res = (qsc_socket_exceptions)closesocket(sock->connection);
 		}
 #else
+		/* shut down the connection first, so a receive blocked on another thread returns */
+		shutdown(sock->connection, SHUT_RDWR);
 		res = (qsc_socket_exceptions)close(sock->connection);
 #endif
 	}
@@ -542,10 +551,7 @@ size_t qsc_socket_receive(const qsc_socket* sock, uint8_t* output, size_t otplen
 
 static void qsc_socket_receive_async_invoke(qsc_socket_receive_async_state* state)
 {
-	qsc_mutex mtx;
-
-	mtx = qsc_async_mutex_lock_ex();
-
+	/* the receive loop owns its state, it must not hold the process-wide lock while it blocks */
 	if (state != NULL)
 	{
 		while (state->source->connection_status == qsc_socket_state_connected)
@@ -560,8 +566,6 @@ static void qsc_socket_receive_async_invoke(qsc_socket_receive_async_state* stat
 			}
 		}
 	}
-
-	qsc_async_mutex_unlock_ex(mtx);
 }
 
 qsc_socket_exceptions qsc_socket_receive_async(qsc_socket_receive_async_state* state)
@@ -584,11 +588,8 @@ uint32_t qsc_socket_receive_poll(const qsc_socket_receive_poll_state* state)
 {
 	assert(state != NULL);
 
-	qsc_mutex mtx;
 	uint32_t ctr;
 
-	mtx = qsc_async_mutex_lock_ex();
-
 	ctr = 0;
 
 	if (state != NULL)
@@ -610,8 +611,6 @@ uint32_t qsc_socket_receive_poll(const qsc_socket_receive_poll_state* state)
 		}
 	}
 
-	qsc_async_mutex_unlock_ex(mtx);
-
 	return ctr;
 }
 
@@ -719,13 +718,63 @@ size_t qsc_socket_send(const qsc_socket* sock, const uint8_t* input, size_t inle
 
 	if (sock != NULL && input != NULL)
 	{
-		res = send(sock->connection, (const char*)input, (int32_t)inlen + 1, (int32_t)flag);
+		res = send(sock->connection, (const char*)input, (int32_t)inlen + 1, (int32_t)flag | QSC_SOCKET_SEND_NOSIGNAL);
 		res = (res == qsc_socket_exception_error) ? 0 : res;
 	}
 
 	return (size_t)res;
 }
 
+size_t qsc_socket_sendv(const qsc_socket* sock, const qsc_socket_buffer* buffers, size_t count, qsc_socket_send_flags flag)
+{
+	assert(sock != NULL);
+	assert(buffers != NULL);
+	assert(count <= QSC_SOCKET_SENDV_MAX);
+
+	size_t res;
+
+	res = 0;
+
+	if (sock != NULL && buffers != NULL && count != 0 && count <= QSC_SOCKET_SENDV_MAX)
+	{
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+		WSABUF wbuf[QSC_SOCKET_SENDV_MAX];
+		DWORD slen;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			wbuf[i].buf = (CHAR*)buffers[i].data;
+			wbuf[i].len = (ULONG)buffers[i].length;
+		}
+
+		slen = 0;
+
+		if (WSASend(sock->connection, wbuf, (DWORD)count, &slen, (DWORD)flag, NULL, NULL) == 0)
+		{
+			res = (size_t)slen;
+		}
+#else
+		struct iovec vbuf[QSC_SOCKET_SENDV_MAX];
+		struct msghdr mhdr = { 0 };
+		ssize_t slen;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			vbuf[i].iov_base = (void*)buffers[i].data;
+			vbuf[i].iov_len = buffers[i].length;
+		}
+
+		/* the segments are gathered by the kernel, so the caller does not copy them into one buffer */
+		mhdr.msg_iov = vbuf;
+		mhdr.msg_iovlen = count;
+		slen = sendmsg(sock->connection, &mhdr, (int32_t)flag | QSC_SOCKET_SEND_NOSIGNAL);
+		res = (slen > 0) ? (size_t)slen : 0;
+#endif
+	}
+
+	return res;
+}
+
 size_t qsc_socket_send_to(const qsc_socket* sock, const uint8_t* input, size_t inlen, qsc_socket_send_flags flag)
 {
 	int32_t res;
@@ -773,7 +822,7 @@ size_t qsc_socket_send_all(const qsc_socket* sock, const uint8_t* input, size_t
 	{
 		while (inlen > 0)
 		{
-			res = send(sock->connection, (const char*)input, (int32_t)inlen, (int32_t)flag);
+			res = send(sock->connection, (const char*)input, (int32_t)inlen, (int32_t)flag | QSC_SOCKET_SEND_NOSIGNAL);
 
 			if (res < 1)
 			{
@@ -821,6 +870,30 @@ qsc_socket_exceptions qsc_socket_shut_down(qsc_socket* sock, qsc_socket_shut_dow
 	return res;
 }
 
+qsc_socket_exceptions qsc_socket_shut_down_channels(const qsc_socket* sock, qsc_socket_shut_down_flags parameters)
+{
+	assert(sock != NULL);
+
+	qsc_socket_exceptions res;
+
+	res = qsc_socket_exception_error;
+
+	if (sock != NULL)
+	{
+		if (sock->connection != QSC_UNINITIALIZED_SOCKET && qsc_socket_is_connected(sock))
+		{
+			res = (qsc_socket_exceptions)shutdown(sock->connection, (int32_t)parameters);
+		}
+	}
+
+	if (res == qsc_socket_exception_error)
+	{
+		res = qsc_socket_get_last_error();
+	}
+
+	return res;
+}
+
 //~~~Helper Functions~~~//
 
 const char* qsc_socket_error_to_string(qsc_socket_exceptions code)
@@ -1090,61 +1163,63 @@ qsc_socket_exceptions qsc_socket_ioctl(const qsc_socket* sock, int32_t command,
 bool qsc_socket_receive_ready(const qsc_socket* sock, const struct timeval* timeout)
 {
 	assert(sock != NULL);
-	assert(timeout != NULL);
 
-	qsc_socket_exceptions res;
+	int32_t res;
 
-	res = qsc_socket_invalid_input;
+	res = 0;
 
 	if (sock != NULL)
 	{
 		fd_set fds;
+		struct timeval tcopy;
+
 		FD_ZERO(&fds);
 		FD_SET(sock->connection, &fds);
 
 		if (timeout == NULL)
 		{
-			res = (qsc_socket_exceptions)select((int32_t)sock->connection + 1, &fds, NULL, NULL, NULL);
+			res = (int32_t)select((int32_t)sock->connection + 1, &fds, NULL, NULL, NULL);
 		}
 		else
 		{
-			struct timeval* tcopy = (struct timeval*)timeout;
-			res = (qsc_socket_exceptions)select((int32_t)sock->connection + 1, &fds, NULL, NULL, tcopy);
+			/* select may update the interval, so a copy is passed */
+			tcopy = *timeout;
+			res = (int32_t)select((int32_t)sock->connection + 1, &fds, NULL, NULL, &tcopy);
 		}
 	}
 
-	return (res == qsc_socket_exception_success);
+	/* select returns the number of ready descriptors, zero on a timeout, or a negative value on error */
+	return (res > 0);
 }
 
 bool qsc_socket_send_ready(const qsc_socket* sock, const struct timeval* timeout)
 {
 	assert(sock != NULL);
-	assert(timeout != NULL);
 
-	qsc_socket_exceptions res;
+	int32_t res;
 
-	res = qsc_socket_invalid_input;
+	res = 0;
 
 	if (sock != NULL)
 	{
 		fd_set fds;
-		struct timeval* tcopy;
+		struct timeval tcopy;
 
 		FD_ZERO(&fds);
 		FD_SET(sock->connection, &fds);
 
 		if (timeout == NULL)
 		{
-			res = (qsc_socket_exceptions)select((int32_t)sock->connection + 1, NULL, &fds, NULL, NULL);
+			res = (int32_t)select((int32_t)sock->connection + 1, NULL, &fds, NULL, NULL);
 		}
 		else
 		{
-			tcopy = (struct timeval*)timeout;
-			res = (qsc_socket_exceptions)select((int32_t)sock->connection + 1, NULL, &fds, NULL, tcopy);
+			tcopy = *timeout;
+			res = (int32_t)select((int32_t)sock->connection + 1, NULL, &fds, NULL, &tcopy);
 		}
 	}
 
-	return (res == qsc_socket_exception_success);
+	return (res > 0);
 }
 
 void qsc_socket_set_last_error(qsc_socket_exceptions error)
@@ -1190,6 +1265,36 @@ qsc_socket_exceptions qsc_socket_set_option(const qsc_socket* sock, qsc_socket_p
 	return res;
 }
 
+qsc_socket_exceptions qsc_socket_set_reuse_port(const qsc_socket* sock, bool enabled)
+{
+	assert(sock != NULL);
+
+	qsc_socket_exceptions res;
+#if defined(SO_REUSEPORT)
+	int32_t optval;
+#endif
+
+	res = qsc_socket_invalid_input;
+
+	if (sock != NULL)
+	{
+#if defined(SO_REUSEPORT)
+		optval = (enabled == true) ? 1 : 0;
+		res = (qsc_socket_exceptions)setsockopt(sock->connection, SOL_SOCKET, SO_REUSEPORT, (void*)&optval, sizeof(optval));
+
+		if (res == qsc_socket_exception_error)
+		{
+			res = qsc_socket_get_last_error();
+		}
+#else
+		(void)enabled;
+		res = qsc_socket_exception_operation_unsupported;
+#endif
+	}
+
+	return res;
+}
+
 bool qsc_socket_start_sockets()
 {
 	qsc_socket_exceptions res;
@@ -94,6 +94,12 @@ QSC_SYSTEM_CONDITION_IGNORE(5105)
 */
 #define QSC_SOCKET_RECEIVE_BUFFER_SIZE 1600
 
+/*!
+\def QSC_SOCKET_SENDV_MAX
+* \brief The maximum number of buffers in a vectored send
+*/
+#define QSC_SOCKET_SENDV_MAX 64
+
 /*! \enum qsc_socket_exceptions
 * \brief Socket code enumeration names
 */
@@ -262,6 +268,16 @@ typedef struct qsc_socket_receive_async_state
 	uint8_t buffer[QSC_SOCKET_RECEIVE_BUFFER_SIZE];										/*!< A pointer to the message buffer */
 } qsc_socket_receive_async_state;
 
+/*! \struct qsc_socket_buffer
+* \brief A buffer segment of a vectored send.
+* The segments are sent in order as one contiguous stream.
+*/
+typedef struct qsc_socket_buffer
+{
+	const uint8_t* data;																/*!< A pointer to the segment data */
+	size_t length;																		/*!< The segment length in bytes */
+} qsc_socket_buffer;
+
 /*! \struct qsc_socket_receive_poll_state
 * \brief The socket polling state structure.
 * The structure contains an array of client sockets,
@@ -531,6 +547,19 @@ QSC_EXPORT_API uint32_t qsc_socket_receive_poll(const qsc_socket_receive_poll_st
 */
 QSC_EXPORT_API size_t qsc_socket_send(const qsc_socket* sock, const uint8_t* input, size_t inlen, qsc_socket_send_flags flag);
 
+/**
+* \brief Sends a list of buffers on a TCP connected socket with a single gathering write.
+* Unlike qsc_socket_send, the lengths are sent exactly, and no terminator is appended.
+*
+* \param sock: [const] The socket instance
+* \param buffers: [const] The array of buffer segments, sent in order
+* \param count: The number of segments, at most QSC_SOCKET_SENDV_MAX
+* \param flag: Flags that influence the behavior of the send function
+*
+* \return Returns the number of bytes sent to the remote host, a partial send ends inside a segment
+*/
+QSC_EXPORT_API size_t qsc_socket_sendv(const qsc_socket* sock, const qsc_socket_buffer* buffers, size_t count, qsc_socket_send_flags flag);
+
 /**
 * \brief Sends data on a UDP socket
 *
@@ -565,6 +594,17 @@ QSC_EXPORT_API size_t qsc_socket_send_all(const qsc_socket* sock, const uint8_t*
 */
 QSC_EXPORT_API qsc_socket_exceptions qsc_socket_shut_down(qsc_socket* sock, qsc_socket_shut_down_flags parameters);
 
+/**
+* \brief Shuts down the sending and receiving channels of a socket, without closing the socket.
+* A receive blocked on the socket in another thread returns, and the socket is closed by its owner
+*
+* \param sock: [const] The socket instance
+* \param parameters: The shutdown parameters
+*
+* \return Returns an exception code on failure, or success(0)
+*/
+QSC_EXPORT_API qsc_socket_exceptions qsc_socket_shut_down_channels(const qsc_socket* sock, qsc_socket_shut_down_flags parameters);
+
 /*~~~ Helper Functions ~~~*/
 
 /**
@@ -597,7 +637,7 @@ QSC_EXPORT_API qsc_socket_exceptions qsc_socket_ioctl(const qsc_socket* sock, in
 * \brief Tests the socket to see if it is ready to receive data
 *
 * \param sock: [const] The socket instance
-* \param timeout: [const] The receive wait timeout
+* \param timeout: [const] The receive wait timeout, or NULL to wait until the socket is ready
 *
 * \return Returns true if the socket is ready to receive data
 */
@@ -607,7 +647,7 @@ QSC_EXPORT_API bool qsc_socket_receive_ready(const qsc_socket* sock, const struc
 * \brief Tests the socket to see if it is ready to send data
 *
 * \param sock: [const] The socket instance
-* \param timeout: [const] The maximum time to wait for a response from the socket
+* \param timeout: [const] The maximum time to wait for a response from the socket, or NULL to wait until the socket is ready
 *
 * \return Returns true if the socket is ready to send data
 */
@@ -640,6 +680,18 @@ QSC_EXPORT_API qsc_socket_exceptions qsc_socket_shut_down_sockets(void);
 */
 QSC_EXPORT_API qsc_socket_exceptions qsc_socket_set_option(const qsc_socket* sock, qsc_socket_protocols level, qsc_socket_options option, int32_t optval);
 
+/**
+* \brief Allow several sockets to bind the same address and port with SO_REUSEPORT.
+* The kernel distributes incoming connections between the listening sockets.
+* Must be set before the socket is bound, and is not supported on every platform.
+*
+* \param sock: [const] The socket instance
+* \param enabled: Enable or disable port sharing
+*
+* \return Returns an exception code on failure, or success(0)
+*/
+QSC_EXPORT_API qsc_socket_exceptions qsc_socket_set_reuse_port(const qsc_socket* sock, bool enabled);
+
 /**
 * \brief Start the sockets library
 *
@@ -129,6 +129,13 @@ typedef enum qsc_socket_send_flags
 	qsc_socket_send_flag_send_oob = 0x00000001L,		/*!< Sends OOB data on a stream type socket MSG_OOB */
 	qsc_socket_send_flag_peek_message = 0x00000002L,	/*!< Sends a partial message */
 	qsc_socket_send_flag_no_routing = 0x00000004L,		/*!< The data packets should not be routed MSG_DONTROUTE */
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	qsc_socket_send_flag_dont_wait = 0x00000000L,		/*!< Not supported, a non-blocking send requires a non-blocking socket */
+#elif defined(QSC_SYSTEM_OS_APPLE)
+	qsc_socket_send_flag_dont_wait = 0x00000080L,		/*!< The send returns rather than blocking when the buffer is full MSG_DONTWAIT */
+#else
+	qsc_socket_send_flag_dont_wait = 0x00000040L,		/*!< The send returns rather than blocking when the buffer is full MSG_DONTWAIT */
+#endif
 } qsc_socket_send_flags;
 
 /*! \enum qsc_socket_shut_down_flags
@@ -190,10 +190,7 @@ static void qsc_socket_server_accept_invoke(qsc_socket_server_async_accept_state
 {
 	assert(state != NULL);
 
-	qsc_mutex mtx;
-
-	mtx = qsc_async_mutex_lock_ex();
-
+	/* accept blocks, so the process-wide lock is not held here */
 	if (state != NULL)
 	{
 		qsc_socket_server_accept_result ar;
@@ -220,8 +217,6 @@ static void qsc_socket_server_accept_invoke(qsc_socket_server_async_accept_state
 			}
 		}
 	}
-
-	qsc_async_mutex_unlock_ex(mtx);
 }
 
 qsc_socket_exceptions qsc_socket_server_listen_async(qsc_socket_server_async_accept_state* state, const char* address, uint16_t port, qsc_socket_address_families family)
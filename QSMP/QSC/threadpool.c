@@ -28,7 +28,11 @@ bool qsc_threadpool_add_task(qsc_threadpool_state* ctx, void (*func)(void*), voi
 				++ctx->tcount;
 				res = true;
 
+				/* the task may take the process-wide lock, so it is released while waiting */
+				qsc_async_mutex_unlock_ex(mtx);
 				qsc_async_thread_wait(thd);
+				mtx = qsc_async_mutex_lock_ex();
+
 				ctx->tpool[idx] = 0;
 				--ctx->tcount;
 			}
@@ -1,4 +1,7 @@
 #include "timerex.h"
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+#	include <Windows.h>
+#endif
 #if defined(QSC_DEBUG_MODE)
 #	include "consoleutils.h"
 #	include "memutils.h"
@@ -159,6 +162,27 @@ uint64_t qsc_timerex_stopwatch_elapsed(uint64_t start)
 	return msec;
 }
 
+uint64_t qsc_timerex_stopwatch_microseconds()
+{
+	uint64_t usec;
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	LARGE_INTEGER ctr;
+	LARGE_INTEGER frq;
+
+	QueryPerformanceCounter(&ctr);
+	QueryPerformanceFrequency(&frq);
+	usec = (uint64_t)((ctr.QuadPart / frq.QuadPart) * 1000000ULL) + (uint64_t)(((ctr.QuadPart % frq.QuadPart) * 1000000ULL) / frq.QuadPart);
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	usec = ((uint64_t)ts.tv_sec * 1000000ULL) + ((uint64_t)ts.tv_nsec / 1000ULL);
+#endif
+
+	return usec;
+}
+
 #if defined(QSC_DEBUG_MODE)
 void qsc_timerex_print_values()
 {
@@ -76,6 +76,13 @@ QSC_EXPORT_API uint64_t qsc_timerex_stopwatch_start();
 */
 QSC_EXPORT_API uint64_t qsc_timerex_stopwatch_elapsed(uint64_t start);
 
+/**
+* \brief Returns the value of a monotonic wall clock in microseconds, used to measure short intervals
+*
+* \return The monotonic clock time in microseconds
+*/
+QSC_EXPORT_API uint64_t qsc_timerex_stopwatch_microseconds(void);
+
 #if defined(QSC_DEBUG_MODE)
 /**
 * \brief Print timer function values
@@ -45,11 +45,15 @@ static void client_print_message(const char* message)
 	}
 }
 
-static void client_print_string(const char* message, size_t msglen)
+static void client_print_string(const uint8_t* message, size_t msglen)
 {
 	if (message != NULL && msglen != 0)
 	{
-		qsc_consoleutils_print_line(message);
+		char mstr[QSMP_CONNECTION_MTU + 1] = { 0 };
+
+		/* the received message is not terminated, copy it to a bounded string */
+		qsc_memutils_copy(mstr, message, (msglen < QSMP_CONNECTION_MTU) ? msglen : QSMP_CONNECTION_MTU);
+		qsc_consoleutils_print_line(mstr);
 	}
 }
 
@@ -129,7 +133,7 @@ static bool client_ipv4_dialogue(qsc_ipinfo_ipv4_address* address, qsmp_client_s
 	return res;
 }
 
-static void client_receive_callback(const qsmp_connection_state* cns, const char* pmsg, size_t msglen)
+static void client_receive_callback(const qsmp_connection_state* cns, const uint8_t* pmsg, size_t msglen)
 {
 	client_print_string(pmsg, msglen);
 	client_print_prompt();
@@ -137,9 +141,6 @@ static void client_receive_callback(const qsmp_connection_state* cns, const char
 
 static void client_send_loop(qsmp_connection_state* cns)
 {
-	qsmp_packet pkt = { 0 };
-	uint8_t pmsg[QSMP_MESSAGE_MAX] = { 0 };
-	uint8_t msgstr[QSMP_CONNECTION_MTU] = { 0 };
 	char sin[QSMP_CONNECTION_MTU + 1] = { 0 };
 	size_t mlen;
 
@@ -159,12 +160,9 @@ static void client_send_loop(qsmp_connection_state* cns)
 		{
 			if (mlen > 0)
 			{
-				/* convert the packet to bytes */
-				pkt.pmessage = pmsg;
-				qsmp_encrypt_packet(cns, &pkt, (const uint8_t*)sin, mlen);
+				/* encrypt and send the message */
+				qsmp_connection_send(cns, (const uint8_t*)sin, mlen);
 				qsc_memutils_clear((uint8_t*)sin, sizeof(sin));
-				mlen = qsmp_packet_to_stream(&pkt, msgstr);
-				qsc_socket_send(&cns->target, msgstr, mlen, qsc_socket_send_flag_none);
 			}
 		}
 
@@ -49,11 +49,15 @@ static void sender_print_message(const char* message)
 	}
 }
 
-static void sender_print_string(const char* message, size_t msglen)
+static void sender_print_string(const uint8_t* message, size_t msglen)
 {
 	if (message != NULL && msglen != 0)
 	{
-		qsc_consoleutils_print_line(message);
+		char mstr[QSMP_CONNECTION_MTU + 1] = { 0 };
+
+		/* the received message is not terminated, copy it to a bounded string */
+		qsc_memutils_copy(mstr, message, (msglen < QSMP_CONNECTION_MTU) ? msglen : QSMP_CONNECTION_MTU);
+		qsc_consoleutils_print_line(mstr);
 	}
 }
 
@@ -245,7 +249,7 @@ static bool sender_ipv4_dialogue(qsc_ipinfo_ipv4_address* address, qsmp_server_s
 	return res;
 }
 
-static void sender_receive_callback(const qsmp_connection_state* cns, const char* pmsg, size_t msglen)
+static void sender_receive_callback(const qsmp_connection_state* cns, const uint8_t* pmsg, size_t msglen)
 {
 	qsc_consoleutils_print_safe("RECD: ");
 	sender_print_string(pmsg, msglen);
@@ -254,15 +258,10 @@ static void sender_receive_callback(const qsmp_connection_state* cns, const char
 
 static void sender_send_loop(qsmp_connection_state* cns)
 {
-	qsmp_packet pkt = { 0 };
-	/* Note: the buffer can be sized to the expected message maximum */
-	uint8_t pmsg[QSMP_MESSAGE_MAX] = { 0 };
-	uint8_t msgstr[QSMP_CONNECTION_MTU] = { 0 };
 	char sin[QSMP_CONNECTION_MTU + 1] = { 0 };
 	size_t mlen;
 
 	mlen = 0;
-	pkt.pmessage = pmsg;
 
 	/* start the sender loop */
 	while (true)
@@ -287,11 +286,9 @@ static void sender_send_loop(qsmp_connection_state* cns)
 		{
 			if (mlen > 0)
 			{
-				/* convert the packet to bytes */
-				qsmp_encrypt_packet(cns, &pkt, (const uint8_t*)sin, mlen);
+				/* encrypt and send the message */
+				qsmp_connection_send(cns, (const uint8_t*)sin, mlen);
 				qsc_memutils_clear((uint8_t*)sin, sizeof(sin));
-				mlen = qsmp_packet_to_stream(&pkt, msgstr);
-				qsc_socket_send(&cns->target, msgstr, mlen, qsc_socket_send_flag_none);
 			}
 		}
 
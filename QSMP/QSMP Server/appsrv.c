@@ -1,11 +1,13 @@
 #include "appsrv.h"
 #include "../QSMP/qsmpserver.h"
+#include "../QSMP/selftest.h"
 #include "../../QSC/QSC/acp.h"
 #include "../../QSC/QSC/async.h"
 #include "../../QSC/QSC/consoleutils.h"
 #include "../../QSC/QSC/fileutils.h"
 #include "../../QSC/QSC/folderutils.h"
 #include "../../QSC/QSC/ipinfo.h"
+#include "../../QSC/QSC/memutils.h"
 #include "../../QSC/QSC/netutils.h"
 #include "../../QSC/QSC/stringutils.h"
 
@@ -206,8 +208,6 @@ static void server_send_echo(qsmp_connection_state* cns, const char* message, si
 
 	char mstr[QSMP_CONNECTION_MTU] = "ECHO: ";
 	char rstr[QSMP_CONNECTION_MTU] = "RCVD #";
-	uint8_t pmsg[QSMP_MESSAGE_MAX] = { 0 };
-	qsmp_packet pkt = { 0 };
 	qsc_mutex mtx;
 	size_t mlen;
 
@@ -223,19 +223,22 @@ static void server_send_echo(qsmp_connection_state* cns, const char* message, si
 		qsc_async_mutex_unlock_ex(mtx);
 
 		mlen = qsc_stringutils_concat_strings(mstr, sizeof(mstr), message);
-		pkt.pmessage = pmsg;
-		qsmp_encrypt_packet(cns, &pkt, (uint8_t*)mstr, mlen);
-		mlen = qsmp_packet_to_stream(&pkt, mstr);
-		qsc_socket_send(&cns->target, mstr, mlen, qsc_socket_send_flag_none);
+		qsmp_connection_send(cns, (const uint8_t*)mstr, mlen);
 	}
 }
 
-static void server_receive_callback(qsmp_connection_state* cns, const char* message, size_t msglen)
+static void server_receive_callback(qsmp_connection_state* cns, const uint8_t* message, size_t msglen)
 {
 	/* Envelope data in an application header, in a request->response model.
 	   Parse that header here, process requests from the client, and transmit the response. */
 
-	server_send_echo(cns, message, msglen);
+	char mstr[QSMP_CONNECTION_MTU / 2] = { 0 };
+	size_t mlen;
+
+	/* the message is binary, this example echoes it as a bounded string */
+	mlen = (msglen < sizeof(mstr) - 1) ? msglen : sizeof(mstr) - 1;
+	qsc_memutils_copy(mstr, message, mlen);
+	server_send_echo(cns, mstr, mlen);
 }
 
 int main(void)
@@ -249,7 +252,11 @@ int main(void)
 
 	server_print_banner();
 
-	if (server_key_dialogue(&prik, &rverk, kid) == true)
+	if (qsmp_selftest_run() == false)
+	{
+		server_print_message("The library self-test failed, the application will exit.");
+	}
+	else if (server_key_dialogue(&prik, &rverk, kid) == true)
 	{
 		server_print_message("Waiting for a connection...");
 		qerr = qsmp_server_start_ipv4(&source , &prik, &server_receive_callback);
@@ -0,0 +1,223 @@
+#include "bufferpool.h"
+#include "../../QSC/QSC/async.h"
+#include "../../QSC/QSC/memutils.h"
+
+/* the buffer header is one cache line, so the buffer that follows it keeps the allocation alignment */
+#define BUFFERPOOL_HEADER_SIZE 64
+#define BUFFERPOOL_CLASS_COUNT 2
+
+typedef struct bufferpool_node
+{
+	struct bufferpool_node* next;
+	size_t cls;
+} bufferpool_node;
+
+typedef struct bufferpool_class
+{
+	bufferpool_node* free;
+	qsc_mutex lock;
+	size_t count;
+	size_t depth;
+	size_t size;
+} bufferpool_class;
+
+typedef struct qsmp_bufferpool_state
+{
+	bufferpool_class classes[BUFFERPOOL_CLASS_COUNT];
+	volatile int32_t ready;
+} qsmp_bufferpool_state;
+
+static qsmp_bufferpool_state m_buffer_pool;
+
+static bool bufferpool_initialize()
+{
+	qsc_mutex mtx;
+	bool res;
+
+	/* the ready flag is read and set atomically, so a thread that sees it set also sees the initialized classes */
+	res = (qsc_async_atomic_add(&m_buffer_pool.ready, 0) != 0);
+
+	if (res == false)
+	{
+		/* the pool is created on first use, the global lock serializes the threads that race to create it */
+		mtx = qsc_async_mutex_lock_ex();
+
+		if (qsc_async_atomic_add(&m_buffer_pool.ready, 0) == 0)
+		{
+			m_buffer_pool.classes[0].size = QSMP_BUFFERPOOL_DATA_SIZE;
+			m_buffer_pool.classes[0].depth = QSMP_BUFFERPOOL_DATA_DEPTH;
+			m_buffer_pool.classes[1].size = QSMP_BUFFERPOOL_HANDSHAKE_SIZE;
+			m_buffer_pool.classes[1].depth = QSMP_BUFFERPOOL_HANDSHAKE_DEPTH;
+			res = true;
+
+			/* each class has its own lock, so the data and handshake classes do not contend */
+			for (size_t i = 0; i < BUFFERPOOL_CLASS_COUNT; ++i)
+			{
+				if (m_buffer_pool.classes[i].lock == NULL)
+				{
+					m_buffer_pool.classes[i].lock = qsc_async_mutex_create();
+				}
+
+				res = (res == true && m_buffer_pool.classes[i].lock != NULL);
+			}
+
+			if (res == true)
+			{
+				qsc_async_atomic_exchange(&m_buffer_pool.ready, 1);
+			}
+		}
+		else
+		{
+			res = true;
+		}
+
+		qsc_async_mutex_unlock_ex(mtx);
+	}
+
+	return res;
+}
+
+uint8_t* qsmp_bufferpool_acquire(size_t length)
+{
+	bufferpool_node* node;
+	uint8_t* res;
+	size_t cls;
+
+	node = NULL;
+	res = NULL;
+
+	/* the smallest class that holds the length, the handshake class is smaller than the data class in some configurations */
+	if (length <= QSMP_BUFFERPOOL_DATA_SIZE)
+	{
+		cls = 0;
+	}
+	else if (length <= QSMP_BUFFERPOOL_HANDSHAKE_SIZE)
+	{
+		cls = 1;
+	}
+	else
+	{
+		cls = BUFFERPOOL_CLASS_COUNT;
+	}
+
+	if (cls < BUFFERPOOL_CLASS_COUNT && bufferpool_initialize() == true)
+	{
+		qsc_async_mutex_lock(m_buffer_pool.classes[cls].lock);
+		node = m_buffer_pool.classes[cls].free;
+
+		if (node != NULL)
+		{
+			m_buffer_pool.classes[cls].free = node->next;
+			m_buffer_pool.classes[cls].count -= 1;
+		}
+
+		qsc_async_mutex_unlock(m_buffer_pool.classes[cls].lock);
+
+		if (node == NULL)
+		{
+			/* a new buffer is cleared once, after that the pool keeps it zeroed */
+			node = (bufferpool_node*)qsc_memutils_malloc(BUFFERPOOL_HEADER_SIZE + m_buffer_pool.classes[cls].size);
+
+			if (node != NULL)
+			{
+				qsc_memutils_clear((uint8_t*)node + BUFFERPOOL_HEADER_SIZE, m_buffer_pool.classes[cls].size);
+				node->cls = cls;
+			}
+		}
+
+		if (node != NULL)
+		{
+			node->next = NULL;
+			res = (uint8_t*)node + BUFFERPOOL_HEADER_SIZE;
+		}
+	}
+
+	return res;
+}
+
+void qsmp_bufferpool_dispose()
+{
+	bufferpool_node* node;
+
+	if (qsc_async_atomic_add(&m_buffer_pool.ready, 0) != 0)
+	{
+		for (size_t i = 0; i < BUFFERPOOL_CLASS_COUNT; ++i)
+		{
+			qsc_async_mutex_lock(m_buffer_pool.classes[i].lock);
+
+			while (m_buffer_pool.classes[i].free != NULL)
+			{
+				node = m_buffer_pool.classes[i].free;
+				m_buffer_pool.classes[i].free = node->next;
+				qsc_memutils_alloc_free(node);
+			}
+
+			m_buffer_pool.classes[i].count = 0;
+			qsc_async_mutex_unlock(m_buffer_pool.classes[i].lock);
+		}
+	}
+}
+
+void qsmp_bufferpool_release(uint8_t* buffer, size_t used)
+{
+	bufferpool_node* node;
+	size_t cls;
+
+	if (buffer != NULL)
+	{
+		node = (bufferpool_node*)(buffer - BUFFERPOOL_HEADER_SIZE);
+		cls = node->cls;
+
+		/* only the bytes that were written are cleared, the rest of the buffer is still zero */
+		used = (used <= m_buffer_pool.classes[cls].size) ? used : m_buffer_pool.classes[cls].size;
+		qsc_memutils_clear(buffer, used);
+
+		qsc_async_mutex_lock(m_buffer_pool.classes[cls].lock);
+
+		if (m_buffer_pool.classes[cls].count < m_buffer_pool.classes[cls].depth)
+		{
+			node->next = m_buffer_pool.classes[cls].free;
+			m_buffer_pool.classes[cls].free = node;
+			m_buffer_pool.classes[cls].count += 1;
+			node = NULL;
+		}
+
+		qsc_async_mutex_unlock(m_buffer_pool.classes[cls].lock);
+
+		if (node != NULL)
+		{
+			qsc_memutils_alloc_free(node);
+		}
+	}
+}
+
+bool qsmp_bufferpool_self_test()
+{
+	uint8_t* pbuf;
+	uint8_t* pdat;
+	uint8_t* phsk;
+	bool res;
+
+	res = false;
+	pdat = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_DATA_SIZE);
+	phsk = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+
+	if (pdat != NULL && phsk != NULL)
+	{
+		/* a released buffer is reused, and is returned zeroed */
+		qsc_memutils_setvalue(pdat, 0xFF, 100);
+		qsmp_bufferpool_release(pdat, 100);
+		pbuf = qsmp_bufferpool_acquire(1);
+		res = (pbuf == pdat && qsc_memutils_zeroed(pbuf, QSMP_BUFFERPOOL_DATA_SIZE) == true);
+
+		/* a length larger than every class is refused */
+		res = (res == true && qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE + QSMP_BUFFERPOOL_DATA_SIZE) == NULL);
+		res = (res == true && qsc_memutils_zeroed(phsk, QSMP_BUFFERPOOL_HANDSHAKE_SIZE) == true);
+
+		qsmp_bufferpool_release(pbuf, 0);
+		qsmp_bufferpool_release(phsk, 0);
+		qsmp_bufferpool_dispose();
+	}
+
+	return res;
+}
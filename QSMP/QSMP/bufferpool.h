@@ -0,0 +1,89 @@
+/* 2023 Quantum Secure Cryptographic Solutions QSCS Corp. (QSCS.ca)
+* All Rights Reserved.
+*
+* NOTICE:  All information contained herein is, and remains
+* the property of the QSCS Corporation.
+* The intellectual and technical concepts contained
+* herein are proprietary to the QSCS Corporation
+* and its suppliers and may be covered by U.S. and Foreign Patents,
+* patents in process, and are protected by trade secret or copyright law.
+* Dissemination of this information or reproduction of this material
+* is strictly forbidden unless prior written permission is obtained
+* from the QSCS Corporation.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+/**
+* \file bufferpool.h
+* \brief The packet buffer pool.
+* Packet buffers are served from two size classes, a data class sized for encrypted messages,
+* and a handshake class sized for the largest key exchange message.
+* Released buffers are kept on a free list for reuse, and only the bytes that were used are cleared.
+* Buffers in the pool are always zeroed, so an acquired buffer does not need to be cleared.
+* \note These are internal non-exportable functions.
+*/
+
+#ifndef QSMP_BUFFERPOOL_H
+#define QSMP_BUFFERPOOL_H
+
+#include "common.h"
+#include "qsmp.h"
+
+/*!
+* \def QSMP_BUFFERPOOL_DATA_SIZE
+* \brief The size of a data class buffer in bytes
+*/
+#define QSMP_BUFFERPOOL_DATA_SIZE 4096
+
+/*!
+* \def QSMP_BUFFERPOOL_DATA_DEPTH
+* \brief The maximum number of free data class buffers kept by the pool
+*/
+#define QSMP_BUFFERPOOL_DATA_DEPTH 256
+
+/*!
+* \def QSMP_BUFFERPOOL_HANDSHAKE_SIZE
+* \brief The size of a handshake class buffer in bytes, the largest message and the socket terminator
+*/
+#define QSMP_BUFFERPOOL_HANDSHAKE_SIZE (QSMP_MESSAGE_MAX + QSC_SOCKET_TERMINATOR_SIZE)
+
+/*!
+* \def QSMP_BUFFERPOOL_HANDSHAKE_DEPTH
+* \brief The maximum number of free handshake class buffers kept by the pool
+*/
+#define QSMP_BUFFERPOOL_HANDSHAKE_DEPTH 12
+
+/**
+* \brief Acquire a zeroed buffer from the smallest size class that holds the length
+*
+* \param length: The number of bytes required
+*
+* \return: Returns a pointer to the buffer, or NULL if the length exceeds the largest class or the allocation failed
+*/
+uint8_t* qsmp_bufferpool_acquire(size_t length);
+
+/**
+* \brief Release the cached free buffers of every class
+*/
+void qsmp_bufferpool_dispose(void);
+
+/**
+* \brief Return a buffer to the pool.
+* The used bytes are cleared, and the buffer is kept for reuse or freed if the class is at its depth.
+*
+* \param buffer: A pointer to the buffer, can be NULL
+* \param used: The number of bytes at the start of the buffer that were written
+*/
+void qsmp_bufferpool_release(uint8_t* buffer, size_t used);
+
+/**
+* \brief Run the buffer pool self-test
+*
+* \return: Returns true if the test succeeded
+*/
+bool qsmp_bufferpool_self_test(void);
+
+#endif
@@ -1,94 +1,324 @@
 #include "connections.h"
+#include "../../QSC/QSC/async.h"
 #include "../../QSC/QSC/common.h"
+#include "../../QSC/QSC/intutils.h"
 #include "../../QSC/QSC/memutils.h"
 
-QSC_SIMD_ALIGN typedef struct qsmp_connection_set
+typedef struct qsmp_connection_shard
 {
-	qsmp_connection_state* conset;
-	bool* active;
+	qsc_mutex lock;
+	size_t first;
 	size_t maximum;
 	size_t length;
+	size_t fcount;
+} qsmp_connection_shard;
+
+QSC_SIMD_ALIGN typedef struct qsmp_connection_set
+{
+	qsmp_connection_shard shards[QSMP_CONNECTIONS_SHARDS_MAX];
+	uint8_t** pages;
+	uint32_t* active;
+	uint32_t* freelist;
+	size_t maximum;
+	size_t pmax;
+	size_t range;
+	size_t scount;
+	size_t stride;
 } qsmp_connection_set;
 
 static qsmp_connection_set m_connection_set;
 
-bool qsmp_connections_active(size_t index)
+static qsmp_connection_state* connections_slot(size_t index)
+{
+	uint8_t* page;
+
+	/* slots are addressed by page and offset, the pages themselves are never moved */
+	page = m_connection_set.pages[index / QSMP_CONNECTIONS_PAGE_SIZE];
+
+	return (qsmp_connection_state*)(page + ((index % QSMP_CONNECTIONS_PAGE_SIZE) * m_connection_set.stride));
+}
+
+static qsmp_connection_shard* connections_shard(size_t index)
+{
+	qsmp_connection_shard* res;
+	size_t sidx;
+
+	res = NULL;
+
+	if (m_connection_set.range != 0)
+	{
+		/* each shard owns a contiguous range of slots, so the index selects the shard */
+		sidx = index / m_connection_set.range;
+
+		if (sidx < m_connection_set.scount)
+		{
+			res = &m_connection_set.shards[sidx];
+		}
+	}
+
+	return res;
+}
+
+static bool connections_valid(size_t index)
 {
+	const qsmp_connection_shard* pshd;
 	bool res;
 
 	res = false;
+	pshd = connections_shard(index);
 
-	if (index < m_connection_set.length)
+	if (pshd != NULL)
 	{
-		res = m_connection_set.active[index];
+		res = ((index - pshd->first) < pshd->length);
 	}
 
 	return res;
 }
 
-qsmp_connection_state* qsmp_connections_add()
+static bool connections_page_allocate(size_t index)
+{
+	uint8_t* page;
+	size_t pidx;
+	bool res;
+
+	pidx = index / QSMP_CONNECTIONS_PAGE_SIZE;
+	res = (pidx < m_connection_set.pmax && m_connection_set.pages[pidx] != NULL);
+
+	if (pidx < m_connection_set.pmax && m_connection_set.pages[pidx] == NULL)
+	{
+		page = (uint8_t*)qsc_memutils_aligned_alloc(QSMP_CONNECTIONS_SLOT_ALIGNMENT, QSMP_CONNECTIONS_PAGE_SIZE * m_connection_set.stride);
+
+		if (page != NULL)
+		{
+			qsc_memutils_clear(page, QSMP_CONNECTIONS_PAGE_SIZE * m_connection_set.stride);
+			m_connection_set.pages[pidx] = page;
+			res = true;
+		}
+	}
+
+	return res;
+}
+
+static bool connections_bit_test(size_t index)
+{
+	return (((m_connection_set.active[index / 32] >> (index % 32)) & 1U) != 0);
+}
+
+static void connections_bit_set(size_t index, bool state)
+{
+	if (state == true)
+	{
+		m_connection_set.active[index / 32] |= (1U << (index % 32));
+	}
+	else
+	{
+		m_connection_set.active[index / 32] &= ~(1U << (index % 32));
+	}
+}
+
+static void connections_free_rebuild(qsmp_connection_shard* pshd)
+{
+	uint32_t* pfree;
+
+	/* pushed in descending order, so the lowest free index is acquired first */
+	pfree = m_connection_set.freelist + pshd->first;
+	pshd->fcount = 0;
+
+	for (size_t i = pshd->first + pshd->length; i > pshd->first; --i)
+	{
+		if (connections_bit_test(i - 1) == false)
+		{
+			pfree[pshd->fcount] = (uint32_t)(i - 1);
+			++pshd->fcount;
+		}
+	}
+}
+
+static void connections_slot_clear(size_t index)
+{
+	qsmp_connection_state* cns;
+
+	cns = connections_slot(index);
+	/* the state is released under the transmit lock, which belongs to the slot and survives the reset,
+	a broadcast holding the lock finishes with the buffers before they are disposed */
+	qsmp_connection_state_reset(cns);
+
+	if (cns->txlock == NULL)
+	{
+		cns->txlock = qsc_async_mutex_create();
+	}
+
+	cns->instance = (uint32_t)index;
+}
+
+static void connections_slot_initialize(size_t index)
+{
+	qsmp_connection_state* cns;
+
+	cns = connections_slot(index);
+	qsc_memutils_clear(cns, sizeof(qsmp_connection_state));
+	cns->instance = (uint32_t)index;
+	cns->txlock = qsc_async_mutex_create();
+}
+
+static qsmp_connection_state* connections_add(qsmp_connection_shard* pshd)
 {
 	qsmp_connection_state* cns;
+	size_t idx;
+	bool res;
 
 	cns = NULL;
 
-	if ((m_connection_set.length + 1) <= m_connection_set.maximum)
+	if ((pshd->length + 1) <= pshd->maximum)
 	{
-		m_connection_set.conset = qsc_memutils_realloc(m_connection_set.conset, (m_connection_set.length + 1) * sizeof(qsmp_connection_state));
-		m_connection_set.active = qsc_memutils_realloc(m_connection_set.active, (m_connection_set.length + 1) * sizeof(bool));
+		idx = pshd->first + pshd->length;
+		res = true;
+
+		/* growth adds one page, existing slots are left in place */
+		if (idx % QSMP_CONNECTIONS_PAGE_SIZE == 0)
+		{
+			res = connections_page_allocate(idx);
+		}
 
-		if (m_connection_set.conset != NULL && m_connection_set.active != NULL)
+		if (res == true)
 		{
-			qsc_memutils_clear(&m_connection_set.conset[m_connection_set.length], sizeof(qsmp_connection_state));
-			m_connection_set.conset[m_connection_set.length].instance = (uint32_t)m_connection_set.length;
-			m_connection_set.active[m_connection_set.length] = true;
-			cns = &m_connection_set.conset[m_connection_set.length];
-			++m_connection_set.length;
+			connections_slot_initialize(idx);
+			connections_bit_set(idx, true);
+			cns = connections_slot(idx);
+			++pshd->length;
 		}
 	}
 
 	return cns;
 }
 
+static qsmp_connection_state* connections_acquire(qsmp_connection_shard* pshd)
+{
+	qsmp_connection_state* res;
+	size_t idx;
+
+	res = NULL;
+	qsc_async_mutex_lock(pshd->lock);
+
+	if (pshd->fcount != 0)
+	{
+		--pshd->fcount;
+		idx = m_connection_set.freelist[pshd->first + pshd->fcount];
+		connections_bit_set(idx, true);
+		res = connections_slot(idx);
+	}
+	else
+	{
+		res = connections_add(pshd);
+	}
+
+	qsc_async_mutex_unlock(pshd->lock);
+
+	return res;
+}
+
+bool qsmp_connections_active(size_t index)
+{
+	bool res;
+
+	res = false;
+
+	if (connections_valid(index) == true)
+	{
+		res = connections_bit_test(index);
+	}
+
+	return res;
+}
+
+qsmp_connection_state* qsmp_connections_add()
+{
+	qsmp_connection_state* cns;
+
+	cns = NULL;
+
+	if (m_connection_set.scount != 0)
+	{
+		qsc_async_mutex_lock(m_connection_set.shards[0].lock);
+		cns = connections_add(&m_connection_set.shards[0]);
+		qsc_async_mutex_unlock(m_connection_set.shards[0].lock);
+	}
+
+	return cns;
+}
+
 size_t qsmp_connections_available()
 {
 	size_t count;
 
 	count = 0;
 
-	for (size_t i = 0; i < m_connection_set.length; ++i)
+	/* every initialized slot that is not active is held on its shard free list */
+	for (size_t i = 0; i < m_connection_set.scount; ++i)
 	{
-		if (m_connection_set.active[i] == false)
-		{
-			++count;
-		}
+		count += m_connection_set.shards[i].fcount;
 	}
-	
+
 	return count;
 }
 
 void qsmp_connections_clear()
 {
-	qsc_memutils_clear(m_connection_set.conset, sizeof(qsmp_connection_state) * m_connection_set.length);
+	qsmp_connection_shard* pshd;
 
-	for (size_t i = 0; i < m_connection_set.length; ++i)
+	for (size_t i = 0; i < m_connection_set.scount; ++i)
 	{
-		m_connection_set.active[i] = false;
-		m_connection_set.conset[i].instance = (uint32_t)i;
+		pshd = &m_connection_set.shards[i];
+
+		for (size_t j = pshd->first; j < pshd->first + pshd->length; ++j)
+		{
+			connections_slot_clear(j);
+			connections_bit_set(j, false);
+		}
+
+		if (m_connection_set.freelist != NULL)
+		{
+			connections_free_rebuild(pshd);
+		}
 	}
 }
 
 void qsmp_connections_dispose()
 {
-	if (m_connection_set.conset != NULL)
+	qsmp_connection_shard* pshd;
+	qsmp_connection_state* cns;
+
+	if (m_connection_set.pages != NULL)
 	{
 		qsmp_connections_clear();
 
-		if (m_connection_set.conset != NULL)
+		for (size_t i = 0; i < m_connection_set.scount; ++i)
 		{
-			qsc_memutils_alloc_free(m_connection_set.conset);
-			m_connection_set.conset = NULL;
+			pshd = &m_connection_set.shards[i];
+
+			for (size_t j = pshd->first; j < pshd->first + pshd->length; ++j)
+			{
+				cns = connections_slot(j);
+
+				if (cns->txlock != NULL)
+				{
+					qsc_async_mutex_destroy(cns->txlock);
+					cns->txlock = NULL;
+				}
+			}
+		}
+
+		for (size_t i = 0; i < m_connection_set.pmax; ++i)
+		{
+			if (m_connection_set.pages[i] != NULL)
+			{
+				qsc_memutils_aligned_free(m_connection_set.pages[i]);
+				m_connection_set.pages[i] = NULL;
+			}
 		}
+
+		qsc_memutils_alloc_free(m_connection_set.pages);
+		m_connection_set.pages = NULL;
 	}
 
 	if (m_connection_set.active != NULL)
@@ -97,8 +327,25 @@ void qsmp_connections_dispose()
 		m_connection_set.active = NULL;
 	}
 
-	m_connection_set.length = 0;
+	if (m_connection_set.freelist != NULL)
+	{
+		qsc_memutils_alloc_free(m_connection_set.freelist);
+		m_connection_set.freelist = NULL;
+	}
+
+	for (size_t i = 0; i < m_connection_set.scount; ++i)
+	{
+		if (m_connection_set.shards[i].lock != NULL)
+		{
+			qsc_async_mutex_destroy(m_connection_set.shards[i].lock);
+		}
+	}
+
+	qsc_memutils_clear(m_connection_set.shards, sizeof(m_connection_set.shards));
 	m_connection_set.maximum = 0;
+	m_connection_set.pmax = 0;
+	m_connection_set.range = 0;
+	m_connection_set.scount = 0;
 }
 
 qsmp_connection_state* qsmp_connections_index(size_t index)
@@ -107,9 +354,10 @@ qsmp_connection_state* qsmp_connections_index(size_t index)
 
 	res = NULL;
 
-	if (index < m_connection_set.length)
+	/* the slots between the end of one shard and the start of the next are not allocated */
+	if (connections_valid(index) == true)
 	{
-		res = &m_connection_set.conset[index];
+		res = connections_slot(index);
 	}
 
 	return res;
@@ -117,20 +365,7 @@ qsmp_connection_state* qsmp_connections_index(size_t index)
 
 bool qsmp_connections_full()
 {
-	bool res;
-
-	res = true;
-
-	for (size_t i = 0; i < m_connection_set.length; ++i)
-	{
-		if (m_connection_set.active[i] == false)
-		{
-			res = false;
-			break;
-		}
-	}
-
-	return res;
+	return (qsmp_connections_available() == 0);
 }
 
 qsmp_connection_state* qsmp_connections_get(uint32_t instance)
@@ -139,12 +374,10 @@ qsmp_connection_state* qsmp_connections_get(uint32_t instance)
 
 	res = NULL;
 
-	for (size_t i = 0; i < m_connection_set.length; ++i)
+	/* the instance number is the slot index */
+	if (connections_valid(instance) == true)
 	{
-		if (m_connection_set.conset[i].instance == instance)
-		{
-			res = &m_connection_set.conset[i];
-		}
+		res = connections_slot(instance);
 	}
 
 	return res;
@@ -155,108 +388,292 @@ void qsmp_connections_initialize(size_t count, size_t maximum)
 	assert(count != 0);
 	assert(maximum != 0);
 	assert(count <= maximum);
-	
-	if (count != 0 && maximum != 0 && count <= maximum)
+
+	qsmp_connections_initialize_sharded(count, maximum, 1);
+}
+
+void qsmp_connections_initialize_sharded(size_t count, size_t maximum, size_t shards)
+{
+	assert(count != 0);
+	assert(maximum != 0);
+	assert(count <= maximum);
+	assert(shards != 0);
+
+	qsmp_connection_shard* pshd;
+	size_t scnt;
+	size_t wcnt;
+	bool res;
+
+	if (count != 0 && maximum != 0 && count <= maximum && shards != 0)
 	{
-		m_connection_set.length = count;
+		/* each slot is padded to a whole number of cache lines */
+		m_connection_set.stride = ((sizeof(qsmp_connection_state) + (QSMP_CONNECTIONS_SLOT_ALIGNMENT - 1)) / QSMP_CONNECTIONS_SLOT_ALIGNMENT) * QSMP_CONNECTIONS_SLOT_ALIGNMENT;
 		m_connection_set.maximum = maximum;
-		m_connection_set.conset = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state) * m_connection_set.length);
-		m_connection_set.active = (bool*)qsc_memutils_malloc(sizeof(bool) * m_connection_set.length);
+		m_connection_set.pmax = (maximum + (QSMP_CONNECTIONS_PAGE_SIZE - 1)) / QSMP_CONNECTIONS_PAGE_SIZE;
+		/* a shard spans whole pages, so no page or active bitmap word is shared between shards */
+		shards = qsc_intutils_min(shards, (size_t)QSMP_CONNECTIONS_SHARDS_MAX);
+		m_connection_set.range = (maximum + shards - 1) / shards;
+		m_connection_set.range = ((m_connection_set.range + (QSMP_CONNECTIONS_PAGE_SIZE - 1)) / QSMP_CONNECTIONS_PAGE_SIZE) * QSMP_CONNECTIONS_PAGE_SIZE;
+		m_connection_set.scount = (maximum + m_connection_set.range - 1) / m_connection_set.range;
+		scnt = (count + m_connection_set.scount - 1) / m_connection_set.scount;
+		wcnt = (maximum + 31) / 32;
+		/* the page table, active bitmap and free lists are sized to the maximum once, and never reallocated */
+		m_connection_set.pages = (uint8_t**)qsc_memutils_malloc(sizeof(uint8_t*) * m_connection_set.pmax);
+		m_connection_set.active = (uint32_t*)qsc_memutils_malloc(sizeof(uint32_t) * wcnt);
+		m_connection_set.freelist = (uint32_t*)qsc_memutils_malloc(sizeof(uint32_t) * m_connection_set.maximum);
+
+		for (size_t i = 0; i < m_connection_set.scount; ++i)
+		{
+			pshd = &m_connection_set.shards[i];
+			pshd->first = i * m_connection_set.range;
+			pshd->maximum = qsc_intutils_min(m_connection_set.range, maximum - pshd->first);
+			pshd->length = 0;
+			pshd->fcount = 0;
+			pshd->lock = qsc_async_mutex_create();
+		}
 
-		if (m_connection_set.conset != NULL && m_connection_set.active != NULL)
+		if (m_connection_set.pages != NULL && m_connection_set.active != NULL && m_connection_set.freelist != NULL)
 		{
-			qsc_memutils_clear(m_connection_set.conset, sizeof(qsmp_connection_state) * m_connection_set.length);
+			qsc_memutils_clear(m_connection_set.pages, sizeof(uint8_t*) * m_connection_set.pmax);
+			qsc_memutils_clear(m_connection_set.active, sizeof(uint32_t) * wcnt);
 
-			for (size_t i = 0; i < count; ++i)
+			/* the initial slots are divided evenly between the shards */
+			for (size_t i = 0; i < m_connection_set.scount; ++i)
 			{
-				m_connection_set.conset[i].instance = (uint32_t)i;
-				m_connection_set.active[i] = false;
+				pshd = &m_connection_set.shards[i];
+				res = true;
+
+				for (size_t j = 0; j < qsc_intutils_min(scnt, pshd->maximum); ++j)
+				{
+					if ((pshd->first + j) % QSMP_CONNECTIONS_PAGE_SIZE == 0)
+					{
+						res = connections_page_allocate(pshd->first + j);
+					}
+
+					if (res == false)
+					{
+						break;
+					}
+
+					connections_slot_initialize(pshd->first + j);
+					++pshd->length;
+				}
+
+				connections_free_rebuild(pshd);
 			}
 		}
 	}
 }
 
 qsmp_connection_state* qsmp_connections_next()
+{
+	return qsmp_connections_next_shard(0);
+}
+
+qsmp_connection_state* qsmp_connections_next_shard(size_t shard)
 {
 	qsmp_connection_state* res;
 
 	res = NULL;
 
-	if (qsmp_connections_full() == false)
+	/* a slot is taken from the preferred shard, the remaining shards are used only when it is full */
+	for (size_t i = 0; i < m_connection_set.scount; ++i)
 	{
-		for (size_t i = 0; i < m_connection_set.length; ++i)
+		res = connections_acquire(&m_connection_set.shards[(shard + i) % m_connection_set.scount]);
+
+		if (res != NULL)
 		{
-			if (m_connection_set.active[i] == false)
-			{
-				res = &m_connection_set.conset[i];
-				m_connection_set.active[i] = true;
-				break;
-			}
+			break;
 		}
 	}
-	else
-	{
-		res = qsmp_connections_add();
-	}
 
 	return res;
 }
 
 void qsmp_connections_reset(uint32_t instance)
 {
-	for (size_t i = 0; i < m_connection_set.length; ++i)
+	qsmp_connection_shard* pshd;
+
+	pshd = connections_shard(instance);
+
+	if (pshd != NULL)
 	{
-		if (m_connection_set.conset[i].instance == instance)
+		qsc_async_mutex_lock(pshd->lock);
+
+		if ((instance - pshd->first) < pshd->length)
 		{
-			qsc_memutils_clear(&m_connection_set.conset[i], sizeof(qsmp_connection_state));
-			m_connection_set.conset[i].instance = (uint32_t)i;
-			m_connection_set.active[i] = false;
-			break;
+			connections_slot_clear(instance);
+
+			/* only an active slot is returned to the free list, a repeated reset is ignored */
+			if (connections_bit_test(instance) == true)
+			{
+				connections_bit_set(instance, false);
+				m_connection_set.freelist[pshd->first + pshd->fcount] = instance;
+				++pshd->fcount;
+			}
 		}
+
+		qsc_async_mutex_unlock(pshd->lock);
 	}
 }
 
-size_t qsmp_connections_size()
+size_t qsmp_connections_shard_count()
 {
-	return m_connection_set.length;
+	return m_connection_set.scount;
 }
 
-void qsmp_connections_self_test()
+size_t qsmp_connections_size()
 {
-	qsmp_connection_state* xn[20] = { 0 };
-	size_t cnt;
-	bool full;
+	size_t res;
 
-	qsmp_connections_initialize(1, 10); /* init with 1 */
+	res = 0;
 
-	for (size_t i = 1; i < 10; ++i)
+	/* the size spans every shard up to the end of the last initialized slot */
+	for (size_t i = m_connection_set.scount; i > 0; --i)
 	{
-		xn[i] = qsmp_connections_next(); /* init next 9 */
+		if (m_connection_set.shards[i - 1].length != 0)
+		{
+			res = m_connection_set.shards[i - 1].first + m_connection_set.shards[i - 1].length;
+			break;
+		}
 	}
 
-	cnt = qsmp_connections_available(); /* expected 0 */
-	full = qsmp_connections_full(); /* expected true */
+	return res;
+}
+
+bool qsmp_connections_self_test()
+{
+	qsmp_connection_state* xn[10] = { 0 };
+	qsmp_connection_state* pfst;
+	qsmp_connection_state* plst;
+	qsmp_connection_state* pcns;
+	bool res;
 
-	qsmp_connections_reset(1); /* release 5 */
-	qsmp_connections_reset(3);
-	qsmp_connections_reset(5);
-	qsmp_connections_reset(7);
-	qsmp_connections_reset(9);
+	/* the initial slot is taken first, the collection then grows to the maximum */
+	qsmp_connections_initialize(1, 10);
 
-	full = qsmp_connections_full(); /* expected false */
+	for (size_t i = 0; i < 10; ++i)
+	{
+		xn[i] = qsmp_connections_next();
+	}
 
-	xn[11] = qsmp_connections_next(); /* reclaim 5 */
-	xn[12] = qsmp_connections_next();
-	xn[13] = qsmp_connections_next();
-	xn[14] = qsmp_connections_next();
-	xn[15] = qsmp_connections_next();
+	/* the collection is full, and each slot carries its own index */
+	res = (qsmp_connections_available() == 0 && qsmp_connections_full() == true && qsmp_connections_size() == 10);
 
-	full = qsmp_connections_full(); /* expected true */
+	for (size_t i = 0; i < 10 && res == true; ++i)
+	{
+		res = (xn[i] != NULL && xn[i]->instance == (uint32_t)i && qsmp_connections_index(i) == xn[i]);
+	}
 
-	xn[16] = qsmp_connections_next(); /* should exceed max */
+	if (res == true)
+	{
+		/* released slots are reclaimed in place, and the maximum is not exceeded */
+		for (size_t i = 1; i < 10; i += 2)
+		{
+			qsmp_connections_reset((uint32_t)i);
+		}
 
-	cnt = qsmp_connections_size(); /* expected 10 */
+		res = (qsmp_connections_available() == 5 && qsmp_connections_full() == false &&
+			qsmp_connections_active(1) == false && qsmp_connections_active(2) == true);
+
+		for (size_t i = 0; i < 5 && res == true; ++i)
+		{
+			pcns = qsmp_connections_next();
+			res = (pcns != NULL && pcns == xn[pcns->instance] && (pcns->instance % 2) == 1);
+		}
+
+		res = (res == true && qsmp_connections_full() == true && qsmp_connections_next() == NULL && qsmp_connections_size() == 10);
+	}
 
 	qsmp_connections_clear();
 	qsmp_connections_dispose();
+
+	if (res == true)
+	{
+		/* growing across page boundaries does not move the slots already handed out */
+		qsmp_connections_initialize(1, (QSMP_CONNECTIONS_PAGE_SIZE * 2) + 1);
+		pfst = qsmp_connections_next();
+		plst = NULL;
+
+		for (size_t i = 1; i < (QSMP_CONNECTIONS_PAGE_SIZE * 2) + 1; ++i)
+		{
+			pcns = qsmp_connections_next();
+
+			if (i == QSMP_CONNECTIONS_PAGE_SIZE - 1)
+			{
+				plst = pcns;
+			}
+		}
+
+		res = (pfst != NULL && plst != NULL && pfst == qsmp_connections_index(0) && pfst->instance == 0 &&
+			plst == qsmp_connections_index(QSMP_CONNECTIONS_PAGE_SIZE - 1) && plst->instance == QSMP_CONNECTIONS_PAGE_SIZE - 1 &&
+			qsmp_connections_size() == (QSMP_CONNECTIONS_PAGE_SIZE * 2) + 1 && qsmp_connections_next() == NULL);
+
+		qsmp_connections_clear();
+		qsmp_connections_dispose();
+	}
+
+	if (res == true)
+	{
+		/* the collection scales to the maximum, and a reset returns each slot once */
+		qsmp_connections_initialize(QSMP_CONNECTIONS_INIT, QSMP_CONNECTIONS_MAX);
+
+		for (size_t i = 0; i < QSMP_CONNECTIONS_MAX; ++i)
+		{
+			qsmp_connections_next();
+		}
+
+		res = (qsmp_connections_full() == true && qsmp_connections_available() == 0 && qsmp_connections_next() == NULL);
+
+		for (size_t i = 0; i < QSMP_CONNECTIONS_MAX; i += 2)
+		{
+			qsmp_connections_reset((uint32_t)i);
+		}
+
+		/* a repeated release is ignored */
+		qsmp_connections_reset(0);
+		res = (res == true && qsmp_connections_available() == QSMP_CONNECTIONS_MAX / 2);
+
+		for (size_t i = 0; i < QSMP_CONNECTIONS_MAX / 2 && res == true; ++i)
+		{
+			pcns = qsmp_connections_next();
+			res = (pcns != NULL && (pcns->instance % 2) == 0);
+		}
+
+		pcns = qsmp_connections_get(QSMP_CONNECTIONS_MAX - 1);
+		res = (res == true && qsmp_connections_full() == true && pcns != NULL &&
+			pcns == qsmp_connections_index(QSMP_CONNECTIONS_MAX - 1) && qsmp_connections_active(QSMP_CONNECTIONS_MAX - 1) == true);
+
+		qsmp_connections_clear();
+		res = (res == true && qsmp_connections_available() == QSMP_CONNECTIONS_MAX);
+		qsmp_connections_dispose();
+	}
+
+	if (res == true)
+	{
+		/* a full shard falls back to the next shard, and a released slot returns to its own shard */
+		qsmp_connections_initialize_sharded(4, 1000, 4);
+		res = (qsmp_connections_shard_count() == 4);
+		pfst = qsmp_connections_next_shard(2);
+
+		for (size_t i = 1; i < 256; ++i)
+		{
+			qsmp_connections_next_shard(2);
+		}
+
+		plst = qsmp_connections_next_shard(2);
+		res = (res == true && pfst != NULL && plst != NULL && pfst->instance == 512 && plst->instance == 768 &&
+			qsmp_connections_size() == 769);
+
+		if (res == true)
+		{
+			qsmp_connections_reset(pfst->instance);
+			res = (qsmp_connections_next_shard(2) == pfst);
+		}
+
+		qsmp_connections_clear();
+		qsmp_connections_dispose();
+	}
+
+	return res;
 }
@@ -29,6 +29,26 @@
 #include "common.h"
 #include "qsmp.h"
 
+/*!
+* \def QSMP_CONNECTIONS_PAGE_SIZE
+* \brief The number of connection slots allocated in each page of the collection.
+* Pages are never relocated, so connection pointers remain valid while the collection grows.
+*/
+#define QSMP_CONNECTIONS_PAGE_SIZE 256
+
+/*!
+* \def QSMP_CONNECTIONS_SLOT_ALIGNMENT
+* \brief The memory alignment of a connection slot, one cache line
+*/
+#define QSMP_CONNECTIONS_SLOT_ALIGNMENT 64
+
+/*!
+* \def QSMP_CONNECTIONS_SHARDS_MAX
+* \brief The maximum number of connection table shards.
+* Each shard owns a contiguous range of slots with its own lock and free list.
+*/
+#define QSMP_CONNECTIONS_SHARDS_MAX 64
+
 /**
 * \brief Check if a collection member is set to active
 *
@@ -68,6 +88,16 @@ qsmp_connection_state* qsmp_connections_get(uint32_t instance);
 */
 void qsmp_connections_initialize(size_t count, size_t maximum);
 
+/**
+* \brief Initialize the connections collection divided into shards.
+* Slots are acquired and released under the lock of the owning shard, so threads using different shards do not contend.
+*
+* \param count: The number of initial connection states, divided between the shards
+* \param maximum: The maximum number of connection states, must be more equal to count
+* \param shards: The number of shards, a maximum of QSMP_CONNECTIONS_SHARDS_MAX
+*/
+void qsmp_connections_initialize_sharded(size_t count, size_t maximum, size_t shards);
+
 /**
 * \brief Erase all the collection members
 */
@@ -101,6 +131,15 @@ bool qsmp_connections_full(void);
 */
 qsmp_connection_state* qsmp_connections_next(void);
 
+/**
+* \brief Get the next available connection state from a shard, or from another shard if it is full
+*
+* \param shard: The preferred shard index
+*
+* \return: Returns the next available collection state pointer or NULL
+*/
+qsmp_connection_state* qsmp_connections_next_shard(size_t shard);
+
 /**
 * \brief Reset a connection from the collection
 *
@@ -108,6 +147,13 @@ qsmp_connection_state* qsmp_connections_next(void);
 */
 void qsmp_connections_reset(uint32_t instance);
 
+/**
+* \brief Get the number of shards the collection is divided into
+*
+* \return: Returns the shard count
+*/
+size_t qsmp_connections_shard_count(void);
+
 /**
 * \brief Get the size of the collection
 *
@@ -116,8 +162,11 @@ void qsmp_connections_reset(uint32_t instance);
 size_t qsmp_connections_size(void);
 
 /**
-* \brief Run the connections queue self-test
+* \brief Run the connections collection self-test.
+* Checks slot reuse, slot addresses across growth, the free and available counts, and the shard fallback
+*
+* \return: Returns true if the test succeeded
 */
-void qsmp_connections_self_test(void);
+bool qsmp_connections_self_test(void);
 
 #endif
@@ -0,0 +1,365 @@
+#include "datagram.h"
+#include "../../QSC/QSC/async.h"
+#include "../../QSC/QSC/intutils.h"
+#include "../../QSC/QSC/memutils.h"
+#include "../../QSC/QSC/sha3.h"
+
+static const uint8_t m_datagram_domain[] = "QSMP datagram channel";
+
+static void datagram_cipher(qsc_rcs_state* ctx, const qsc_rcs_state* base, uint64_t sequence)
+{
+	uint8_t seq[sizeof(uint64_t)] = { 0 };
+
+	/* the keyed cipher is copied, so each datagram starts from the same key and mac state */
+	qsc_memutils_copy(ctx, base, sizeof(qsc_rcs_state));
+
+	/* the sequence is added to the upper half of the nonce, the counter mode increments the lower half */
+	qsc_intutils_le64to8(seq, sequence);
+	qsc_memutils_xor(ctx->nonce + (QSC_RCS_NONCE_SIZE / 2), seq, sizeof(seq));
+}
+
+static bool datagram_window_check(const qsmp_datagram_state* dgs, uint64_t sequence)
+{
+	uint64_t diff;
+	bool res;
+
+	res = false;
+
+	if (sequence > dgs->rxhigh)
+	{
+		res = true;
+	}
+	else if (sequence != 0)
+	{
+		/* an older sequence is accepted once, if it is still inside the window */
+		diff = dgs->rxhigh - sequence;
+		res = (diff < QSMP_DATAGRAM_WINDOW_SIZE && ((dgs->rxmask >> diff) & 1) == 0);
+	}
+
+	return res;
+}
+
+static void datagram_window_update(qsmp_datagram_state* dgs, uint64_t sequence)
+{
+	uint64_t diff;
+
+	if (sequence > dgs->rxhigh)
+	{
+		/* slide the window forward, the new sequence is bit zero */
+		diff = sequence - dgs->rxhigh;
+		dgs->rxmask = (diff < QSMP_DATAGRAM_WINDOW_SIZE) ? (dgs->rxmask << diff) | 1 : 1;
+		dgs->rxhigh = sequence;
+	}
+	else
+	{
+		dgs->rxmask |= (1ULL << (dgs->rxhigh - sequence));
+	}
+}
+
+qsmp_errors qsmp_datagram_decrypt(qsmp_datagram_state* dgs, uint8_t* message, size_t* msglen, const uint8_t* input, size_t inlen)
+{
+	assert(dgs != NULL);
+	assert(message != NULL);
+	assert(msglen != NULL);
+	assert(input != NULL);
+
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (dgs != NULL && message != NULL && msglen != NULL && input != NULL)
+	{
+		const size_t MACLEN = (dgs->rxbase.ctype == qsc_rcs_cipher_256) ? QSMP_SIMPLEX_MACTAG_SIZE : QSMP_DUPLEX_MACTAG_SIZE;
+		qsmp_packet pkt = { 0 };
+
+		*msglen = 0;
+		qerr = qsmp_error_invalid_request;
+
+		if (inlen >= QSMP_HEADER_SIZE + MACLEN && inlen - (QSMP_HEADER_SIZE + MACLEN) <= QSMP_DATAGRAM_MESSAGE_MAX)
+		{
+			qsmp_packet_header_deserialize(input, &pkt);
+
+			if (pkt.flag == qsmp_flag_datagram_message && pkt.msglen == inlen - QSMP_HEADER_SIZE)
+			{
+				/* the window is checked before the mac, and updated only after the datagram is authenticated */
+				if (datagram_window_check(dgs, pkt.sequence) == true)
+				{
+					qsc_rcs_state ctx;
+
+					datagram_cipher(&ctx, &dgs->rxbase, pkt.sequence);
+					qsc_rcs_set_associated(&ctx, input, QSMP_HEADER_SIZE);
+
+					if (qsc_rcs_transform(&ctx, message, input + QSMP_HEADER_SIZE, pkt.msglen - MACLEN) == true)
+					{
+						datagram_window_update(dgs, pkt.sequence);
+						*msglen = pkt.msglen - MACLEN;
+						qerr = qsmp_error_none;
+					}
+					else
+					{
+						qerr = qsmp_error_authentication_failure;
+					}
+
+					qsc_rcs_dispose(&ctx);
+				}
+				else
+				{
+					qerr = qsmp_error_packet_unsequenced;
+				}
+			}
+		}
+	}
+
+	return qerr;
+}
+
+void qsmp_datagram_dispose(qsmp_datagram_state* dgs)
+{
+	assert(dgs != NULL);
+
+	if (dgs != NULL)
+	{
+		qsc_rcs_dispose(&dgs->rxbase);
+		qsc_rcs_dispose(&dgs->txbase);
+
+		if (dgs->txlock != NULL)
+		{
+			qsc_async_mutex_destroy(dgs->txlock);
+			dgs->txlock = NULL;
+		}
+
+		dgs->rxhigh = 0;
+		dgs->rxmask = 0;
+		dgs->txseq = 0;
+	}
+}
+
+qsmp_errors qsmp_datagram_encrypt(qsmp_datagram_state* dgs, uint8_t* output, size_t* outlen, const uint8_t* message, size_t msglen)
+{
+	assert(dgs != NULL);
+	assert(output != NULL);
+	assert(outlen != NULL);
+	assert(message != NULL);
+
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (dgs != NULL && output != NULL && outlen != NULL && message != NULL && msglen != 0 && msglen <= QSMP_DATAGRAM_MESSAGE_MAX)
+	{
+		const size_t MACLEN = (dgs->txbase.ctype == qsc_rcs_cipher_256) ? QSMP_SIMPLEX_MACTAG_SIZE : QSMP_DUPLEX_MACTAG_SIZE;
+		qsmp_packet pkt = { 0 };
+		qsc_rcs_state ctx;
+
+		/* only the sequence is taken under the lock, datagrams are encrypted concurrently */
+		qsc_async_mutex_lock(dgs->txlock);
+		dgs->txseq += 1;
+		pkt.sequence = dgs->txseq;
+		qsc_async_mutex_unlock(dgs->txlock);
+
+		pkt.flag = qsmp_flag_datagram_message;
+		pkt.msglen = (uint32_t)(msglen + MACLEN);
+		qsmp_packet_header_serialize(&pkt, output);
+
+		datagram_cipher(&ctx, &dgs->txbase, pkt.sequence);
+		qsc_rcs_set_associated(&ctx, output, QSMP_HEADER_SIZE);
+		qsc_rcs_transform(&ctx, output + QSMP_HEADER_SIZE, message, msglen);
+		qsc_rcs_dispose(&ctx);
+
+		*outlen = QSMP_HEADER_SIZE + pkt.msglen;
+		qerr = qsmp_error_none;
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_datagram_initialize(qsmp_datagram_state* dgs, const qsmp_connection_state* cns, bool initiator)
+{
+	assert(dgs != NULL);
+	assert(cns != NULL);
+
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (dgs != NULL && cns != NULL)
+	{
+		if (cns->exflag == qsmp_flag_session_established)
+		{
+			const size_t KEYLEN = (cns->txcpr.ctype == qsc_rcs_cipher_256) ? QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE : QSMP_DUPLEX_SYMMETRIC_KEY_SIZE;
+			uint8_t prnd[(QSC_KECCAK_512_RATE * 3)] = { 0 };
+			qsc_keccak_state kstate = { 0 };
+			qsc_rcs_keyparams kp1;
+			qsc_rcs_keyparams kp2;
+
+			/* the channel keys are derived from the session key state, in a domain separate from the ratchet */
+			qsc_cshake_initialize(&kstate, qsc_keccak_rate_512, cns->rtcs, QSMP_DUPLEX_SYMMETRIC_KEY_SIZE, (const uint8_t*)QSMP_CONFIG_STRING, QSMP_CONFIG_SIZE, m_datagram_domain, sizeof(m_datagram_domain) - 1);
+			qsc_cshake_squeezeblocks(&kstate, qsc_keccak_rate_512, prnd, 3);
+
+			/* the first key and nonce raise the initiators transmit channel, the second the remote hosts */
+			kp1.key = prnd;
+			kp1.keylen = KEYLEN;
+			kp1.nonce = prnd + KEYLEN;
+			kp1.info = NULL;
+			kp1.infolen = 0;
+			kp2.key = prnd + KEYLEN + QSMP_NONCE_SIZE;
+			kp2.keylen = KEYLEN;
+			kp2.nonce = prnd + KEYLEN + QSMP_NONCE_SIZE + KEYLEN;
+			kp2.info = NULL;
+			kp2.infolen = 0;
+
+			qsc_rcs_initialize(&dgs->txbase, (initiator == true) ? &kp1 : &kp2, true);
+			qsc_rcs_initialize(&dgs->rxbase, (initiator == true) ? &kp2 : &kp1, false);
+			qsc_memutils_clear(prnd, sizeof(prnd));
+			qsc_keccak_dispose(&kstate);
+
+			dgs->txlock = qsc_async_mutex_create();
+			dgs->rxhigh = 0;
+			dgs->rxmask = 0;
+			dgs->txseq = 0;
+			qerr = (dgs->txlock != NULL) ? qsmp_error_none : qsmp_error_memory_allocation;
+		}
+		else
+		{
+			qerr = qsmp_error_channel_down;
+		}
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_datagram_receive(qsmp_datagram_state* dgs, const qsc_socket* sock, uint8_t* message, size_t* msglen)
+{
+	assert(dgs != NULL);
+	assert(sock != NULL);
+	assert(message != NULL);
+	assert(msglen != NULL);
+
+	uint8_t dgm[QSMP_CONNECTION_MTU] = { 0 };
+	qsmp_errors qerr;
+	size_t rlen;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (dgs != NULL && sock != NULL && message != NULL && msglen != NULL)
+	{
+		/* each receive returns one datagram */
+		rlen = qsc_socket_receive(sock, dgm, sizeof(dgm), qsc_socket_receive_flag_none);
+
+		if (rlen != 0)
+		{
+			qerr = qsmp_datagram_decrypt(dgs, message, msglen, dgm, rlen);
+		}
+		else
+		{
+			*msglen = 0;
+			qerr = qsmp_error_receive_failure;
+		}
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_datagram_send(qsmp_datagram_state* dgs, const qsc_socket* sock, const uint8_t* message, size_t msglen)
+{
+	assert(dgs != NULL);
+	assert(sock != NULL);
+	assert(message != NULL);
+
+	uint8_t dgm[QSMP_CONNECTION_MTU] = { 0 };
+	qsmp_errors qerr;
+	size_t dlen;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (dgs != NULL && sock != NULL && message != NULL)
+	{
+		dlen = 0;
+		qerr = qsmp_datagram_encrypt(dgs, dgm, &dlen, message, msglen);
+
+		if (qerr == qsmp_error_none)
+		{
+			if (qsc_socket_send_to(sock, dgm, dlen, qsc_socket_send_flag_none) != dlen)
+			{
+				qerr = qsmp_error_transmit_failure;
+			}
+		}
+	}
+
+	return qerr;
+}
+
+bool qsmp_datagram_self_test()
+{
+	uint8_t dgm[4][QSMP_CONNECTION_MTU] = { 0 };
+	uint8_t msg[QSMP_DATAGRAM_MESSAGE_MAX] = { 0 };
+	uint8_t otp[QSMP_DATAGRAM_MESSAGE_MAX] = { 0 };
+	qsmp_datagram_state dga = { 0 };
+	qsmp_datagram_state dgb = { 0 };
+	qsmp_connection_state* pcns;
+	size_t dlen[4] = { 0 };
+	size_t mlen;
+	bool res;
+
+	res = false;
+	pcns = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state));
+
+	if (pcns != NULL)
+	{
+		/* both hosts derive the channel from the same session key state */
+		qsc_memutils_clear(pcns, sizeof(qsmp_connection_state));
+		pcns->exflag = qsmp_flag_session_established;
+		pcns->txcpr.ctype = qsc_rcs_cipher_512;
+
+		for (size_t i = 0; i < QSMP_DUPLEX_SYMMETRIC_KEY_SIZE; ++i)
+		{
+			pcns->rtcs[i] = (uint8_t)i;
+		}
+
+		for (size_t i = 0; i < sizeof(msg); ++i)
+		{
+			msg[i] = (uint8_t)(i * 3);
+		}
+
+		res = (qsmp_datagram_initialize(&dga, pcns, true) == qsmp_error_none && qsmp_datagram_initialize(&dgb, pcns, false) == qsmp_error_none);
+
+		for (size_t i = 0; i < 3 && res == true; ++i)
+		{
+			res = (qsmp_datagram_encrypt(&dga, dgm[i], &dlen[i], msg, 100 + i) == qsmp_error_none);
+		}
+
+		if (res == true)
+		{
+			/* datagrams are accepted out of order, and each is decrypted independently */
+			res = (qsmp_datagram_decrypt(&dgb, otp, &mlen, dgm[2], dlen[2]) == qsmp_error_none && mlen == 102 && qsc_intutils_are_equal8(otp, msg, mlen) == true);
+			res = (res == true && qsmp_datagram_decrypt(&dgb, otp, &mlen, dgm[0], dlen[0]) == qsmp_error_none && mlen == 100 && qsc_intutils_are_equal8(otp, msg, mlen) == true);
+			res = (res == true && qsmp_datagram_decrypt(&dgb, otp, &mlen, dgm[1], dlen[1]) == qsmp_error_none && mlen == 101 && qsc_intutils_are_equal8(otp, msg, mlen) == true);
+
+			/* a replayed datagram is rejected */
+			res = (res == true && qsmp_datagram_decrypt(&dgb, otp, &mlen, dgm[1], dlen[1]) == qsmp_error_packet_unsequenced);
+
+			/* a modified datagram fails authentication */
+			qsmp_datagram_encrypt(&dga, dgm[3], &dlen[3], msg, QSMP_DATAGRAM_MESSAGE_MAX);
+			dgm[3][QSMP_HEADER_SIZE] ^= 1;
+			res = (res == true && qsmp_datagram_decrypt(&dgb, otp, &mlen, dgm[3], dlen[3]) == qsmp_error_authentication_failure);
+			dgm[3][QSMP_HEADER_SIZE] ^= 1;
+
+			/* a datagram older than the window is rejected */
+			dga.txseq += QSMP_DATAGRAM_WINDOW_SIZE;
+			qsmp_datagram_encrypt(&dga, dgm[0], &dlen[0], msg, 1);
+			res = (res == true && qsmp_datagram_decrypt(&dgb, otp, &mlen, dgm[0], dlen[0]) == qsmp_error_none);
+			res = (res == true && qsmp_datagram_decrypt(&dgb, otp, &mlen, dgm[3], dlen[3]) == qsmp_error_packet_unsequenced);
+
+			/* the remote host transmits on the other channel */
+			qsmp_datagram_encrypt(&dgb, dgm[1], &dlen[1], msg, 10);
+			res = (res == true && qsmp_datagram_decrypt(&dga, otp, &mlen, dgm[1], dlen[1]) == qsmp_error_none && mlen == 10);
+			res = (res == true && qsmp_datagram_decrypt(&dgb, otp, &mlen, dgm[1], dlen[1]) != qsmp_error_none);
+		}
+
+		qsmp_datagram_dispose(&dga);
+		qsmp_datagram_dispose(&dgb);
+		qsc_memutils_alloc_free(pcns);
+	}
+
+	return res;
+}
@@ -0,0 +1,140 @@
+/* 2023 Quantum Secure Cryptographic Solutions QSCS Corp. (QSCS.ca)
+* All Rights Reserved.
+*
+* NOTICE:  All information contained herein is, and remains
+* the property of the QSCS Corporation.
+* The intellectual and technical concepts contained
+* herein are proprietary to the QSCS Corporation
+* and its suppliers and may be covered by U.S. and Foreign Patents,
+* patents in process, and are protected by trade secret or copyright law.
+* Dissemination of this information or reproduction of this material
+* is strictly forbidden unless prior written permission is obtained
+* from the QSCS Corporation.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+/**
+* \file datagram.h
+* \brief <b>QSMP Datagram functions</b> \n
+* A connection-less channel for a QSMP session, that sends each message as an independent UDP datagram.
+* The key exchange is run on the session stream connection, which recovers from loss, and the datagram channel keys are derived from the session.
+* Each datagram carries an explicit sequence number, the nonce of the datagram is derived from the sequence,
+* so a datagram can be authenticated and decrypted without the datagrams that preceded it.
+* Lost and reordered datagrams are accepted, and a sliding anti-replay window rejects datagrams that were already received or are too old.
+*/
+
+#ifndef QSMP_DATAGRAM_H
+#define QSMP_DATAGRAM_H
+
+#include "qsmp.h"
+#include "../../QSC/QSC/rcs.h"
+#include "../../QSC/QSC/socketbase.h"
+
+/*!
+* \def QSMP_DATAGRAM_MESSAGE_MAX
+* \brief The maximum message size of a datagram, a datagram with its header and mac tag fits in the connection MTU
+*/
+#define QSMP_DATAGRAM_MESSAGE_MAX (QSMP_CONNECTION_MTU - (QSMP_HEADER_SIZE + QSMP_DUPLEX_MACTAG_SIZE))
+
+/*!
+* \def QSMP_DATAGRAM_WINDOW_SIZE
+* \brief The number of sequence numbers tracked by the anti-replay window
+*/
+#define QSMP_DATAGRAM_WINDOW_SIZE 64
+
+/*!
+* \struct qsmp_datagram_state
+* \brief The QSMP datagram channel state
+*/
+QSMP_EXPORT_API typedef struct qsmp_datagram_state
+{
+	qsc_rcs_state rxbase;							/*!< The keyed receive cipher, copied for each datagram */
+	qsc_rcs_state txbase;							/*!< The keyed transmit cipher, copied for each datagram */
+	qsc_mutex txlock;								/*!< The transmit lock, serializes the transmit sequence */
+	uint64_t rxhigh;								/*!< The highest authenticated receive sequence number */
+	uint64_t rxmask;								/*!< The anti-replay window, bit n is set if sequence rxhigh - n was received */
+	uint64_t txseq;									/*!< The transmit sequence number */
+} qsmp_datagram_state;
+
+/**
+* \brief Decrypt a datagram and copy the message to the output.
+* The datagram is rejected if it fails authentication, or its sequence was already received or is older than the anti-replay window.
+*
+* \param dgs: A pointer to the datagram state
+* \param message: The message output array, must hold QSMP_DATAGRAM_MESSAGE_MAX bytes
+* \param msglen: A pointer receiving the message length
+* \param input: [const] The received datagram
+* \param inlen: The length of the received datagram
+*
+* \return: Returns the function error state, qsmp_error_packet_unsequenced for a replayed or expired datagram
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_datagram_decrypt(qsmp_datagram_state* dgs, uint8_t* message, size_t* msglen, const uint8_t* input, size_t inlen);
+
+/**
+* \brief Erase the keys and release the datagram state
+*
+* \param dgs: A pointer to the datagram state
+*/
+QSMP_EXPORT_API void qsmp_datagram_dispose(qsmp_datagram_state* dgs);
+
+/**
+* \brief Encrypt a message as a datagram.
+*
+* \param dgs: A pointer to the datagram state
+* \param output: The datagram output array, must hold the message length, the header, and the mac tag
+* \param outlen: A pointer receiving the datagram length
+* \param message: [const] The message array
+* \param msglen: The length of the message, at most QSMP_DATAGRAM_MESSAGE_MAX
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_datagram_encrypt(qsmp_datagram_state* dgs, uint8_t* output, size_t* outlen, const uint8_t* message, size_t msglen);
+
+/**
+* \brief Initialize the datagram channel of an established session.
+* The channel keys are derived from the session key state and are independent of the stream ciphers.
+* The host that initiated the session connection sets the initiator flag, and the remote host clears it.
+*
+* \param dgs: A pointer to the datagram state
+* \param cns: [const] A pointer to the established connection state
+* \param initiator: True if this host initiated the session connection
+*
+* \return: Returns the function error state, qsmp_error_channel_down if the session is not established
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_datagram_initialize(qsmp_datagram_state* dgs, const qsmp_connection_state* cns, bool initiator);
+
+/**
+* \brief Receive a datagram from a bound UDP socket, and decrypt it.
+*
+* \param dgs: A pointer to the datagram state
+* \param sock: [const] A pointer to the bound datagram socket
+* \param message: The message output array, must hold QSMP_DATAGRAM_MESSAGE_MAX bytes
+* \param msglen: A pointer receiving the message length
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_datagram_receive(qsmp_datagram_state* dgs, const qsc_socket* sock, uint8_t* message, size_t* msglen);
+
+/**
+* \brief Run the datagram channel self-test
+*
+* \return: Returns true if the test succeeded
+*/
+QSMP_EXPORT_API bool qsmp_datagram_self_test(void);
+
+/**
+* \brief Encrypt a message and send it as a datagram to the socket's remote address and port.
+*
+* \param dgs: A pointer to the datagram state
+* \param sock: [const] A pointer to the datagram socket, the address and port are the remote host
+* \param message: [const] The message array
+* \param msglen: The length of the message, at most QSMP_DATAGRAM_MESSAGE_MAX
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_datagram_send(qsmp_datagram_state* dgs, const qsc_socket* sock, const uint8_t* message, size_t msglen);
+
+#endif
@@ -1,4 +1,5 @@
 ﻿#include "kex.h"
+#include "bufferpool.h"
 #include "../../QSC/QSC/acp.h"
 #include "../../QSC/QSC/encoding.h"
 #include "../../QSC/QSC/intutils.h"
@@ -100,6 +101,7 @@ static void kex_simplex_client_reset(qsmp_kex_simplex_client_state* kcs)
 	{
 		qsc_memutils_clear(kcs->keyid, QSMP_KEYID_SIZE);
 		qsc_memutils_clear(kcs->schash, QSMP_SIMPLEX_SCHASH_SIZE);
+		qsc_memutils_clear(kcs->ssec, QSMP_SECRET_SIZE);
 		qsc_memutils_clear(kcs->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
 		kcs->expiration = 0;
 	}
@@ -126,8 +128,242 @@ static void kex_simplex_server_reset(qsmp_kex_simplex_server_state* kss)
 		qsc_memutils_clear(kss->pubkey, QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE);
 		qsc_memutils_clear(kss->sigkey, QSMP_ASYMMETRIC_SIGNING_KEY_SIZE);
 		qsc_memutils_clear(kss->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
+		qsc_memutils_clear(kss->fonce, QSMP_NONCE_SIZE);
 		kss->expiration = 0;
+		kss->tktkey = NULL;
+		kss->fostate = NULL;
+		kss->fopen = false;
+	}
+}
+
+static size_t kex_receive_packet(const qsc_socket* sock, uint8_t* spct, qsmp_packet* packetin, size_t msgmax)
+{
+	size_t mlen;
+	size_t rlen;
+
+	/* the header is received first, and the message length sets the size of the remainder */
+	rlen = qsc_socket_receive(sock, spct, QSMP_HEADER_SIZE, qsc_socket_receive_flag_wait_all);
+
+	if (rlen == QSMP_HEADER_SIZE)
+	{
+		mlen = qsc_intutils_le8to32(spct + sizeof(uint8_t));
+
+		if (mlen <= msgmax)
+		{
+			rlen += qsc_socket_receive(sock, spct + QSMP_HEADER_SIZE, mlen + QSC_SOCKET_TERMINATOR_SIZE, qsc_socket_receive_flag_wait_all);
+
+			if (rlen == QSMP_HEADER_SIZE + mlen + QSC_SOCKET_TERMINATOR_SIZE)
+			{
+				qsmp_stream_to_packet(spct, packetin);
+			}
+			else
+			{
+				rlen = 0;
+			}
+		}
+		else
+		{
+			rlen = 0;
+		}
+	}
+	else
+	{
+		rlen = 0;
+	}
+
+	return rlen;
+}
+
+static void kex_resumption_secret(uint8_t* secret, const uint8_t* rtcs)
+{
+	static const uint8_t rsdom[] = "QSMP resumption secret";
+
+	/* the resumption secret is derived from the session key state in its own domain: rsec <- KDF(rtcs) */
+	qsc_cshake256_compute(secret, QSMP_SECRET_SIZE, rtcs, QSMP_DUPLEX_SYMMETRIC_KEY_SIZE, (const uint8_t*)QSMP_CONFIG_STRING, QSMP_CONFIG_SIZE, rsdom, sizeof(rsdom) - 1);
+}
+
+static void kex_resume_binder(uint8_t* binder, const qsmp_packet* packet, const uint8_t* secret)
+{
+	static const uint8_t bndom[] = "QSMP resume binder";
+	uint8_t breq[QSMP_HEADER_SIZE + QSMP_RESUME_REQUEST_SIZE - QSMP_SIMPLEX_MACTAG_SIZE] = { 0 };
+
+	/* the binder is a mac of the request header and message, keyed with the resumption secret: bnd <- Mrsec(hdr || kid || cfg || tkt || cn) */
+	qsmp_packet_header_serialize(packet, breq);
+	qsc_memutils_copy(breq + QSMP_HEADER_SIZE, packet->pmessage, QSMP_RESUME_REQUEST_SIZE - QSMP_SIMPLEX_MACTAG_SIZE);
+	qsc_kmac256_compute(binder, QSMP_SIMPLEX_MACTAG_SIZE, breq, sizeof(breq), secret, QSMP_SECRET_SIZE, bndom, sizeof(bndom) - 1);
+}
+
+static void kex_simplex_raise_channels(qsmp_connection_state* cns, const uint8_t* secret, const uint8_t* name, size_t namelen, const uint8_t* custom, size_t custlen, bool server)
+{
+	uint8_t prnd[(QSC_KECCAK_256_RATE * 2)] = { 0 };
+	qsc_keccak_state kstate = { 0 };
+	qsc_rcs_keyparams kp1;
+	qsc_rcs_keyparams kp2;
+
+	/* initialize cSHAKE k = H(sec, name, custom) */
+	qsc_cshake_initialize(&kstate, qsc_keccak_rate_256, secret, QSMP_SECRET_SIZE, name, namelen, custom, custlen);
+	qsc_cshake_squeezeblocks(&kstate, qsc_keccak_rate_256, prnd, 2);
+	/* permute the state so we are not storing the current key */
+	qsc_keccak_permute(&kstate, QSC_KECCAK_PERMUTATION_ROUNDS);
+	/* copy as next key */
+	qsc_memutils_copy(cns->rtcs, (uint8_t*)kstate.state, QSMP_DUPLEX_SYMMETRIC_KEY_SIZE);
+
+	/* the first key and nonce raise the client transmit channel, the second the server transmit channel */
+	kp1.key = prnd;
+	kp1.keylen = QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE;
+	kp1.nonce = prnd + QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE;
+	kp1.info = NULL;
+	kp1.infolen = 0;
+	kp2.key = prnd + QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE + QSMP_NONCE_SIZE;
+	kp2.keylen = QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE;
+	kp2.nonce = prnd + QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE + QSMP_NONCE_SIZE + QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE;
+	kp2.info = NULL;
+	kp2.infolen = 0;
+
+	qsc_rcs_initialize(&cns->rxcpr, (server == true) ? &kp1 : &kp2, false);
+	qsc_rcs_initialize(&cns->txcpr, (server == true) ? &kp2 : &kp1, true);
+
+	qsc_memutils_clear(prnd, sizeof(prnd));
+	qsc_keccak_dispose(&kstate);
+}
+
+static void kex_resume_keys(qsmp_connection_state* cns, const uint8_t* secret, const uint8_t* cnonce, const uint8_t* snonce, bool server)
+{
+	uint8_t nonces[QSMP_NONCE_SIZE * 2] = { 0 };
+
+	/* the resumed session keys are derived from the resumption secret and both nonces: k <- H(rsec, cn || sn, cfg) */
+	qsc_memutils_copy(nonces, cnonce, QSMP_NONCE_SIZE);
+	qsc_memutils_copy(nonces + QSMP_NONCE_SIZE, snonce, QSMP_NONCE_SIZE);
+	kex_simplex_raise_channels(cns, secret, nonces, sizeof(nonces), (const uint8_t*)QSMP_CONFIG_STRING, QSMP_CONFIG_SIZE, server);
+}
+
+static void kex_fastopen_key_hash(uint8_t* khash, const uint8_t* expiration, const uint8_t* pubkey)
+{
+	qsc_keccak_state kstate = { 0 };
+
+	/* the signed hash binds the expiration time to the fast-open key: kh <- H(exp || pk) */
+	qsc_sha3_initialize(&kstate);
+	qsc_sha3_update(&kstate, qsc_keccak_rate_256, expiration, QSMP_TIMESTAMP_SIZE);
+	qsc_sha3_update(&kstate, qsc_keccak_rate_256, pubkey, QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE);
+	qsc_sha3_finalize(&kstate, qsc_keccak_rate_256, khash);
+}
+
+static void kex_fastopen_refresh(qsmp_kex_fastopen_state* fos, const uint8_t* sigkey)
+{
+	uint8_t khash[QSMP_SIMPLEX_HASH_SIZE] = { 0 };
+	uint8_t sexp[QSMP_TIMESTAMP_SIZE] = { 0 };
+	size_t slen;
+
+	/* the key is replaced when it expires, clients holding the previous key are sent the new one */
+	qsmp_cipher_generate_keypair(fos->pubkey, fos->prikey, qsc_acp_generate);
+	fos->expiration = qsc_timestamp_epochtime_seconds() + QSMP_FASTOPEN_KEY_LIFETIME;
+	qsc_intutils_le64to8(sexp, fos->expiration);
+	kex_fastopen_key_hash(khash, sexp, fos->pubkey);
+
+	slen = 0;
+	qsc_memutils_clear(fos->sigkh, QSMP_ASYMMETRIC_SIGNATURE_SIZE + QSMP_SIMPLEX_HASH_SIZE);
+	qsmp_signature_sign(fos->sigkh, &slen, khash, QSMP_SIMPLEX_HASH_SIZE, sigkey, qsc_acp_generate);
+	qsc_sha3_compute256(fos->pkhash, fos->pubkey, QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE);
+}
+
+static bool kex_ticket_open(const uint8_t* ticket, const uint8_t* tktkey, uint8_t* keyid, uint8_t* secret, uint64_t* expiration)
+{
+	uint8_t ptxt[QSMP_TIMESTAMP_SIZE + QSMP_KEYID_SIZE + QSMP_SECRET_SIZE] = { 0 };
+	uint8_t tnce[QSMP_NONCE_SIZE] = { 0 };
+	qsc_rcs_keyparams kp;
+	qsc_rcs_state ctx;
+	bool res;
+
+	qsc_memutils_copy(tnce, ticket, QSMP_NONCE_SIZE);
+	kp.key = tktkey;
+	kp.keylen = QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE;
+	kp.nonce = tnce;
+	kp.info = NULL;
+	kp.infolen = 0;
+	qsc_rcs_initialize(&ctx, &kp, false);
+	res = qsc_rcs_transform(&ctx, ptxt, ticket + QSMP_NONCE_SIZE, sizeof(ptxt));
+	qsc_rcs_dispose(&ctx);
+
+	if (res == true)
+	{
+		*expiration = qsc_intutils_le8to64(ptxt);
+		qsc_memutils_copy(keyid, ptxt + QSMP_TIMESTAMP_SIZE, QSMP_KEYID_SIZE);
+		qsc_memutils_copy(secret, ptxt + QSMP_TIMESTAMP_SIZE + QSMP_KEYID_SIZE, QSMP_SECRET_SIZE);
+	}
+
+	qsc_memutils_clear(ptxt, sizeof(ptxt));
+
+	return res;
+}
+
+static void kex_ticket_seal(uint8_t* ticket, const uint8_t* tktkey, const uint8_t* keyid, const uint8_t* secret, uint64_t expiration)
+{
+	uint8_t ptxt[QSMP_TIMESTAMP_SIZE + QSMP_KEYID_SIZE + QSMP_SECRET_SIZE] = { 0 };
+	uint8_t tnce[QSMP_NONCE_SIZE] = { 0 };
+	qsc_rcs_keyparams kp;
+	qsc_rcs_state ctx;
+
+	/* each ticket is sealed with a random nonce under the servers ticket key: tkt <- n || Ek(exp || kid || rsec) */
+	qsc_acp_generate(tnce, sizeof(tnce));
+	qsc_memutils_copy(ticket, tnce, QSMP_NONCE_SIZE);
+	qsc_intutils_le64to8(ptxt, expiration);
+	qsc_memutils_copy(ptxt + QSMP_TIMESTAMP_SIZE, keyid, QSMP_KEYID_SIZE);
+	qsc_memutils_copy(ptxt + QSMP_TIMESTAMP_SIZE + QSMP_KEYID_SIZE, secret, QSMP_SECRET_SIZE);
+
+	kp.key = tktkey;
+	kp.keylen = QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE;
+	kp.nonce = tnce;
+	kp.info = NULL;
+	kp.infolen = 0;
+	qsc_rcs_initialize(&ctx, &kp, true);
+	qsc_rcs_transform(&ctx, ticket + QSMP_NONCE_SIZE, ptxt, sizeof(ptxt));
+	qsc_rcs_dispose(&ctx);
+
+	qsc_memutils_clear(ptxt, sizeof(ptxt));
+}
+
+static qsmp_errors kex_simplex_client_ticket_accept(qsmp_connection_state* cns, const uint8_t* keyid, const qsmp_packet* packetin, size_t offset)
+{
+	uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
+	uint8_t tckt[QSMP_TICKET_SIZE] = { 0 };
+	qsmp_errors qerr;
+
+	/* the ticket is decrypted on the new receive channel, a valid mac confirms the server derived the same session keys */
+	qsmp_packet_header_serialize(packetin, hdr);
+	qsc_rcs_set_associated(&cns->rxcpr, hdr, QSMP_HEADER_SIZE);
+
+	if (qsc_rcs_transform(&cns->rxcpr, tckt, packetin->pmessage + offset, QSMP_TICKET_SIZE) == true)
+	{
+		qsc_memutils_copy(cns->ticket.ticket, tckt, QSMP_TICKET_SIZE);
+		qsc_memutils_copy(cns->ticket.keyid, keyid, QSMP_KEYID_SIZE);
+		kex_resumption_secret(cns->ticket.secret, cns->rtcs);
+		cns->ticket.expiration = qsc_timestamp_epochtime_seconds() + QSMP_TICKET_LIFETIME;
+		qerr = qsmp_error_none;
 	}
+	else
+	{
+		qerr = qsmp_error_authentication_failure;
+	}
+
+	return qerr;
+}
+
+static void kex_simplex_server_ticket_issue(const qsmp_kex_simplex_server_state* kss, qsmp_connection_state* cns, qsmp_packet* packetout, size_t offset)
+{
+	uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
+	uint8_t rsec[QSMP_SECRET_SIZE] = { 0 };
+	uint8_t tckt[QSMP_TICKET_SIZE] = { 0 };
+
+	kex_resumption_secret(rsec, cns->rtcs);
+	kex_ticket_seal(tckt, kss->tktkey, kss->keyid, rsec, qsc_timestamp_epochtime_seconds() + QSMP_TICKET_LIFETIME);
+
+	/* the ticket is encrypted on the new transmit channel, with the packet header as associated data */
+	packetout->msglen = (uint32_t)(offset + QSMP_TICKET_SIZE + QSMP_SIMPLEX_MACTAG_SIZE);
+	qsmp_packet_header_serialize(packetout, hdr);
+	qsc_rcs_set_associated(&cns->txcpr, hdr, QSMP_HEADER_SIZE);
+	qsc_rcs_transform(&cns->txcpr, packetout->pmessage + offset, tckt, QSMP_TICKET_SIZE);
+
+	qsc_memutils_clear(rsec, sizeof(rsec));
 }
 
 /*
@@ -154,11 +390,18 @@ k,mk		-A symmetric cipher or MAC key
 KDF			-The key expansion function (SHAKE)
 kid			-The public keys unique identity array
 Mmk			-The MAC function and key (KMAC)
+bnd			-The resume request binder, a MAC keyed with the resumption secret
+cn,sn		-The client and server nonces
+exp			-The fast-open key expiration time
+fpk,fsk		-The servers fast-open asymmetric public and secret keys
 pk,sk		-Asymmetric public and secret keys
 pvk			-Public signature verification key
 sch			-A hash of the configuration string and and asymmetric verification-keys
 sec			-The shared secret derived from asymmetric encapsulation and decapsulation
+rsec		-The resumption secret, derived from the session key state
+sfpkh		-The signed hash of the fast-open key expiration and public key
 spkh		-The signed hash of the asymmetric public encapsulation-key
+tkt			-The session resumption ticket, sealed with the servers ticket key
 */
 
 /*
@@ -810,14 +1053,11 @@ static qsmp_errors kex_duplex_server_establish_response(const qsmp_kex_duplex_se
 	return qerr;
 }
 
-qsmp_errors qsmp_kex_duplex_client_key_exchange(qsmp_kex_duplex_client_state* kcs, qsmp_connection_state* cns)
+static qsmp_errors kex_duplex_client_exchange(qsmp_kex_duplex_client_state* kcs, qsmp_connection_state* cns, uint8_t* mreqt, uint8_t* mresp, uint8_t* spct)
 {
 	assert(kcs != NULL);
 	assert(cns != NULL);
 
-	uint8_t mresp[QSMP_MESSAGE_MAX] = { 0 };
-	uint8_t mreqt[QSMP_MESSAGE_MAX] = { 0 };
-	uint8_t spct[QSMP_MESSAGE_MAX + 1] = { 0 };
 	qsmp_packet reqt = { 0 };
 	qsmp_packet resp = { 0 };
 	qsmp_errors qerr;
@@ -853,7 +1093,7 @@ qsmp_errors qsmp_kex_duplex_client_key_exchange(qsmp_kex_duplex_client_state* kc
 					/* convert server response to packet */
 					resp.pmessage = mresp;
 					qsmp_stream_to_packet(spct, &resp);
-					qsc_memutils_clear(spct, sizeof(spct));
+					qsc_memutils_clear(spct, rlen);
 
 					if (resp.sequence == cns->rxseq)
 					{
@@ -915,7 +1155,7 @@ qsmp_errors qsmp_kex_duplex_client_key_exchange(qsmp_kex_duplex_client_state* kc
 				if (rlen == EXCLEN)
 				{
 					qsmp_stream_to_packet(spct, &resp);
-					qsc_memutils_clear(spct, sizeof(spct));
+					qsc_memutils_clear(spct, rlen);
 
 					if (resp.sequence == cns->rxseq)
 					{
@@ -969,7 +1209,7 @@ qsmp_errors qsmp_kex_duplex_client_key_exchange(qsmp_kex_duplex_client_state* kc
 				cns->txseq += 1;
 				rlen = qsc_socket_receive(&cns->target, spct, ESTLEN, qsc_socket_receive_flag_wait_all);
 				qsmp_stream_to_packet(spct, &resp);
-				qsc_memutils_clear(spct, sizeof(spct));
+				qsc_memutils_clear(spct, rlen);
 
 				if (rlen == ESTLEN)
 				{
@@ -1031,14 +1271,48 @@ qsmp_errors qsmp_kex_duplex_client_key_exchange(qsmp_kex_duplex_client_state* kc
 	return qerr;
 }
 
-qsmp_errors qsmp_kex_duplex_server_key_exchange(qsmp_kex_duplex_server_state* kss, qsmp_connection_state* cns)
+qsmp_errors qsmp_kex_duplex_client_key_exchange(qsmp_kex_duplex_client_state* kcs, qsmp_connection_state* cns)
+{
+	assert(kcs != NULL);
+	assert(cns != NULL);
+
+	uint8_t* mreqt;
+	uint8_t* mresp;
+	uint8_t* spct;
+	qsmp_errors qerr;
+
+	/* the exchange messages are held in pooled handshake buffers, rather than on the stack of the calling thread */
+	mreqt = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	mresp = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	spct = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+
+	if (mreqt != NULL && mresp != NULL && spct != NULL)
+	{
+		qerr = kex_duplex_client_exchange(kcs, cns, mreqt, mresp, spct);
+	}
+	else
+	{
+		qerr = qsmp_error_memory_allocation;
+
+		if (cns != NULL && cns->target.connection_status == qsc_socket_state_connected)
+		{
+			kex_client_send_error(&cns->target, qerr);
+			qsc_socket_shut_down(&cns->target, qsc_socket_shut_down_flag_both);
+		}
+	}
+
+	qsmp_bufferpool_release(mreqt, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	qsmp_bufferpool_release(mresp, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	qsmp_bufferpool_release(spct, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+
+	return qerr;
+}
+
+static qsmp_errors kex_duplex_server_exchange(qsmp_kex_duplex_server_state* kss, qsmp_connection_state* cns, uint8_t* mreqt, uint8_t* mresp, uint8_t* spct)
 {
 	assert(kss != NULL);
 	assert(cns != NULL);
 
-	uint8_t spct[QSMP_MESSAGE_MAX + 1] = { 0 };
-	uint8_t mreqt[QSMP_MESSAGE_MAX + 1] = { 0 };
-	uint8_t mresp[QSMP_MESSAGE_MAX + 1] = { 0 };
 	qsmp_packet reqt = { 0 };
 	qsmp_packet resp = { 0 };
 	qsmp_errors qerr;
@@ -1055,7 +1329,7 @@ qsmp_errors qsmp_kex_duplex_server_key_exchange(qsmp_kex_duplex_server_state* ks
 		/* convert server response to packet */
 		resp.pmessage = mresp;
 		qsmp_stream_to_packet(spct, &resp);
-		qsc_memutils_clear(spct, sizeof(spct));
+		qsc_memutils_clear(spct, rlen);
 
 		if (resp.sequence == cns->rxseq)
 		{
@@ -1106,7 +1380,7 @@ qsmp_errors qsmp_kex_duplex_server_key_exchange(qsmp_kex_duplex_server_state* ks
 			if (rlen == EXCLEN)
 			{
 				qsmp_stream_to_packet(spct, &resp);
-				qsc_memutils_clear(spct, sizeof(spct));
+				qsc_memutils_clear(spct, rlen);
 
 				if (resp.sequence == cns->rxseq)
 				{
@@ -1162,7 +1436,7 @@ qsmp_errors qsmp_kex_duplex_server_key_exchange(qsmp_kex_duplex_server_state* ks
 			{
 				cns->rxseq += 1;
 				qsmp_stream_to_packet(spct, &resp);
-				qsc_memutils_clear(spct, sizeof(spct));
+				qsc_memutils_clear(spct, rlen);
 
 				if (resp.flag == qsmp_flag_establish_request)
 				{
@@ -1221,14 +1495,120 @@ qsmp_errors qsmp_kex_duplex_server_key_exchange(qsmp_kex_duplex_server_state* ks
 		{
 			kex_server_send_error(&cns->target, qerr);
 			qsc_socket_shut_down(&cns->target, qsc_socket_shut_down_flag_both);
+			qsc_socket_close_socket(&cns->target);
 		}
 
-		qsmp_connection_state_dispose(cns);
+		/* the server connection is a slot in the connections collection, its transmit lock and instance are kept */
+		qsmp_connection_state_reset(cns);
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_kex_duplex_server_key_exchange(qsmp_kex_duplex_server_state* kss, qsmp_connection_state* cns)
+{
+	assert(kss != NULL);
+	assert(cns != NULL);
+
+	uint8_t* mreqt;
+	uint8_t* mresp;
+	uint8_t* spct;
+	qsmp_errors qerr;
+
+	/* the exchange messages are held in pooled handshake buffers, rather than on the stack of the calling thread */
+	mreqt = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	mresp = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	spct = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+
+	if (mreqt != NULL && mresp != NULL && spct != NULL)
+	{
+		qerr = kex_duplex_server_exchange(kss, cns, mreqt, mresp, spct);
+	}
+	else
+	{
+		qerr = qsmp_error_memory_allocation;
+
+		if (cns != NULL && cns->target.connection_status == qsc_socket_state_connected)
+		{
+			kex_server_send_error(&cns->target, qerr);
+			qsc_socket_shut_down(&cns->target, qsc_socket_shut_down_flag_both);
+		}
 	}
 
+	qsmp_bufferpool_release(mreqt, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	qsmp_bufferpool_release(mresp, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	qsmp_bufferpool_release(spct, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+
 	return qerr;
 }
 
+void qsmp_kex_fastopen_dispose(qsmp_kex_fastopen_state* fos)
+{
+	assert(fos != NULL);
+
+	if (fos != NULL)
+	{
+		if (fos->prikey != NULL)
+		{
+			qsc_memutils_clear(fos->prikey, QSMP_ASYMMETRIC_PRIVATE_KEY_SIZE);
+			qsc_memutils_alloc_free(fos->prikey);
+			fos->prikey = NULL;
+		}
+
+		if (fos->pubkey != NULL)
+		{
+			qsc_memutils_alloc_free(fos->pubkey);
+			fos->pubkey = NULL;
+		}
+
+		if (fos->sigkh != NULL)
+		{
+			qsc_memutils_alloc_free(fos->sigkh);
+			fos->sigkh = NULL;
+		}
+
+		if (fos->lock != NULL)
+		{
+			qsc_async_mutex_destroy(fos->lock);
+			fos->lock = NULL;
+		}
+
+		qsc_memutils_clear(fos->pkhash, QSMP_SIMPLEX_HASH_SIZE);
+		fos->expiration = 0;
+	}
+}
+
+bool qsmp_kex_fastopen_initialize(qsmp_kex_fastopen_state* fos)
+{
+	assert(fos != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (fos != NULL)
+	{
+		/* the keys are held on the heap, the mceliece public key is too large for the stack of a worker */
+		fos->prikey = (uint8_t*)qsc_memutils_malloc(QSMP_ASYMMETRIC_PRIVATE_KEY_SIZE);
+		fos->pubkey = (uint8_t*)qsc_memutils_malloc(QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE);
+		fos->sigkh = (uint8_t*)qsc_memutils_malloc(QSMP_ASYMMETRIC_SIGNATURE_SIZE + QSMP_SIMPLEX_HASH_SIZE);
+		fos->lock = qsc_async_mutex_create();
+		/* an expired key is generated by the first exchange that uses it */
+		fos->expiration = 0;
+
+		if (fos->prikey != NULL && fos->pubkey != NULL && fos->sigkh != NULL && fos->lock != NULL)
+		{
+			res = true;
+		}
+		else
+		{
+			qsmp_kex_fastopen_dispose(fos);
+		}
+	}
+
+	return res;
+}
+
 /*
 The client sends a connection request with its configuration string, and asymmetric public signature key identity.
 The key identity (kid) is a multi-part 16-byte address and key identification array, 
@@ -1419,6 +1799,8 @@ Establish Verify:
 The client checks the flag of the exchange response packet sent by the server. 
 If the flag is set to indicate an error state, the tunnel is torn down on both sides,
 otherwise the client tunnel is established and in an operational state.
+If the server issued a resumption ticket, the client decrypts it on the receive channel and stores it with the resumption secret.
+rsec <- KDF(rtcs)
 The client sets the operational state to session established, and is now ready to process data.
 */
 static qsmp_errors kex_simplex_client_establish_verify(const qsmp_kex_simplex_client_state* kcs, qsmp_connection_state* cns, const qsmp_packet* packetin)
@@ -1433,8 +1815,21 @@ static qsmp_errors kex_simplex_client_establish_verify(const qsmp_kex_simplex_cl
 	{
 		if (cns->exflag == qsmp_flag_exchange_request && packetin->flag == qsmp_flag_exchange_response)
 		{
-			cns->exflag = qsmp_flag_session_established;
-			qerr = qsmp_error_none;
+			if (packetin->msglen == QSMP_TICKET_SIZE + QSMP_SIMPLEX_MACTAG_SIZE)
+			{
+				/* store the resumption ticket issued by the server */
+				qerr = kex_simplex_client_ticket_accept(cns, kcs->keyid, packetin, 0);
+			}
+			else if (packetin->msglen == 0)
+			{
+				qerr = qsmp_error_none;
+			}
+			else
+			{
+				qerr = qsmp_error_invalid_request;
+			}
+
+			cns->exflag = (qerr == qsmp_error_none) ? qsmp_flag_session_established : qsmp_flag_none;
 		}
 		else
 		{
@@ -1450,6 +1845,55 @@ static qsmp_errors kex_simplex_client_establish_verify(const qsmp_kex_simplex_cl
 	return qerr;
 }
 
+static qsmp_errors kex_simplex_server_request_verify(qsmp_kex_simplex_server_state* kss, const qsmp_packet* packetin)
+{
+	char confs[QSMP_CONFIG_SIZE + 1] = { 0 };
+	qsc_keccak_state kstate = { 0 };
+	qsmp_errors qerr;
+	uint64_t tm;
+
+	/* compare the state key-id to the id in the message */
+	if (kex_simplex_server_keyid_verify(kss->keyid, packetin->pmessage) == true)
+	{
+		tm = qsc_timestamp_epochtime_seconds();
+
+		/* check the keys expiration date */
+		if (tm <= kss->expiration)
+		{
+			/* get a copy of the configuration string */
+			qsc_memutils_copy(confs, (packetin->pmessage + QSMP_KEYID_SIZE), QSMP_CONFIG_SIZE);
+
+			/* compare the state configuration string to the message configuration string */
+			if (qsc_stringutils_compare_strings(confs, QSMP_CONFIG_STRING, QSMP_CONFIG_SIZE) == true)
+			{
+				/* store a hash of the configuration string, and the public signature key: sch = H(cfg || pvk) */
+				qsc_memutils_clear(kss->schash, QSMP_SIMPLEX_SCHASH_SIZE);
+				qsc_sha3_initialize(&kstate);
+				qsc_sha3_update(&kstate, qsc_keccak_rate_256, (const uint8_t*)QSMP_CONFIG_STRING, QSMP_CONFIG_SIZE);
+				qsc_sha3_update(&kstate, qsc_keccak_rate_256, kss->keyid, QSMP_KEYID_SIZE);
+				qsc_sha3_update(&kstate, qsc_keccak_rate_256, kss->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
+				qsc_sha3_finalize(&kstate, qsc_keccak_rate_256, kss->schash);
+
+				qerr = qsmp_error_none;
+			}
+			else
+			{
+				qerr = qsmp_error_unknown_protocol;
+			}
+		}
+		else
+		{
+			qerr = qsmp_error_key_expired;
+		}
+	}
+	else
+	{
+		qerr = qsmp_error_key_unrecognized;
+	}
+
+	return qerr;
+}
+
 /*
 Connect Response:
 The server responds with either an error message, or a response packet. 
@@ -1473,11 +1917,8 @@ static qsmp_errors kex_simplex_server_connect_response(qsmp_kex_simplex_server_s
 	assert(packetin != NULL);
 	assert(packetout != NULL);
 
-	char confs[QSMP_CONFIG_SIZE + 1] = { 0 };
 	uint8_t phash[QSMP_SIMPLEX_HASH_SIZE] = { 0 };
-	qsc_keccak_state kstate = { 0 };
 	qsmp_errors qerr;
-	uint64_t tm;
 	size_t mlen;
 
 	qerr = qsmp_error_invalid_input;
@@ -1486,81 +1927,51 @@ static qsmp_errors kex_simplex_server_connect_response(qsmp_kex_simplex_server_s
 	{
 		if (packetin->flag == qsmp_flag_connect_request)
 		{
-			/* compare the state key-id to the id in the message */
-			if (kex_simplex_server_keyid_verify(kss->keyid, packetin->pmessage) == true)
-			{
-				tm = qsc_timestamp_epochtime_seconds();
+			/* verify the key-id, expiration, and configuration string, and store the session cookie */
+			qerr = kex_simplex_server_request_verify(kss, packetin);
 
-				/* check the keys expiration date */
-				if (tm <= kss->expiration)
-				{
-					/* get a copy of the configuration string */
-					qsc_memutils_copy(confs, (packetin->pmessage + QSMP_KEYID_SIZE), QSMP_CONFIG_SIZE);
+			if (qerr == qsmp_error_none)
+			{
+				/* initialize the packet and asymmetric encryption keys */
+				qsc_memutils_clear(kss->pubkey, QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE);
+				qsc_memutils_clear(kss->prikey, QSMP_ASYMMETRIC_PRIVATE_KEY_SIZE);
 
-					/* compare the state configuration string to the message configuration string */
-					if (qsc_stringutils_compare_strings(confs, QSMP_CONFIG_STRING, QSMP_CONFIG_SIZE) == true)
-					{
-						/* store a hash of the configuration string, and the public signature key: sch = H(cfg || pvk) */
-						qsc_memutils_clear(kss->schash, QSMP_SIMPLEX_SCHASH_SIZE);
-						qsc_sha3_initialize(&kstate);
-						qsc_sha3_update(&kstate, qsc_keccak_rate_256, (const uint8_t*)QSMP_CONFIG_STRING, QSMP_CONFIG_SIZE);
-						qsc_sha3_update(&kstate, qsc_keccak_rate_256, kss->keyid, QSMP_KEYID_SIZE);
-						qsc_sha3_update(&kstate, qsc_keccak_rate_256, kss->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
-						qsc_sha3_finalize(&kstate, qsc_keccak_rate_256, kss->schash);
+				/* generate the asymmetric encryption key-pair */
+				qsmp_cipher_generate_keypair(kss->pubkey, kss->prikey, qsc_acp_generate);
 
-						/* initialize the packet and asymmetric encryption keys */
-						qsc_memutils_clear(kss->pubkey, QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE);
-						qsc_memutils_clear(kss->prikey, QSMP_ASYMMETRIC_PRIVATE_KEY_SIZE);
+				/* hash the public encapsulation key */
+				qsc_sha3_compute256(phash, kss->pubkey, QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE);
 
-						/* generate the asymmetric encryption key-pair */
-						qsmp_cipher_generate_keypair(kss->pubkey, kss->prikey, qsc_acp_generate);
+				/* sign the hash and add it to the message */
+				mlen = 0;
+				qsc_memutils_clear(packetout->pmessage, QSMP_MESSAGE_MAX);
+				qsmp_signature_sign(packetout->pmessage, &mlen, phash, QSMP_SIMPLEX_HASH_SIZE, kss->sigkey, qsc_acp_generate);
 
-						/* hash the public encapsulation key */
-						qsc_sha3_compute256(phash, kss->pubkey, QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE);
+				/* copy the public key to the message */
+				qsc_memutils_copy(((uint8_t*)packetout->pmessage + mlen), kss->pubkey, QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE);
 
-						/* sign the hash and add it to the message */
-						mlen = 0;
-						qsc_memutils_clear(packetout->pmessage, QSMP_MESSAGE_MAX);
-						qsmp_signature_sign(packetout->pmessage, &mlen, phash, QSMP_SIMPLEX_HASH_SIZE, kss->sigkey, qsc_acp_generate);
+				/* assemble the connection-response packet */
+				packetout->flag = qsmp_flag_connect_response;
+				packetout->msglen = QSMP_ASYMMETRIC_SIGNATURE_SIZE + QSMP_SIMPLEX_HASH_SIZE + QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE;
+				packetout->sequence = cns->txseq;
 
-						/* copy the public key to the message */
-						qsc_memutils_copy(((uint8_t*)packetout->pmessage + mlen), kss->pubkey, QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE);
+				kss->fopen = false;
+				cns->exflag = qsmp_flag_connect_response;
+			}
+			else
+			{
+				cns->exflag = qsmp_flag_none;
+			}
+		}
+		else
+		{
+			qerr = qsmp_error_invalid_request;
+			cns->exflag = qsmp_flag_none;
+		}
+	}
 
-						/* assemble the connection-response packet */
-						packetout->flag = qsmp_flag_connect_response;
-						packetout->msglen = QSMP_ASYMMETRIC_SIGNATURE_SIZE + QSMP_SIMPLEX_HASH_SIZE + QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE;
-						packetout->sequence = cns->txseq;
-
-						qerr = qsmp_error_none;
-						cns->exflag = qsmp_flag_connect_response;
-					}
-					else
-					{
-						qerr = qsmp_error_unknown_protocol;
-						cns->exflag = qsmp_flag_none;
-					}
-				}
-				else
-				{
-					qerr = qsmp_error_key_expired;
-					cns->exflag = qsmp_flag_none;
-				}
-			}
-			else
-			{
-				qerr = qsmp_error_key_unrecognized;
-				cns->exflag = qsmp_flag_none;
-			}
-		}
-		else
-		{
-			qerr = qsmp_error_invalid_request;
-			cns->exflag = qsmp_flag_none;
-		}
-	}
-
-	return qerr;
-}
+	return qerr;
+}
 
 /*
 Exchange Response:
@@ -1573,9 +1984,11 @@ The receive and transmit channel ciphers are initialized.
 cprrx(k1,n1)
 cprtx(k2,n2)
 The server sets the packet flag to exchange response, indicating that the encrypted channels have been raised, 
-and sends the notification to the client. The server sets the operational state to session established, 
-and is now ready to process data.
-S{ f } -> C
+and sends the notification to the client. If the server holds a ticket key, it seals a resumption ticket 
+and encrypts it on the transmit channel.
+tkt <- Ek(exp || kid || rsec)
+The server sets the operational state to session established, and is now ready to process data.
+S{ f, Ecpr(tkt) } -> C
 */
 static qsmp_errors kex_simplex_server_exchange_response(const qsmp_kex_simplex_server_state* kss, qsmp_connection_state* cns, const qsmp_packet* packetin, qsmp_packet* packetout)
 {
@@ -1600,8 +2013,8 @@ static qsmp_errors kex_simplex_server_exchange_response(const qsmp_kex_simplex_s
 
 				qsc_memutils_clear(packetout->pmessage, QSMP_MESSAGE_MAX);
 
-				/* initialize cSHAKE k = H(ssec, sch) */
-				qsc_cshake_initialize(&kstate, qsc_keccak_rate_256, ssec, sizeof(ssec), kss->schash, QSMP_SIMPLEX_SCHASH_SIZE, NULL, 0);
+				/* initialize cSHAKE k = H(ssec, sch), a fast-open exchange adds the server nonce k = H(ssec, sch, sn) */
+				qsc_cshake_initialize(&kstate, qsc_keccak_rate_256, ssec, sizeof(ssec), kss->schash, QSMP_SIMPLEX_SCHASH_SIZE, (kss->fopen == true) ? kss->fonce : NULL, (kss->fopen == true) ? QSMP_NONCE_SIZE : 0);
 				qsc_cshake_squeezeblocks(&kstate, qsc_keccak_rate_256, prnd, 2);
 				/* permute the state so we are not storing the current key */
 				qsc_keccak_permute(&kstate, QSC_KECCAK_PERMUTATION_ROUNDS);
@@ -1631,19 +2044,857 @@ static qsmp_errors kex_simplex_server_exchange_response(const qsmp_kex_simplex_s
 				packetout->msglen = 0;
 				packetout->sequence = cns->txseq;
 
+				if (kss->tktkey != NULL)
+				{
+					/* issue a resumption ticket for the new session */
+					kex_simplex_server_ticket_issue(kss, cns, packetout, 0);
+				}
+
 				qerr = qsmp_error_none;
 				cns->exflag = qsmp_flag_session_established;
 			}
 			else
 			{
-				qerr = qsmp_error_decapsulation_failure;
-				cns->exflag = qsmp_flag_none;
+				qerr = qsmp_error_decapsulation_failure;
+				cns->exflag = qsmp_flag_none;
+			}
+		}
+		else
+		{
+			qerr = qsmp_error_invalid_request;
+			cns->exflag = qsmp_flag_none;
+		}
+	}
+	else
+	{
+		qerr = qsmp_error_invalid_input;
+	}
+
+	return qerr;
+}
+
+/*
+Resume Request:
+The client presents a resumption ticket issued in a previous session, in place of the asymmetric key exchange.
+The client generates a random nonce, and binds the request to the resumption secret with a MAC.
+bnd <- Mrsec(hdr || kid || cfg || tkt || cn)
+The client sends the key identity, the configuration string, the ticket, the nonce, and the binder to the server.
+C{ kid, cfg, tkt, cn, bnd } -> S
+*/
+static qsmp_errors kex_simplex_client_resume_request(const qsmp_session_ticket* ticket, qsmp_connection_state* cns, uint8_t* cnonce, qsmp_packet* packetout)
+{
+	assert(ticket != NULL);
+	assert(cns != NULL);
+	assert(cnonce != NULL);
+	assert(packetout != NULL);
+
+	qsmp_errors qerr;
+	size_t mpos;
+	uint64_t tm;
+
+	if (ticket != NULL && cns != NULL && cnonce != NULL && packetout != NULL)
+	{
+		tm = qsc_timestamp_epochtime_seconds();
+
+		if (tm <= ticket->expiration)
+		{
+			/* generate the client nonce */
+			qsc_acp_generate(cnonce, QSMP_NONCE_SIZE);
+
+			/* copy the key-id, configuration string, ticket, and nonce to the message */
+			qsc_memutils_copy(packetout->pmessage, ticket->keyid, QSMP_KEYID_SIZE);
+			mpos = QSMP_KEYID_SIZE;
+			qsc_memutils_copy(packetout->pmessage + mpos, QSMP_CONFIG_STRING, QSMP_CONFIG_SIZE);
+			mpos += QSMP_CONFIG_SIZE;
+			qsc_memutils_copy(packetout->pmessage + mpos, ticket->ticket, QSMP_TICKET_SIZE);
+			mpos += QSMP_TICKET_SIZE;
+			qsc_memutils_copy(packetout->pmessage + mpos, cnonce, QSMP_NONCE_SIZE);
+			mpos += QSMP_NONCE_SIZE;
+
+			/* assemble the resume-request packet, and append the binder */
+			packetout->flag = qsmp_flag_resume_request;
+			packetout->msglen = QSMP_RESUME_REQUEST_SIZE;
+			packetout->sequence = cns->txseq;
+			kex_resume_binder(packetout->pmessage + mpos, packetout, ticket->secret);
+
+			qerr = qsmp_error_none;
+			cns->exflag = qsmp_flag_resume_request;
+		}
+		else
+		{
+			qerr = qsmp_error_key_expired;
+			cns->exflag = qsmp_flag_none;
+		}
+	}
+	else
+	{
+		qerr = qsmp_error_invalid_input;
+	}
+
+	return qerr;
+}
+
+/*
+Resume Verify:
+The client combines the resumption secret and both nonces to create the session keys.
+k1, k2, n1, n2 <- KDF(rsec, cn || sn)
+The receive and transmit channel ciphers are initialized.
+cprrx(k2,n2)
+cprtx(k1,n1)
+The client decrypts the replacement ticket on the receive channel, a valid MAC confirms the server holds the same keys.
+The client stores the new ticket, sets the operational state to session established, and is now ready to process data.
+*/
+static qsmp_errors kex_simplex_client_resume_verify(const qsmp_session_ticket* ticket, qsmp_connection_state* cns, const uint8_t* cnonce, const qsmp_packet* packetin)
+{
+	assert(ticket != NULL);
+	assert(cns != NULL);
+	assert(cnonce != NULL);
+	assert(packetin != NULL);
+
+	uint8_t keyid[QSMP_KEYID_SIZE] = { 0 };
+	qsmp_errors qerr;
+
+	if (ticket != NULL && cns != NULL && cnonce != NULL && packetin != NULL)
+	{
+		if (cns->exflag == qsmp_flag_resume_request && packetin->flag == qsmp_flag_resume_response && packetin->msglen == QSMP_RESUME_RESPONSE_SIZE)
+		{
+			/* the ticket may be stored in the connection state, the key identity is copied before it is replaced */
+			qsc_memutils_copy(keyid, ticket->keyid, QSMP_KEYID_SIZE);
+			kex_resume_keys(cns, ticket->secret, cnonce, packetin->pmessage, false);
+			qerr = kex_simplex_client_ticket_accept(cns, keyid, packetin, QSMP_NONCE_SIZE);
+			cns->exflag = (qerr == qsmp_error_none) ? qsmp_flag_session_established : qsmp_flag_none;
+		}
+		else
+		{
+			qerr = qsmp_error_invalid_request;
+			cns->exflag = qsmp_flag_none;
+		}
+	}
+	else
+	{
+		qerr = qsmp_error_invalid_input;
+	}
+
+	return qerr;
+}
+
+/*
+Resume Response:
+The server checks the key identity and configuration string, then decrypts the ticket with its ticket key,
+and checks the ticket and key expiration times.
+exp, kid, rsec <- -Ek(tkt)
+The server verifies the binder, which proves the client holds the resumption secret.
+cond <- Mrsec(hdr || kid || cfg || tkt || cn) = (true ?= bnd : 0)
+The server generates a random nonce, and combines it with the client nonce and the resumption secret to create the session keys.
+k1, k2, n1, n2 <- KDF(rsec, cn || sn)
+The receive and transmit channel ciphers are initialized.
+cprrx(k1,n1)
+cprtx(k2,n2)
+The server issues a replacement ticket for the new session, encrypted on the transmit channel.
+The server sets the operational state to session established, and is now ready to process data.
+S{ sn, Ecpr(tkt) } -> C
+*/
+static qsmp_errors kex_simplex_server_resume_response(const qsmp_kex_simplex_server_state* kss, qsmp_connection_state* cns, const qsmp_packet* packetin, qsmp_packet* packetout)
+{
+	assert(kss != NULL);
+	assert(cns != NULL);
+	assert(packetin != NULL);
+	assert(packetout != NULL);
+
+	char confs[QSMP_CONFIG_SIZE + 1] = { 0 };
+	uint8_t bndr[QSMP_SIMPLEX_MACTAG_SIZE] = { 0 };
+	uint8_t rkid[QSMP_KEYID_SIZE] = { 0 };
+	uint8_t rsec[QSMP_SECRET_SIZE] = { 0 };
+	const uint8_t* pmsg;
+	qsmp_errors qerr;
+	uint64_t texp;
+	uint64_t tm;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (kss != NULL && cns != NULL && packetin != NULL && packetout != NULL)
+	{
+		if (packetin->flag == qsmp_flag_resume_request && packetin->msglen == QSMP_RESUME_REQUEST_SIZE && kss->tktkey != NULL)
+		{
+			pmsg = packetin->pmessage;
+			tm = qsc_timestamp_epochtime_seconds();
+			qsc_memutils_copy(confs, pmsg + QSMP_KEYID_SIZE, QSMP_CONFIG_SIZE);
+
+			if (kex_simplex_server_keyid_verify(kss->keyid, pmsg) == false)
+			{
+				qerr = qsmp_error_key_unrecognized;
+			}
+			else if (qsc_stringutils_compare_strings(confs, QSMP_CONFIG_STRING, QSMP_CONFIG_SIZE) == false)
+			{
+				qerr = qsmp_error_unknown_protocol;
+			}
+			else if (kex_ticket_open(pmsg + QSMP_KEYID_SIZE + QSMP_CONFIG_SIZE, kss->tktkey, rkid, rsec, &texp) == false || 
+				kex_simplex_server_keyid_verify(kss->keyid, rkid) == false)
+			{
+				qerr = qsmp_error_authentication_failure;
+			}
+			else if (tm > texp || tm > kss->expiration)
+			{
+				qerr = qsmp_error_key_expired;
+			}
+			else
+			{
+				kex_resume_binder(bndr, packetin, rsec);
+
+				if (qsc_intutils_verify(bndr, pmsg + QSMP_RESUME_REQUEST_SIZE - QSMP_SIMPLEX_MACTAG_SIZE, QSMP_SIMPLEX_MACTAG_SIZE) == 0)
+				{
+					/* generate the server nonce, and raise the channels */
+					qsc_memutils_clear(packetout->pmessage, QSMP_MESSAGE_MAX);
+					qsc_acp_generate(packetout->pmessage, QSMP_NONCE_SIZE);
+					kex_resume_keys(cns, rsec, pmsg + QSMP_RESUME_REQUEST_SIZE - (QSMP_NONCE_SIZE + QSMP_SIMPLEX_MACTAG_SIZE), packetout->pmessage, true);
+
+					/* assemble the resume-response packet with a replacement ticket */
+					packetout->flag = qsmp_flag_resume_response;
+					packetout->sequence = cns->txseq;
+					kex_simplex_server_ticket_issue(kss, cns, packetout, QSMP_NONCE_SIZE);
+
+					qerr = qsmp_error_none;
+				}
+				else
+				{
+					qerr = qsmp_error_authentication_failure;
+				}
+			}
+
+			qsc_memutils_clear(rsec, sizeof(rsec));
+		}
+		else
+		{
+			qerr = qsmp_error_invalid_request;
+		}
+
+		cns->exflag = (qerr == qsmp_error_none) ? qsmp_flag_session_established : qsmp_flag_none;
+	}
+
+	return qerr;
+}
+
+/*
+Fast-open Request:
+The client sends a connection request, and if it holds a current copy of the servers fast-open key, 
+it encapsulates a shared secret with that key and sends the cipher-text with the request.
+sch <- H(cfg || kid || pvk)
+cpt, sec <- AEfpk(sec)
+The client sends the key identity, the configuration string, and with a cached key, the hash of the fast-open key and the cipher-text.
+C{ kid, cfg, [H(fpk), cpt] } -> S
+*/
+static qsmp_errors kex_simplex_client_fastopen_request(qsmp_kex_simplex_client_state* kcs, const qsmp_fastopen_key* fokey, qsmp_connection_state* cns, qsmp_packet* packetout)
+{
+	assert(kcs != NULL);
+	assert(fokey != NULL);
+	assert(cns != NULL);
+	assert(packetout != NULL);
+
+	size_t moff;
+	qsmp_errors qerr;
+	uint64_t tm;
+
+	if (kcs != NULL && fokey != NULL && cns != NULL && packetout != NULL)
+	{
+		/* the request opens with the same key-id and configuration string as a connection request */
+		qerr = kex_simplex_client_connect_request(kcs, cns, packetout);
+
+		if (qerr == qsmp_error_none)
+		{
+			tm = qsc_timestamp_epochtime_seconds();
+			packetout->flag = qsmp_flag_fastopen_request;
+
+			if (tm <= fokey->expiration && qsc_intutils_verify(fokey->keyid, kcs->keyid, QSMP_KEYID_SIZE) == 0)
+			{
+				moff = QSMP_KEYID_SIZE + QSMP_CONFIG_SIZE;
+				/* identify the cached key, and encapsulate the secret with it */
+				qsc_sha3_compute256(packetout->pmessage + moff, fokey->pubkey, QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE);
+				moff += QSMP_SIMPLEX_HASH_SIZE;
+				qsmp_cipher_encapsulate(kcs->ssec, packetout->pmessage + moff, fokey->pubkey, qsc_acp_generate);
+				packetout->msglen = QSMP_FASTOPEN_REQUEST_SIZE;
+				cns->exflag = qsmp_flag_fastopen_request;
+			}
+		}
+	}
+	else
+	{
+		qerr = qsmp_error_invalid_input;
+	}
+
+	return qerr;
+}
+
+/*
+Fast-open Verify:
+The server accepted the cipher-text, and sent its nonce with the exchange response.
+The client combines the secret, the session cookie, and the server nonce to create the session keys.
+k1, k2, n1, n2 <- KDF(sec, sch, sn)
+The receive and transmit channel ciphers are initialized.
+cprrx(k2,n2)
+cprtx(k1,n1)
+If the server issued a resumption ticket, the client decrypts it on the receive channel and stores it.
+The client sets the operational state to session established, and is now ready to process data.
+*/
+static qsmp_errors kex_simplex_client_fastopen_verify(qsmp_kex_simplex_client_state* kcs, qsmp_connection_state* cns, const qsmp_packet* packetin)
+{
+	assert(kcs != NULL);
+	assert(cns != NULL);
+	assert(packetin != NULL);
+
+	qsmp_errors qerr;
+
+	if (kcs != NULL && cns != NULL && packetin != NULL)
+	{
+		if (cns->exflag == qsmp_flag_fastopen_request && packetin->flag == qsmp_flag_exchange_response &&
+			(packetin->msglen == QSMP_NONCE_SIZE || packetin->msglen == QSMP_NONCE_SIZE + QSMP_TICKET_SIZE + QSMP_SIMPLEX_MACTAG_SIZE))
+		{
+			/* the server nonce makes the session keys unique to this exchange: k <- H(sec, sch, sn) */
+			kex_simplex_raise_channels(cns, kcs->ssec, kcs->schash, QSMP_SIMPLEX_SCHASH_SIZE, packetin->pmessage, QSMP_NONCE_SIZE, false);
+
+			if (packetin->msglen != QSMP_NONCE_SIZE)
+			{
+				/* store the resumption ticket issued by the server */
+				qerr = kex_simplex_client_ticket_accept(cns, kcs->keyid, packetin, QSMP_NONCE_SIZE);
+			}
+			else
+			{
+				qerr = qsmp_error_none;
+			}
+
+			cns->exflag = (qerr == qsmp_error_none) ? qsmp_flag_session_established : qsmp_flag_none;
+		}
+		else
+		{
+			qerr = qsmp_error_invalid_request;
+			cns->exflag = qsmp_flag_none;
+		}
+	}
+	else
+	{
+		qerr = qsmp_error_invalid_input;
+	}
+
+	return qerr;
+}
+
+/*
+Fast-open Exchange Request:
+The server did not accept the cached key, and sent its current fast-open key, signed with its expiration time, and its nonce.
+The client verifies the signature of the hash, compares it to its own hash of the expiration and key, and checks the expiration.
+cond <- AVpk(H(exp || fpk)) = (true ?= fpk : 0)
+The client stores the key in its cache, then encapsulates a secret, and combines it with the session cookie and the server nonce.
+cpt, sec <- AEfpk(sec)
+k1, k2, n1, n2 <- KDF(sec, sch, sn)
+The receive and transmit channel ciphers are initialized.
+cprrx(k2,n2)
+cprtx(k1,n1)
+The client sends the cipher-text to the server.
+C{ cpt } -> S
+*/
+static qsmp_errors kex_simplex_client_fastopen_exchange_request(qsmp_kex_simplex_client_state* kcs, qsmp_fastopen_key* fokey, qsmp_connection_state* cns, const qsmp_packet* packetin, qsmp_packet* packetout)
+{
+	assert(kcs != NULL);
+	assert(fokey != NULL);
+	assert(cns != NULL);
+	assert(packetin != NULL);
+	assert(packetout != NULL);
+
+	uint8_t khash[QSMP_SIMPLEX_HASH_SIZE] = { 0 };
+	uint8_t phash[QSMP_SIMPLEX_HASH_SIZE] = { 0 };
+	const uint8_t* pexp;
+	const uint8_t* pkey;
+	const uint8_t* snce;
+	size_t mlen;
+	size_t slen;
+	qsmp_errors qerr;
+	uint64_t exp;
+
+	if (kcs != NULL && fokey != NULL && cns != NULL && packetin != NULL && packetout != NULL)
+	{
+		if ((cns->exflag == qsmp_flag_connect_request || cns->exflag == qsmp_flag_fastopen_request) && 
+			packetin->flag == qsmp_flag_fastopen_response && packetin->msglen == QSMP_FASTOPEN_RESPONSE_SIZE)
+		{
+			slen = 0;
+
+#if defined(QSMP_FALCON_SIGNATURE)
+			const size_t FLCDLM = 42;
+			/* Note: accounts for a signature encoding length variance in falcon signature size,
+			by decoding the signature size directly from the raw signature */
+			mlen = ((size_t)packetin->pmessage[0] << 8) | (size_t)packetin->pmessage[1] + FLCDLM + QSMP_SIMPLEX_HASH_SIZE;
+#else
+			mlen = QSMP_ASYMMETRIC_SIGNATURE_SIZE + QSMP_SIMPLEX_HASH_SIZE;
+#endif
+			/* the signed hash is held in a fixed size field, followed by the expiration, the key, and the server nonce */
+			pexp = packetin->pmessage + QSMP_ASYMMETRIC_SIGNATURE_SIZE + QSMP_SIMPLEX_HASH_SIZE;
+			pkey = pexp + QSMP_TIMESTAMP_SIZE;
+			snce = pkey + QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE;
+
+			/* verify the asymmetric signature */
+			if (mlen <= QSMP_ASYMMETRIC_SIGNATURE_SIZE + QSMP_SIMPLEX_HASH_SIZE && 
+				qsmp_signature_verify(khash, &slen, packetin->pmessage, mlen, kcs->verkey) == true)
+			{
+				/* verify the hash of the expiration and key */
+				kex_fastopen_key_hash(phash, pexp, pkey);
+				exp = qsc_intutils_le8to64(pexp);
+
+				if (qsc_intutils_verify(phash, khash, QSMP_SIMPLEX_HASH_SIZE) == 0 && exp >= qsc_timestamp_epochtime_seconds())
+				{
+					/* cache the key for the next connection */
+					qsc_memutils_copy(fokey->pubkey, pkey, QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE);
+					qsc_memutils_copy(fokey->keyid, kcs->keyid, QSMP_KEYID_SIZE);
+					fokey->expiration = exp;
+
+					/* generate, and encapsulate the secret */
+					qsc_memutils_clear(packetout->pmessage, QSMP_MESSAGE_MAX);
+					qsmp_cipher_encapsulate(kcs->ssec, packetout->pmessage, fokey->pubkey, qsc_acp_generate);
+
+					/* assemble the exchange-request packet */
+					packetout->flag = qsmp_flag_exchange_request;
+					packetout->msglen = QSMP_ASYMMETRIC_CIPHER_TEXT_SIZE;
+					packetout->sequence = cns->txseq;
+
+					/* raise the channels: k <- H(sec, sch, sn) */
+					kex_simplex_raise_channels(cns, kcs->ssec, kcs->schash, QSMP_SIMPLEX_SCHASH_SIZE, snce, QSMP_NONCE_SIZE, false);
+
+					qerr = qsmp_error_none;
+					cns->exflag = qsmp_flag_exchange_request;
+				}
+				else
+				{
+					qerr = qsmp_error_hash_invalid;
+					cns->exflag = qsmp_flag_none;
+				}
+			}
+			else
+			{
+				qerr = qsmp_error_authentication_failure;
+				cns->exflag = qsmp_flag_none;
+			}
+		}
+		else
+		{
+			qerr = qsmp_error_invalid_request;
+			cns->exflag = qsmp_flag_none;
+		}
+	}
+	else
+	{
+		qerr = qsmp_error_invalid_input;
+	}
+
+	return qerr;
+}
+
+/*
+Fast-open Response:
+The server checks the key identity and configuration string as with a connection request, and stores the session cookie hash.
+sch <- H(cfg || kid || pvk)
+The server generates a nonce, and rotates its fast-open key if it has expired; the key is signed with its expiration time.
+fpk, fsk <- AG(cfg)
+sfpkh <- ASsk(H(exp || fpk))
+If the request carries a cipher-text for the current fast-open key, the server decapsulates the secret, and raises the channels.
+sec <- -AEfsk(cpt)
+k1, k2, n1, n2 <- KDF(sec, sch, sn)
+cprrx(k1,n1)
+cprtx(k2,n2)
+The server sends an exchange response with its nonce, and if it holds a ticket key, a resumption ticket, 
+and the session is established in a single round trip.
+S{ sn, Ecpr(tkt) } -> C
+Otherwise the server sends its current fast-open key, and the exchange continues with an exchange request.
+S{ sfpkh, exp, fpk, sn } -> C
+*/
+static qsmp_errors kex_simplex_server_fastopen_response(qsmp_kex_simplex_server_state* kss, qsmp_connection_state* cns, const qsmp_packet* packetin, qsmp_packet* packetout)
+{
+	assert(kss != NULL);
+	assert(cns != NULL);
+	assert(packetin != NULL);
+	assert(packetout != NULL);
+
+	uint8_t ssec[QSMP_SECRET_SIZE] = { 0 };
+	qsmp_kex_fastopen_state* fos;
+	size_t moff;
+	qsmp_errors qerr;
+	bool acpt;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (kss != NULL && cns != NULL && packetin != NULL && packetout != NULL)
+	{
+		fos = kss->fostate;
+
+		if (fos != NULL && packetin->flag == qsmp_flag_fastopen_request && 
+			(packetin->msglen == QSMP_KEYID_SIZE + QSMP_CONFIG_SIZE || packetin->msglen == QSMP_FASTOPEN_REQUEST_SIZE))
+		{
+			/* the key identity and configuration are checked, and the session cookie stored, as with a connection request */
+			qerr = kex_simplex_server_request_verify(kss, packetin);
+
+			if (qerr == qsmp_error_none)
+			{
+				qsc_memutils_clear(packetout->pmessage, QSMP_MESSAGE_MAX);
+				qsc_acp_generate(kss->fonce, QSMP_NONCE_SIZE);
+				kss->fopen = true;
+				moff = QSMP_KEYID_SIZE + QSMP_CONFIG_SIZE;
+
+				qsc_async_mutex_lock(fos->lock);
+
+				if (qsc_timestamp_epochtime_seconds() > fos->expiration)
+				{
+					kex_fastopen_refresh(fos, kss->sigkey);
+				}
+
+				/* the exchange uses the current fast-open key in place of an ephemeral key */
+				qsc_memutils_copy(kss->prikey, fos->prikey, QSMP_ASYMMETRIC_PRIVATE_KEY_SIZE);
+				acpt = (packetin->msglen == QSMP_FASTOPEN_REQUEST_SIZE &&
+					qsc_intutils_verify(packetin->pmessage + moff, fos->pkhash, QSMP_SIMPLEX_HASH_SIZE) == 0);
+
+				if (acpt == false)
+				{
+					/* send the signed key, its expiration, the key, and the nonce */
+					moff = QSMP_ASYMMETRIC_SIGNATURE_SIZE + QSMP_SIMPLEX_HASH_SIZE;
+					qsc_memutils_copy(packetout->pmessage, fos->sigkh, moff);
+					qsc_intutils_le64to8(packetout->pmessage + moff, fos->expiration);
+					moff += QSMP_TIMESTAMP_SIZE;
+					qsc_memutils_copy(packetout->pmessage + moff, fos->pubkey, QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE);
+					moff += QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE;
+					qsc_memutils_copy(packetout->pmessage + moff, kss->fonce, QSMP_NONCE_SIZE);
+				}
+
+				qsc_async_mutex_unlock(fos->lock);
+
+				if (acpt == true)
+				{
+					moff += QSMP_SIMPLEX_HASH_SIZE;
+
+					/* decapsulate the shared secret */
+					if (qsmp_cipher_decapsulate(ssec, packetin->pmessage + moff, kss->prikey) == true)
+					{
+						/* raise the channels: k <- H(sec, sch, sn) */
+						kex_simplex_raise_channels(cns, ssec, kss->schash, QSMP_SIMPLEX_SCHASH_SIZE, kss->fonce, QSMP_NONCE_SIZE, true);
+
+						/* assemble the exchange-response packet */
+						qsc_memutils_copy(packetout->pmessage, kss->fonce, QSMP_NONCE_SIZE);
+						packetout->flag = qsmp_flag_exchange_response;
+						packetout->msglen = QSMP_NONCE_SIZE;
+						packetout->sequence = cns->txseq;
+
+						if (kss->tktkey != NULL)
+						{
+							/* issue a resumption ticket for the new session */
+							kex_simplex_server_ticket_issue(kss, cns, packetout, QSMP_NONCE_SIZE);
+						}
+
+						qerr = qsmp_error_none;
+						cns->exflag = qsmp_flag_session_established;
+					}
+					else
+					{
+						qerr = qsmp_error_decapsulation_failure;
+						cns->exflag = qsmp_flag_none;
+					}
+
+					qsc_memutils_clear(ssec, sizeof(ssec));
+				}
+				else
+				{
+					/* assemble the fast-open response packet, the exchange continues with the exchange request */
+					packetout->flag = qsmp_flag_fastopen_response;
+					packetout->msglen = QSMP_FASTOPEN_RESPONSE_SIZE;
+					packetout->sequence = cns->txseq;
+					cns->exflag = qsmp_flag_connect_response;
+				}
+			}
+			else
+			{
+				cns->exflag = qsmp_flag_none;
+			}
+		}
+		else
+		{
+			qerr = qsmp_error_invalid_request;
+			cns->exflag = qsmp_flag_none;
+		}
+	}
+
+	return qerr;
+}
+
+static qsmp_errors kex_simplex_client_exchange(qsmp_kex_simplex_client_state* kcs, qsmp_connection_state* cns, uint8_t* mreqt, uint8_t* mresp, uint8_t* spct)
+{
+	assert(kcs != NULL);
+	assert(cns != NULL);
+
+	qsmp_packet reqt = { 0 };
+	qsmp_packet resp = { 0 };
+	qsmp_errors qerr;
+	size_t plen;
+	size_t rlen;
+	size_t slen;
+
+	if (kcs != NULL && cns != NULL)
+	{
+		/* create the connection request packet */
+		reqt.pmessage = mreqt;
+		qerr = kex_simplex_client_connect_request(kcs, cns, &reqt);
+
+		if (qerr == qsmp_error_none)
+		{
+			/* convert the packet to bytes */
+			plen = qsmp_packet_to_stream(&reqt, spct);
+			/* send the connection request */
+			slen = qsc_socket_send(&cns->target, spct, plen, qsc_socket_send_flag_none);
+			qsc_memutils_clear(spct, plen + 1);
+
+			if (slen == plen + QSC_SOCKET_TERMINATOR_SIZE)
+			{
+				const size_t CONLEN = QSMP_ASYMMETRIC_SIGNATURE_SIZE + QSMP_SIMPLEX_HASH_SIZE + QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE + QSMP_HEADER_SIZE + QSC_SOCKET_TERMINATOR_SIZE;
+
+				cns->txseq += 1;
+
+				/* blocking receive waits for server */
+				rlen = qsc_socket_receive(&cns->target, spct, CONLEN, qsc_socket_receive_flag_wait_all);
+
+				if (rlen == CONLEN)
+				{
+					/* convert server response to packet */
+					resp.pmessage = mresp;
+					qsmp_stream_to_packet(spct, &resp);
+					qsc_memutils_clear(spct, rlen);
+
+					if (resp.sequence == cns->rxseq)
+					{
+						cns->rxseq += 1;
+
+						if (resp.flag == qsmp_flag_connect_response)
+						{
+							/* clear the request packet */
+							qsmp_packet_clear(&reqt);
+							/* create the exstart request packet */
+							qerr = kex_simplex_client_exchange_request(kcs, cns, &resp, &reqt);
+						}
+						else
+						{
+							/* if we receive an error, set the error flag from the packet */
+							if (resp.flag == qsmp_flag_error_condition)
+							{
+								qerr = (qsmp_errors)resp.pmessage[0];
+							}
+							else
+							{
+								qerr = qsmp_error_connect_failure;
+							}
+						}
+					}
+					else
+					{
+						qerr = qsmp_error_packet_unsequenced;
+					}
+				}
+				else
+				{
+					qerr = qsmp_error_receive_failure;
+				}
+			}
+			else
+			{
+				qerr = qsmp_error_transmit_failure;
+			}
+		}
+
+		if (qerr == qsmp_error_none)
+		{
+			qsmp_packet_clear(&resp);
+			plen = qsmp_packet_to_stream(&reqt, spct);
+			slen = qsc_socket_send(&cns->target, spct, plen, qsc_socket_send_flag_none);
+			qsc_memutils_clear(spct, plen + 1);
+
+			if (slen == plen + QSC_SOCKET_TERMINATOR_SIZE)
+			{
+				cns->txseq += 1;
+				/* the exchange response may carry a resumption ticket */
+				rlen = kex_receive_packet(&cns->target, spct, &resp, QSMP_TICKET_SIZE + QSMP_SIMPLEX_MACTAG_SIZE);
+				qsc_memutils_clear(spct, rlen);
+
+				if (rlen != 0)
+				{
+					if (resp.sequence == cns->rxseq)
+					{
+						cns->rxseq += 1;
+
+						if (resp.flag == qsmp_flag_exchange_response)
+						{
+							/* verify the exchange  */
+							qerr = kex_simplex_client_establish_verify(kcs, cns, &resp);
+						}
+						else
+						{
+							if (resp.flag == qsmp_flag_error_condition)
+							{
+								qerr = (qsmp_errors)resp.pmessage[0];
+							}
+							else
+							{
+								qerr = qsmp_error_establish_failure;
+							}
+						}
+					}
+					else
+					{
+						qerr = qsmp_error_packet_unsequenced;
+					}
+				}
+				else
+				{
+					qerr = qsmp_error_receive_failure;
+				}
+			}
+			else
+			{
+				qerr = qsmp_error_transmit_failure;
+			}
+		}
+
+		kex_simplex_client_reset(kcs);
+
+		if (qerr != qsmp_error_none)
+		{
+			if (cns->target.connection_status == qsc_socket_state_connected)
+			{
+				kex_client_send_error(&cns->target, qerr);
+				qsc_socket_shut_down(&cns->target, qsc_socket_shut_down_flag_both);
+			}
+
+			qsmp_connection_state_dispose(cns);
+		}
+	}
+	else
+	{
+		qerr = qsmp_error_invalid_input;
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_kex_simplex_client_key_exchange(qsmp_kex_simplex_client_state* kcs, qsmp_connection_state* cns)
+{
+	assert(kcs != NULL);
+	assert(cns != NULL);
+
+	uint8_t* mreqt;
+	uint8_t* mresp;
+	uint8_t* spct;
+	qsmp_errors qerr;
+
+	/* the exchange messages are held in pooled handshake buffers, rather than on the stack of the calling thread */
+	mreqt = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	mresp = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	spct = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+
+	if (mreqt != NULL && mresp != NULL && spct != NULL)
+	{
+		qerr = kex_simplex_client_exchange(kcs, cns, mreqt, mresp, spct);
+	}
+	else
+	{
+		qerr = qsmp_error_memory_allocation;
+
+		if (cns != NULL && cns->target.connection_status == qsc_socket_state_connected)
+		{
+			kex_client_send_error(&cns->target, qerr);
+			qsc_socket_shut_down(&cns->target, qsc_socket_shut_down_flag_both);
+		}
+	}
+
+	qsmp_bufferpool_release(mreqt, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	qsmp_bufferpool_release(mresp, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	qsmp_bufferpool_release(spct, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+
+	return qerr;
+}
+
+static qsmp_errors kex_simplex_client_resume_exchange(const qsmp_session_ticket* ticket, qsmp_connection_state* cns, uint8_t* mreqt, uint8_t* mresp, uint8_t* spct)
+{
+	assert(ticket != NULL);
+	assert(cns != NULL);
+
+	uint8_t cnce[QSMP_NONCE_SIZE] = { 0 };
+	qsmp_packet reqt = { 0 };
+	qsmp_packet resp = { 0 };
+	qsmp_errors qerr;
+	size_t plen;
+	size_t rlen;
+	size_t slen;
+
+	if (ticket != NULL && cns != NULL)
+	{
+		/* create the resume request packet */
+		reqt.pmessage = mreqt;
+		qerr = kex_simplex_client_resume_request(ticket, cns, cnce, &reqt);
+
+		if (qerr == qsmp_error_none)
+		{
+			plen = qsmp_packet_to_stream(&reqt, spct);
+			slen = qsc_socket_send(&cns->target, spct, plen, qsc_socket_send_flag_none);
+			qsc_memutils_clear(spct, plen + 1);
+
+			if (slen == plen + QSC_SOCKET_TERMINATOR_SIZE)
+			{
+				cns->txseq += 1;
+
+				/* blocking receive waits for server */
+				resp.pmessage = mresp;
+				rlen = kex_receive_packet(&cns->target, spct, &resp, QSMP_RESUME_RESPONSE_SIZE);
+				qsc_memutils_clear(spct, rlen);
+
+				if (rlen != 0)
+				{
+					if (resp.sequence == cns->rxseq)
+					{
+						cns->rxseq += 1;
+
+						if (resp.flag == qsmp_flag_resume_response)
+						{
+							/* raise the channels and store the replacement ticket */
+							qerr = kex_simplex_client_resume_verify(ticket, cns, cnce, &resp);
+						}
+						else
+						{
+							if (resp.flag == qsmp_flag_error_condition)
+							{
+								qerr = (qsmp_errors)resp.pmessage[0];
+							}
+							else
+							{
+								qerr = qsmp_error_establish_failure;
+							}
+						}
+					}
+					else
+					{
+						qerr = qsmp_error_packet_unsequenced;
+					}
+				}
+				else
+				{
+					qerr = qsmp_error_receive_failure;
+				}
+			}
+			else
+			{
+				qerr = qsmp_error_transmit_failure;
 			}
 		}
-		else
+
+		qsc_memutils_clear(cnce, sizeof(cnce));
+
+		if (qerr != qsmp_error_none)
 		{
-			qerr = qsmp_error_invalid_request;
-			cns->exflag = qsmp_flag_none;
+			if (cns->target.connection_status == qsc_socket_state_connected)
+			{
+				kex_client_send_error(&cns->target, qerr);
+				qsc_socket_shut_down(&cns->target, qsc_socket_shut_down_flag_both);
+			}
+
+			qsmp_connection_state_dispose(cns);
 		}
 	}
 	else
@@ -1654,14 +2905,48 @@ static qsmp_errors kex_simplex_server_exchange_response(const qsmp_kex_simplex_s
 	return qerr;
 }
 
-qsmp_errors qsmp_kex_simplex_client_key_exchange(qsmp_kex_simplex_client_state* kcs, qsmp_connection_state* cns)
+qsmp_errors qsmp_kex_simplex_client_resume(const qsmp_session_ticket* ticket, qsmp_connection_state* cns)
+{
+	assert(ticket != NULL);
+	assert(cns != NULL);
+
+	uint8_t* mreqt;
+	uint8_t* mresp;
+	uint8_t* spct;
+	qsmp_errors qerr;
+
+	mreqt = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	mresp = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	spct = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+
+	if (mreqt != NULL && mresp != NULL && spct != NULL)
+	{
+		qerr = kex_simplex_client_resume_exchange(ticket, cns, mreqt, mresp, spct);
+	}
+	else
+	{
+		qerr = qsmp_error_memory_allocation;
+
+		if (cns != NULL && cns->target.connection_status == qsc_socket_state_connected)
+		{
+			kex_client_send_error(&cns->target, qerr);
+			qsc_socket_shut_down(&cns->target, qsc_socket_shut_down_flag_both);
+		}
+	}
+
+	qsmp_bufferpool_release(mreqt, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	qsmp_bufferpool_release(mresp, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	qsmp_bufferpool_release(spct, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+
+	return qerr;
+}
+
+static qsmp_errors kex_simplex_client_fastopen_exchange(qsmp_kex_simplex_client_state* kcs, qsmp_fastopen_key* fokey, qsmp_connection_state* cns, uint8_t* mreqt, uint8_t* mresp, uint8_t* spct)
 {
 	assert(kcs != NULL);
+	assert(fokey != NULL);
 	assert(cns != NULL);
 
-	uint8_t spct[QSMP_MESSAGE_MAX + 1] = { 0 };
-	uint8_t mreqt[QSMP_MESSAGE_MAX + 1] = { 0 };
-	uint8_t mresp[QSMP_MESSAGE_MAX + 1] = { 0 };
 	qsmp_packet reqt = { 0 };
 	qsmp_packet resp = { 0 };
 	qsmp_errors qerr;
@@ -1669,50 +2954,46 @@ qsmp_errors qsmp_kex_simplex_client_key_exchange(qsmp_kex_simplex_client_state*
 	size_t rlen;
 	size_t slen;
 
-	if (kcs != NULL && cns != NULL)
+	if (kcs != NULL && fokey != NULL && cns != NULL)
 	{
-		/* create the connection request packet */
+		/* create the fast-open request packet */
 		reqt.pmessage = mreqt;
-		qerr = kex_simplex_client_connect_request(kcs, cns, &reqt);
+		qerr = kex_simplex_client_fastopen_request(kcs, fokey, cns, &reqt);
 
 		if (qerr == qsmp_error_none)
 		{
-			/* convert the packet to bytes */
 			plen = qsmp_packet_to_stream(&reqt, spct);
-			/* send the connection request */
 			slen = qsc_socket_send(&cns->target, spct, plen, qsc_socket_send_flag_none);
 			qsc_memutils_clear(spct, plen + 1);
 
 			if (slen == plen + QSC_SOCKET_TERMINATOR_SIZE)
 			{
-				const size_t CONLEN = QSMP_ASYMMETRIC_SIGNATURE_SIZE + QSMP_SIMPLEX_HASH_SIZE + QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE + QSMP_HEADER_SIZE + QSC_SOCKET_TERMINATOR_SIZE;
-
 				cns->txseq += 1;
 
-				/* blocking receive waits for server */
-				rlen = qsc_socket_receive(&cns->target, spct, CONLEN, qsc_socket_receive_flag_wait_all);
+				/* the response either establishes the session, or carries the servers current fast-open key */
+				resp.pmessage = mresp;
+				rlen = kex_receive_packet(&cns->target, spct, &resp, QSMP_FASTOPEN_RESPONSE_SIZE);
+				qsc_memutils_clear(spct, rlen);
 
-				if (rlen == CONLEN)
+				if (rlen != 0)
 				{
-					/* convert server response to packet */
-					resp.pmessage = mresp;
-					qsmp_stream_to_packet(spct, &resp);
-					qsc_memutils_clear(spct, sizeof(spct));
-
 					if (resp.sequence == cns->rxseq)
 					{
 						cns->rxseq += 1;
 
-						if (resp.flag == qsmp_flag_connect_response)
+						if (resp.flag == qsmp_flag_exchange_response)
+						{
+							/* the cached key was accepted, raise the channels */
+							qerr = kex_simplex_client_fastopen_verify(kcs, cns, &resp);
+						}
+						else if (resp.flag == qsmp_flag_fastopen_response)
 						{
-							/* clear the request packet */
 							qsmp_packet_clear(&reqt);
-							/* create the exstart request packet */
-							qerr = kex_simplex_client_exchange_request(kcs, cns, &resp, &reqt);
+							/* cache the new key, and create the exchange request packet */
+							qerr = kex_simplex_client_fastopen_exchange_request(kcs, fokey, cns, &resp, &reqt);
 						}
 						else
 						{
-							/* if we receive an error, set the error flag from the packet */
 							if (resp.flag == qsmp_flag_error_condition)
 							{
 								qerr = (qsmp_errors)resp.pmessage[0];
@@ -1739,7 +3020,7 @@ qsmp_errors qsmp_kex_simplex_client_key_exchange(qsmp_kex_simplex_client_state*
 			}
 		}
 
-		if (qerr == qsmp_error_none)
+		if (qerr == qsmp_error_none && cns->exflag == qsmp_flag_exchange_request)
 		{
 			qsmp_packet_clear(&resp);
 			plen = qsmp_packet_to_stream(&reqt, spct);
@@ -1748,14 +3029,12 @@ qsmp_errors qsmp_kex_simplex_client_key_exchange(qsmp_kex_simplex_client_state*
 
 			if (slen == plen + QSC_SOCKET_TERMINATOR_SIZE)
 			{
-				const size_t EXCLEN = QSMP_HEADER_SIZE + QSC_SOCKET_TERMINATOR_SIZE;
-
 				cns->txseq += 1;
-				rlen = qsc_socket_receive(&cns->target, spct, EXCLEN, qsc_socket_receive_flag_wait_all);
-				qsmp_stream_to_packet(spct, &resp);
-				qsc_memutils_clear(spct, sizeof(spct));
+				/* the exchange response may carry a resumption ticket */
+				rlen = kex_receive_packet(&cns->target, spct, &resp, QSMP_TICKET_SIZE + QSMP_SIMPLEX_MACTAG_SIZE);
+				qsc_memutils_clear(spct, rlen);
 
-				if (rlen == EXCLEN)
+				if (rlen != 0)
 				{
 					if (resp.sequence == cns->rxseq)
 					{
@@ -1815,44 +3094,85 @@ qsmp_errors qsmp_kex_simplex_client_key_exchange(qsmp_kex_simplex_client_state*
 	return qerr;
 }
 
-qsmp_errors qsmp_kex_simplex_server_key_exchange(qsmp_kex_simplex_server_state* kss, qsmp_connection_state* cns)
+qsmp_errors qsmp_kex_simplex_client_fastopen(qsmp_kex_simplex_client_state* kcs, qsmp_fastopen_key* fokey, qsmp_connection_state* cns)
+{
+	assert(kcs != NULL);
+	assert(fokey != NULL);
+	assert(cns != NULL);
+
+	uint8_t* mreqt;
+	uint8_t* mresp;
+	uint8_t* spct;
+	qsmp_errors qerr;
+
+	mreqt = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	mresp = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	spct = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+
+	if (mreqt != NULL && mresp != NULL && spct != NULL)
+	{
+		qerr = kex_simplex_client_fastopen_exchange(kcs, fokey, cns, mreqt, mresp, spct);
+	}
+	else
+	{
+		qerr = qsmp_error_memory_allocation;
+
+		if (cns != NULL && cns->target.connection_status == qsc_socket_state_connected)
+		{
+			kex_client_send_error(&cns->target, qerr);
+			qsc_socket_shut_down(&cns->target, qsc_socket_shut_down_flag_both);
+		}
+	}
+
+	qsmp_bufferpool_release(mreqt, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	qsmp_bufferpool_release(mresp, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	qsmp_bufferpool_release(spct, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+
+	return qerr;
+}
+
+static qsmp_errors kex_simplex_server_exchange(qsmp_kex_simplex_server_state* kss, qsmp_connection_state* cns, uint8_t* mreqt, uint8_t* mresp, uint8_t* spct)
 {
 	assert(kss != NULL);
 	assert(cns != NULL);
 
-	uint8_t spct[QSMP_MESSAGE_MAX + 1] = { 0 };
-	uint8_t mreqt[QSMP_MESSAGE_MAX + 1] = { 0 };
-	uint8_t mresp[QSMP_MESSAGE_MAX + 1] = { 0 };
 	qsmp_packet reqt = { 0 };
 	qsmp_packet resp = { 0 };
 	qsmp_errors qerr;
 	size_t plen;
 	size_t rlen;
 	size_t slen;
-	const size_t CONLEN = QSMP_KEYID_SIZE + QSMP_CONFIG_SIZE + QSMP_HEADER_SIZE + QSC_SOCKET_TERMINATOR_SIZE;
 
-	/* blocking receive waits for client */
-	rlen = qsc_socket_receive(&cns->target, spct, CONLEN, qsc_socket_receive_flag_wait_all);
+	/* blocking receive waits for client, the request is a connection, resume, or fast-open request */
+	resp.pmessage = mresp;
+	rlen = kex_receive_packet(&cns->target, spct, &resp, (QSMP_FASTOPEN_REQUEST_SIZE > QSMP_RESUME_REQUEST_SIZE) ? QSMP_FASTOPEN_REQUEST_SIZE : QSMP_RESUME_REQUEST_SIZE);
 
-	if (rlen == CONLEN)
+	if (rlen != 0)
 	{
-		/* convert server response to packet */
-		resp.pmessage = mresp;
-		qsmp_stream_to_packet(spct, &resp);
-		qsc_memutils_clear(spct, sizeof(spct));
+		qsc_memutils_clear(spct, rlen);
 
 		if (resp.sequence == cns->rxseq)
 		{
 			cns->rxseq += 1;
+			/* clear the request packet */
+			reqt.pmessage = mreqt;
+			qsmp_packet_clear(&reqt);
 
-			if (resp.flag == qsmp_flag_connect_request)
+			if (resp.flag == qsmp_flag_connect_request && resp.msglen == QSMP_KEYID_SIZE + QSMP_CONFIG_SIZE)
 			{
-				/* clear the request packet */
-				reqt.pmessage = mreqt;
-				qsmp_packet_clear(&reqt);
 				/* create the connection request packet */
 				qerr = kex_simplex_server_connect_response(kss, cns, &resp, &reqt);
 			}
+			else if (resp.flag == qsmp_flag_resume_request)
+			{
+				/* a resumed session is established by the resume response, and skips the asymmetric exchange */
+				qerr = kex_simplex_server_resume_response(kss, cns, &resp, &reqt);
+			}
+			else if (resp.flag == qsmp_flag_fastopen_request)
+			{
+				/* an accepted fast-open request establishes the session, otherwise the exchange continues with the fast-open key */
+				qerr = kex_simplex_server_fastopen_response(kss, cns, &resp, &reqt);
+			}
 			else
 			{
 				if (resp.flag == qsmp_flag_error_condition)
@@ -1875,7 +3195,7 @@ qsmp_errors qsmp_kex_simplex_server_key_exchange(qsmp_kex_simplex_server_state*
 		qerr = qsmp_error_receive_failure;
 	}
 
-	if (qerr == qsmp_error_none)
+	if (qerr == qsmp_error_none && cns->exflag == qsmp_flag_connect_response)
 	{
 		plen = qsmp_packet_to_stream(&reqt, spct);
 		slen = qsc_socket_send(&cns->target, spct, plen, qsc_socket_send_flag_none);
@@ -1890,7 +3210,7 @@ qsmp_errors qsmp_kex_simplex_server_key_exchange(qsmp_kex_simplex_server_state*
 			if (rlen == EXCLEN)
 			{
 				qsmp_stream_to_packet(spct, &resp);
-				qsc_memutils_clear(spct, sizeof(spct));
+				qsc_memutils_clear(spct, rlen);
 
 				if (resp.sequence == cns->rxseq)
 				{
@@ -1954,14 +3274,110 @@ qsmp_errors qsmp_kex_simplex_server_key_exchange(qsmp_kex_simplex_server_state*
 		{
 			kex_server_send_error(&cns->target, qerr);
 			qsc_socket_shut_down(&cns->target, qsc_socket_shut_down_flag_both);
+			qsc_socket_close_socket(&cns->target);
 		}
 
-		qsmp_connection_state_dispose(cns);
+		/* the server connection is a slot in the connections collection, its transmit lock and instance are kept */
+		qsmp_connection_state_reset(cns);
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_kex_simplex_server_key_exchange(qsmp_kex_simplex_server_state* kss, qsmp_connection_state* cns)
+{
+	assert(kss != NULL);
+	assert(cns != NULL);
+
+	uint8_t* mreqt;
+	uint8_t* mresp;
+	uint8_t* spct;
+	qsmp_errors qerr;
+
+	/* the exchange messages are held in pooled handshake buffers, rather than on the stack of the calling thread */
+	mreqt = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	mresp = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	spct = qsmp_bufferpool_acquire(QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+
+	if (mreqt != NULL && mresp != NULL && spct != NULL)
+	{
+		qerr = kex_simplex_server_exchange(kss, cns, mreqt, mresp, spct);
+	}
+	else
+	{
+		qerr = qsmp_error_memory_allocation;
+
+		if (cns != NULL && cns->target.connection_status == qsc_socket_state_connected)
+		{
+			kex_server_send_error(&cns->target, qerr);
+			qsc_socket_shut_down(&cns->target, qsc_socket_shut_down_flag_both);
+		}
 	}
 
+	qsmp_bufferpool_release(mreqt, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	qsmp_bufferpool_release(mresp, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+	qsmp_bufferpool_release(spct, QSMP_BUFFERPOOL_HANDSHAKE_SIZE);
+
 	return qerr;
 }
 
+static bool kex_test_key_query(uint8_t* rvkey, const uint8_t* pkid)
+{
+	/* the test server already holds the client verification key, so every key identity is accepted */
+	(void)rvkey;
+	(void)pkid;
+
+	return true;
+}
+
+static void kex_test_simplex_keys(qsmp_kex_simplex_client_state* skcs, qsmp_kex_simplex_server_state* skss, uint8_t* tkey)
+{
+	qsmp_signature_generate_keypair(skss->verkey, skss->sigkey, qsc_acp_generate);
+	qsc_memutils_copy(skcs->verkey, skss->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
+
+	skcs->expiration = qsc_timestamp_epochtime_seconds() + QSMP_PUBKEY_DURATION_SECONDS;
+	skss->expiration = skcs->expiration;
+	qsc_acp_generate(tkey, QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE);
+	skss->tktkey = tkey;
+}
+
+static bool kex_test_simplex_exchange(qsmp_kex_simplex_client_state* skcs, qsmp_kex_simplex_server_state* skss, 
+	qsmp_connection_state* cnc, qsmp_connection_state* cns, qsmp_packet* pckclt, qsmp_packet* pcksrv)
+{
+	qsmp_errors qerr;
+	bool res;
+
+	res = false;
+	qerr = kex_simplex_client_connect_request(skcs, cnc, pckclt);
+
+	if (qerr == qsmp_error_none)
+	{
+		qerr = kex_simplex_server_connect_response(skss, cns, pckclt, pcksrv);
+
+		if (qerr == qsmp_error_none)
+		{
+			qerr = kex_simplex_client_exchange_request(skcs, cnc, pcksrv, pckclt);
+
+			if (qerr == qsmp_error_none)
+			{
+				qerr = kex_simplex_server_exchange_response(skss, cns, pckclt, pcksrv);
+
+				if (qerr == qsmp_error_none)
+				{
+					qerr = kex_simplex_client_establish_verify(skcs, cnc, pcksrv);
+
+					if (qerr == qsmp_error_none)
+					{
+						res = true;
+					}
+				}
+			}
+		}
+	}
+
+	return res;
+}
+
 bool qsmp_kex_test()
 {
 	qsmp_kex_simplex_client_state skcs = { 0 };
@@ -1974,6 +3390,7 @@ bool qsmp_kex_test()
 	qsmp_packet pcksrv = { 0 };
 	uint8_t mclt[QSMP_MESSAGE_MAX + 1] = { 0 };
 	uint8_t msrv[QSMP_MESSAGE_MAX + 1] = { 0 };
+	uint8_t tkey[QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE] = { 0 };
 	qsmp_errors qerr;
 	bool res;
 
@@ -1986,6 +3403,7 @@ bool qsmp_kex_test()
 
 	dkcs.expiration = qsc_timestamp_epochtime_seconds() + QSMP_PUBKEY_DURATION_SECONDS;
 	dkss.expiration = dkcs.expiration;
+	dkss.key_query = &kex_test_key_query;
 
 	res = false;
 	qerr = kex_duplex_client_connect_request(&dkcs, &cnc, &pckclt);
@@ -2027,21 +3445,97 @@ bool qsmp_kex_test()
 
 	if (res == true)
 	{
-		qsmp_signature_generate_keypair(skss.verkey, skss.sigkey, qsc_acp_generate);
-		qsc_memutils_copy(skcs.verkey, skss.verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
+		kex_test_simplex_keys(&skcs, &skss, tkey);
+		res = kex_test_simplex_exchange(&skcs, &skss, &cnc, &cns, &pckclt, &pcksrv);
+	}
+
+	return res;
+}
+
+bool qsmp_kex_resume_test()
+{
+	qsmp_kex_simplex_client_state skcs = { 0 };
+	qsmp_kex_simplex_server_state skss = { 0 };
+	qsmp_connection_state cnc = { 0 };
+	qsmp_connection_state cns = { 0 };
+	qsmp_packet pckclt = { 0 };
+	qsmp_packet pcksrv = { 0 };
+	uint8_t mclt[QSMP_MESSAGE_MAX + 1] = { 0 };
+	uint8_t msrv[QSMP_MESSAGE_MAX + 1] = { 0 };
+	uint8_t cnce[QSMP_NONCE_SIZE] = { 0 };
+	uint8_t tkey[QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE] = { 0 };
+	qsmp_session_ticket tckt = { 0 };
+	qsmp_errors qerr;
+	bool res;
+
+	pckclt.pmessage = mclt;
+	pcksrv.pmessage = msrv;
+	kex_test_simplex_keys(&skcs, &skss, tkey);
+	res = kex_test_simplex_exchange(&skcs, &skss, &cnc, &cns, &pckclt, &pcksrv);
+
+	if (res == true)
+	{
+		/* resume a session with the ticket issued by the simplex exchange */
+		qsc_memutils_copy(&tckt, &cnc.ticket, sizeof(qsmp_session_ticket));
+		res = false;
+
+		qerr = kex_simplex_client_resume_request(&tckt, &cnc, cnce, &pckclt);
+
+		if (qerr == qsmp_error_none)
+		{
+			qerr = kex_simplex_server_resume_response(&skss, &cns, &pckclt, &pcksrv);
+
+			if (qerr == qsmp_error_none)
+			{
+				qerr = kex_simplex_client_resume_verify(&tckt, &cnc, cnce, &pcksrv);
+
+				if (qerr == qsmp_error_none)
+				{
+					/* both hosts hold the same key state, and the client holds a replacement ticket */
+					res = (qsc_intutils_verify(cnc.rtcs, cns.rtcs, QSMP_DUPLEX_SYMMETRIC_KEY_SIZE) == 0 && 
+						qsc_intutils_verify(cnc.ticket.ticket, tckt.ticket, QSMP_TICKET_SIZE) != 0);
+				}
+			}
+		}
+	}
+
+	return res;
+}
+
+bool qsmp_kex_fastopen_test()
+{
+	qsmp_kex_simplex_client_state skcs = { 0 };
+	qsmp_kex_simplex_server_state skss = { 0 };
+	qsmp_connection_state cnc = { 0 };
+	qsmp_connection_state cns = { 0 };
+	qsmp_packet pckclt = { 0 };
+	qsmp_packet pcksrv = { 0 };
+	uint8_t mclt[QSMP_MESSAGE_MAX + 1] = { 0 };
+	uint8_t msrv[QSMP_MESSAGE_MAX + 1] = { 0 };
+	uint8_t tkey[QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE] = { 0 };
+	qsmp_kex_fastopen_state fos = { 0 };
+	qsmp_fastopen_key fokey = { 0 };
+	qsmp_errors qerr;
+	bool res;
 
-		skcs.expiration = qsc_timestamp_epochtime_seconds() + QSMP_PUBKEY_DURATION_SECONDS;
-		skss.expiration = skcs.expiration;
+	res = false;
+	pckclt.pmessage = mclt;
+	pcksrv.pmessage = msrv;
+	kex_test_simplex_keys(&skcs, &skss, tkey);
 
-		qerr = kex_simplex_client_connect_request(&skcs, &cnc, &pckclt);
+	if (qsmp_kex_fastopen_initialize(&fos) == true)
+	{
+		/* a fast-open request without a cached key receives the key, and completes in two round trips */
+		skss.fostate = &fos;
+		qerr = kex_simplex_client_fastopen_request(&skcs, &fokey, &cnc, &pckclt);
 
 		if (qerr == qsmp_error_none)
 		{
-			qerr = kex_simplex_server_connect_response(&skss, &cns, &pckclt, &pcksrv);
+			qerr = kex_simplex_server_fastopen_response(&skss, &cns, &pckclt, &pcksrv);
 
 			if (qerr == qsmp_error_none)
 			{
-				qerr = kex_simplex_client_exchange_request(&skcs, &cnc, &pcksrv, &pckclt);
+				qerr = kex_simplex_client_fastopen_exchange_request(&skcs, &fokey, &cnc, &pcksrv, &pckclt);
 
 				if (qerr == qsmp_error_none)
 				{
@@ -2053,12 +3547,37 @@ bool qsmp_kex_test()
 
 						if (qerr == qsmp_error_none)
 						{
-							res = true;
+							res = (qsc_intutils_verify(cnc.rtcs, cns.rtcs, QSMP_DUPLEX_SYMMETRIC_KEY_SIZE) == 0);
 						}
 					}
 				}
 			}
 		}
+
+		if (res == true)
+		{
+			/* with the cached key the session is established by the first response */
+			res = false;
+
+			qerr = kex_simplex_client_fastopen_request(&skcs, &fokey, &cnc, &pckclt);
+
+			if (qerr == qsmp_error_none && cnc.exflag == qsmp_flag_fastopen_request)
+			{
+				qerr = kex_simplex_server_fastopen_response(&skss, &cns, &pckclt, &pcksrv);
+
+				if (qerr == qsmp_error_none && cns.exflag == qsmp_flag_session_established)
+				{
+					qerr = kex_simplex_client_fastopen_verify(&skcs, &cnc, &pcksrv);
+
+					if (qerr == qsmp_error_none)
+					{
+						res = (qsc_intutils_verify(cnc.rtcs, cns.rtcs, QSMP_DUPLEX_SYMMETRIC_KEY_SIZE) == 0);
+					}
+				}
+			}
+		}
+
+		qsmp_kex_fastopen_dispose(&fos);
 	}
 
 	return res;
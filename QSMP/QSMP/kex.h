@@ -68,6 +68,20 @@ typedef struct qsmp_kex_duplex_server_state
 	bool (*key_query)(uint8_t*, const uint8_t*);			/*!< The key query callback */
 } qsmp_kex_duplex_server_state;
 
+/*!
+* \struct qsmp_kex_fastopen_state
+* \brief The QSMP simplex server fast-open key state, shared by the key exchange workers
+*/
+typedef struct qsmp_kex_fastopen_state
+{
+	uint8_t* prikey;										/*!< The fast-open asymmetric cipher private key */
+	uint8_t* pubkey;										/*!< The fast-open asymmetric cipher public key */
+	uint8_t* sigkh;											/*!< The signed hash of the key expiration and public key */
+	uint8_t pkhash[QSMP_SIMPLEX_HASH_SIZE];					/*!< The public key hash, identifies the key in a fast-open request */
+	uint64_t expiration;									/*!< The key expiration time, in seconds from epoch */
+	qsc_mutex lock;											/*!< Serializes key rotation with the exchanges that read the key */
+} qsmp_kex_fastopen_state;
+
 /*!
 * \struct qsmp_kex_simplex_client_state
 * \brief The QSMP simplex client state structure
@@ -78,6 +92,7 @@ typedef struct qsmp_kex_simplex_client_state
 	uint8_t rverkey[QSMP_ASYMMETRIC_VERIFY_KEY_SIZE];		/*!< The remote asymmetric signature verification-key */
 	uint8_t sigkey[QSMP_ASYMMETRIC_SIGNING_KEY_SIZE];		/*!< The asymmetric signature signing-key */
 	uint8_t schash[QSMP_SIMPLEX_SCHASH_SIZE];				/*!< The session token hash */
+	uint8_t ssec[QSMP_SECRET_SIZE];							/*!< The fast-open shared secret, held until the server nonce is received */
 	uint8_t verkey[QSMP_ASYMMETRIC_VERIFY_KEY_SIZE];		/*!< The local asymmetric signature verification-key */
 	uint64_t expiration;									/*!< The expiration time, in seconds from epoch */
 } qsmp_kex_simplex_client_state;
@@ -94,7 +109,11 @@ typedef struct qsmp_kex_simplex_server_state
 	uint8_t pubkey[QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE];		/*!< The asymmetric cipher public key */
 	uint8_t sigkey[QSMP_ASYMMETRIC_SIGNING_KEY_SIZE];		/*!< The asymmetric signature signing-key */
 	uint8_t verkey[QSMP_ASYMMETRIC_VERIFY_KEY_SIZE];		/*!< The local asymmetric signature verification-key */
+	uint8_t fonce[QSMP_NONCE_SIZE];							/*!< The fast-open server nonce */
 	uint64_t expiration;									/*!< The expiration time, in seconds from epoch */
+	const uint8_t* tktkey;									/*!< The resumption ticket key, tickets are not issued or accepted when null */
+	qsmp_kex_fastopen_state* fostate;						/*!< The fast-open key state, fast-open requests are refused when null */
+	bool fopen;												/*!< The exchange was started with a fast-open request */
 } qsmp_kex_simplex_server_state;
 
 /**
@@ -121,6 +140,26 @@ qsmp_errors qsmp_kex_duplex_server_key_exchange(qsmp_kex_duplex_server_state* ks
 */
 qsmp_errors qsmp_kex_duplex_client_key_exchange(qsmp_kex_duplex_client_state* kcs, qsmp_connection_state* cns);
 
+/**
+* \brief Release the fast-open key state
+*
+* \note This is an internal non-exportable API.
+*
+* \param fos: A pointer to the fast-open key state
+*/
+void qsmp_kex_fastopen_dispose(qsmp_kex_fastopen_state* fos);
+
+/**
+* \brief Initialize the fast-open key state, the key is generated by the first exchange that uses it
+*
+* \note This is an internal non-exportable API.
+*
+* \param fos: A pointer to the fast-open key state
+*
+* \return: Returns true if the state was initialized
+*/
+bool qsmp_kex_fastopen_initialize(qsmp_kex_fastopen_state* fos);
+
 /**
 * \brief Run the network server version of the simplex key exchange.
 *
@@ -145,6 +184,52 @@ qsmp_errors qsmp_kex_simplex_server_key_exchange(qsmp_kex_simplex_server_state*
 */
 qsmp_errors qsmp_kex_simplex_client_key_exchange(qsmp_kex_simplex_client_state* kcs, qsmp_connection_state* cns);
 
+/**
+* \brief Run the network client version of the simplex fast-open key exchange.
+* If the cached key is current, the encapsulation is sent with the connection request and the exchange completes in one round trip,
+* otherwise the server returns its current fast-open key, which is stored in the cache, and the exchange continues in two round trips.
+*
+* \note This is an internal non-exportable API.
+*
+* \param kcs: A pointer to client key exchange state
+* \param fokey: A pointer to the cached fast-open key
+* \param cns: A pointer to the connection state
+*
+* \return: Returns the function error state
+*/
+qsmp_errors qsmp_kex_simplex_client_fastopen(qsmp_kex_simplex_client_state* kcs, qsmp_fastopen_key* fokey, qsmp_connection_state* cns);
+
+/**
+* \brief Run the network client version of the simplex session resumption.
+* The ticket is presented in place of the asymmetric key exchange, and is replaced by the ticket issued for the new session.
+*
+* \note This is an internal non-exportable API.
+*
+* \param ticket: [const] A pointer to the session ticket
+* \param cns: A pointer to the connection state
+*
+* \return: Returns the function error state
+*/
+qsmp_errors qsmp_kex_simplex_client_resume(const qsmp_session_ticket* ticket, qsmp_connection_state* cns);
+
+/**
+* \brief Run the fast-open exchange tests, with and without a cached server key
+*
+* \note This is an internal non-exportable API.
+*
+* \return: Returns true if the tests succeed
+*/
+bool qsmp_kex_fastopen_test(void);
+
+/**
+* \brief Run the session resumption test, resuming with the ticket issued by a simplex exchange
+*
+* \note This is an internal non-exportable API.
+*
+* \return: Returns true if the test succeeds
+*/
+bool qsmp_kex_resume_test(void);
+
 /**
 * \brief Run the internal function tests
 *
@@ -1,41 +1,1728 @@
 #include "qsmp.h"
+#include "bufferpool.h"
 #include "../QSMP/logger.h"
 #include "../../QSC/QSC/acp.h"
 #include "../../QSC/QSC/encoding.h"
 #include "../../QSC/QSC/intutils.h"
 #include "../../QSC/QSC/memutils.h"
 #include "../../QSC/QSC/stringutils.h"
+#include "../../QSC/QSC/timerex.h"
 #include "../../QSC/QSC/timestamp.h"
 
+static const uint8_t m_record_terminator[QSC_SOCKET_TERMINATOR_SIZE] = { 0 };
+static void (*m_multiplex_callback)(qsmp_connection_state*, uint32_t, const uint8_t*, size_t) = NULL;
+
+typedef enum multiplex_frames
+{
+	multiplex_frame_open = 0x01,					/* the stream is opened by the sender */
+	multiplex_frame_data = 0x02,					/* a frame of a message that continues in the next frame */
+	multiplex_frame_final = 0x03,					/* the last frame of a message */
+	multiplex_frame_close = 0x04,					/* the stream is closed by the sender */
+} multiplex_frames;
+
+static qsmp_errors packet_encrypt_header(qsmp_connection_state* cns, qsmp_packet* packetout, qsmp_flags flag, size_t msglen)
+{
+	qsmp_errors qerr;
+
+	if (cns->exflag == qsmp_flag_session_established && msglen != 0)
+	{
+		uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
+		const uint32_t MACLEN = (cns->txcpr.ctype == qsc_rcs_cipher_256) ? QSMP_SIMPLEX_MACTAG_SIZE : QSMP_DUPLEX_MACTAG_SIZE;
+
+		/* assemble the encryption packet, the transform writes every byte of the cipher-text and tag */
+		cns->txseq += 1;
+		packetout->flag = flag;
+		packetout->msglen = (uint32_t)msglen + MACLEN;
+		packetout->sequence = cns->txseq;
+
+		/* serialize the header and add it to the ciphers associated data */
+		qsmp_packet_header_serialize(packetout, hdr);
+		qsc_rcs_set_associated(&cns->txcpr, hdr, QSMP_HEADER_SIZE);
+
+		qerr = qsmp_error_none;
+	}
+	else
+	{
+		qerr = qsmp_error_channel_down;
+	}
+
+	return qerr;
+}
+
+static qsmp_errors packet_encrypt(qsmp_connection_state* cns, qsmp_packet* packetout, qsmp_flags flag, const uint8_t* message, size_t msglen)
+{
+	qsmp_errors qerr;
+
+	qerr = packet_encrypt_header(cns, packetout, flag, msglen);
+
+	if (qerr == qsmp_error_none)
+	{
+		/* encrypt the message */
+		qsc_rcs_transform(&cns->txcpr, packetout->pmessage, message, msglen);
+	}
+
+	return qerr;
+}
+
+static uint8_t* connection_queue_reserve(qsmp_record_buffer* tbuf, size_t reqlen)
+{
+	uint8_t* ptail;
+
+	ptail = NULL;
+
+	if (tbuf->buffer == NULL)
+	{
+		tbuf->buffer = (uint8_t*)qsc_memutils_malloc(QSMP_SEND_BUFFER_SIZE);
+		tbuf->capacity = (tbuf->buffer != NULL) ? QSMP_SEND_BUFFER_SIZE : 0;
+		tbuf->position = 0;
+		tbuf->length = 0;
+	}
+
+	if (tbuf->buffer != NULL && tbuf->length + reqlen <= tbuf->capacity)
+	{
+		/* move the unsent bytes to the front of the queue to make room at the tail */
+		if (tbuf->position + tbuf->length + reqlen > tbuf->capacity)
+		{
+			qsc_memutils_move(tbuf->buffer, tbuf->buffer + tbuf->position, tbuf->length);
+			tbuf->position = 0;
+		}
+
+		ptail = tbuf->buffer + tbuf->position + tbuf->length;
+	}
+
+	return ptail;
+}
+
+static qsmp_errors connection_queue_flush(qsmp_connection_state* cns)
+{
+	qsmp_record_buffer* tbuf;
+	qsc_socket_exceptions serr;
+	qsmp_errors qerr;
+	size_t slen;
+
+	tbuf = &cns->txbuf;
+	qerr = qsmp_error_none;
+
+	while (tbuf->length != 0)
+	{
+		/* the socket send appends the terminator size to the length */
+		slen = qsc_socket_send(&cns->target, tbuf->buffer + tbuf->position, tbuf->length - QSC_SOCKET_TERMINATOR_SIZE, qsc_socket_send_flag_dont_wait);
+
+		if (slen == 0)
+		{
+			serr = qsc_socket_get_last_error();
+
+			/* the socket buffer is full, the remainder is sent on the next flush */
+			if (serr != qsc_socket_exception_would_block)
+			{
+				qerr = qsmp_error_transmit_failure;
+			}
+
+			break;
+		}
+
+		tbuf->position += slen;
+		tbuf->length -= slen;
+	}
+
+	if (tbuf->length == 0)
+	{
+		tbuf->position = 0;
+	}
+
+	return qerr;
+}
+
+static qsmp_errors connection_queue_message(qsmp_connection_state* cns, qsmp_flags flag, const uint8_t* message, size_t msglen)
+{
+	const size_t MACLEN = (cns->txcpr.ctype == qsc_rcs_cipher_256) ? QSMP_SIMPLEX_MACTAG_SIZE : QSMP_DUPLEX_MACTAG_SIZE;
+	qsmp_packet pkt = { 0 };
+	qsmp_errors qerr;
+	uint8_t* ptail;
+	size_t plen;
+
+	/* the space is reserved before encryption, so a full queue leaves the transmit sequence unchanged */
+	ptail = connection_queue_reserve(&cns->txbuf, QSMP_HEADER_SIZE + msglen + MACLEN + QSC_SOCKET_TERMINATOR_SIZE);
+
+	if (ptail != NULL)
+	{
+		/* the message is encrypted in place at the queue tail, behind the space for its header */
+		pkt.pmessage = ptail + QSMP_HEADER_SIZE;
+		qerr = packet_encrypt(cns, &pkt, flag, message, msglen);
+
+		if (qerr == qsmp_error_none)
+		{
+			qsmp_packet_header_serialize(&pkt, ptail);
+			plen = QSMP_HEADER_SIZE + pkt.msglen;
+			ptail[plen] = 0;
+			cns->txbuf.length += plen + QSC_SOCKET_TERMINATOR_SIZE;
+		}
+	}
+	else
+	{
+		qerr = qsmp_error_transmit_failure;
+	}
+
+	return qerr;
+}
+
+static qsmp_errors connection_send_vector(qsmp_connection_state* cns, const qsc_socket_buffer* buffers, size_t count)
+{
+	qsmp_errors qerr;
+	uint8_t* ptail;
+	size_t clen;
+	size_t plen;
+	size_t slen;
+
+	qerr = qsmp_error_none;
+	plen = 0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		plen += buffers[i].length;
+	}
+
+	/* the record segments are written with one gathering send, rather than copied into a contiguous stream */
+	slen = qsc_socket_sendv(&cns->target, buffers, count, qsc_socket_send_flag_none);
+
+	if (slen != plen)
+	{
+		/* a non-blocking socket may accept part of the records, the remainder is queued */
+		if (slen != 0 || qsc_socket_get_last_error() == qsc_socket_exception_would_block)
+		{
+			plen -= slen;
+			ptail = connection_queue_reserve(&cns->txbuf, plen);
+
+			if (ptail != NULL)
+			{
+				/* skip the bytes that were sent, and copy the rest of the segments to the queue */
+				for (size_t i = 0; i < count; ++i)
+				{
+					if (slen < buffers[i].length)
+					{
+						clen = buffers[i].length - slen;
+						qsc_memutils_copy(ptail, buffers[i].data + slen, clen);
+						ptail += clen;
+						slen = 0;
+					}
+					else
+					{
+						slen -= buffers[i].length;
+					}
+				}
+
+				cns->txbuf.length += plen;
+			}
+			else
+			{
+				qerr = qsmp_error_transmit_failure;
+			}
+		}
+		else
+		{
+			qerr = qsmp_error_transmit_failure;
+		}
+	}
+
+	return qerr;
+}
+
+static qsmp_errors connection_send_control(qsmp_connection_state* cns, const uint8_t* record, size_t reclen)
+{
+	qsmp_errors qerr;
+	uint8_t* ptail;
+
+	/* a control record is sent in order behind any queued records, and is queued behind those that remain */
+	qerr = (cns->txbuf.length != 0) ? connection_queue_flush(cns) : qsmp_error_none;
+
+	if (qerr == qsmp_error_none && cns->txbuf.length != 0)
+	{
+		ptail = connection_queue_reserve(&cns->txbuf, reclen);
+
+		if (ptail != NULL)
+		{
+			qsc_memutils_copy(ptail, record, reclen);
+			cns->txbuf.length += reclen;
+		}
+		else
+		{
+			qerr = qsmp_error_transmit_failure;
+		}
+	}
+	else if (qerr == qsmp_error_none)
+	{
+		qsc_socket_buffer sbuf = { record, reclen };
+
+		qerr = connection_send_vector(cns, &sbuf, 1);
+	}
+
+	return qerr;
+}
+
+static qsmp_errors connection_send_record(qsmp_connection_state* cns, qsmp_flags flag, const uint8_t* message, size_t msglen)
+{
+	uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
+	qsc_socket_buffer sbuf[3] = { 0 };
+	qsmp_packet pkt = { 0 };
+	qsmp_errors qerr;
+
+	/* queued records are sent first, a message is queued behind any that remain */
+	qerr = (cns->txbuf.length != 0) ? connection_queue_flush(cns) : qsmp_error_none;
+
+	if (qerr == qsmp_error_none && cns->txbuf.length != 0)
+	{
+		qerr = connection_queue_message(cns, flag, message, msglen);
+	}
+	else if (qerr == qsmp_error_none)
+	{
+		/* the cipher-text is written to a pooled data buffer, rather than a maximum size message on the stack */
+		pkt.pmessage = qsmp_bufferpool_acquire(msglen + QSMP_DUPLEX_MACTAG_SIZE);
+
+		if (pkt.pmessage != NULL)
+		{
+			qerr = packet_encrypt(cns, &pkt, flag, message, msglen);
+
+			if (qerr == qsmp_error_none)
+			{
+				/* the header, cipher-text, and terminator are sent from where they are, without a stream copy */
+				qsmp_packet_header_serialize(&pkt, hdr);
+				sbuf[0].data = hdr;
+				sbuf[0].length = QSMP_HEADER_SIZE;
+				sbuf[1].data = pkt.pmessage;
+				sbuf[1].length = pkt.msglen;
+				sbuf[2].data = m_record_terminator;
+				sbuf[2].length = QSC_SOCKET_TERMINATOR_SIZE;
+				qerr = connection_send_vector(cns, sbuf, 3);
+			}
+
+			qsmp_bufferpool_release(pkt.pmessage, pkt.msglen);
+		}
+		else
+		{
+			qerr = qsmp_error_memory_allocation;
+		}
+	}
+
+	return qerr;
+}
+
+static qsmp_errors connection_coalesce_flush(qsmp_connection_state* cns)
+{
+	qsmp_coalesce_state* cls;
+	qsmp_errors qerr;
+
+	cls = &cns->coalesce;
+	qerr = qsmp_error_none;
+
+	if (cls->length != 0)
+	{
+		/* the pending messages are sent as one record, and the buffer is cleared for the next batch */
+		qerr = connection_send_record(cns, qsmp_flag_coalesced_message, cls->buffer, cls->length);
+		qsc_memutils_clear(cls->buffer, cls->length);
+		cls->length = 0;
+	}
+
+	return qerr;
+}
+
+static uint32_t connection_coalesce_timer(void* state)
+{
+	qsmp_connection_state* cns;
+
+	cns = (qsmp_connection_state*)state;
+
+	/* the latency backstop for a connection that stops sending, the batch may already have been flushed */
+	qsc_async_mutex_lock_counted(cns->txlock, &cns->txstats);
+
+	/* a stream transfer in progress owns the transmit cipher, the batch is flushed by the next send */
+	if (cns->coalesce.buffer != NULL && cns->coalesce.length != 0 && cns->txstream == false && qsc_socket_is_connected(&cns->target) == true)
+	{
+		connection_coalesce_flush(cns);
+	}
+
+	qsc_async_mutex_unlock(cns->txlock);
+
+	return 0;
+}
+
+static qsmp_errors connection_coalesce_message(qsmp_connection_state* cns, const uint8_t* message, size_t msglen)
+{
+	qsmp_coalesce_state* cls;
+	qsmp_errors qerr;
+
+	cls = &cns->coalesce;
+	qerr = qsmp_error_none;
+
+	/* a message that does not fit behind the pending messages, or is as large as the threshold, is sent after them */
+	if (cls->length != 0 && (msglen >= cls->threshold || cls->length + QSMP_COALESCE_PREFIX_SIZE + msglen > QSMP_COALESCE_SIZE_MAX))
+	{
+		qerr = connection_coalesce_flush(cns);
+	}
+
+	if (qerr == qsmp_error_none)
+	{
+		if (msglen >= cls->threshold)
+		{
+			qerr = connection_send_record(cns, qsmp_flag_encrypted_message, message, msglen);
+		}
+		else
+		{
+			if (cls->length == 0)
+			{
+				/* the first message of a batch starts the latency budget */
+				cls->stime = qsc_timerex_stopwatch_microseconds();
+				qsmp_timerwheel_schedule(&cls->timer, (uint32_t)((cls->latency + 999) / 1000), &connection_coalesce_timer, cns);
+			}
+
+			qsc_intutils_le16to8(cls->buffer + cls->length, (uint16_t)msglen);
+			qsc_memutils_copy(cls->buffer + cls->length + QSMP_COALESCE_PREFIX_SIZE, message, msglen);
+			cls->length += QSMP_COALESCE_PREFIX_SIZE + msglen;
+
+			/* the batch is sent when it reaches the threshold, or the oldest message has waited for the latency budget */
+			if (cls->length >= cls->threshold || qsc_timerex_stopwatch_microseconds() - cls->stime >= cls->latency)
+			{
+				qerr = connection_coalesce_flush(cns);
+			}
+		}
+	}
+
+	return qerr;
+}
+
+static void coalesce_state_reset(qsmp_coalesce_state* cls)
+{
+	if (cls->buffer != NULL)
+	{
+		qsc_memutils_clear(cls->buffer, QSMP_COALESCE_SIZE_MAX);
+		qsc_memutils_alloc_free(cls->buffer);
+		cls->buffer = NULL;
+	}
+
+	cls->length = 0;
+	cls->threshold = 0;
+	cls->latency = 0;
+	cls->stime = 0;
+}
+
+static void send_queue_push(qsmp_send_queue* que, qsmp_send_record* rec)
+{
+	qsmp_send_record* prev;
+
+	/* the stub is linked on first use, so a cleared connection state is an empty queue */
+	if (qsc_async_atomic_load_pointer((void* volatile*)&que->head) == NULL)
+	{
+		qsc_async_atomic_compare_exchange_pointer((void* volatile*)&que->head, &que->stub, NULL);
+	}
+
+	rec->next = NULL;
+	/* the exchange orders the producers, the link makes the record visible to the writer */
+	prev = (qsmp_send_record*)qsc_async_atomic_exchange_pointer((void* volatile*)&que->head, rec);
+	qsc_async_atomic_store_pointer((void* volatile*)&prev->next, rec);
+}
+
+static qsmp_send_record* send_queue_pop(qsmp_send_queue* que)
+{
+	qsmp_send_record* next;
+	qsmp_send_record* rec;
+	qsmp_send_record* tail;
+
+	rec = NULL;
+
+	if (que->tail == NULL)
+	{
+		que->tail = &que->stub;
+	}
+
+	tail = que->tail;
+	next = (qsmp_send_record*)qsc_async_atomic_load_pointer((void* volatile*)&tail->next);
+
+	/* step over the stub, it is never returned */
+	if (tail == &que->stub && next != NULL)
+	{
+		que->tail = next;
+		tail = next;
+		next = (qsmp_send_record*)qsc_async_atomic_load_pointer((void* volatile*)&tail->next);
+	}
+
+	if (tail != &que->stub)
+	{
+		if (next != NULL)
+		{
+			que->tail = next;
+			rec = tail;
+		}
+		else if (tail == (qsmp_send_record*)qsc_async_atomic_load_pointer((void* volatile*)&que->head))
+		{
+			/* the last record is only released once the stub is linked behind it */
+			send_queue_push(que, &que->stub);
+			next = (qsmp_send_record*)qsc_async_atomic_load_pointer((void* volatile*)&tail->next);
+
+			if (next != NULL)
+			{
+				que->tail = next;
+				rec = tail;
+			}
+		}
+	}
+
+	/* a null return with messages pending is a producer between its exchange and its link */
+	return rec;
+}
+
+static void send_queue_free_push(qsmp_send_queue* que, qsmp_send_record* first, qsmp_send_record* last)
+{
+	qsmp_send_record* head;
+
+	/* a push only compares the head it linked behind, so a chain can be returned by any thread */
+	do
+	{
+		head = (qsmp_send_record*)qsc_async_atomic_load_pointer((void* volatile*)&que->freelist);
+		last->next = head;
+	}
+	while (qsc_async_atomic_compare_exchange_pointer((void* volatile*)&que->freelist, first, head) == false);
+}
+
+static qsmp_send_record* send_queue_acquire(qsmp_send_queue* que, size_t msglen)
+{
+	qsmp_send_record* last;
+	qsmp_send_record* list;
+	qsmp_send_record* rec;
+
+	rec = NULL;
+	/* the list is taken whole, so an entry is never removed while another producer is reading it */
+	list = (qsmp_send_record*)qsc_async_atomic_exchange_pointer((void* volatile*)&que->freelist, NULL);
+
+	if (list != NULL)
+	{
+		rec = list;
+		list = rec->next;
+		qsc_async_atomic_add(&que->freecount, -1);
+
+		if (list != NULL)
+		{
+			last = list;
+
+			while (last->next != NULL)
+			{
+				last = last->next;
+			}
+
+			send_queue_free_push(que, list, last);
+		}
+
+		if (rec->capacity < msglen)
+		{
+			qsmp_bufferpool_release((uint8_t*)rec, sizeof(qsmp_send_record) + rec->capacity);
+			rec = NULL;
+		}
+	}
+
+	if (rec == NULL)
+	{
+		rec = (qsmp_send_record*)qsmp_bufferpool_acquire(sizeof(qsmp_send_record) + msglen);
+
+		if (rec != NULL)
+		{
+			rec->capacity = msglen;
+		}
+	}
+
+	return rec;
+}
+
+static void send_queue_release(qsmp_send_queue* que, qsmp_send_record* rec)
+{
+	/* the message is cleared when the entry is returned, the pool expects the header and capacity to be cleared on release */
+	qsc_memutils_clear(rec->message, rec->length);
+	rec->message = NULL;
+	rec->length = 0;
+
+	if (qsc_async_atomic_add(&que->freecount, 1) <= (int32_t)QSMP_SEND_FREELIST_DEPTH)
+	{
+		send_queue_free_push(que, rec, rec);
+	}
+	else
+	{
+		qsc_async_atomic_add(&que->freecount, -1);
+		qsmp_bufferpool_release((uint8_t*)rec, sizeof(qsmp_send_record) + rec->capacity);
+	}
+}
+
+static void send_queue_free_dispose(qsmp_send_queue* que)
+{
+	qsmp_send_record* list;
+	qsmp_send_record* rec;
+
+	list = (qsmp_send_record*)qsc_async_atomic_exchange_pointer((void* volatile*)&que->freelist, NULL);
+
+	while (list != NULL)
+	{
+		rec = list;
+		list = rec->next;
+		qsc_async_atomic_add(&que->freecount, -1);
+		qsmp_bufferpool_release((uint8_t*)rec, sizeof(qsmp_send_record) + rec->capacity);
+	}
+}
+
+static qsmp_errors send_queue_write(qsmp_connection_state* cns, const uint8_t* message, size_t msglen)
+{
+	qsmp_errors qerr;
+
+	/* the writer holds the transmit lock, which the control records sent outside the queue share */
+	if (cns->coalesce.buffer != NULL)
+	{
+		qerr = connection_coalesce_message(cns, message, msglen);
+	}
+	else
+	{
+		qerr = connection_send_record(cns, qsmp_flag_encrypted_message, message, msglen);
+	}
+
+	return qerr;
+}
+
+static qsmp_send_record* send_queue_next(qsmp_send_queue* que)
+{
+	const size_t SPNMAX = 64;
+	qsmp_send_record* rec;
+	size_t spin;
+
+	rec = send_queue_pop(que);
+	spin = 0;
+
+	/* a counted producer that has not linked its record is a few instructions from doing so,
+	the writer retries briefly, then yields in case the producer was preempted in that window */
+	while (rec == NULL)
+	{
+		if (spin < SPNMAX)
+		{
+			++spin;
+		}
+		else
+		{
+			qsc_async_thread_yield();
+		}
+
+		rec = send_queue_pop(que);
+	}
+
+	return rec;
+}
+
+static void send_queue_drain(qsmp_connection_state* cns)
+{
+	qsmp_send_queue* que;
+	qsmp_send_record* rec;
+	qsmp_errors qerr;
+
+	que = &cns->txque;
+
+	/* the writer sends one queued message for each producer that arrived while it was writing,
+	the transmit lock is held by the caller for the whole drain, rather than taken for each record */
+	while (qsc_async_atomic_add(&que->pending, -1) != 0)
+	{
+		rec = send_queue_next(que);
+		qerr = send_queue_write(cns, rec->message, rec->length);
+
+		if (qerr != qsmp_error_none)
+		{
+			/* only the first failure is kept, until a producer collects it */
+			qsc_async_atomic_compare_exchange(&que->error, (int32_t)qerr, 0);
+		}
+
+		send_queue_release(que, rec);
+	}
+}
+
+static void send_queue_reset(qsmp_send_queue* que)
+{
+	/* the queue links and the pending count belong to a writer in progress, which drains every counted message
+	before it returns, so only the free list and the uncollected error are released with the session */
+	send_queue_free_dispose(que);
+	qsc_async_atomic_exchange(&que->error, 0);
+}
+
+static void send_queue_dispose(qsmp_send_queue* que)
+{
+	qsmp_send_record* rec;
+
+	if (que->head != NULL)
+	{
+		rec = send_queue_pop(que);
+
+		while (rec != NULL)
+		{
+			qsmp_bufferpool_release((uint8_t*)rec, sizeof(qsmp_send_record) + rec->capacity);
+			rec = send_queue_pop(que);
+		}
+	}
+
+	send_queue_free_dispose(que);
+
+	que->stub.next = NULL;
+	que->head = NULL;
+	que->tail = NULL;
+	que->pending = 0;
+	que->error = 0;
+}
+
+static bool record_length_valid(const qsmp_packet* packet)
+{
+	/* a stream transfer segment is larger than a message, and carries the mac tag on the final segment */
+	return (packet->msglen <= QSMP_MESSAGE_MAX ||
+		(packet->flag == qsmp_flag_transfer_request && packet->msglen <= QSMP_STREAM_SEGMENT_SIZE + QSMP_DUPLEX_MACTAG_SIZE));
+}
+
+static void record_buffer_shrink(qsmp_record_buffer* rbuf)
+{
+	uint8_t* ptmp;
+
+	/* a buffer grown to hold stream transfer segments is returned to its default size, the unparsed records are kept */
+	if (rbuf->capacity > QSMP_RECORD_BUFFER_SIZE && rbuf->length <= QSMP_RECORD_BUFFER_SIZE)
+	{
+		if (rbuf->position != 0)
+		{
+			qsc_memutils_move(rbuf->buffer, rbuf->buffer + rbuf->position, rbuf->length);
+			rbuf->position = 0;
+		}
+
+		qsc_memutils_clear(rbuf->buffer + rbuf->length, rbuf->capacity - rbuf->length);
+		ptmp = (uint8_t*)qsc_memutils_realloc(rbuf->buffer, QSMP_RECORD_BUFFER_SIZE);
+
+		if (ptmp != NULL)
+		{
+			rbuf->buffer = ptmp;
+			rbuf->capacity = QSMP_RECORD_BUFFER_SIZE;
+		}
+	}
+}
+
+static void stream_state_reset(qsmp_stream_state* stm)
+{
+	if (stm->buffer != NULL)
+	{
+		qsc_memutils_clear(stm->buffer, stm->length);
+		qsc_memutils_alloc_free(stm->buffer);
+		stm->buffer = NULL;
+	}
+
+	stm->length = 0;
+	stm->position = 0;
+}
+
+static qsmp_errors stream_send_record(qsmp_connection_state* cns, const qsmp_packet* packet)
+{
+	uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
+	qsc_socket_buffer sbuf[3] = { 0 };
+	struct timeval tv = { 0 };
+	qsmp_errors qerr;
+	uint8_t* ptail;
+	size_t idx;
+	size_t plen;
+	size_t slen;
+
+	qsmp_packet_header_serialize(packet, hdr);
+	sbuf[0].data = hdr;
+	sbuf[0].length = QSMP_HEADER_SIZE;
+	sbuf[1].data = packet->pmessage;
+	sbuf[1].length = packet->msglen;
+	sbuf[2].data = m_record_terminator;
+	sbuf[2].length = QSC_SOCKET_TERMINATOR_SIZE;
+	tv.tv_usec = QSMP_STREAM_WRITABLE_WAIT;
+	qerr = qsmp_error_none;
+	idx = 0;
+
+	while (idx < 3 && qerr == qsmp_error_none)
+	{
+		/* the record follows the queued records */
+		qerr = connection_queue_flush(cns);
+
+		if (qerr == qsmp_error_none && cns->txbuf.length == 0)
+		{
+			slen = qsc_socket_sendv(&cns->target, sbuf + idx, 3 - idx, qsc_socket_send_flag_none);
+
+			if (slen == 0 && qsc_socket_get_last_error() != qsc_socket_exception_would_block)
+			{
+				qerr = qsmp_error_transmit_failure;
+			}
+
+			/* advance past the segments the socket accepted */
+			while (slen != 0 && idx < 3)
+			{
+				if (slen >= sbuf[idx].length)
+				{
+					slen -= sbuf[idx].length;
+					++idx;
+				}
+				else
+				{
+					sbuf[idx].data += slen;
+					sbuf[idx].length -= slen;
+					slen = 0;
+				}
+			}
+		}
+
+		if (qerr == qsmp_error_none && idx < 3)
+		{
+			plen = 0;
+
+			for (size_t i = idx; i < 3; ++i)
+			{
+				plen += sbuf[i].length;
+			}
+
+			/* the unsent remainder is handed to the transmit queue, and sent by the next flush or writable event */
+			ptail = connection_queue_reserve(&cns->txbuf, plen);
+
+			if (ptail != NULL)
+			{
+				for (; idx < 3; ++idx)
+				{
+					qsc_memutils_copy(ptail, sbuf[idx].data, sbuf[idx].length);
+					ptail += sbuf[idx].length;
+				}
+
+				cns->txbuf.length += plen;
+			}
+			else if (qsc_socket_is_connected(&cns->target) == true)
+			{
+				/* a segment is larger than the queue, so the sender waits for the socket to drain */
+				qsc_socket_send_ready(&cns->target, &tv);
+			}
+			else
+			{
+				qerr = qsmp_error_channel_down;
+			}
+		}
+	}
+
+	return qerr;
+}
+
+static qsmp_multiplex_stream* multiplex_stream_find(qsmp_multiplex_state* mux, uint32_t sid)
+{
+	qsmp_multiplex_stream* stm;
+
+	stm = NULL;
+
+	for (size_t i = 0; i < QSMP_MULTIPLEX_STREAMS_MAX; ++i)
+	{
+		if (mux->streams[i].id == sid && sid != 0)
+		{
+			stm = &mux->streams[i];
+			break;
+		}
+	}
+
+	return stm;
+}
+
+static qsmp_multiplex_stream* multiplex_stream_add(qsmp_multiplex_state* mux, uint32_t sid, void (*callback)(qsmp_connection_state*, uint32_t, const uint8_t*, size_t))
+{
+	qsmp_multiplex_stream* stm;
+
+	stm = NULL;
+
+	for (size_t i = 0; i < QSMP_MULTIPLEX_STREAMS_MAX; ++i)
+	{
+		if (mux->streams[i].id == 0)
+		{
+			stm = &mux->streams[i];
+			qsc_memutils_clear(stm, sizeof(qsmp_multiplex_stream));
+			stm->id = sid;
+			stm->callback = callback;
+			break;
+		}
+	}
+
+	return stm;
+}
+
+static void multiplex_stream_release(qsmp_multiplex_stream* stm)
+{
+	qsmp_multiplex_message* msg;
+
+	while (stm->head != NULL)
+	{
+		msg = stm->head;
+		stm->head = msg->next;
+		qsc_memutils_clear(msg->message, msg->length);
+		qsc_memutils_alloc_free(msg);
+	}
+
+	if (stm->rxbuf != NULL)
+	{
+		qsc_memutils_clear(stm->rxbuf, stm->rxcap);
+		qsc_memutils_alloc_free(stm->rxbuf);
+	}
+
+	qsc_memutils_clear(stm, sizeof(qsmp_multiplex_stream));
+}
+
+static qsmp_errors multiplex_stream_queue(qsmp_multiplex_stream* stm, uint8_t type, const uint8_t* message, size_t msglen)
+{
+	qsmp_multiplex_message* msg;
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_transmit_failure;
+
+	if (stm->pending + msglen <= QSMP_MULTIPLEX_QUEUE_SIZE)
+	{
+		/* the message is copied behind its queue entry, so one allocation holds both */
+		msg = (qsmp_multiplex_message*)qsc_memutils_malloc(sizeof(qsmp_multiplex_message) + msglen);
+
+		if (msg != NULL)
+		{
+			msg->next = NULL;
+			msg->message = (uint8_t*)msg + sizeof(qsmp_multiplex_message);
+			msg->length = msglen;
+			msg->position = 0;
+			msg->type = type;
+
+			if (msglen != 0)
+			{
+				qsc_memutils_copy(msg->message, message, msglen);
+			}
+
+			if (stm->tail != NULL)
+			{
+				stm->tail->next = msg;
+			}
+			else
+			{
+				stm->head = msg;
+			}
+
+			stm->tail = msg;
+			stm->pending += msglen;
+			qerr = qsmp_error_none;
+		}
+		else
+		{
+			qerr = qsmp_error_memory_allocation;
+		}
+	}
+
+	return qerr;
+}
+
+static size_t multiplex_schedule(qsmp_multiplex_state* mux, uint8_t* frame)
+{
+	qsmp_multiplex_message* msg;
+	qsmp_multiplex_stream* stm;
+	size_t flen;
+	size_t plen;
+	size_t sidx;
+
+	flen = 0;
+
+	/* the streams are visited in turn from the slot after the last stream sent, each sends at most one frame */
+	for (size_t i = 0; i < QSMP_MULTIPLEX_STREAMS_MAX; ++i)
+	{
+		sidx = (mux->next + i) % QSMP_MULTIPLEX_STREAMS_MAX;
+		stm = &mux->streams[sidx];
+
+		if (stm->id != 0 && stm->head != NULL)
+		{
+			msg = stm->head;
+			plen = msg->length - msg->position;
+			plen = (plen > QSMP_MULTIPLEX_FRAME_SIZE) ? QSMP_MULTIPLEX_FRAME_SIZE : plen;
+			frame[0] = msg->type;
+			qsc_intutils_le32to8(frame + sizeof(uint8_t), stm->id);
+
+			if (plen != 0)
+			{
+				qsc_memutils_copy(frame + QSMP_MULTIPLEX_PREFIX_SIZE, msg->message + msg->position, plen);
+				msg->position += plen;
+				stm->pending -= plen;
+
+				/* the last frame of a message completes it at the receiver */
+				if (msg->position != msg->length)
+				{
+					frame[0] = multiplex_frame_data;
+				}
+			}
+
+			flen = QSMP_MULTIPLEX_PREFIX_SIZE + plen;
+
+			if (msg->position == msg->length)
+			{
+				stm->head = msg->next;
+				stm->tail = (stm->head != NULL) ? stm->tail : NULL;
+				qsc_memutils_clear(msg->message, msg->length);
+				qsc_memutils_alloc_free(msg);
+
+				if (frame[0] == multiplex_frame_close)
+				{
+					multiplex_stream_release(stm);
+				}
+			}
+
+			mux->next = sidx + 1;
+			break;
+		}
+	}
+
+	return flen;
+}
+
+static qsmp_errors multiplex_drain(qsmp_connection_state* cns)
+{
+	uint8_t frame[QSMP_MULTIPLEX_PREFIX_SIZE + QSMP_MULTIPLEX_FRAME_SIZE] = { 0 };
+	qsmp_multiplex_state* mux;
+	qsmp_errors qerr;
+	size_t flen;
+
+	mux = cns->mux;
+	qerr = qsmp_error_none;
+	qsc_async_mutex_lock(mux->lock);
+
+	/* one thread sends the frames of every stream, a thread that finds the queues being drained leaves its message to that thread */
+	if (mux->draining == false)
+	{
+		mux->draining = true;
+
+		do
+		{
+			flen = multiplex_schedule(mux, frame);
+			qsc_async_mutex_unlock(mux->lock);
+
+			if (flen != 0)
+			{
+				qsmp_connection_transmit_lock(cns);
+				qerr = connection_coalesce_flush(cns);
+
+				if (qerr == qsmp_error_none)
+				{
+					qerr = connection_send_record(cns, qsmp_flag_multiplex_message, frame, flen);
+				}
+
+				qsc_async_mutex_unlock(cns->txlock);
+			}
+
+			qsc_async_mutex_lock(mux->lock);
+		} 
+		while (flen != 0 && qerr == qsmp_error_none);
+
+		mux->draining = false;
+	}
+
+	qsc_async_mutex_unlock(mux->lock);
+	qsc_memutils_clear(frame, sizeof(frame));
+
+	return qerr;
+}
+
+static void multiplex_state_dispose(qsmp_connection_state* cns)
+{
+	if (cns->mux != NULL)
+	{
+		for (size_t i = 0; i < QSMP_MULTIPLEX_STREAMS_MAX; ++i)
+		{
+			multiplex_stream_release(&cns->mux->streams[i]);
+		}
+
+		if (cns->mux->lock != NULL)
+		{
+			qsc_async_mutex_destroy(cns->mux->lock);
+		}
+
+		qsc_memutils_alloc_free(cns->mux);
+		cns->mux = NULL;
+	}
+}
+
+bool qsmp_coalesced_next(const uint8_t* message, size_t msglen, size_t* position, const uint8_t** entry, size_t* entlen)
+{
+	assert(message != NULL);
+	assert(position != NULL);
+	assert(entry != NULL);
+	assert(entlen != NULL);
+
+	size_t elen;
+	bool res;
+
+	res = false;
+
+	if (message != NULL && position != NULL && entry != NULL && entlen != NULL && *position + QSMP_COALESCE_PREFIX_SIZE <= msglen)
+	{
+		/* each message is prefixed with its 16-bit length */
+		elen = qsc_intutils_le8to16(message + *position);
+
+		if (elen != 0 && *position + QSMP_COALESCE_PREFIX_SIZE + elen <= msglen)
+		{
+			*entry = message + *position + QSMP_COALESCE_PREFIX_SIZE;
+			*entlen = elen;
+			*position += QSMP_COALESCE_PREFIX_SIZE + elen;
+			res = true;
+		}
+	}
+
+	return res;
+}
+
 void qsmp_connection_close(qsmp_connection_state* cns, qsmp_errors err, bool notify)
 {
 	assert(cns != NULL);
 
-	if (cns != NULL)
+	if (cns != NULL)
+	{
+		if (qsc_socket_is_connected(&cns->target) == true)
+		{
+			if (notify == true)
+			{
+				qsmp_packet resp = { 0 };
+				uint8_t mresp[sizeof(uint8_t)] = { 0 };
+				uint8_t spct[QSMP_HEADER_SIZE + sizeof(uint8_t) + QSC_SOCKET_TERMINATOR_SIZE] = { 0 };
+				size_t plen;
+
+				/* send a disconnect message */
+				resp.pmessage = mresp;
+				resp.flag = qsmp_flag_connection_terminate;
+				resp.sequence = QSMP_SEQUENCE_TERMINATOR;
+				resp.msglen = 1;
+				resp.pmessage[0] = (uint8_t)err;
+				plen = qsmp_packet_to_stream(&resp, spct) + QSC_SOCKET_TERMINATOR_SIZE;
+				qsc_async_mutex_lock_counted(cns->txlock, &cns->txstats);
+
+				/* pending messages are sent before the notification, which follows any queued records,
+				   a stream transfer in progress owns the transmit cipher and the notification ends it */
+				if (cns->txstream == true || connection_coalesce_flush(cns) == qsmp_error_none)
+				{
+					connection_send_control(cns, spct, plen);
+				}
+
+				qsc_async_mutex_unlock(cns->txlock);
+			}
+
+			/* close the socket */
+			qsc_socket_close_socket(&cns->target);
+			cns->target.connection_status = qsc_socket_state_none;
+		}
+	}
+}
+
+void qsmp_connection_coalesce_disable(qsmp_connection_state* cns)
+{
+	assert(cns != NULL);
+
+	if (cns != NULL)
+	{
+		/* the timer is cancelled before the lock is taken, its callback also takes the transmit lock */
+		qsmp_timerwheel_cancel(&cns->coalesce.timer);
+		qsmp_connection_transmit_lock(cns);
+
+		if (cns->coalesce.buffer != NULL)
+		{
+			connection_coalesce_flush(cns);
+			coalesce_state_reset(&cns->coalesce);
+		}
+
+		qsc_async_mutex_unlock(cns->txlock);
+	}
+}
+
+qsmp_errors qsmp_connection_coalesce_enable(qsmp_connection_state* cns, size_t threshold, uint32_t latency)
+{
+	assert(cns != NULL);
+
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL && threshold != 0)
+	{
+		qsc_async_mutex_lock_counted(cns->txlock, &cns->txstats);
+
+		if (cns->coalesce.buffer == NULL)
+		{
+			cns->coalesce.buffer = (uint8_t*)qsc_memutils_malloc(QSMP_COALESCE_SIZE_MAX);
+
+			if (cns->coalesce.buffer != NULL)
+			{
+				qsc_memutils_clear(cns->coalesce.buffer, QSMP_COALESCE_SIZE_MAX);
+				cns->coalesce.length = 0;
+			}
+		}
+
+		if (cns->coalesce.buffer != NULL)
+		{
+			/* the settings can be changed while enabled, and apply from the next message */
+			cns->coalesce.threshold = (threshold < QSMP_COALESCE_SIZE_MAX - QSMP_COALESCE_PREFIX_SIZE) ? threshold : QSMP_COALESCE_SIZE_MAX - QSMP_COALESCE_PREFIX_SIZE;
+			cns->coalesce.latency = latency;
+			qerr = qsmp_error_none;
+		}
+		else
+		{
+			qerr = qsmp_error_memory_allocation;
+		}
+
+		qsc_async_mutex_unlock(cns->txlock);
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_connection_dispatch(qsmp_connection_state* cns,
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t),
+	qsmp_errors (*control_callback)(qsmp_connection_state*, const qsmp_packet*))
+{
+	assert(cns != NULL);
+	assert(receive_callback != NULL);
+
+	qsmp_packet pkts[QSMP_DECRYPT_BATCH_MAX] = { 0 };
+	qsc_socket_buffer msgs[QSMP_DECRYPT_BATCH_MAX] = { 0 };
+	qsmp_packet pkt = { 0 };
+	const uint8_t* pcms;
+	uint8_t* pstm;
+	qsmp_errors qerr;
+	size_t clen;
+	size_t cpos;
+	size_t mcnt;
+	size_t mlen;
+	size_t pcnt;
+
+	qerr = qsmp_error_none;
+
+	if (cns != NULL && receive_callback != NULL)
+	{
+		/* process every complete record in the buffer, a partial record is kept for the next read */
+		while (qerr == qsmp_error_none && qsmp_record_buffer_next(&cns->rxbuf, &pkt) == true)
+		{
+			if (pkt.flag == qsmp_flag_encrypted_message)
+			{
+				/* the message records that follow are taken from the buffer, and the run is decrypted in place with one call */
+				pkts[0] = pkt;
+				pcnt = 1 + qsmp_record_buffer_run(&cns->rxbuf, pkts + 1, QSMP_DECRYPT_BATCH_MAX - 1);
+				mcnt = 0;
+				qerr = qsmp_decrypt_packets(cns, pkts, pcnt, msgs, &mcnt);
+
+				/* the callback receives pointers into the receive buffer */
+				for (size_t i = 0; i < mcnt; ++i)
+				{
+					receive_callback(cns, msgs[i].data, msgs[i].length);
+				}
+
+				if (qerr != qsmp_error_none)
+				{
+					/* close the connection on authentication failure */
+					qsmp_log_write(qsmp_messages_decryption_fail, (const char*)cns->target.address);
+					qerr = qsmp_error_authentication_failure;
+				}
+			}
+			else if (pkt.flag == qsmp_flag_coalesced_message)
+			{
+				mlen = 0;
+				/* decrypt the record in place, each message packed in the record is passed to the callback in order */
+				qerr = qsmp_decrypt_packet(cns, pkt.pmessage, &mlen, &pkt);
+
+				if (qerr == qsmp_error_none)
+				{
+					cpos = 0;
+
+					while (qsmp_coalesced_next(pkt.pmessage, mlen, &cpos, &pcms, &clen) == true)
+					{
+						receive_callback(cns, pcms, clen);
+					}
+				}
+				else
+				{
+					qsmp_log_write(qsmp_messages_decryption_fail, (const char*)cns->target.address);
+					qerr = qsmp_error_authentication_failure;
+				}
+			}
+			else if (pkt.flag == qsmp_flag_transfer_request)
+			{
+				mlen = 0;
+				pstm = NULL;
+				/* the payload of a stream transfer is delivered once the final segment is authenticated */
+				qerr = qsmp_stream_receive(cns, &pkt, &pstm, &mlen);
+
+				if (qerr == qsmp_error_none)
+				{
+					if (pstm != NULL)
+					{
+						receive_callback(cns, pstm, mlen);
+						qsc_memutils_clear(pstm, mlen);
+						qsc_memutils_alloc_free(pstm);
+						record_buffer_shrink(&cns->rxbuf);
+					}
+				}
+				else
+				{
+					qsmp_log_write(qsmp_messages_decryption_fail, (const char*)cns->target.address);
+					qerr = qsmp_error_authentication_failure;
+				}
+			}
+			else if (pkt.flag == qsmp_flag_multiplex_message)
+			{
+				/* the frame is decrypted in place, and a completed message is passed to the callback of its logical stream */
+				qerr = qsmp_multiplex_receive(cns, &pkt);
+
+				if (qerr != qsmp_error_none)
+				{
+					qsmp_log_write(qsmp_messages_decryption_fail, (const char*)cns->target.address);
+					qerr = qsmp_error_authentication_failure;
+				}
+			}
+			else if (pkt.flag == qsmp_flag_connection_terminate)
+			{
+				qsmp_log_write(qsmp_messages_disconnect, (const char*)cns->target.address);
+				qerr = qsmp_error_channel_down;
+			}
+			else
+			{
+				/* session control records are handled by the caller, an unknown or malformed record ends the session */
+				qerr = (control_callback != NULL) ? control_callback(cns, &pkt) : qsmp_error_invalid_request;
+
+				if (qerr == qsmp_error_invalid_request)
+				{
+					qsmp_log_write(qsmp_messages_receive_fail, (const char*)cns->target.address);
+				}
+			}
+		}
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_connection_flush(qsmp_connection_state* cns)
+{
+	assert(cns != NULL);
+
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL)
+	{
+		qsc_async_mutex_lock_counted(cns->txlock, &cns->txstats);
+		/* the coalesced messages are sent, or queued behind the records that are waiting,
+		   unless a stream transfer owns the transmit cipher */
+		qerr = (cns->txstream == false) ? connection_coalesce_flush(cns) : qsmp_error_none;
+
+		if (qerr == qsmp_error_none)
+		{
+			qerr = connection_queue_flush(cns);
+		}
+
+		qsc_async_mutex_unlock(cns->txlock);
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_connection_keepalive_request(qsmp_connection_state* cns)
+{
+	assert(cns != NULL);
+
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL)
+	{
+		uint8_t mreq[sizeof(uint64_t)] = { 0 };
+		uint8_t spct[QSMP_HEADER_SIZE + sizeof(uint64_t) + QSC_SOCKET_TERMINATOR_SIZE] = { 0 };
+		qsmp_packet req = { 0 };
+		size_t plen;
+
+		qsc_async_mutex_lock_counted(cns->txlock, &cns->txstats);
+
+		/* a request is outstanding until its response is verified */
+		if (cns->kpa.etime != 0 && cns->kpa.recd == false)
+		{
+			qerr = qsmp_error_keep_alive_expired;
+		}
+		else
+		{
+			/* the request carries the time it was sent, and the keep alive sequence counter */
+			cns->kpa.etime = qsc_timestamp_epochtime_seconds();
+			cns->kpa.recd = false;
+			req.pmessage = mreq;
+			req.flag = qsmp_flag_keep_alive_request;
+			req.sequence = cns->kpa.seqctr;
+			req.msglen = sizeof(uint64_t);
+			qsc_intutils_le64to8(req.pmessage, cns->kpa.etime);
+			plen = qsmp_packet_to_stream(&req, spct) + QSC_SOCKET_TERMINATOR_SIZE;
+			/* the request is sent in order behind any queued records */
+			qerr = connection_send_control(cns, spct, plen);
+		}
+
+		qsc_async_mutex_unlock(cns->txlock);
+	}
+
+	return qerr;
+}
+
+void qsmp_connection_transmit_lock(qsmp_connection_state* cns)
+{
+	assert(cns != NULL);
+
+	if (cns != NULL)
+	{
+		qsc_async_mutex_lock_counted(cns->txlock, &cns->txstats);
+
+		/* a stream transfer releases the lock between segments, but owns the transmit cipher until it completes */
+		while (cns->txstream == true)
+		{
+			qsc_async_mutex_unlock(cns->txlock);
+			qsc_async_thread_yield();
+			qsc_async_mutex_lock_counted(cns->txlock, &cns->txstats);
+		}
+	}
+}
+
+qsmp_errors qsmp_connection_send_locked(qsmp_connection_state* cns, const uint8_t* record, size_t reclen)
+{
+	assert(cns != NULL);
+	assert(record != NULL);
+
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL && record != NULL && reclen != 0)
+	{
+		qerr = connection_send_control(cns, record, reclen);
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_connection_keepalive_response(qsmp_connection_state* cns, const qsmp_packet* packetin)
+{
+	assert(cns != NULL);
+	assert(packetin != NULL);
+
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL && packetin != NULL)
+	{
+		qerr = qsmp_error_bad_keep_alive;
+		qsc_async_mutex_lock_counted(cns->txlock, &cns->txstats);
+
+		/* the response must echo the sequence and time of the outstanding request */
+		if (packetin->msglen == sizeof(uint64_t) && cns->kpa.recd == false &&
+			packetin->sequence == cns->kpa.seqctr &&
+			qsc_intutils_le8to64(packetin->pmessage) == cns->kpa.etime)
+		{
+			cns->kpa.seqctr += 1;
+			cns->kpa.recd = true;
+			qerr = qsmp_error_none;
+		}
+
+		qsc_async_mutex_unlock(cns->txlock);
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_connection_queue(qsmp_connection_state* cns, const uint8_t* message, size_t msglen)
+{
+	assert(cns != NULL);
+	assert(message != NULL);
+
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL && message != NULL && msglen != 0 && msglen <= QSMP_MESSAGE_MAX - (QSMP_HEADER_SIZE + QSMP_DUPLEX_MACTAG_SIZE))
+	{
+		qsc_async_mutex_lock_counted(cns->txlock, &cns->txstats);
+		/* a stream transfer in progress owns the transmit cipher, the message is refused and can be sent when it completes */
+		qerr = (cns->txstream == false) ? connection_coalesce_flush(cns) : qsmp_error_transmit_busy;
+
+		if (qerr == qsmp_error_none)
+		{
+			qerr = connection_queue_message(cns, qsmp_flag_encrypted_message, message, msglen);
+		}
+
+		if (qerr == qsmp_error_none)
+		{
+			qerr = connection_queue_flush(cns);
+		}
+
+		qsc_async_mutex_unlock(cns->txlock);
+	}
+
+	return qerr;
+}
+
+size_t qsmp_connection_queue_multi(qsmp_connection_state* cns[], size_t count, const uint8_t* message, size_t msglen, qsmp_errors results[])
+{
+	assert(cns != NULL);
+	assert(message != NULL);
+	assert(results != NULL);
+
+	qsmp_packet pkt[QSMP_CONNECTION_QUEUE_MULTI_MAX];
+	qsc_rcs_state* pcpr[QSMP_CONNECTION_QUEUE_MULTI_MAX];
+	const uint8_t* pinp[QSMP_CONNECTION_QUEUE_MULTI_MAX];
+	uint8_t* pout[QSMP_CONNECTION_QUEUE_MULTI_MAX];
+	uint8_t* ptail[QSMP_CONNECTION_QUEUE_MULTI_MAX];
+	size_t pidx[QSMP_CONNECTION_QUEUE_MULTI_MAX];
+	size_t plen[QSMP_CONNECTION_QUEUE_MULTI_MAX];
+	size_t bcnt;
+	size_t ccnt;
+	size_t hlen;
+	size_t i;
+	size_t j;
+	size_t qcnt;
+
+	qcnt = 0;
+
+	if (cns != NULL && message != NULL && results != NULL && msglen != 0 && msglen <= QSMP_MESSAGE_MAX - (QSMP_HEADER_SIZE + QSMP_DUPLEX_MACTAG_SIZE))
+	{
+		for (i = 0; i < count; i += bcnt)
+		{
+			bcnt = (count - i < QSMP_CONNECTION_QUEUE_MULTI_MAX) ? count - i : QSMP_CONNECTION_QUEUE_MULTI_MAX;
+			ccnt = 0;
+
+			/* the transmit locks are taken in array order, and held until the batch is queued */
+			for (j = i; j < i + bcnt; ++j)
+			{
+				qsc_async_mutex_lock_counted(cns[j]->txlock, &cns[j]->txstats);
+
+				/* the session may have been closed and its slot reset after it was selected */
+				if (cns[j]->exflag == qsmp_flag_session_established && qsc_socket_is_connected(&cns[j]->target) == true)
+				{
+					results[j] = (cns[j]->txstream == false) ? connection_coalesce_flush(cns[j]) : qsmp_error_transmit_busy;
+				}
+				else
+				{
+					results[j] = qsmp_error_channel_down;
+				}
+
+				if (results[j] == qsmp_error_none)
+				{
+					const size_t MACLEN = (cns[j]->txcpr.ctype == qsc_rcs_cipher_256) ? QSMP_SIMPLEX_MACTAG_SIZE : QSMP_DUPLEX_MACTAG_SIZE;
+
+					ptail[ccnt] = connection_queue_reserve(&cns[j]->txbuf, QSMP_HEADER_SIZE + msglen + MACLEN + QSC_SOCKET_TERMINATOR_SIZE);
+
+					if (ptail[ccnt] != NULL)
+					{
+						qsc_memutils_clear((uint8_t*)&pkt[ccnt], sizeof(qsmp_packet));
+						pkt[ccnt].pmessage = ptail[ccnt] + QSMP_HEADER_SIZE;
+						results[j] = packet_encrypt_header(cns[j], &pkt[ccnt], qsmp_flag_encrypted_message, msglen);
+
+						if (results[j] == qsmp_error_none)
+						{
+							pcpr[ccnt] = &cns[j]->txcpr;
+							pinp[ccnt] = message;
+							pout[ccnt] = pkt[ccnt].pmessage;
+							plen[ccnt] = msglen;
+							pidx[ccnt] = j;
+							++ccnt;
+						}
+					}
+					else
+					{
+						results[j] = qsmp_error_transmit_failure;
+					}
+				}
+			}
+
+			/* the message is encrypted for every session in the batch with one multi-buffer transform */
+			qsc_rcs_transform_multi(pcpr, pout, pinp, plen, ccnt);
+
+			for (j = 0; j < ccnt; ++j)
+			{
+				qsmp_packet_header_serialize(&pkt[j], ptail[j]);
+				hlen = QSMP_HEADER_SIZE + pkt[j].msglen;
+				ptail[j][hlen] = 0;
+				cns[pidx[j]]->txbuf.length += hlen + QSC_SOCKET_TERMINATOR_SIZE;
+				results[pidx[j]] = connection_queue_flush(cns[pidx[j]]);
+
+				if (results[pidx[j]] == qsmp_error_none)
+				{
+					++qcnt;
+				}
+			}
+
+			for (j = i; j < i + bcnt; ++j)
+			{
+				qsc_async_mutex_unlock(cns[j]->txlock);
+			}
+		}
+	}
+	else if (results != NULL)
+	{
+		for (i = 0; i < count; ++i)
+		{
+			results[i] = qsmp_error_invalid_input;
+		}
+	}
+
+	return qcnt;
+}
+
+qsmp_errors qsmp_connection_send(qsmp_connection_state* cns, const uint8_t* message, size_t msglen)
+{
+	assert(cns != NULL);
+	assert(message != NULL);
+
+	qsmp_send_record* rec;
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL && message != NULL && msglen != 0 && msglen <= QSMP_MESSAGE_MAX - (QSMP_HEADER_SIZE + QSMP_DUPLEX_MACTAG_SIZE))
+	{
+		/* a queued message from an earlier call failed, the failure is collected and reported once */
+		qerr = (qsmp_errors)qsc_async_atomic_exchange(&cns->txque.error, 0);
+
+		if (qerr == qsmp_error_none && (cns->exflag != qsmp_flag_session_established || qsc_socket_is_connected(&cns->target) == false))
+		{
+			/* a message is not counted on a closed session, whose slot may be reset and reused */
+			qerr = qsmp_error_channel_down;
+		}
+		else if (qerr == qsmp_error_none && cns->txque.pending >= QSMP_SEND_QUEUE_DEPTH)
+		{
+			/* the depth is read without ordering, the bound is approximate by up to the number of producers */
+			qerr = qsmp_error_transmit_failure;
+		}
+		else if (qerr == qsmp_error_none)
+		{
+			/* the queue is idle, this thread is the writer and sends its own message without taking an entry */
+			if (qsc_async_atomic_compare_exchange(&cns->txque.pending, 1, 0) == true)
+			{
+				rec = NULL;
+			}
+			else
+			{
+				/* the entry is taken before the producer is counted, so a counted message is never lost */
+				rec = send_queue_acquire(&cns->txque, msglen);
+
+				if (rec != NULL && qsc_async_atomic_add(&cns->txque.pending, 1) == 1)
+				{
+					/* the writer finished while the entry was taken, so this thread is the writer */
+					send_queue_release(&cns->txque, rec);
+					rec = NULL;
+				}
+				else if (rec == NULL)
+				{
+					qerr = qsmp_error_memory_allocation;
+				}
+			}
+
+			if (qerr == qsmp_error_none && rec == NULL)
+			{
+				qsmp_connection_transmit_lock(cns);
+				qerr = send_queue_write(cns, message, msglen);
+				send_queue_drain(cns);
+				qsc_async_mutex_unlock(cns->txlock);
+			}
+			else if (qerr == qsmp_error_none)
+			{
+				/* the writer owns the cipher and sequence, and sends the message in the order it was added */
+				rec->message = (uint8_t*)rec + sizeof(qsmp_send_record);
+				rec->length = msglen;
+				qsc_memutils_copy(rec->message, message, msglen);
+				send_queue_push(&cns->txque, rec);
+			}
+		}
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_connection_sendv(qsmp_connection_state* cns, const qsc_socket_buffer* messages, size_t count)
+{
+	assert(cns != NULL);
+	assert(messages != NULL);
+
+	qsmp_errors qerr;
+	size_t clen;
+	size_t mlen;
+
+	qerr = qsmp_error_invalid_input;
+	clen = 0;
+
+	if (cns != NULL && messages != NULL && count != 0 && count <= QSMP_CONNECTION_SENDV_MAX)
 	{
-		if (qsc_socket_is_connected(&cns->target) == true)
+		mlen = (cns->txcpr.ctype == qsc_rcs_cipher_256) ? QSMP_SIMPLEX_MACTAG_SIZE : QSMP_DUPLEX_MACTAG_SIZE;
+
+		for (size_t i = 0; i < count; ++i)
 		{
-			if (notify == true)
+			if (messages[i].data == NULL || messages[i].length == 0 || messages[i].length > QSMP_MESSAGE_MAX - (QSMP_HEADER_SIZE + QSMP_DUPLEX_MACTAG_SIZE))
 			{
-				qsmp_packet resp = { 0 };
-				uint8_t mresp[QSMP_MESSAGE_MAX] = { 0 };
-				uint8_t spct[QSMP_MESSAGE_MAX] = { 0 };
-				size_t plen;
+				clen = 0;
+				break;
+			}
 
-				/* send a disconnect message */
-				resp.pmessage = mresp;
-				resp.flag = qsmp_flag_connection_terminate;
-				resp.sequence = QSMP_SEQUENCE_TERMINATOR;
-				resp.msglen = 1;
-				resp.pmessage[0] = (uint8_t)err;
-				plen = qsmp_packet_to_stream(&resp, spct);
-				qsc_socket_send(&cns->target, spct, plen, qsc_socket_send_flag_none);
+			clen += messages[i].length + mlen;
+		}
+	}
+
+	if (clen != 0)
+	{
+		uint8_t hdrs[QSMP_CONNECTION_SENDV_MAX][QSMP_HEADER_SIZE] = { 0 };
+		qsc_socket_buffer sbuf[QSMP_CONNECTION_SENDV_MAX * 3] = { 0 };
+		qsmp_packet pkt = { 0 };
+		uint8_t* pctx;
+
+		/* the cipher-text of every record is written to one allocation, and the records are sent with a single gathering send */
+		pctx = (uint8_t*)qsc_memutils_malloc(clen);
+
+		if (pctx != NULL)
+		{
+			qsmp_connection_transmit_lock(cns);
+			qerr = connection_coalesce_flush(cns);
+
+			if (qerr == qsmp_error_none && cns->txbuf.length != 0)
+			{
+				qerr = connection_queue_flush(cns);
 			}
 
-			/* close the socket */
-			qsc_socket_close_socket(&cns->target);
+			if (qerr == qsmp_error_none && cns->txbuf.length != 0)
+			{
+				/* the records are queued in order behind the records still waiting */
+				for (size_t i = 0; i < count && qerr == qsmp_error_none; ++i)
+				{
+					qerr = connection_queue_message(cns, qsmp_flag_encrypted_message, messages[i].data, messages[i].length);
+				}
+			}
+			else if (qerr == qsmp_error_none)
+			{
+				clen = 0;
+
+				for (size_t i = 0; i < count && qerr == qsmp_error_none; ++i)
+				{
+					pkt.pmessage = pctx + clen;
+					qerr = qsmp_encrypt_packet(cns, &pkt, messages[i].data, messages[i].length);
+
+					if (qerr == qsmp_error_none)
+					{
+						qsmp_packet_header_serialize(&pkt, hdrs[i]);
+						sbuf[i * 3].data = hdrs[i];
+						sbuf[i * 3].length = QSMP_HEADER_SIZE;
+						sbuf[(i * 3) + 1].data = pkt.pmessage;
+						sbuf[(i * 3) + 1].length = pkt.msglen;
+						sbuf[(i * 3) + 2].data = m_record_terminator;
+						sbuf[(i * 3) + 2].length = QSC_SOCKET_TERMINATOR_SIZE;
+						clen += pkt.msglen;
+					}
+				}
+
+				if (qerr == qsmp_error_none)
+				{
+					qerr = connection_send_vector(cns, sbuf, count * 3);
+				}
+			}
+
+			qsc_async_mutex_unlock(cns->txlock);
+			qsc_memutils_alloc_free(pctx);
+		}
+		else
+		{
+			qerr = qsmp_error_memory_allocation;
 		}
 	}
+
+	return qerr;
 }
 
 void qsmp_connection_state_dispose(qsmp_connection_state* cns)
@@ -44,6 +1731,9 @@ void qsmp_connection_state_dispose(qsmp_connection_state* cns)
 
 	if (cns != NULL)
 	{
+		/* a running timer callback completes before the state is released */
+		qsmp_timerwheel_cancel(&cns->timer);
+		qsmp_timerwheel_cancel(&cns->coalesce.timer);
 		qsc_rcs_dispose(&cns->rxcpr);
 		qsc_rcs_dispose(&cns->txcpr);
 		qsc_memutils_clear((uint8_t*)&cns->target, sizeof(qsc_socket));
@@ -52,6 +1742,65 @@ void qsmp_connection_state_dispose(qsmp_connection_state* cns)
 		cns->txseq = 0;
 		cns->instance = 0;
 		cns->exflag = qsmp_flag_none;
+		qsmp_record_buffer_dispose(&cns->rxbuf);
+		qsmp_record_buffer_dispose(&cns->txbuf);
+		stream_state_reset(&cns->rxstm);
+		coalesce_state_reset(&cns->coalesce);
+		multiplex_state_dispose(cns);
+		send_queue_dispose(&cns->txque);
+		qsc_memutils_clear(&cns->kpa, sizeof(qsmp_keep_alive_state));
+		qsc_memutils_clear(&cns->ticket, sizeof(qsmp_session_ticket));
+
+		if (cns->txlock != NULL)
+		{
+			qsc_async_mutex_destroy(cns->txlock);
+			cns->txlock = NULL;
+		}
+	}
+}
+
+void qsmp_connection_state_reset(qsmp_connection_state* cns)
+{
+	assert(cns != NULL);
+
+	const size_t LCKPOS = offsetof(qsmp_connection_state, txlock) + sizeof(qsc_mutex);
+	const size_t QUEPOS = offsetof(qsmp_connection_state, txque) + sizeof(qsmp_send_queue);
+	qsc_mutex txlock;
+	uint32_t instance;
+
+	if (cns != NULL)
+	{
+		/* the timer callbacks take the transmit lock, so they are cancelled before it is held */
+		qsmp_timerwheel_cancel(&cns->timer);
+		qsmp_timerwheel_cancel(&cns->coalesce.timer);
+		txlock = cns->txlock;
+
+		/* a sender holding the lock, such as a broadcast, completes before the buffers are released */
+		if (txlock != NULL)
+		{
+			qsc_async_mutex_lock(txlock);
+		}
+
+		instance = cns->instance;
+		qsc_rcs_dispose(&cns->rxcpr);
+		qsc_rcs_dispose(&cns->txcpr);
+		qsmp_record_buffer_dispose(&cns->rxbuf);
+		qsmp_record_buffer_dispose(&cns->txbuf);
+		stream_state_reset(&cns->rxstm);
+		coalesce_state_reset(&cns->coalesce);
+		multiplex_state_dispose(cns);
+		send_queue_reset(&cns->txque);
+		/* the lock is not part of the cleared state, a thread waiting on it still holds a valid handle,
+		   and the send queue is shared with producers that do not take the lock */
+		qsc_memutils_clear((uint8_t*)cns, offsetof(qsmp_connection_state, txlock));
+		qsc_memutils_clear((uint8_t*)cns + LCKPOS, offsetof(qsmp_connection_state, txque) - LCKPOS);
+		qsc_memutils_clear((uint8_t*)cns + QUEPOS, sizeof(qsmp_connection_state) - QUEPOS);
+		cns->instance = instance;
+
+		if (txlock != NULL)
+		{
+			qsc_async_mutex_unlock(txlock);
+		}
 	}
 }
 
@@ -111,15 +1860,24 @@ qsmp_errors qsmp_decrypt_packet(qsmp_connection_state* cns, uint8_t* message, si
 			{
 				const uint32_t MACLEN = (cns->txcpr.ctype == qsc_rcs_cipher_256) ? QSMP_SIMPLEX_MACTAG_SIZE : QSMP_DUPLEX_MACTAG_SIZE;
 
-				/* serialize the header and add it to the ciphers associated data */
-				qsmp_packet_header_serialize(packetin, hdr);
-				qsc_rcs_set_associated(&cns->rxcpr, hdr, QSMP_HEADER_SIZE);
-				*msglen = packetin->msglen - MACLEN;
-
-				/* authenticate then decrypt the data */
-				if (qsc_rcs_transform(&cns->rxcpr, message, packetin->pmessage, *msglen) == true)
+				/* a record shorter than the mac tag can not be authenticated */
+				if (packetin->msglen >= MACLEN)
 				{
-					qerr = qsmp_error_none;
+					/* serialize the header and add it to the ciphers associated data */
+					qsmp_packet_header_serialize(packetin, hdr);
+					qsc_rcs_set_associated(&cns->rxcpr, hdr, QSMP_HEADER_SIZE);
+					*msglen = packetin->msglen - MACLEN;
+
+					/* authenticate then decrypt the data */
+					if (qsc_rcs_transform(&cns->rxcpr, message, packetin->pmessage, *msglen) == true)
+					{
+						qerr = qsmp_error_none;
+					}
+					else
+					{
+						*msglen = 0;
+						qerr = qsmp_error_authentication_failure;
+					}
 				}
 				else
 				{
@@ -143,6 +1901,63 @@ qsmp_errors qsmp_decrypt_packet(qsmp_connection_state* cns, uint8_t* message, si
 	return qerr;
 }
 
+qsmp_errors qsmp_decrypt_packets(qsmp_connection_state* cns, const qsmp_packet* packets, size_t count, qsc_socket_buffer* messages, size_t* mcount)
+{
+	assert(cns != NULL);
+	assert(packets != NULL);
+	assert(messages != NULL);
+	assert(mcount != NULL);
+
+	uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
+	qsmp_errors qerr;
+	size_t mlen;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL && packets != NULL && messages != NULL && mcount != NULL)
+	{
+		const uint32_t MACLEN = (cns->txcpr.ctype == qsc_rcs_cipher_256) ? QSMP_SIMPLEX_MACTAG_SIZE : QSMP_DUPLEX_MACTAG_SIZE;
+
+		*mcount = 0;
+		qerr = (cns->exflag == qsmp_flag_session_established) ? qsmp_error_none : qsmp_error_channel_down;
+
+		/* the records are decrypted in place in order, a failure stops the run and the preceding messages are returned */
+		for (size_t i = 0; i < count && qerr == qsmp_error_none; ++i)
+		{
+			cns->rxseq += 1;
+
+			if (packets[i].sequence != cns->rxseq)
+			{
+				qerr = qsmp_error_packet_unsequenced;
+			}
+			else if (packets[i].msglen < MACLEN)
+			{
+				qerr = qsmp_error_authentication_failure;
+			}
+			else
+			{
+				/* each header is authenticated with its record */
+				qsmp_packet_header_serialize(&packets[i], hdr);
+				qsc_rcs_set_associated(&cns->rxcpr, hdr, QSMP_HEADER_SIZE);
+				mlen = packets[i].msglen - MACLEN;
+
+				if (qsc_rcs_transform(&cns->rxcpr, packets[i].pmessage, packets[i].pmessage, mlen) == true)
+				{
+					messages[i].data = packets[i].pmessage;
+					messages[i].length = mlen;
+					*mcount += 1;
+				}
+				else
+				{
+					qerr = qsmp_error_authentication_failure;
+				}
+			}
+		}
+	}
+
+	return qerr;
+}
+
 void qsmp_deserialize_signature_key(qsmp_server_signature_key* kset, const uint8_t serk[QSMP_SIGKEY_ENCODED_SIZE])
 {
 	assert(kset != NULL);
@@ -239,30 +2054,7 @@ qsmp_errors qsmp_encrypt_packet(qsmp_connection_state* cns, qsmp_packet* packeto
 
 	if (cns != NULL && message != NULL && packetout != NULL)
 	{
-		if (cns->exflag == qsmp_flag_session_established && msglen != 0)
-		{
-			uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
-			const uint32_t MACLEN = (cns->txcpr.ctype == qsc_rcs_cipher_256) ? QSMP_SIMPLEX_MACTAG_SIZE : QSMP_DUPLEX_MACTAG_SIZE;
-
-			/* assemble the encryption packet */
-			cns->txseq += 1;
-			qsc_memutils_clear(packetout->pmessage, QSMP_MESSAGE_MAX);
-			packetout->flag = qsmp_flag_encrypted_message;
-			packetout->msglen = (uint32_t)msglen + MACLEN;
-			packetout->sequence = cns->txseq;
-
-			/* serialize the header and add it to the ciphers associated data */
-			qsmp_packet_header_serialize(packetout, hdr);
-			qsc_rcs_set_associated(&cns->txcpr, hdr, QSMP_HEADER_SIZE);
-			/* encrypt the message */
-			qsc_rcs_transform(&cns->txcpr, packetout->pmessage, message, msglen);
-
-			qerr = qsmp_error_none;
-		}
-		else
-		{
-			qerr = qsmp_error_channel_down;
-		}
+		qerr = packet_encrypt(cns, packetout, qsmp_flag_encrypted_message, message, msglen);
 	}
 
 	return qerr;
@@ -339,57 +2131,381 @@ void qsmp_log_write(qsmp_messages emsg, const char* msg)
 	{
 		if (msg != NULL)
 		{
-			char mtmp[QSMP_ERROR_STRING_WIDTH] = { 0 };
+			char mtmp[QSMP_ERROR_STRING_WIDTH] = { 0 };
+
+			qsc_stringutils_copy_string(mtmp, sizeof(mtmp), pmsg);
+			qsc_stringutils_concat_strings(mtmp, sizeof(mtmp), msg);
+			qsmp_logger_write(mtmp);
+		}
+		else
+		{
+			qsmp_logger_write(pmsg);
+		}
+	}
+}
+
+const char* qsmp_get_error_description(qsmp_messages message)
+{
+	const char* dsc;
+
+	dsc = NULL;
+
+	if ((uint32_t)message < QSMP_MESSAGE_STRING_DEPTH)
+	{
+		dsc = QSMP_MESSAGE_STRINGS[(size_t)message];
+
+	}
+
+	return dsc;
+}
+
+void qsmp_generate_keypair(qsmp_client_signature_key* pubkey, qsmp_server_signature_key* prikey, const uint8_t keyid[QSMP_KEYID_SIZE])
+{
+	assert(prikey != NULL);
+	assert(pubkey != NULL);
+
+	if (prikey != NULL && pubkey != NULL)
+	{
+		/* add the timestamp plus duration to the key */
+		prikey->expiration = qsc_timestamp_epochtime_seconds() + QSMP_PUBKEY_DURATION_SECONDS;
+
+		/* set the configuration string and key-identity strings */
+		qsc_memutils_copy(prikey->config, QSMP_CONFIG_STRING, QSMP_CONFIG_SIZE);
+		qsc_memutils_copy(prikey->keyid, keyid, QSMP_KEYID_SIZE);
+
+		/* generate the signature key-pair */
+		qsmp_signature_generate_keypair(prikey->verkey, prikey->sigkey, qsc_acp_generate);
+
+		/* copy the key expiration, config, key-id, and the signatures verification key, to the public key structure */
+		pubkey->expiration = prikey->expiration;
+		qsc_memutils_copy(pubkey->config, prikey->config, QSMP_CONFIG_SIZE);
+		qsc_memutils_copy(pubkey->keyid, prikey->keyid, QSMP_KEYID_SIZE);
+		qsc_memutils_copy(pubkey->verkey, prikey->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
+	}
+}
+
+void qsmp_multiplex_accept_callback(void (*callback)(qsmp_connection_state*, uint32_t, const uint8_t*, size_t))
+{
+	m_multiplex_callback = callback;
+}
+
+qsmp_errors qsmp_multiplex_close(qsmp_connection_state* cns, uint32_t sid)
+{
+	assert(cns != NULL);
+
+	qsmp_multiplex_stream* stm;
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL && cns->mux != NULL)
+	{
+		qsc_async_mutex_lock(cns->mux->lock);
+		stm = multiplex_stream_find(cns->mux, sid);
+
+		if (stm != NULL && stm->closing == false)
+		{
+			/* the close frame follows the queued messages of the stream */
+			qerr = multiplex_stream_queue(stm, multiplex_frame_close, NULL, 0);
+			stm->closing = (qerr == qsmp_error_none);
+		}
+
+		qsc_async_mutex_unlock(cns->mux->lock);
+
+		if (qerr == qsmp_error_none)
+		{
+			qerr = multiplex_drain(cns);
+		}
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_multiplex_enable(qsmp_connection_state* cns, bool initiator, void (*callback)(qsmp_connection_state*, uint32_t, const uint8_t*, size_t))
+{
+	assert(cns != NULL);
+
+	qsmp_multiplex_state* mux;
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL)
+	{
+		qerr = qsmp_error_none;
+
+		if (qsc_async_atomic_load_pointer((void* volatile*)&cns->mux) == NULL)
+		{
+			mux = (qsmp_multiplex_state*)qsc_memutils_malloc(sizeof(qsmp_multiplex_state));
+
+			if (mux != NULL)
+			{
+				qsc_memutils_clear(mux, sizeof(qsmp_multiplex_state));
+				mux->lock = qsc_async_mutex_create();
+				/* the two hosts open streams with identifiers of opposite parity, so the identifiers never collide */
+				mux->sidnext = (initiator == true) ? 1 : 2;
+
+				if (mux->lock == NULL)
+				{
+					qsc_memutils_alloc_free(mux);
+					qerr = qsmp_error_memory_allocation;
+				}
+				else if (qsc_async_atomic_compare_exchange_pointer((void* volatile*)&cns->mux, mux, NULL) == false)
+				{
+					/* the application and the receive thread enabled the connection at the same time, the first state is kept */
+					qsc_async_mutex_destroy(mux->lock);
+					qsc_memutils_alloc_free(mux);
+				}
+			}
+			else
+			{
+				qerr = qsmp_error_memory_allocation;
+			}
+		}
+
+		if (qerr == qsmp_error_none)
+		{
+			qsc_async_mutex_lock(cns->mux->lock);
+			cns->mux->callback = callback;
+			qsc_async_mutex_unlock(cns->mux->lock);
+		}
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_multiplex_open(qsmp_connection_state* cns, void (*callback)(qsmp_connection_state*, uint32_t, const uint8_t*, size_t), uint32_t* sid)
+{
+	assert(cns != NULL);
+	assert(callback != NULL);
+	assert(sid != NULL);
+
+	qsmp_multiplex_stream* stm;
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL && cns->mux != NULL && callback != NULL && sid != NULL)
+	{
+		qsc_async_mutex_lock(cns->mux->lock);
+		/* the identifiers are not reused, the last identifier of each parity is never opened so the next can not wrap */
+		stm = (cns->mux->sidnext <= UINT32_MAX - 2U) ? multiplex_stream_add(cns->mux, cns->mux->sidnext, callback) : NULL;
+
+		if (stm != NULL)
+		{
+			/* the open frame is the first entry in the queue of the stream */
+			qerr = multiplex_stream_queue(stm, multiplex_frame_open, NULL, 0);
 
-			qsc_stringutils_copy_string(mtmp, sizeof(mtmp), pmsg);
-			qsc_stringutils_concat_strings(mtmp, sizeof(mtmp), msg);
-			qsmp_logger_write(mtmp);
+			if (qerr == qsmp_error_none)
+			{
+				*sid = stm->id;
+				cns->mux->sidnext += 2;
+			}
+			else
+			{
+				multiplex_stream_release(stm);
+			}
 		}
 		else
 		{
-			qsmp_logger_write(pmsg);
+			qerr = qsmp_error_hosts_exceeded;
+		}
+
+		qsc_async_mutex_unlock(cns->mux->lock);
+
+		if (qerr == qsmp_error_none)
+		{
+			qerr = multiplex_drain(cns);
 		}
 	}
+
+	return qerr;
 }
 
-const char* qsmp_get_error_description(qsmp_messages message)
+qsmp_errors qsmp_multiplex_receive(qsmp_connection_state* cns, const qsmp_packet* packetin)
 {
-	const char* dsc;
+	assert(cns != NULL);
+	assert(packetin != NULL);
 
-	dsc = NULL;
+	void (*callback)(qsmp_connection_state*, uint32_t, const uint8_t*, size_t);
+	qsmp_multiplex_stream* stm;
+	const uint8_t* pmsg;
+	uint8_t* pbuf;
+	qsmp_errors qerr;
+	size_t flen;
+	size_t mlen;
+	size_t rcap;
+	uint32_t sid;
+	uint8_t type;
 
-	if ((uint32_t)message < QSMP_MESSAGE_STRING_DEPTH)
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL && packetin != NULL && packetin->flag == qsmp_flag_multiplex_message)
 	{
-		dsc = QSMP_MESSAGE_STRINGS[(size_t)message];
+		callback = NULL;
+		pbuf = NULL;
+		pmsg = NULL;
+		mlen = 0;
+		flen = 0;
+		qerr = qsmp_decrypt_packet(cns, packetin->pmessage, &flen, packetin);
+
+		if (qerr == qsmp_error_none && flen >= QSMP_MULTIPLEX_PREFIX_SIZE)
+		{
+			type = packetin->pmessage[0];
+			sid = qsc_intutils_le8to32(packetin->pmessage + sizeof(uint8_t));
+			flen -= QSMP_MULTIPLEX_PREFIX_SIZE;
+
+			if (cns->mux == NULL && type == multiplex_frame_open && m_multiplex_callback != NULL)
+			{
+				/* a server accepts logical streams on a connection when the first stream is opened */
+				qerr = qsmp_multiplex_enable(cns, false, m_multiplex_callback);
+			}
+
+			if (qerr == qsmp_error_none && cns->mux != NULL)
+			{
+				qsc_async_mutex_lock(cns->mux->lock);
+				stm = multiplex_stream_find(cns->mux, sid);
 
+				if (type == multiplex_frame_open)
+				{
+					/* the remote host opens streams with the parity of its own identifiers */
+					if (stm == NULL && (sid & 1U) != (cns->mux->sidnext & 1U))
+					{
+						qerr = (multiplex_stream_add(cns->mux, sid, cns->mux->callback) != NULL) ? qsmp_error_none : qsmp_error_hosts_exceeded;
+					}
+					else
+					{
+						qerr = qsmp_error_invalid_request;
+					}
+				}
+				else if (type == multiplex_frame_data || type == multiplex_frame_final)
+				{
+					/* frames of a stream that was closed locally are discarded */
+					if (stm != NULL)
+					{
+						if (stm->rxlen + flen > QSMP_MULTIPLEX_QUEUE_SIZE)
+						{
+							qerr = qsmp_error_invalid_request;
+						}
+						else if (type == multiplex_frame_final && stm->rxlen == 0)
+						{
+							/* a message carried in one frame is passed to the callback from the receive buffer */
+							pmsg = packetin->pmessage + QSMP_MULTIPLEX_PREFIX_SIZE;
+							mlen = flen;
+							callback = stm->callback;
+						}
+						else
+						{
+							if (stm->rxlen + flen > stm->rxcap)
+							{
+								/* the reassembly buffer grows to the size of the largest message */
+								rcap = (stm->rxcap == 0) ? QSMP_MULTIPLEX_FRAME_SIZE * 4 : stm->rxcap * 2;
+								rcap = (rcap > QSMP_MULTIPLEX_QUEUE_SIZE) ? QSMP_MULTIPLEX_QUEUE_SIZE : rcap;
+								pbuf = (uint8_t*)qsc_memutils_realloc(stm->rxbuf, rcap);
+
+								if (pbuf != NULL)
+								{
+									stm->rxbuf = pbuf;
+									stm->rxcap = rcap;
+									pbuf = NULL;
+								}
+								else
+								{
+									qerr = qsmp_error_memory_allocation;
+								}
+							}
+
+							if (qerr == qsmp_error_none)
+							{
+								qsc_memutils_copy(stm->rxbuf + stm->rxlen, packetin->pmessage + QSMP_MULTIPLEX_PREFIX_SIZE, flen);
+								stm->rxlen += flen;
+
+								if (type == multiplex_frame_final)
+								{
+									/* the completed message is taken from the stream, and released after the callback */
+									pbuf = stm->rxbuf;
+									pmsg = pbuf;
+									mlen = stm->rxlen;
+									callback = stm->callback;
+									stm->rxbuf = NULL;
+									stm->rxcap = 0;
+									stm->rxlen = 0;
+								}
+							}
+						}
+					}
+				}
+				else if (type == multiplex_frame_close)
+				{
+					if (stm != NULL)
+					{
+						/* the callback is notified with an empty message, and messages still queued to the remote host are discarded */
+						callback = stm->callback;
+						multiplex_stream_release(stm);
+					}
+				}
+				else
+				{
+					qerr = qsmp_error_invalid_request;
+				}
+
+				qsc_async_mutex_unlock(cns->mux->lock);
+			}
+			else if (qerr == qsmp_error_none)
+			{
+				qerr = qsmp_error_invalid_request;
+			}
+
+			/* the callback is run without the stream lock, so it can send on the streams */
+			if (qerr == qsmp_error_none && callback != NULL)
+			{
+				callback(cns, sid, pmsg, mlen);
+			}
+
+			if (pbuf != NULL)
+			{
+				qsc_memutils_clear(pbuf, mlen);
+				qsc_memutils_alloc_free(pbuf);
+			}
+		}
+		else if (qerr == qsmp_error_none)
+		{
+			qerr = qsmp_error_invalid_request;
+		}
 	}
 
-	return dsc;
+	return qerr;
 }
 
-void qsmp_generate_keypair(qsmp_client_signature_key* pubkey, qsmp_server_signature_key* prikey, const uint8_t keyid[QSMP_KEYID_SIZE])
+qsmp_errors qsmp_multiplex_send(qsmp_connection_state* cns, uint32_t sid, const uint8_t* message, size_t msglen)
 {
-	assert(prikey != NULL);
-	assert(pubkey != NULL);
+	assert(cns != NULL);
+	assert(message != NULL);
 
-	if (prikey != NULL && pubkey != NULL)
+	qsmp_multiplex_stream* stm;
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL && cns->mux != NULL && message != NULL && msglen != 0 && msglen <= QSMP_MULTIPLEX_QUEUE_SIZE)
 	{
-		/* add the timestamp plus duration to the key */
-		prikey->expiration = qsc_timestamp_epochtime_seconds() + QSMP_PUBKEY_DURATION_SECONDS;
+		qsc_async_mutex_lock(cns->mux->lock);
+		stm = multiplex_stream_find(cns->mux, sid);
 
-		/* set the configuration string and key-identity strings */
-		qsc_memutils_copy(prikey->config, QSMP_CONFIG_STRING, QSMP_CONFIG_SIZE);
-		qsc_memutils_copy(prikey->keyid, keyid, QSMP_KEYID_SIZE);
+		if (stm != NULL && stm->closing == false)
+		{
+			qerr = multiplex_stream_queue(stm, multiplex_frame_final, message, msglen);
+		}
 
-		/* generate the signature key-pair */
-		qsmp_signature_generate_keypair(prikey->verkey, prikey->sigkey, qsc_acp_generate);
+		qsc_async_mutex_unlock(cns->mux->lock);
 
-		/* copy the key expiration, config, key-id, and the signatures verification key, to the public key structure */
-		pubkey->expiration = prikey->expiration;
-		qsc_memutils_copy(pubkey->config, prikey->config, QSMP_CONFIG_SIZE);
-		qsc_memutils_copy(pubkey->keyid, prikey->keyid, QSMP_KEYID_SIZE);
-		qsc_memutils_copy(pubkey->verkey, prikey->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
+		if (qerr == qsmp_error_none)
+		{
+			qerr = multiplex_drain(cns);
+		}
 	}
+
+	return qerr;
 }
 
 void qsmp_packet_clear(qsmp_packet* packet)
@@ -464,6 +2580,174 @@ size_t qsmp_packet_to_stream(const qsmp_packet* packet, uint8_t* pstream)
 	return res;
 }
 
+void qsmp_record_buffer_dispose(qsmp_record_buffer* rbuf)
+{
+	assert(rbuf != NULL);
+
+	if (rbuf != NULL)
+	{
+		if (rbuf->buffer != NULL)
+		{
+			qsc_memutils_clear(rbuf->buffer, rbuf->capacity);
+			qsc_memutils_alloc_free(rbuf->buffer);
+			rbuf->buffer = NULL;
+		}
+
+		rbuf->capacity = 0;
+		rbuf->position = 0;
+		rbuf->length = 0;
+	}
+}
+
+bool qsmp_record_buffer_next(qsmp_record_buffer* rbuf, qsmp_packet* packet)
+{
+	assert(rbuf != NULL);
+	assert(packet != NULL);
+
+	size_t rlen;
+	bool res;
+
+	res = false;
+
+	if (rbuf != NULL && packet != NULL && rbuf->length >= QSMP_HEADER_SIZE)
+	{
+		qsmp_packet_header_deserialize(rbuf->buffer + rbuf->position, packet);
+
+		if (record_length_valid(packet) == true)
+		{
+			/* a record is the header, the message, and the socket terminator */
+			rlen = QSMP_HEADER_SIZE + packet->msglen + QSC_SOCKET_TERMINATOR_SIZE;
+
+			if (rbuf->length >= rlen)
+			{
+				packet->pmessage = rbuf->buffer + rbuf->position + QSMP_HEADER_SIZE;
+				rbuf->position += rlen;
+				rbuf->length -= rlen;
+				res = true;
+			}
+		}
+		else
+		{
+			/* the stream can not be resynchronized after an invalid length */
+			packet->flag = qsmp_flag_error_condition;
+			packet->msglen = 0;
+			packet->pmessage = NULL;
+			rbuf->position = 0;
+			rbuf->length = 0;
+			res = true;
+		}
+
+		if (rbuf->length == 0)
+		{
+			rbuf->position = 0;
+		}
+	}
+
+	return res;
+}
+
+size_t qsmp_record_buffer_receive(qsmp_record_buffer* rbuf, const qsc_socket* sock)
+{
+	assert(rbuf != NULL);
+	assert(sock != NULL);
+
+	qsmp_packet hdr = { 0 };
+	uint8_t* ptmp;
+	size_t rlen;
+	size_t res;
+
+	res = 0;
+
+	if (rbuf != NULL && sock != NULL)
+	{
+		if (rbuf->buffer == NULL)
+		{
+			rbuf->buffer = (uint8_t*)qsc_memutils_malloc(QSMP_RECORD_BUFFER_SIZE);
+			rbuf->capacity = (rbuf->buffer != NULL) ? QSMP_RECORD_BUFFER_SIZE : 0;
+			rbuf->position = 0;
+			rbuf->length = 0;
+		}
+
+		if (rbuf->buffer != NULL)
+		{
+			/* move the partial record to the front of the buffer */
+			if (rbuf->position != 0)
+			{
+				qsc_memutils_move(rbuf->buffer, rbuf->buffer + rbuf->position, rbuf->length);
+				rbuf->position = 0;
+			}
+
+			/* grow the buffer if the pending record is larger than the buffer */
+			if (rbuf->length >= QSMP_HEADER_SIZE)
+			{
+				qsmp_packet_header_deserialize(rbuf->buffer, &hdr);
+
+				if (record_length_valid(&hdr) == true)
+				{
+					rlen = QSMP_HEADER_SIZE + hdr.msglen + QSC_SOCKET_TERMINATOR_SIZE;
+
+					if (rlen > rbuf->capacity)
+					{
+						ptmp = (uint8_t*)qsc_memutils_realloc(rbuf->buffer, rlen);
+
+						if (ptmp != NULL)
+						{
+							rbuf->buffer = ptmp;
+							rbuf->capacity = rlen;
+						}
+					}
+				}
+			}
+
+			if (rbuf->length < rbuf->capacity)
+			{
+				res = qsc_socket_receive(sock, rbuf->buffer + rbuf->length, rbuf->capacity - rbuf->length, qsc_socket_receive_flag_none);
+				rbuf->length += res;
+			}
+		}
+	}
+
+	return res;
+}
+
+size_t qsmp_record_buffer_run(qsmp_record_buffer* rbuf, qsmp_packet* packets, size_t count)
+{
+	assert(rbuf != NULL);
+	assert(packets != NULL);
+
+	size_t res;
+	size_t rlen;
+
+	res = 0;
+
+	if (rbuf != NULL && packets != NULL)
+	{
+		/* take the complete message records at the front of the buffer, the first record of another type ends the run */
+		while (res < count && rbuf->length >= QSMP_HEADER_SIZE)
+		{
+			qsmp_packet_header_deserialize(rbuf->buffer + rbuf->position, &packets[res]);
+			rlen = QSMP_HEADER_SIZE + packets[res].msglen + QSC_SOCKET_TERMINATOR_SIZE;
+
+			if (packets[res].flag != qsmp_flag_encrypted_message || packets[res].msglen > QSMP_MESSAGE_MAX || rbuf->length < rlen)
+			{
+				break;
+			}
+
+			packets[res].pmessage = rbuf->buffer + rbuf->position + QSMP_HEADER_SIZE;
+			rbuf->position += rlen;
+			rbuf->length -= rlen;
+			++res;
+		}
+
+		if (rbuf->length == 0)
+		{
+			rbuf->position = 0;
+		}
+	}
+
+	return res;
+}
+
 void qsmp_serialize_signature_key(uint8_t serk[QSMP_SIGKEY_ENCODED_SIZE], const qsmp_server_signature_key* kset)
 {
 	assert(kset != NULL);
@@ -481,6 +2765,216 @@ void qsmp_serialize_signature_key(uint8_t serk[QSMP_SIGKEY_ENCODED_SIZE], const
 	qsc_memutils_copy((serk + pos), kset->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
 }
 
+qsmp_errors qsmp_stream_receive(qsmp_connection_state* cns, const qsmp_packet* packetin, uint8_t** message, size_t* msglen)
+{
+	assert(cns != NULL);
+	assert(packetin != NULL);
+	assert(message != NULL);
+	assert(msglen != NULL);
+
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL && packetin != NULL && message != NULL && msglen != NULL && packetin->flag == qsmp_flag_transfer_request)
+	{
+		const size_t MACLEN = (cns->rxcpr.ctype == qsc_rcs_cipher_256) ? QSMP_SIMPLEX_MACTAG_SIZE : QSMP_DUPLEX_MACTAG_SIZE;
+		qsmp_stream_state* stm;
+
+		stm = &cns->rxstm;
+		*message = NULL;
+		*msglen = 0;
+
+		if (stm->buffer == NULL)
+		{
+			uint8_t mreq[sizeof(uint64_t)] = { 0 };
+			uint64_t tlen;
+			size_t rlen;
+
+			/* the transfer request is a complete authenticated record carrying the payload length */
+			qerr = qsmp_error_invalid_request;
+			rlen = 0;
+
+			if (packetin->msglen == sizeof(uint64_t) + MACLEN)
+			{
+				qerr = qsmp_decrypt_packet(cns, mreq, &rlen, packetin);
+
+				if (qerr == qsmp_error_none)
+				{
+					tlen = qsc_intutils_le8to64(mreq);
+
+					if (tlen != 0 && tlen <= QSMP_STREAM_MAX_SIZE)
+					{
+						stm->buffer = (uint8_t*)qsc_memutils_malloc((size_t)tlen);
+
+						if (stm->buffer != NULL)
+						{
+							stm->length = (size_t)tlen;
+							stm->position = 0;
+						}
+						else
+						{
+							qerr = qsmp_error_memory_allocation;
+						}
+					}
+					else
+					{
+						qerr = qsmp_error_invalid_request;
+					}
+				}
+			}
+		}
+		else
+		{
+			size_t rlen;
+			size_t slen;
+			bool fin;
+
+			cns->rxseq += 1;
+			rlen = stm->length - stm->position;
+
+			/* every segment is full sized, except the final segment which also carries the mac tag */
+			fin = (rlen <= QSMP_STREAM_SEGMENT_SIZE);
+			slen = (fin == true) ? rlen : QSMP_STREAM_SEGMENT_SIZE;
+
+			if (packetin->sequence != cns->rxseq)
+			{
+				qerr = qsmp_error_packet_unsequenced;
+			}
+			else if (cns->exflag != qsmp_flag_session_established)
+			{
+				qerr = qsmp_error_channel_down;
+			}
+			else if (packetin->msglen != slen + ((fin == true) ? MACLEN : 0))
+			{
+				qerr = qsmp_error_invalid_request;
+			}
+			else
+			{
+				uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
+
+				/* each segment header is added to the running mac, which is verified before the final segment is decrypted */
+				qsmp_packet_header_serialize(packetin, hdr);
+				qsc_rcs_set_associated(&cns->rxcpr, hdr, QSMP_HEADER_SIZE);
+
+				if (qsc_rcs_extended_transform(&cns->rxcpr, stm->buffer + stm->position, packetin->pmessage, slen, fin) == true)
+				{
+					stm->position += slen;
+					qerr = qsmp_error_none;
+
+					if (fin == true)
+					{
+						/* the payload is authenticated, ownership passes to the caller */
+						*message = stm->buffer;
+						*msglen = stm->length;
+						stm->buffer = NULL;
+						stm->length = 0;
+						stm->position = 0;
+					}
+				}
+				else
+				{
+					qerr = qsmp_error_authentication_failure;
+				}
+			}
+
+			if (qerr != qsmp_error_none)
+			{
+				/* the segments decrypted so far are unauthenticated, and are erased */
+				stream_state_reset(stm);
+			}
+		}
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_stream_send(qsmp_connection_state* cns, const uint8_t* message, size_t msglen)
+{
+	assert(cns != NULL);
+	assert(message != NULL);
+
+	qsmp_errors qerr;
+
+	qerr = qsmp_error_invalid_input;
+
+	if (cns != NULL && message != NULL && msglen != 0 && msglen <= QSMP_STREAM_MAX_SIZE)
+	{
+		const size_t MACLEN = (cns->txcpr.ctype == qsc_rcs_cipher_256) ? QSMP_SIMPLEX_MACTAG_SIZE : QSMP_DUPLEX_MACTAG_SIZE;
+		uint8_t mreq[sizeof(uint64_t)] = { 0 };
+		uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
+		qsmp_packet pkt = { 0 };
+		uint8_t* pseg;
+		size_t slen;
+		bool fin;
+
+		/* one segment buffer is used for the cipher-text of every record in the transfer */
+		pseg = (uint8_t*)qsc_memutils_malloc(QSMP_STREAM_SEGMENT_SIZE + MACLEN);
+
+		if (pseg != NULL)
+		{
+			/* the running mac spans the transfer, so no other record can be encrypted until it completes */
+			qsmp_connection_transmit_lock(cns);
+			cns->txstream = true;
+			qerr = connection_coalesce_flush(cns);
+
+			if (qerr == qsmp_error_none)
+			{
+				/* the transfer request announces the payload length in an authenticated record */
+				qsc_intutils_le64to8(mreq, (uint64_t)msglen);
+				pkt.pmessage = pseg;
+				qerr = packet_encrypt(cns, &pkt, qsmp_flag_transfer_request, mreq, sizeof(mreq));
+			}
+
+			if (qerr == qsmp_error_none)
+			{
+				qerr = stream_send_record(cns, &pkt);
+			}
+
+			for (size_t pos = 0; pos < msglen && qerr == qsmp_error_none; pos += slen)
+			{
+				/* every segment is full sized, except the final segment which also carries the mac tag */
+				slen = ((msglen - pos) < QSMP_STREAM_SEGMENT_SIZE) ? (msglen - pos) : QSMP_STREAM_SEGMENT_SIZE;
+				fin = (pos + slen == msglen);
+				cns->txseq += 1;
+				pkt.flag = qsmp_flag_transfer_request;
+				pkt.msglen = (uint32_t)(slen + ((fin == true) ? MACLEN : 0));
+				pkt.sequence = cns->txseq;
+
+				/* each segment header is added to the running mac */
+				qsmp_packet_header_serialize(&pkt, hdr);
+				qsc_rcs_set_associated(&cns->txcpr, hdr, QSMP_HEADER_SIZE);
+				qsc_rcs_extended_transform(&cns->txcpr, pseg, message + pos, slen, fin);
+				qerr = stream_send_record(cns, &pkt);
+
+				if (qerr == qsmp_error_none && fin == false)
+				{
+					/* the lock is released between segments, so control records and queue flushes are not held behind the transfer */
+					qsc_async_mutex_unlock(cns->txlock);
+					qsc_async_thread_yield();
+					qsc_async_mutex_lock_counted(cns->txlock, &cns->txstats);
+
+					if (qsc_socket_is_connected(&cns->target) == false)
+					{
+						qerr = qsmp_error_channel_down;
+					}
+				}
+			}
+
+			cns->txstream = false;
+			qsc_async_mutex_unlock(cns->txlock);
+			qsc_memutils_clear(pseg, QSMP_STREAM_SEGMENT_SIZE + MACLEN);
+			qsc_memutils_alloc_free(pseg);
+		}
+		else
+		{
+			qerr = qsmp_error_memory_allocation;
+		}
+	}
+
+	return qerr;
+}
+
 void qsmp_stream_to_packet(const uint8_t* pstream, qsmp_packet* packet)
 {
 	assert(packet != NULL);
@@ -107,6 +107,8 @@
 //#define QSMP_CONFIG_SPHINCS_MCELIECE
 
 #include "common.h"
+#include "timerwheel.h"
+#include "../../QSC/QSC/async.h"
 #include "../../QSC/QSC/socketbase.h"
 
 #if defined(QSMP_CONFIG_DILITHIUM_KYBER)
@@ -1009,6 +1011,69 @@ static const char QSMP_CONFIG_STRING[QSMP_CONFIG_SIZE] = "sphincs-s6f_mceliece-s
 */
 #define QSMP_CONNECTION_MTU 1500
 
+/*!
+* \def QSMP_RECORD_BUFFER_SIZE
+* \brief The initial size of a connection receive buffer.
+* The buffer is grown to hold a record larger than this, up to the maximum message size, or the stream segment size for a transfer record
+*/
+#define QSMP_RECORD_BUFFER_SIZE (QSMP_CONNECTION_MTU * 2)
+
+/*!
+* \def QSMP_CONNECTION_SENDV_MAX
+* \brief The maximum number of messages sent as records with one call to qsmp_connection_sendv
+*/
+#define QSMP_CONNECTION_SENDV_MAX 16
+
+/*!
+* \def QSMP_CONNECTION_QUEUE_MULTI_MAX
+* \brief The number of connections a message is encrypted for together by qsmp_connection_queue_multi
+*/
+#define QSMP_CONNECTION_QUEUE_MULTI_MAX 16
+
+/*!
+* \def QSMP_DECRYPT_BATCH_MAX
+* \brief The maximum number of consecutive message records decrypted with one call to qsmp_decrypt_packets
+*/
+#define QSMP_DECRYPT_BATCH_MAX 16
+
+/*!
+* \def QSMP_SEND_BUFFER_SIZE
+* \brief The maximum number of bytes queued for transmission on a connection.
+* A message that does not fit in the queue is refused, see qsmp_connection_queue
+*/
+#define QSMP_SEND_BUFFER_SIZE (QSMP_CONNECTION_MTU * 32)
+
+/*!
+* \def QSMP_SEND_QUEUE_DEPTH
+* \brief The maximum number of messages waiting in the send queue of a connection.
+* A message sent while the queue is full is refused, see qsmp_connection_send
+*/
+#define QSMP_SEND_QUEUE_DEPTH 4096
+
+/*!
+* \def QSMP_SEND_FREELIST_DEPTH
+* \brief The maximum number of released send queue entries a connection keeps for reuse
+*/
+#define QSMP_SEND_FREELIST_DEPTH 32
+
+/*!
+* \def QSMP_STREAM_SEGMENT_SIZE
+* \brief The number of payload bytes carried by each record of a stream transfer
+*/
+#define QSMP_STREAM_SEGMENT_SIZE (64 * 1024)
+
+/*!
+* \def QSMP_STREAM_MAX_SIZE
+* \brief The maximum payload size of a stream transfer, the receiver allocates the payload in one buffer
+*/
+#define QSMP_STREAM_MAX_SIZE (256ULL * 1024 * 1024)
+
+/*!
+* \def QSMP_STREAM_WRITABLE_WAIT
+* \brief The maximum time in microseconds a stream transfer waits for the socket to become writable, before it tests the connection again
+*/
+#define QSMP_STREAM_WRITABLE_WAIT 100000
+
 /*!
 * \def QSMP_HEADER_SIZE
 * \brief The QSMP packet header size
@@ -1027,6 +1092,12 @@ static const char QSMP_CONFIG_STRING[QSMP_CONFIG_SIZE] = "sphincs-s6f_mceliece-s
 */
 #define QSMP_KEEPALIVE_TIMEOUT (120 * 1000)
 
+/*!
+* \def QSMP_SYMMETRIC_RATCHET_INTERVAL
+* \brief The interval in milliseconds at which a duplex client ratchets the session keys, zero disables the schedule
+*/
+#define QSMP_SYMMETRIC_RATCHET_INTERVAL 0
+
 /*!
 * \def QSMP_ASYMMETRIC_KEYCHAIN_COUNT
 * \brief The key-chain asymmetric key count
@@ -1075,12 +1146,90 @@ static const char QSMP_CONFIG_STRING[QSMP_CONFIG_SIZE] = "sphincs-s6f_mceliece-s
 */
 #define QSMP_STOKEN_SIZE 64
 
+/*!
+* \def QSMP_FASTOPEN_KEY_LIFETIME
+* \brief The validity period of the servers fast-open asymmetric cipher key in seconds (1 hour)
+*/
+#define QSMP_FASTOPEN_KEY_LIFETIME (60 * 60)
+
+/*!
+* \def QSMP_FASTOPEN_REQUEST_SIZE
+* \brief The size of a fast-open request message; the key identity, configuration string, fast-open key hash, and cipher-text
+*/
+#define QSMP_FASTOPEN_REQUEST_SIZE (QSMP_KEYID_SIZE + QSMP_CONFIG_SIZE + QSMP_SIMPLEX_HASH_SIZE + QSMP_ASYMMETRIC_CIPHER_TEXT_SIZE)
+
+/*!
+* \def QSMP_FASTOPEN_RESPONSE_SIZE
+* \brief The size of a fast-open key response message; the signed key hash, expiration, fast-open public key, and server nonce
+*/
+#define QSMP_FASTOPEN_RESPONSE_SIZE (QSMP_ASYMMETRIC_SIGNATURE_SIZE + QSMP_SIMPLEX_HASH_SIZE + QSMP_TIMESTAMP_SIZE + QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE + QSMP_NONCE_SIZE)
+
+/*!
+* \def QSMP_TICKET_LIFETIME
+* \brief The validity period of a session resumption ticket in seconds (24 hours)
+*/
+#define QSMP_TICKET_LIFETIME (24 * 60 * 60)
+
+/*!
+* \def QSMP_TICKET_SIZE
+* \brief The size of an encrypted session resumption ticket; the nonce, expiration, key identity, resumption secret, and mac tag
+*/
+#define QSMP_TICKET_SIZE (QSMP_NONCE_SIZE + QSMP_TIMESTAMP_SIZE + QSMP_KEYID_SIZE + QSMP_SECRET_SIZE + QSMP_SIMPLEX_MACTAG_SIZE)
+
+/*!
+* \def QSMP_RESUME_REQUEST_SIZE
+* \brief The size of a resume request message; the key identity, configuration string, ticket, client nonce, and binder
+*/
+#define QSMP_RESUME_REQUEST_SIZE (QSMP_KEYID_SIZE + QSMP_CONFIG_SIZE + QSMP_TICKET_SIZE + QSMP_NONCE_SIZE + QSMP_SIMPLEX_MACTAG_SIZE)
+
+/*!
+* \def QSMP_RESUME_RESPONSE_SIZE
+* \brief The size of a resume response message; the server nonce, and the replacement ticket encrypted on the new channel
+*/
+#define QSMP_RESUME_RESPONSE_SIZE (QSMP_NONCE_SIZE + QSMP_TICKET_SIZE + QSMP_SIMPLEX_MACTAG_SIZE)
+
 /*!
 * \def QSMP_MESSAGE_MAX
 * \brief The maximum message size used during the key exchange (may exceed mtu)
 */
 #define QSMP_MESSAGE_MAX (QSMP_HEADER_SIZE + QSMP_ASYMMETRIC_CIPHER_TEXT_SIZE + QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE + QSMP_DUPLEX_HASH_SIZE + QSMP_ASYMMETRIC_SIGNATURE_SIZE)
 
+/*!
+* \def QSMP_COALESCE_PREFIX_SIZE
+* \brief The size of the length prefix of each message in a coalesced record
+*/
+#define QSMP_COALESCE_PREFIX_SIZE 2
+
+/*!
+* \def QSMP_COALESCE_SIZE_MAX
+* \brief The maximum size of the coalesced messages sent in one record, the largest message an encrypted record can carry
+*/
+#define QSMP_COALESCE_SIZE_MAX (QSMP_MESSAGE_MAX - (QSMP_HEADER_SIZE + QSMP_DUPLEX_MACTAG_SIZE))
+
+/*!
+* \def QSMP_MULTIPLEX_PREFIX_SIZE
+* \brief The size of the frame prefix of a multiplexed record; the frame type and the stream identifier
+*/
+#define QSMP_MULTIPLEX_PREFIX_SIZE 5
+
+/*!
+* \def QSMP_MULTIPLEX_FRAME_SIZE
+* \brief The maximum payload of a multiplexed record, each stream with queued messages sends one frame in each turn of the scheduler
+*/
+#define QSMP_MULTIPLEX_FRAME_SIZE (QSMP_CONNECTION_MTU - (QSMP_HEADER_SIZE + QSMP_DUPLEX_MACTAG_SIZE + QSMP_MULTIPLEX_PREFIX_SIZE))
+
+/*!
+* \def QSMP_MULTIPLEX_QUEUE_SIZE
+* \brief The maximum number of bytes queued on a logical stream, and the largest message a stream can send or receive
+*/
+#define QSMP_MULTIPLEX_QUEUE_SIZE (4 * 1024 * 1024)
+
+/*!
+* \def QSMP_MULTIPLEX_STREAMS_MAX
+* \brief The maximum number of logical streams open on a connection at one time
+*/
+#define QSMP_MULTIPLEX_STREAMS_MAX 32
+
 /*!
 * \def QSMP_PUBKEY_DURATION_DAYS
 * \brief The number of days a public key remains valid
@@ -1262,6 +1411,7 @@ QSMP_EXPORT_API typedef enum qsmp_errors
 	qsmp_error_decryption_failure = 0x1A,			/*!< The decryption authentication has failed */
 	qsmp_error_keepalive_timeout = 0x1B,			/*!< The decryption authentication has failed */
 	qsmp_error_keychain_fail = 0x1C,				/*!< The ratchet operation has failed */
+	qsmp_error_transmit_busy = 0x1D,				/*!< A stream transfer owns the transmit cipher, the message can be sent when it completes */
 } qsmp_errors;
 
 /*!
@@ -1291,7 +1441,15 @@ QSMP_EXPORT_API typedef enum qsmp_flags
 	qsmp_flag_asymmetric_ratchet_request = 0x12,	/*!< The host has received a asymmetric key ratchet request */
 	qsmp_flag_asymmetric_ratchet_response = 0x13,	/*!< The host has received a asymmetric key ratchet request */
 	qsmp_flag_symmetric_ratchet_request = 0x14,		/*!< The host has received a symmetric key ratchet request */
-	qsmp_flag_transfer_request = 0x15,				/*!< Reserved - The host has received a transfer request */
+	qsmp_flag_transfer_request = 0x15,				/*!< The record is part of a segmented stream transfer */
+	qsmp_flag_coalesced_message = 0x16,				/*!< The encrypted record contains several length prefixed messages */
+	qsmp_flag_datagram_message = 0x17,				/*!< The datagram contains an independently encrypted message */
+	qsmp_flag_resume_request = 0x18,				/*!< The QSMP session resumption client request flag */
+	qsmp_flag_resume_response = 0x19,				/*!< The QSMP session resumption server response flag */
+	qsmp_flag_fastopen_request = 0x1A,				/*!< The QSMP fast-open client request flag */
+	qsmp_flag_fastopen_response = 0x1B,				/*!< The QSMP fast-open server key response flag */
+	qsmp_flag_multiplex_message = 0x1C,				/*!< The encrypted record contains a frame of a logical stream */
+	qsmp_flag_symmetric_ratchet_response = 0x1D,	/*!< The host has acknowledged a symmetric key ratchet request */
 	qsmp_flag_error_condition = 0xFF,				/*!< The connection experienced an error */
 } qsmp_flags;
 
@@ -1369,12 +1527,152 @@ QSMP_EXPORT_API typedef struct qsmp_server_signature_key
 */
 QSMP_EXPORT_API typedef struct qsmp_keep_alive_state
 {
-	qsc_socket target;								/*!< The target socket structure */
 	uint64_t etime;									/*!< The keep alive epoch time  */
 	uint64_t seqctr;								/*!< The keep alive packet sequence counter  */
 	bool recd;										/*!< The keep alive response received status  */
 } qsmp_keep_alive_state;
 
+/*!
+* \struct qsmp_record_buffer
+* \brief The QSMP connection record buffer.
+* On receive, reassembles complete QSMP records from the TCP byte stream, retaining partial records between reads.
+* On transmit, holds the serialized records the socket has not yet accepted
+*/
+QSMP_EXPORT_API typedef struct qsmp_record_buffer
+{
+	uint8_t* buffer;								/*!< The receive buffer */
+	size_t capacity;								/*!< The allocated size of the receive buffer */
+	size_t position;								/*!< The offset of the first unparsed byte */
+	size_t length;									/*!< The number of unparsed bytes in the buffer */
+} qsmp_record_buffer;
+
+/*!
+* \struct qsmp_send_record
+* \brief A message waiting in the send queue of a connection
+*/
+QSMP_EXPORT_API typedef struct qsmp_send_record
+{
+	struct qsmp_send_record* volatile next;			/*!< The next record in the queue, published by the producer that added it */
+	uint8_t* message;								/*!< The message, allocated with the queue entry */
+	size_t length;									/*!< The message length */
+	size_t capacity;								/*!< The largest message the entry holds */
+} qsmp_send_record;
+
+/*!
+* \struct qsmp_send_queue
+* \brief The multiple producer, single writer send queue of a connection.
+* Producers add messages without a lock; the producer that finds the queue idle becomes the writer,
+* and encrypts and sends every queued message in the order it was added before it returns.
+* Only a message queued behind another writer takes an entry, from the free list of the connection when one is cached
+*/
+QSMP_EXPORT_API typedef struct qsmp_send_queue
+{
+	qsmp_send_record stub;							/*!< The placeholder record that keeps the queue non-empty */
+	qsmp_send_record* volatile head;				/*!< The most recently added record, exchanged by the producers */
+	qsmp_send_record* tail;							/*!< The oldest record, owned by the writer */
+	qsmp_send_record* volatile freelist;			/*!< The released entries, returned by the writer and taken whole by a producer */
+	volatile int32_t freecount;						/*!< The number of entries on the free list */
+	volatile int32_t pending;						/*!< The number of queued messages, the producer that raises it from zero becomes the writer */
+	volatile int32_t error;							/*!< The first transmission error seen by a writer, returned to later producers */
+} qsmp_send_queue;
+
+/*!
+* \struct qsmp_coalesce_state
+* \brief The QSMP small message coalescing state, guarded by the transmit lock
+*/
+QSMP_EXPORT_API typedef struct qsmp_coalesce_state
+{
+	uint8_t* buffer;								/*!< The pending messages, coalescing is enabled when the buffer is allocated */
+	size_t length;									/*!< The number of pending bytes in the buffer */
+	size_t threshold;								/*!< The pending size that sends the batch */
+	uint64_t stime;									/*!< The time the oldest pending message was added, in microseconds */
+	uint32_t latency;								/*!< The latency budget of a pending message, in microseconds */
+	qsmp_timer timer;								/*!< The flush timer of a batch that is not followed by another message */
+} qsmp_coalesce_state;
+
+/*!
+* \struct qsmp_stream_state
+* \brief The QSMP stream transfer receive state
+*/
+QSMP_EXPORT_API typedef struct qsmp_stream_state
+{
+	uint8_t* buffer;								/*!< The payload buffer, allocated when the transfer request is received */
+	size_t length;									/*!< The payload length announced by the transfer request */
+	size_t position;								/*!< The number of payload bytes received */
+} qsmp_stream_state;
+
+/* the stream callbacks take the connection state, which is defined after the multiplexing state */
+struct qsmp_connection_state;
+
+/*!
+* \struct qsmp_multiplex_message
+* \brief A message or control frame queued for transmission on a logical stream
+*/
+QSMP_EXPORT_API typedef struct qsmp_multiplex_message
+{
+	struct qsmp_multiplex_message* next;			/*!< The next queued message on the stream */
+	uint8_t* message;								/*!< The message, allocated with the queue entry */
+	size_t length;									/*!< The message length, zero for a control frame */
+	size_t position;								/*!< The number of message bytes sent */
+	uint8_t type;									/*!< The frame type of the entry */
+} qsmp_multiplex_message;
+
+/*!
+* \struct qsmp_multiplex_stream
+* \brief A logical stream of a multiplexed connection
+*/
+QSMP_EXPORT_API typedef struct qsmp_multiplex_stream
+{
+	void (*callback)(struct qsmp_connection_state*, uint32_t, const uint8_t*, size_t);	/*!< The stream receive callback */
+	qsmp_multiplex_message* head;					/*!< The oldest queued message */
+	qsmp_multiplex_message* tail;					/*!< The newest queued message */
+	uint8_t* rxbuf;									/*!< The message being reassembled from received frames */
+	size_t rxcap;									/*!< The allocated size of the reassembly buffer */
+	size_t rxlen;									/*!< The number of message bytes received */
+	size_t pending;									/*!< The number of message bytes queued for transmission */
+	uint32_t id;									/*!< The stream identifier, zero when the slot is free */
+	bool closing;									/*!< The close frame is queued, no more messages are accepted */
+} qsmp_multiplex_stream;
+
+/*!
+* \struct qsmp_multiplex_state
+* \brief The QSMP logical stream state of a connection
+*/
+QSMP_EXPORT_API typedef struct qsmp_multiplex_state
+{
+	qsmp_multiplex_stream streams[QSMP_MULTIPLEX_STREAMS_MAX];	/*!< The stream table */
+	void (*callback)(struct qsmp_connection_state*, uint32_t, const uint8_t*, size_t);	/*!< The receive callback of streams opened by the remote host */
+	qsc_mutex lock;									/*!< Guards the stream table and queues, it is not held while sending */
+	size_t next;									/*!< The stream slot given the next scheduler turn */
+	uint32_t sidnext;								/*!< The identifier of the next locally opened stream */
+	bool draining;									/*!< A thread is sending the queued frames */
+} qsmp_multiplex_state;
+
+/*!
+* \struct qsmp_fastopen_key
+* \brief The servers fast-open asymmetric cipher public key, cached by a simplex client.
+* A client holding a current key sends its encapsulation with the connection request, and the session is established in one round trip
+*/
+QSMP_EXPORT_API typedef struct qsmp_fastopen_key
+{
+	uint8_t pubkey[QSMP_ASYMMETRIC_PUBLIC_KEY_SIZE];/*!< The servers fast-open asymmetric cipher public key */
+	uint8_t keyid[QSMP_KEYID_SIZE];					/*!< The key identity of the issuing server */
+	uint64_t expiration;							/*!< The key expiration time, in seconds from epoch */
+} qsmp_fastopen_key;
+
+/*!
+* \struct qsmp_session_ticket
+* \brief The QSMP session resumption ticket held by a simplex client.
+* The ticket is issued by the server when the session is established, and is presented to resume a session without the asymmetric key exchange
+*/
+QSMP_EXPORT_API typedef struct qsmp_session_ticket
+{
+	uint8_t ticket[QSMP_TICKET_SIZE];				/*!< The encrypted ticket, opaque to the client */
+	uint8_t keyid[QSMP_KEYID_SIZE];					/*!< The key identity of the issuing server */
+	uint8_t secret[QSMP_SECRET_SIZE];				/*!< The resumption secret sealed in the ticket */
+	uint64_t expiration;							/*!< The ticket expiration time, in seconds from epoch */
+} qsmp_session_ticket;
+
 /*!
 * \struct qsmp_connection_state
 * \brief The QSMP socket connection state structure
@@ -1382,14 +1680,28 @@ QSMP_EXPORT_API typedef struct qsmp_keep_alive_state
 QSMP_EXPORT_API typedef struct qsmp_connection_state
 {
 	uint8_t rtcs[QSMP_DUPLEX_SYMMETRIC_KEY_SIZE];	/*!< The ratchet key generation state */
+	uint8_t rtrx[QSMP_DUPLEX_SYMMETRIC_KEY_SIZE + QSMP_NONCE_SIZE];	/*!< The ratcheted receive key and nonce, installed when the peer acknowledges the request */
 	qsc_socket target;								/*!< The target socket structure */
 	qsc_rcs_state rxcpr;							/*!< The receive channel cipher state */
 	qsc_rcs_state txcpr;							/*!< The transmit channel cipher state */
+	qsc_async_mutex_statistics txstats;				/*!< The transmit lock acquisition and contention counters */
+	qsc_mutex txlock;								/*!< The transmit lock, serializes packet encryption and sends on the connection */
+	qsmp_record_buffer rxbuf;						/*!< The receive record reassembly buffer */
+	qsmp_record_buffer txbuf;						/*!< The bounded transmit queue, guarded by the transmit lock */
+	qsmp_send_queue txque;							/*!< The message send queue, drained by a single writer */
+	qsmp_stream_state rxstm;						/*!< The stream transfer being received */
+	qsmp_coalesce_state coalesce;					/*!< The small message coalescing state */
+	qsmp_multiplex_state* mux;						/*!< The logical stream state, allocated when multiplexing is enabled */
+	qsmp_session_ticket ticket;						/*!< The resumption ticket issued to a simplex client, copy it before the connection is closed */
+	qsmp_keep_alive_state kpa;						/*!< The keep alive state, guarded by the transmit lock */
+	qsmp_timer timer;								/*!< The session timer, runs the keep alive and key schedules */
 	uint64_t rxseq;									/*!< The receive channels packet sequence number  */
 	uint64_t txseq;									/*!< The transmit channels packet sequence number  */
 	uint32_t instance;								/*!< The connections instance count */
 	qsmp_flags exflag;								/*!< The KEX position flag */
 	bool receiver;									/*!< The instance was initialized in listener mode */
+	bool txstream;									/*!< A stream transfer owns the transmit cipher, guarded by the transmit lock */
+	bool rtpend;									/*!< A symmetric ratchet request is awaiting acknowledgement, guarded by the transmit lock */
 	qsmp_mode mode;									/*!< The QSMP operations mode */
 } qsmp_connection_state;
 
@@ -1447,6 +1759,20 @@ QSMP_EXPORT_API typedef struct qsmp_connection_state
 #endif
 
 
+/**
+* \brief Get the next message from a decrypted coalesced record.
+* The position is set to zero before the first call, and is advanced past each message that is returned.
+*
+* \param message: [const] The decrypted record message
+* \param msglen: The length of the record message
+* \param position: A pointer to the offset of the next message in the record
+* \param entry: A pointer receiving the address of the next message in the record
+* \param entlen: A pointer receiving the length of the next message
+*
+* \return: Returns true if a message was returned, false when the record is exhausted
+*/
+QSMP_EXPORT_API bool qsmp_coalesced_next(const uint8_t* message, size_t msglen, size_t* position, const uint8_t** entry, size_t* entlen);
+
 /**
 * \brief Close the network connection between hosts
 *
@@ -1456,6 +1782,159 @@ QSMP_EXPORT_API typedef struct qsmp_connection_state
 */
 QSMP_EXPORT_API void qsmp_connection_close(qsmp_connection_state* cns, qsmp_errors err, bool notify);
 
+/**
+* \brief Send any pending coalesced messages, and disable small message coalescing on the connection
+*
+* \param cns: A pointer to the connection state structure
+*/
+QSMP_EXPORT_API void qsmp_connection_coalesce_disable(qsmp_connection_state* cns);
+
+/**
+* \brief Enable small message coalescing on the connection, or change its settings.
+* While enabled, messages passed to qsmp_connection_send that are smaller than the threshold are packed with a length prefix
+* into one encrypted record, which saves the header, mac tag, and socket write of each message.
+* The batch is sent when it reaches the threshold, on qsmp_connection_flush, or when the oldest message has waited for the latency budget.
+* The latency is checked on each send, and a batch that is not followed by another message is sent by a timer wheel timer,
+* at the timer wheel resolution; applications with a tight latency budget should call qsmp_connection_flush after a burst.
+* A larger threshold and latency favor messages per second, smaller values favor latency.
+*
+* \param cns: A pointer to the connection state structure
+* \param threshold: The pending size in bytes that sends the batch, limited to QSMP_COALESCE_SIZE_MAX
+* \param latency: The maximum time a message is held, in microseconds
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_connection_coalesce_enable(qsmp_connection_state* cns, size_t threshold, uint32_t latency);
+
+/**
+* \brief Process every complete record in the connections receive buffer, filled by qsmp_record_buffer_receive.
+* Message, coalesced, stream transfer, and multiplex records are decrypted and passed to the receive callback,
+* other records are passed to the control callback. Processing stops at the first error, and the caller closes the connection.
+*
+* \param cns: A pointer to the connection state structure
+* \param receive_callback: A pointer to the function that receives the decrypted messages
+* \param control_callback: A pointer to the function that handles keep alive and ratchet records, returns qsmp_error_invalid_request for an unknown record; can be NULL
+*
+* \return: Returns the function error state, qsmp_error_channel_down if the remote host terminated the session
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_connection_dispatch(qsmp_connection_state* cns,
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t),
+	qsmp_errors (*control_callback)(qsmp_connection_state*, const qsmp_packet*));
+
+/**
+* \brief Send the coalesced messages and the records held in the connection transmit queue, without blocking on a full socket buffer.
+* Bytes the socket does not accept remain queued, the pending size is the length of the connections txbuf.
+*
+* \param cns: A pointer to the connection state structure
+*
+* \return: Returns the function error state, qsmp_error_transmit_failure if the socket failed
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_connection_flush(qsmp_connection_state* cns);
+
+/**
+* \brief Send a keep alive request to the remote host, through the connection transmit queue.
+* If the previous request has not been answered, no request is sent and the keep alive has expired.
+*
+* \param cns: A pointer to the connection state structure
+*
+* \return: Returns the function error state, qsmp_error_keep_alive_expired if the last request was not answered
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_connection_keepalive_request(qsmp_connection_state* cns);
+
+/**
+* \brief Take the transmit lock to encrypt a record, waiting for a stream transfer in progress to complete.
+* The running mac of a stream transfer spans its segments, so no other record is encrypted until the transfer completes.
+* The lock is released with qsc_async_mutex_unlock.
+*
+* \param cns: A pointer to the connection state structure
+*/
+QSMP_EXPORT_API void qsmp_connection_transmit_lock(qsmp_connection_state* cns);
+
+/**
+* \brief Send a serialized record through the connection transmit queue, in order behind any queued records.
+* The record is sent directly when the queue is empty, and the unsent remainder is queued.
+*
+* \warning The caller must hold the connection transmit lock.
+*
+* \param cns: A pointer to the connection state structure
+* \param record: [const] The serialized record, including the terminator
+* \param reclen: The length of the record, including the terminator
+*
+* \return: Returns the function error state, qsmp_error_transmit_failure if the queue is full or the socket failed
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_connection_send_locked(qsmp_connection_state* cns, const uint8_t* record, size_t reclen);
+
+/**
+* \brief Verify a keep alive response against the outstanding request
+*
+* \param cns: A pointer to the connection state structure
+* \param packetin: [const] A pointer to the keep alive response packet
+*
+* \return: Returns the function error state, qsmp_error_bad_keep_alive if the response does not match the request
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_connection_keepalive_response(qsmp_connection_state* cns, const qsmp_packet* packetin);
+
+/**
+* \brief Encrypt a message to the bounded connection transmit queue, and send as much of the queue as the socket accepts without blocking.
+* If the queue can not hold the message it is refused before encryption, and the session state is unchanged.
+*
+* \param cns: A pointer to the connection state structure
+* \param message: [const] The input message array
+* \param msglen: The length of the message array
+*
+* \return: Returns the function error state, qsmp_error_transmit_failure if the queue is full or the socket failed,
+* or qsmp_error_transmit_busy if a stream transfer is in progress on the connection
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_connection_queue(qsmp_connection_state* cns, const uint8_t* message, size_t msglen);
+
+/**
+* \brief Queue one message to many connections, as qsmp_connection_queue does for each connection.
+* The connections are processed in groups of QSMP_CONNECTION_QUEUE_MULTI_MAX, and the message is encrypted for a group
+* with one call to qsc_rcs_transform_multi, while the transmit locks of the group are held.
+*
+* \warning The connections in the array must be distinct.
+*
+* \param cns: The array of connection state pointers
+* \param count: The number of connections in the array
+* \param message: [const] The input message array
+* \param msglen: The length of the message array
+* \param results: The array receiving the error state of each connection, qsmp_error_transmit_failure if a queue is full,
+* qsmp_error_transmit_busy if a stream transfer is in progress, or qsmp_error_channel_down if the session is no longer established when its lock is taken
+*
+* \return: Returns the number of connections the message was queued to
+*/
+QSMP_EXPORT_API size_t qsmp_connection_queue_multi(qsmp_connection_state* cns[], size_t count, const uint8_t* message, size_t msglen, qsmp_errors results[]);
+
+/**
+* \brief Encrypt a message and send it to the remote host.
+* The message is added to the connection send queue without taking a lock. If no other thread is sending,
+* the caller becomes the writer: it sends its message and every message added while it writes, then returns.
+* Otherwise the message is copied to the queue and sent by the current writer, which owns the transmit cipher and sequence,
+* so records reach the socket in sequence order. A failure to send a queued message is returned by the next call.
+* Records waiting in the transmit queue are sent first, and the part of a record a non-blocking socket does not accept is queued.
+* If coalescing is enabled with qsmp_connection_coalesce_enable, a message smaller than the threshold is added to the pending batch.
+*
+* \param cns: A pointer to the connection state structure
+* \param message: [const] The input message array
+* \param msglen: The length of the message array
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_connection_send(qsmp_connection_state* cns, const uint8_t* message, size_t msglen);
+
+/**
+* \brief Encrypt a list of messages, and send each as a record with one gathering socket write.
+* The record headers and cipher-text are passed to the socket as separate segments, so the records are not copied to a stream buffer.
+* The records take consecutive sequence numbers, and are queued behind any records waiting in the transmit queue.
+*
+* \param cns: A pointer to the connection state structure
+* \param messages: [const] The array of messages, each is sent as one record
+* \param count: The number of messages, at most QSMP_CONNECTION_SENDV_MAX
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_connection_sendv(qsmp_connection_state* cns, const qsc_socket_buffer* messages, size_t count);
+
 /**
 * \brief Reset the connection state
 *
@@ -1463,6 +1942,15 @@ QSMP_EXPORT_API void qsmp_connection_close(qsmp_connection_state* cns, qsmp_erro
 */
 QSMP_EXPORT_API void qsmp_connection_state_dispose(qsmp_connection_state* cns);
 
+/**
+* \brief Reset the connection state for reuse, keeping the transmit lock and instance number.
+* The state is released while the transmit lock is held, so a sender holding the lock completes first.
+* The timers are cancelled before the lock is taken, the caller must not hold the transmit lock.
+*
+* \param cns: A pointer to the connection state structure
+*/
+QSMP_EXPORT_API void qsmp_connection_state_reset(qsmp_connection_state* cns);
+
 /**
 * \brief Decode a public key string and populate a client key structure
 *
@@ -1490,7 +1978,8 @@ QSMP_EXPORT_API void qsmp_deserialize_signature_key(qsmp_server_signature_key* k
 QSMP_EXPORT_API void qsmp_encode_public_key(char enck[QSMP_PUBKEY_STRING_SIZE], const qsmp_server_signature_key* kset);
 
 /**
-* \brief Decrypt a message and copy it to the message output
+* \brief Decrypt a message and copy it to the message output.
+* The message output may be the packets own message buffer, in which case the packet is decrypted in place.
 *
 * \param cns: A pointer to the connection state structure
 * \param message: The message output array
@@ -1502,7 +1991,23 @@ QSMP_EXPORT_API void qsmp_encode_public_key(char enck[QSMP_PUBKEY_STRING_SIZE],
 QSMP_EXPORT_API qsmp_errors qsmp_decrypt_packet(qsmp_connection_state* cns, uint8_t* message, size_t* msglen, const qsmp_packet* packetin);
 
 /**
-* \brief Encrypt a message and build an output packet
+* \brief Authenticate and decrypt a run of consecutive message records.
+* The records are decrypted in place, and a slice of each plaintext message is written to the messages array.
+* The connection state and tag size are checked once for the run, and processing stops at the first record that fails.
+*
+* \param cns: A pointer to the connection state structure
+* \param packets: [const] The array of encrypted message packets, in sequence order
+* \param count: The number of packets
+* \param messages: The output array of plaintext message slices, must hold count entries
+* \param mcount: A pointer receiving the number of messages decrypted, the messages ahead of a failed record are valid
+*
+* \return: Returns the function error state, the error of the first record that failed
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_decrypt_packets(qsmp_connection_state* cns, const qsmp_packet* packets, size_t count, qsc_socket_buffer* messages, size_t* mcount);
+
+/**
+* \brief Encrypt a message and build an output packet.
+* The packet message buffer must hold the message length and the mac tag, the buffer is not cleared beyond the written bytes.
 *
 * \param cns: A pointer to the connection state structure
 * \param packetout: A pointer to the output packet structure
@@ -1564,6 +2069,76 @@ QSMP_EXPORT_API void qsmp_log_message(qsmp_messages emsg);
 */
 QSMP_EXPORT_API void qsmp_log_write(qsmp_messages emsg, const char* msg);
 
+/**
+* \brief Set the receive callback of logical streams opened by a remote host on a connection that has not enabled multiplexing.
+* The first stream opened on such a connection enables multiplexing as the responder, this is how a server accepts logical streams.
+* The callback receives the stream identifier with each message, and a NULL message of zero length when the stream is closed.
+*
+* \param callback: A pointer to the stream receive callback, or NULL to refuse logical streams
+*/
+QSMP_EXPORT_API void qsmp_multiplex_accept_callback(void (*callback)(qsmp_connection_state*, uint32_t, const uint8_t*, size_t));
+
+/**
+* \brief Close a logical stream.
+* The close frame is sent after the messages already queued on the stream, and the stream identifier is released when it is sent.
+*
+* \param cns: A pointer to the connection state structure
+* \param sid: The stream identifier
+*
+* \return: Returns the function error state, qsmp_error_invalid_input if the stream is not open
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_multiplex_close(qsmp_connection_state* cns, uint32_t sid);
+
+/**
+* \brief Enable logical streams on an established connection.
+* The host that initiated the connection sets the initiator flag, and opens odd numbered streams, the remote host opens even numbered streams.
+*
+* \param cns: A pointer to the connection state structure
+* \param initiator: True if this host initiated the connection
+* \param callback: A pointer to the receive callback of streams opened by the remote host
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_multiplex_enable(qsmp_connection_state* cns, bool initiator, void (*callback)(qsmp_connection_state*, uint32_t, const uint8_t*, size_t));
+
+/**
+* \brief Open a logical stream on the connection.
+*
+* \param cns: A pointer to the connection state structure
+* \param callback: A pointer to the receive callback of the stream
+* \param sid: A pointer receiving the stream identifier
+*
+* \return: Returns the function error state, qsmp_error_hosts_exceeded if QSMP_MULTIPLEX_STREAMS_MAX streams are open,
+* or the stream identifiers of the connection are exhausted
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_multiplex_open(qsmp_connection_state* cns, void (*callback)(qsmp_connection_state*, uint32_t, const uint8_t*, size_t), uint32_t* sid);
+
+/**
+* \brief Process a multiplexed record received from the remote host.
+* The record is decrypted in place, and a completed message is passed to the receive callback of its stream.
+*
+* \param cns: A pointer to the connection state structure
+* \param packetin: [const] A pointer to a multiplexed message packet
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_multiplex_receive(qsmp_connection_state* cns, const qsmp_packet* packetin);
+
+/**
+* \brief Send a message on a logical stream.
+* The message is queued on the stream, and the queued streams are sent in turn, one frame of QSMP_MULTIPLEX_FRAME_SIZE bytes from each stream,
+* so a large message on one stream does not delay the messages of the others.
+* If another thread is sending the queued frames, the message is sent by that thread and the function returns when it is queued.
+*
+* \param cns: A pointer to the connection state structure
+* \param sid: The stream identifier
+* \param message: [const] The message array
+* \param msglen: The length of the message, at most QSMP_MULTIPLEX_QUEUE_SIZE
+*
+* \return: Returns the function error state, qsmp_error_transmit_failure if the stream queue is full or the socket failed
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_multiplex_send(qsmp_connection_state* cns, uint32_t sid, const uint8_t* message, size_t msglen);
+
 /**
 * \brief Clear a packet's state
 *
@@ -1605,6 +2180,49 @@ QSMP_EXPORT_API void qsmp_packet_header_serialize(const qsmp_packet* packet, uin
 */
 QSMP_EXPORT_API size_t qsmp_packet_to_stream(const qsmp_packet* packet, uint8_t* pstream);
 
+/**
+* \brief Release the memory held by a record buffer
+*
+* \param rbuf: A pointer to the record buffer
+*/
+QSMP_EXPORT_API void qsmp_record_buffer_dispose(qsmp_record_buffer* rbuf);
+
+/**
+* \brief Extract the next complete record from the buffer.
+* The packet message points into the record buffer, and is valid until the next call to qsmp_record_buffer_receive.
+* A record with an invalid length is returned with the qsmp_flag_error_condition flag, and the buffered data is discarded.
+*
+* \param rbuf: A pointer to the record buffer
+* \param packet: A pointer to the output packet structure
+*
+* \return: Returns true if a record was extracted, false if more data is required
+*/
+QSMP_EXPORT_API bool qsmp_record_buffer_next(qsmp_record_buffer* rbuf, qsmp_packet* packet);
+
+/**
+* \brief Read available data from the socket into the record buffer.
+* Partial records are moved to the front of the buffer, and the buffer is grown if the pending record exceeds its size.
+*
+* \param rbuf: A pointer to the record buffer
+* \param sock: [const] A pointer to the connected socket
+*
+* \return: Returns the number of bytes received, zero on failure or if the remote host closed the connection
+*/
+QSMP_EXPORT_API size_t qsmp_record_buffer_receive(qsmp_record_buffer* rbuf, const qsc_socket* sock);
+
+/**
+* \brief Take the run of complete message records at the front of the buffer.
+* Records are taken until the count is reached, a record is incomplete, or a record is not an encrypted message,
+* which is left in the buffer for qsmp_record_buffer_next.
+*
+* \param rbuf: A pointer to the record buffer
+* \param packets: The output array of packets, each points into the record buffer
+* \param count: The maximum number of records to take
+*
+* \return: Returns the number of records taken
+*/
+QSMP_EXPORT_API size_t qsmp_record_buffer_run(qsmp_record_buffer* rbuf, qsmp_packet* packets, size_t count);
+
 /**
 * \brief Encode a secret key structure and copy to a string
 *
@@ -1613,6 +2231,38 @@ QSMP_EXPORT_API size_t qsmp_packet_to_stream(const qsmp_packet* packet, uint8_t*
 */
 QSMP_EXPORT_API void qsmp_serialize_signature_key(uint8_t serk[QSMP_SIGKEY_ENCODED_SIZE], const qsmp_server_signature_key* kset);
 
+/**
+* \brief Process a record of a stream transfer received from the remote host.
+* The first record is an authenticated transfer request carrying the payload length, and each following record is a segment of the payload.
+* The segments are decrypted as they arrive, and are authenticated by the single mac appended to the final segment.
+* The payload is returned only after the final mac is verified, the caller owns the payload and releases it with qsc_memutils_alloc_free.
+*
+* \param cns: A pointer to the connection state structure
+* \param packetin: [const] A pointer to a transfer request packet
+* \param message: A pointer receiving the completed payload, set to NULL until the transfer is complete
+* \param msglen: A pointer receiving the payload length
+*
+* \return: Returns the function error state, an error abandons the transfer
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_stream_receive(qsmp_connection_state* cns, const qsmp_packet* packetin, uint8_t** message, size_t* msglen);
+
+/**
+* \brief Send a large payload to the remote host as a segmented stream transfer.
+* The payload is sent in records of QSMP_STREAM_SEGMENT_SIZE bytes, encrypted with a running mac that is appended to the final record,
+* rather than as many independently authenticated messages.
+* The transmit lock is released between segments, so control records and queue flushes are not held behind the transfer,
+* but encrypted records from other senders wait until the transfer completes, and qsmp_connection_queue refuses them with qsmp_error_transmit_busy.
+* A segment the socket does not accept in full is handed to the transmit queue, and the sender waits for the socket to become writable
+* only when the queue can not hold it.
+*
+* \param cns: A pointer to the connection state structure
+* \param message: [const] The input payload array
+* \param msglen: The length of the payload, at most QSMP_STREAM_MAX_SIZE
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_stream_send(qsmp_connection_state* cns, const uint8_t* message, size_t msglen);
+
 /**
 * \brief Deserialize a byte array to a packet
 *
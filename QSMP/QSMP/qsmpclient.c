@@ -44,14 +44,13 @@
 typedef struct client_receiver_state
 {
 	qsmp_connection_state* pcns;
-	void (*callback)(qsmp_connection_state*, const char*, size_t);
+	void (*callback)(qsmp_connection_state*, const uint8_t*, size_t);
 } client_receiver_state;
 
 typedef struct listener_receiver_state
 {
 	qsmp_connection_state* pcns;
-	qsmp_keep_alive_state* pkpa;
-	void (*callback)(qsmp_connection_state*, const char*, size_t);
+	void (*callback)(qsmp_connection_state*, const uint8_t*, size_t);
 } listener_receiver_state;
 
 #if defined(QSMP_ASYMMETRIC_RATCHET)
@@ -82,6 +81,9 @@ static void client_duplex_state_initialize(qsmp_kex_duplex_client_state* kcs, qs
 	cns->rxseq = 0;
 	cns->txseq = 0;
 	cns->receiver = false;
+	cns->txlock = qsc_async_mutex_create();
+	qsc_memutils_clear(&cns->rxbuf, sizeof(qsmp_record_buffer));
+	qsc_memutils_clear(&cns->txstats, sizeof(qsc_async_mutex_statistics));
 }
 
 static void listener_duplex_state_initialize(qsmp_kex_duplex_server_state* kss, listener_receiver_state* rcv, 
@@ -93,7 +95,6 @@ static void listener_duplex_state_initialize(qsmp_kex_duplex_server_state* kss,
 	qsc_memutils_copy(kss->verkey, kset->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
 	kss->key_query = key_query;
 	kss->expiration = kset->expiration;
-	qsc_memutils_copy(&rcv->pkpa->target, &rcv->pcns->target, sizeof(qsc_socket));
 	qsc_memutils_clear((uint8_t*)&rcv->pcns->rxcpr, sizeof(qsc_rcs_state));
 	qsc_memutils_clear((uint8_t*)&rcv->pcns->txcpr, sizeof(qsc_rcs_state));
 	qsc_memutils_clear(&rcv->pcns->rtcs, QSMP_DUPLEX_SYMMETRIC_KEY_SIZE);
@@ -103,6 +104,8 @@ static void listener_duplex_state_initialize(qsmp_kex_duplex_server_state* kss,
 	rcv->pcns->rxseq = 0;
 	rcv->pcns->txseq = 0;
 	rcv->pcns->receiver = true;
+	rcv->pcns->txlock = qsc_async_mutex_create();
+	qsc_memutils_clear(&rcv->pcns->rxbuf, sizeof(qsmp_record_buffer));
 }
 
 static void client_simplex_state_initialize(qsmp_kex_simplex_client_state* kcs, qsmp_connection_state* cns, const qsmp_client_signature_key* pubk)
@@ -118,6 +121,24 @@ static void client_simplex_state_initialize(qsmp_kex_simplex_client_state* kcs,
 	cns->instance = 0;
 	cns->rxseq = 0;
 	cns->txseq = 0;
+	cns->txlock = qsc_async_mutex_create();
+	qsc_memutils_clear(&cns->rxbuf, sizeof(qsmp_record_buffer));
+	qsc_memutils_clear(&cns->txstats, sizeof(qsc_async_mutex_statistics));
+}
+
+static void client_resume_state_initialize(qsmp_connection_state* cns)
+{
+	qsc_memutils_clear(cns->rtcs, QSMP_DUPLEX_SYMMETRIC_KEY_SIZE);
+	qsc_rcs_dispose(&cns->rxcpr);
+	qsc_rcs_dispose(&cns->txcpr);
+	cns->exflag = qsmp_flag_none;
+	cns->mode = qsmp_mode_simplex;
+	cns->instance = 0;
+	cns->rxseq = 0;
+	cns->txseq = 0;
+	cns->txlock = qsc_async_mutex_create();
+	qsc_memutils_clear(&cns->rxbuf, sizeof(qsmp_record_buffer));
+	qsc_memutils_clear(&cns->txstats, sizeof(qsc_async_mutex_statistics));
 }
 
 static void listener_simplex_state_initialize(qsmp_kex_simplex_server_state* kss, listener_receiver_state* rcv, const qsmp_server_signature_key* kset)
@@ -126,7 +147,6 @@ static void listener_simplex_state_initialize(qsmp_kex_simplex_server_state* kss
 	qsc_memutils_copy(kss->sigkey, kset->sigkey, QSMP_ASYMMETRIC_SIGNING_KEY_SIZE);
 	qsc_memutils_copy(kss->verkey, kset->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
 	kss->expiration = kset->expiration;
-	qsc_memutils_copy(&rcv->pkpa->target, &rcv->pcns->target, sizeof(qsc_socket));
 	qsc_memutils_clear((uint8_t*)&rcv->pcns->rxcpr, sizeof(qsc_rcs_state));
 	qsc_memutils_clear((uint8_t*)&rcv->pcns->txcpr, sizeof(qsc_rcs_state));
 	qsc_memutils_clear(&rcv->pcns->rtcs, QSMP_DUPLEX_SYMMETRIC_KEY_SIZE);
@@ -135,68 +155,90 @@ static void listener_simplex_state_initialize(qsmp_kex_simplex_server_state* kss
 	rcv->pcns->instance = 0;
 	rcv->pcns->rxseq = 0;
 	rcv->pcns->txseq = 0;
+	rcv->pcns->txlock = qsc_async_mutex_create();
+	qsc_memutils_clear(&rcv->pcns->rxbuf, sizeof(qsmp_record_buffer));
 }
 
-static void symmetric_ratchet(qsmp_connection_state* cns, const uint8_t* secret, size_t seclen)
+static void symmetric_ratchet_derive(qsmp_connection_state* cns, const uint8_t* secret, size_t seclen, uint8_t* prnd)
 {
 	qsc_keccak_state kstate = { 0 };
-	uint8_t prnd[(QSC_KECCAK_512_RATE * 3)] = { 0 };
 
 	/* re-key the ciphers using the token, ratchet key, and configuration name */
 	qsc_cshake_initialize(&kstate, qsc_keccak_rate_512, secret, seclen, QSMP_CONFIG_STRING, QSMP_CONFIG_SIZE, cns->rtcs, QSMP_DUPLEX_SYMMETRIC_KEY_SIZE);
 	/* re-key the ciphers using the symmetric ratchet key */
 	qsc_cshake_squeezeblocks(&kstate, qsc_keccak_rate_512, prnd, 3);
 
-	if (cns->receiver == true)
-	{
-		/* initialize for decryption, and raise client channel rx */
-		qsc_rcs_keyparams kp1;
-		kp1.key = prnd;
-		kp1.keylen = QSMP_DUPLEX_SYMMETRIC_KEY_SIZE;
-		kp1.nonce = ((uint8_t*)prnd + QSMP_DUPLEX_SYMMETRIC_KEY_SIZE);
-		kp1.info = NULL;
-		kp1.infolen = 0;
-		qsc_rcs_initialize(&cns->rxcpr, &kp1, false);
-
-		/* initialize for encryption, and raise client channel tx */
-		qsc_rcs_keyparams kp2;
-		kp2.key = prnd + QSMP_DUPLEX_SYMMETRIC_KEY_SIZE + QSMP_NONCE_SIZE;
-		kp2.keylen = QSMP_DUPLEX_SYMMETRIC_KEY_SIZE;
-		kp2.nonce = ((uint8_t*)prnd + QSMP_DUPLEX_SYMMETRIC_KEY_SIZE + QSMP_NONCE_SIZE + QSMP_DUPLEX_SYMMETRIC_KEY_SIZE);
-		kp2.info = NULL;
-		kp2.infolen = 0;
-		qsc_rcs_initialize(&cns->txcpr, &kp2, true);
-	}
-	else
-	{
-		/* initialize for encryption, and raise tx */
-		qsc_rcs_keyparams kp1;
-		kp1.key = prnd;
-		kp1.keylen = QSMP_DUPLEX_SYMMETRIC_KEY_SIZE;
-		kp1.nonce = ((uint8_t*)prnd + QSMP_DUPLEX_SYMMETRIC_KEY_SIZE);
-		kp1.info = NULL;
-		kp1.infolen = 0;
-		qsc_rcs_initialize(&cns->txcpr, &kp1, true);
-
-		/* initialize decryption, and raise rx */
-		qsc_rcs_keyparams kp2;
-		kp2.key = prnd + QSMP_DUPLEX_SYMMETRIC_KEY_SIZE + QSMP_NONCE_SIZE;
-		kp2.keylen = QSMP_DUPLEX_SYMMETRIC_KEY_SIZE;
-		kp2.nonce = ((uint8_t*)prnd + QSMP_DUPLEX_SYMMETRIC_KEY_SIZE + QSMP_NONCE_SIZE + QSMP_DUPLEX_SYMMETRIC_KEY_SIZE);
-		kp2.info = NULL;
-		kp2.infolen = 0;
-		qsc_rcs_initialize(&cns->rxcpr, &kp2, false);
-	}
-
 	/* permute key state and store next key */
 	qsc_keccak_permute(&kstate, QSC_KECCAK_PERMUTATION_ROUNDS);
 	qsc_memutils_copy(cns->rtcs, (uint8_t*)kstate.state, QSMP_DUPLEX_SYMMETRIC_KEY_SIZE);
+	qsc_intutils_clear64(kstate.state, QSC_KECCAK_STATE_SIZE);
+}
+
+static size_t symmetric_ratchet_rxpos(const qsmp_connection_state* cns)
+{
+	/* the listener receives on the first key and nonce, the client on the second */
+	return (cns->receiver == true) ? 0 : QSMP_DUPLEX_SYMMETRIC_KEY_SIZE + QSMP_NONCE_SIZE;
+}
+
+static size_t symmetric_ratchet_txpos(const qsmp_connection_state* cns)
+{
+	return (cns->receiver == true) ? QSMP_DUPLEX_SYMMETRIC_KEY_SIZE + QSMP_NONCE_SIZE : 0;
+}
+
+static void symmetric_ratchet_key(qsc_rcs_state* cpr, uint8_t* key, bool encryption)
+{
+	qsc_rcs_keyparams kp;
+
+	/* the key is followed by its nonce */
+	kp.key = key;
+	kp.keylen = QSMP_DUPLEX_SYMMETRIC_KEY_SIZE;
+	kp.nonce = key + QSMP_DUPLEX_SYMMETRIC_KEY_SIZE;
+	kp.info = NULL;
+	kp.infolen = 0;
+	qsc_rcs_initialize(cpr, &kp, encryption);
+}
+
+static void symmetric_ratchet(qsmp_connection_state* cns, const uint8_t* secret, size_t seclen)
+{
+	uint8_t prnd[(QSC_KECCAK_512_RATE * 3)] = { 0 };
+
+	symmetric_ratchet_derive(cns, secret, seclen, prnd);
+	/* initialize for decryption, and raise rx */
+	symmetric_ratchet_key(&cns->rxcpr, prnd + symmetric_ratchet_rxpos(cns), false);
+	/* initialize for encryption, and raise tx */
+	symmetric_ratchet_key(&cns->txcpr, prnd + symmetric_ratchet_txpos(cns), true);
 	/* erase the key array */
 	qsc_memutils_clear(prnd, sizeof(prnd));
 }
 
+static qsmp_errors symmetric_ratchet_acknowledge(qsmp_connection_state* cns)
+{
+	qsmp_packet pkt = { 0 };
+	uint8_t pmsg[QSMP_DUPLEX_MACTAG_SIZE] = { 0 };
+	uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
+	uint8_t spct[QSMP_HEADER_SIZE + QSMP_DUPLEX_MACTAG_SIZE + QSC_SOCKET_TERMINATOR_SIZE] = { 0 };
+	size_t plen;
+
+	/* the acknowledgement is an empty authenticated record, the caller holds the transmit lock */
+	cns->txseq += 1;
+	pkt.pmessage = pmsg;
+	pkt.flag = qsmp_flag_symmetric_ratchet_response;
+	pkt.msglen = QSMP_DUPLEX_MACTAG_SIZE;
+	pkt.sequence = cns->txseq;
+
+	/* serialize the header and add it to the ciphers associated data */
+	qsmp_packet_header_serialize(&pkt, hdr);
+	qsc_rcs_set_associated(&cns->txcpr, hdr, QSMP_HEADER_SIZE);
+	/* append the mac code */
+	qsc_rcs_transform(&cns->txcpr, pkt.pmessage, pmsg, 0);
+	plen = qsmp_packet_to_stream(&pkt, spct);
+
+	return qsmp_connection_send_locked(cns, spct, plen + QSC_SOCKET_TERMINATOR_SIZE);
+}
+
 static bool symmetric_ratchet_response(qsmp_connection_state* cns, const qsmp_packet* packetin)
 {
+	uint8_t prnd[(QSC_KECCAK_512_RATE * 3)] = { 0 };
 	uint8_t rkey[QSMP_RTOK_SIZE] = { 0 };
 	uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
 	size_t mlen;
@@ -215,9 +257,58 @@ static bool symmetric_ratchet_response(qsmp_connection_state* cns, const qsmp_pa
 		/* authenticate then decrypt the data */
 		if (qsc_rcs_transform(&cns->rxcpr, rkey, packetin->pmessage, mlen) == true)
 		{
-			/* inject into key state */
-			symmetric_ratchet(cns, rkey, sizeof(rkey));
-			res = true;
+			/* inject into key state, the ratchet state and transmit cipher are guarded by the send lock */
+			qsmp_connection_transmit_lock(cns);
+			symmetric_ratchet_derive(cns, rkey, sizeof(rkey), prnd);
+
+			/* the peer encrypts under the new key from its request onward */
+			symmetric_ratchet_key(&cns->rxcpr, prnd + symmetric_ratchet_rxpos(cns), false);
+
+			/* acknowledge under the current transmit key, then switch it */
+			if (symmetric_ratchet_acknowledge(cns) == qsmp_error_none)
+			{
+				symmetric_ratchet_key(&cns->txcpr, prnd + symmetric_ratchet_txpos(cns), true);
+				res = true;
+			}
+
+			qsc_async_mutex_unlock(cns->txlock);
+			qsc_memutils_clear(prnd, sizeof(prnd));
+		}
+
+		qsc_memutils_clear(rkey, sizeof(rkey));
+	}
+
+	return res;
+}
+
+static bool symmetric_ratchet_finalize(qsmp_connection_state* cns, const qsmp_packet* packetin)
+{
+	uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
+	bool res;
+
+	res = false;
+	cns->rxseq += 1;
+
+	if (packetin->sequence == cns->rxseq && packetin->msglen == QSMP_DUPLEX_MACTAG_SIZE)
+	{
+		/* serialize the header and add it to the ciphers associated data */
+		qsmp_packet_header_serialize(packetin, hdr);
+		qsc_rcs_set_associated(&cns->rxcpr, hdr, QSMP_HEADER_SIZE);
+
+		/* the acknowledgement is the last record under the previous receive key */
+		if (qsc_rcs_transform(&cns->rxcpr, hdr, packetin->pmessage, 0) == true)
+		{
+			qsc_async_mutex_lock_counted(cns->txlock, &cns->txstats);
+
+			if (cns->rtpend == true)
+			{
+				symmetric_ratchet_key(&cns->rxcpr, cns->rtrx, false);
+				qsc_memutils_clear(cns->rtrx, sizeof(cns->rtrx));
+				cns->rtpend = false;
+				res = true;
+			}
+
+			qsc_async_mutex_unlock(cns->txlock);
 		}
 	}
 
@@ -265,7 +356,7 @@ static bool asymmetric_ratchet_response(qsmp_connection_state* cns, const qsmp_p
 					uint8_t mtmp[QSMP_ASYMMETRIC_SIGNATURE_SIZE + QSMP_SIMPLEX_HASH_SIZE + QSMP_ASYMMETRIC_CIPHER_TEXT_SIZE] = { 0 };					
 					uint8_t khash[QSMP_SIMPLEX_HASH_SIZE] = { 0 };
 					uint8_t secret[QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE] = { 0 };
-					size_t slen;
+					qsmp_errors qerr;
 
 					mlen = QSMP_ASYMMETRIC_SIGNATURE_SIZE + QSMP_SIMPLEX_HASH_SIZE;
 
@@ -280,6 +371,7 @@ static bool asymmetric_ratchet_response(qsmp_connection_state* cns, const qsmp_p
 					qsmp_signature_sign(mtmp, &mlen, khash, sizeof(khash), m_sigkeys.sigkey, qsc_acp_generate);
 
 					/* create the outbound packet */
+					qsmp_connection_transmit_lock(cns);
 					cns->txseq += 1;
 					pkt.flag = qsmp_flag_asymmetric_ratchet_response;
 					pkt.msglen = QSMP_ASYMMETRIC_RATCHET_RESPONSE_MESSAGE_SIZE;
@@ -294,15 +386,17 @@ static bool asymmetric_ratchet_response(qsmp_connection_state* cns, const qsmp_p
 					qsc_rcs_transform(&cns->txcpr, omsg + QSMP_HEADER_SIZE, mtmp, sizeof(mtmp));
 					mlen += QSMP_DUPLEX_MACTAG_SIZE;
 
-					/* send the encrypted message */
-					slen = qsc_socket_send(&cns->target, omsg, mlen, qsc_socket_send_flag_none);
+					/* send the encrypted message, in order behind any queued records */
+					qerr = qsmp_connection_send_locked(cns, omsg, mlen + QSC_SOCKET_TERMINATOR_SIZE);
 					
-					if (slen == mlen + QSC_SOCKET_TERMINATOR_SIZE)
+					if (qerr == qsmp_error_none)
 					{
 						/* pass the secret to the symmetric ratchet */
 						symmetric_ratchet(cns, secret, sizeof(secret));
 						res = true;
 					}
+
+					qsc_async_mutex_unlock(cns->txlock);
 				}
 			}
 		}
@@ -354,7 +448,9 @@ static bool asymmetric_ratchet_finalize(qsmp_connection_state* cns, const qsmp_p
 					if (res == true)
 					{
 						/* pass the secret to the symmetric ratchet */
+						qsmp_connection_transmit_lock(cns);
 						symmetric_ratchet(cns, secret, sizeof(secret));
+						qsc_async_mutex_unlock(cns->txlock);
 					}
 
 					qsc_memutils_clear(m_cprkeys.prikey, QSMP_ASYMMETRIC_PRIVATE_KEY_SIZE);
@@ -368,528 +464,250 @@ static bool asymmetric_ratchet_finalize(qsmp_connection_state* cns, const qsmp_p
 }
 #endif
 
-static void client_receive_loop(client_receiver_state* prcv)
+static qsmp_errors connection_ratchet_control(qsmp_connection_state* cns, const qsmp_packet* packetin)
 {
-	assert(prcv != NULL);
-
-	uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
-	qsmp_packet pkt = { 0 };
 	qsmp_errors qerr;
-	size_t mlen;
-	size_t plen;
-	size_t slen;
-	uint8_t* buff;
-	uint8_t* mstr;
 
-	buff = (uint8_t*)qsc_memutils_malloc(QSC_SOCKET_TERMINATOR_SIZE);
-	mstr = (uint8_t*)qsc_memutils_malloc(QSC_SOCKET_TERMINATOR_SIZE);
+	qerr = qsmp_error_none;
 
-	if (buff != NULL && mstr != NULL)
+	if (packetin->flag == qsmp_flag_symmetric_ratchet_request)
 	{
-		while (prcv->pcns->target.connection_status == qsc_socket_state_connected)
+		if (symmetric_ratchet_response(cns, packetin) == false)
 		{
-			mlen = 0;
-			slen = 0;
-			plen = qsc_socket_peek(&prcv->pcns->target, hdr, sizeof(hdr));
-
-			if (plen == sizeof(hdr))
-			{
-				qsmp_packet_header_deserialize(hdr, &pkt);
-
-				if (pkt.msglen > 0 && pkt.msglen <= QSMP_MESSAGE_MAX)
-				{
-					plen = pkt.msglen + QSMP_HEADER_SIZE + (QSC_SOCKET_TERMINATOR_SIZE * 2);
-					buff = (uint8_t*)qsc_memutils_realloc(buff, plen);
-				}
-
-				if (buff != NULL)
-				{
-					qsc_memutils_clear(buff, plen);
-					mlen = qsc_socket_receive(&prcv->pcns->target, buff, plen, qsc_socket_receive_flag_none);
-				}
-				else
-				{
-					/* close the connection on memory allocation failure */
-					qsmp_log_write(qsmp_messages_allocate_fail, (const char*)prcv->pcns->target.address);
-					qsmp_connection_close(prcv->pcns, qsmp_messages_allocate_fail, true);
-					break;
-				}
-			}
-
-			if (mlen > 0)
-			{
-				pkt.pmessage = buff + QSMP_HEADER_SIZE;
-
-				if (pkt.flag == qsmp_flag_encrypted_message)
-				{
-					slen = pkt.msglen + QSC_SOCKET_TERMINATOR_SIZE;
-					mstr = (uint8_t*)qsc_memutils_realloc(mstr, slen);
-
-					if (mstr != NULL)
-					{
-						qsc_memutils_clear(mstr, slen);
-						qerr = qsmp_decrypt_packet(prcv->pcns, mstr, &mlen, &pkt);
-
-						if (qerr == qsmp_error_none)
-						{
-							prcv->callback(prcv->pcns, mstr, mlen);
-						}
-						else
-						{
-							/* close the connection on authentication failure */
-							qsmp_log_write(qsmp_messages_decryption_fail, (const char*)prcv->pcns->target.address);
-							qsmp_connection_close(prcv->pcns, qsmp_error_authentication_failure, true);
-							break;
-						}
-					}
-					else
-					{
-						/* close the connection on memory allocation failure */
-						qsmp_log_write(qsmp_messages_allocate_fail, (const char*)prcv->pcns->target.address);
-						qsmp_connection_close(prcv->pcns, qsmp_messages_allocate_fail, true);
-						break;
-					}
-				}
-				else if (pkt.flag == qsmp_flag_connection_terminate)
-				{
-					qsmp_log_write(qsmp_messages_disconnect, (const char*)prcv->pcns->target.address);
-					qsmp_connection_close(prcv->pcns, qsmp_error_none, false);
-					break;
-				}
-				else if (pkt.flag == qsmp_flag_keep_alive_request)
-				{
-					const size_t klen = QSMP_HEADER_SIZE + sizeof(uint64_t) + QSC_SOCKET_TERMINATOR_SIZE;
-					/* copy the keep-alive packet and send it back */
-					pkt.flag = qsmp_flag_keep_alive_response;
-					qsmp_packet_header_serialize(&pkt, buff);
-					qsc_socket_send(&prcv->pcns->target, buff, klen, qsc_socket_send_flag_none);
-				}
-				else if (pkt.flag == qsmp_flag_symmetric_ratchet_request)
-				{
-					if (symmetric_ratchet_response(prcv->pcns, &pkt) == false)
-					{
-						qsmp_log_write(qsmp_messages_keepalive_timeout, (const char*)prcv->pcns->target.address);
-						qsmp_connection_close(prcv->pcns, qsmp_error_keychain_fail, true);
-						break;
-					}
-				}
+			qerr = qsmp_error_keychain_fail;
+		}
+	}
+	else if (packetin->flag == qsmp_flag_symmetric_ratchet_response)
+	{
+		if (symmetric_ratchet_finalize(cns, packetin) == false)
+		{
+			qerr = qsmp_error_keychain_fail;
+		}
+	}
 #if defined(QSMP_ASYMMETRIC_RATCHET)
-				else if (pkt.flag == qsmp_flag_asymmetric_ratchet_request)
-				{
-					if (asymmetric_ratchet_response(prcv->pcns, &pkt) == false)
-					{
-						qsmp_log_write(qsmp_messages_keepalive_timeout, (const char*)prcv->pcns->target.address);
-						qsmp_connection_close(prcv->pcns, qsmp_error_keychain_fail, true);
-						break;
-					}
-				}
-				else if (pkt.flag == qsmp_flag_asymmetric_ratchet_response)
-				{
-					if (asymmetric_ratchet_finalize(prcv->pcns, &pkt) == false)
-					{
-						qsmp_log_write(qsmp_messages_keepalive_timeout, (const char*)prcv->pcns->target.address);
-						qsmp_connection_close(prcv->pcns, qsmp_error_keychain_fail, true);
-						break;
-					}
-				}
-#endif
-				else
-				{
-					qsc_socket_exceptions err = qsc_socket_get_last_error();
-
-					if (err != qsc_socket_exception_success)
-					{
-						qsmp_log_error(qsmp_messages_receive_fail, err, prcv->pcns->target.address);
-
-						/* fatal socket errors */
-						if (err == qsc_socket_exception_circuit_reset ||
-							err == qsc_socket_exception_circuit_terminated ||
-							err == qsc_socket_exception_circuit_timeout ||
-							err == qsc_socket_exception_dropped_connection ||
-							err == qsc_socket_exception_network_failure ||
-							err == qsc_socket_exception_shut_down)
-						{
-							qsmp_log_write(qsmp_messages_connection_fail, (const char*)prcv->pcns->target.address);
-							qsmp_connection_close(prcv->pcns, qsmp_error_channel_down, false);
-							break;
-						}
-					}
-				}
-			}
-			else
-			{
-				if (qsc_socket_is_connected(&prcv->pcns->target) == false)
-				{
-					break;
-				}
-			}
+	else if (packetin->flag == qsmp_flag_asymmetric_ratchet_request)
+	{
+		if (asymmetric_ratchet_response(cns, packetin) == false)
+		{
+			qerr = qsmp_error_keychain_fail;
+		}
+	}
+	else if (packetin->flag == qsmp_flag_asymmetric_ratchet_response)
+	{
+		if (asymmetric_ratchet_finalize(cns, packetin) == false)
+		{
+			qerr = qsmp_error_keychain_fail;
 		}
 	}
+#endif
 	else
 	{
-		/* close the connection on memory allocation failure */
-		qsmp_log_write(qsmp_messages_allocate_fail, (const char*)prcv->pcns->target.address);
-		qsmp_connection_close(prcv->pcns, qsmp_messages_allocate_fail, true);
+		qerr = qsmp_error_invalid_request;
 	}
 
-	/* dispose of resources */
-	qsmp_connection_state_dispose(prcv->pcns);
-
-	if (buff != NULL)
+	if (qerr == qsmp_error_keychain_fail)
 	{
-		qsc_memutils_alloc_free(buff);
-		buff = NULL;
+		qsmp_log_write(qsmp_messages_keepalive_timeout, (const char*)cns->target.address);
 	}
 
-	if (mstr != NULL)
+	return qerr;
+}
+
+static qsmp_errors client_receive_control(qsmp_connection_state* cns, const qsmp_packet* packetin)
+{
+	qsmp_errors qerr;
+
+	if (packetin->flag == qsmp_flag_keep_alive_request && packetin->msglen == sizeof(uint64_t))
+	{
+		uint8_t kbuf[QSMP_HEADER_SIZE + sizeof(uint64_t) + QSC_SOCKET_TERMINATOR_SIZE] = { 0 };
+		qsmp_packet pkt;
+
+		/* copy the keep-alive packet and send it back, in order behind any queued records */
+		pkt = *packetin;
+		pkt.flag = qsmp_flag_keep_alive_response;
+		qsmp_packet_header_serialize(&pkt, kbuf);
+		qsc_memutils_copy(kbuf + QSMP_HEADER_SIZE, pkt.pmessage, sizeof(uint64_t));
+		qsc_async_mutex_lock_counted(cns->txlock, &cns->txstats);
+		qsmp_connection_send_locked(cns, kbuf, sizeof(kbuf));
+		qsc_async_mutex_unlock(cns->txlock);
+		qerr = qsmp_error_none;
+	}
+	else
 	{
-		qsc_memutils_alloc_free(mstr);
-		mstr = NULL;
+		qerr = connection_ratchet_control(cns, packetin);
 	}
 
-	if (prcv != NULL)
+	return qerr;
+}
+
+static qsmp_errors listener_receive_control(qsmp_connection_state* cns, const qsmp_packet* packetin)
+{
+	qsmp_errors qerr;
+
+	if (packetin->flag == qsmp_flag_keep_alive_response)
 	{
-		if (prcv->pcns != NULL)
+		/* test the keepalive */
+		if (qsmp_connection_keepalive_response(cns, packetin) == qsmp_error_none)
 		{
-			qsc_memutils_alloc_free(prcv->pcns);
-			prcv->pcns = NULL;
+			qerr = qsmp_error_none;
 		}
-
-		prcv->callback = NULL;
-		qsc_memutils_alloc_free(prcv);
-		prcv = NULL;
+		else
+		{
+			qsmp_log_write(qsmp_messages_keepalive_fail, (const char*)cns->target.address);
+			qerr = qsmp_error_bad_keep_alive;
+		}
+	}
+	else
+	{
+		qerr = connection_ratchet_control(cns, packetin);
 	}
+
+	return qerr;
 }
 
-static qsmp_errors listener_send_keep_alive(qsmp_keep_alive_state* kctx, const qsc_socket* sock)
+static void connection_receive_loop(qsmp_connection_state* cns, void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t),
+	qsmp_errors (*control_callback)(qsmp_connection_state*, const qsmp_packet*))
 {
-	assert(kctx != NULL);
-	assert(sock != NULL);
-
+	qsc_socket_exceptions err;
 	qsmp_errors qerr;
+	size_t plen;
 
-	qerr = qsmp_error_bad_keep_alive;
+	qerr = qsmp_error_none;
 
-	if (qsc_socket_is_connected(sock) == true)
+	while (cns->target.connection_status == qsc_socket_state_connected && qerr == qsmp_error_none)
 	{
-		uint8_t mresp[QSMP_MESSAGE_MAX] = { 0 };
-		uint8_t spct[QSMP_MESSAGE_MAX] = { 0 };
-		qsmp_packet resp = { 0 };
-		uint64_t etime;
-		size_t plen;
-		size_t slen;
+		/* read as much of the stream as is available, and process every complete record */
+		plen = qsmp_record_buffer_receive(&cns->rxbuf, &cns->target);
 
-		/* set the time and store in keep-alive struct */
-		etime = qsc_timestamp_epochtime_seconds();
-		kctx->etime = etime;
-
-		/* assemble the keep-alive packet */
-		resp.pmessage = mresp;
-		resp.flag = qsmp_flag_keep_alive_request;
-		resp.sequence = kctx->seqctr;
-		resp.msglen = sizeof(etime);
-		qsc_intutils_le64to8(resp.pmessage, etime);
-		plen = qsmp_packet_to_stream(&resp, spct);
-		slen = qsc_socket_send(sock, spct, plen, qsc_socket_send_flag_none);
+		if (plen > 0)
+		{
+			qerr = qsmp_connection_dispatch(cns, receive_callback, control_callback);
 
-		if (slen >= plen)
+			if (qerr == qsmp_error_channel_down)
+			{
+				/* the remote host terminated the session */
+				qsmp_connection_close(cns, qsmp_error_none, false);
+			}
+			else if (qerr != qsmp_error_none)
+			{
+				qsmp_connection_close(cns, qerr, true);
+			}
+		}
+		else
 		{
-			qerr = qsmp_error_none;
+			err = qsc_socket_get_last_error();
+
+			/* fatal socket errors */
+			if (err == qsc_socket_exception_circuit_reset ||
+				err == qsc_socket_exception_circuit_terminated ||
+				err == qsc_socket_exception_circuit_timeout ||
+				err == qsc_socket_exception_dropped_connection ||
+				err == qsc_socket_exception_network_failure ||
+				err == qsc_socket_exception_shut_down)
+			{
+				qsmp_log_error(qsmp_messages_receive_fail, err, (const char*)cns->target.address);
+				qsmp_log_write(qsmp_messages_connection_fail, (const char*)cns->target.address);
+			}
+
+			/* a blocking receive that returns no data has been closed by the remote host */
+			qsmp_connection_close(cns, qsmp_error_channel_down, false);
+			qerr = qsmp_error_channel_down;
 		}
 	}
-
-	return qerr;
 }
 
-static void listener_keepalive_loop(qsmp_keep_alive_state* kpa)
+static void client_receive_loop(client_receiver_state* prcv)
 {
-	assert(kpa != NULL);
+	assert(prcv != NULL);
+
+	connection_receive_loop(prcv->pcns, prcv->callback, &client_receive_control);
+}
 
-	qsc_mutex mtx;
+static uint32_t listener_keepalive_timer(void* state)
+{
+	qsmp_connection_state* cns;
 	qsmp_errors qerr;
+	uint32_t ival;
+
+	cns = (qsmp_connection_state*)state;
+	ival = 0;
 
-	do
+	if (qsc_socket_is_connected(&cns->target) == true)
 	{
-		mtx = qsc_async_mutex_lock_ex();
-		kpa->recd = false;
-		qerr = listener_send_keep_alive(kpa, &kpa->target);
+		/* a request is sent each period, the session ends if the last request was not answered */
+		qerr = qsmp_connection_keepalive_request(cns);
 
-		if (kpa->recd == false)
+		if (qerr == qsmp_error_none)
+		{
+			ival = QSMP_KEEPALIVE_TIMEOUT;
+		}
+		else
 		{
-			qerr = qsmp_error_keep_alive_expired;
+			qsmp_log_write(qsmp_messages_keepalive_timeout, (const char*)cns->target.address);
+			/* the receive loop sees the shut down and closes the connection */
+			qsc_socket_shut_down_channels(&cns->target, qsc_socket_shut_down_flag_both);
 		}
+	}
 
-		qsc_async_mutex_unlock_ex(mtx);
-		qsc_async_thread_sleep(QSMP_KEEPALIVE_TIMEOUT);
-	} 
-	while (qerr == qsmp_error_none);
+	return ival;
 }
 
 static void listener_receive_loop(listener_receiver_state* prcv)
 {
 	assert(prcv != NULL);
 
-	qsmp_packet pkt = { 0 };
-	uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
+	connection_receive_loop(prcv->pcns, prcv->callback, &listener_receive_control);
+}
+
+static qsmp_errors listener_duplex_start(const qsmp_server_signature_key* kset, 
+	listener_receiver_state* prcv, 
+	void (*send_func)(qsmp_connection_state*),
+	bool (*key_query)(uint8_t* rvkey, const uint8_t* pkid))
+{
+	assert(kset != NULL);
+	assert(prcv != NULL);
+	assert(send_func != NULL);
+
+	qsmp_kex_duplex_server_state* pkss;
 	qsmp_errors qerr;
-	size_t mlen;
-	size_t plen;
-	size_t slen;
-	uint8_t* buff;
-	uint8_t* mstr;
+	qsc_thread rthd;
 
-	buff = (uint8_t*)qsc_memutils_malloc(QSC_SOCKET_TERMINATOR_SIZE);
-	mstr = (uint8_t*)qsc_memutils_malloc(QSC_SOCKET_TERMINATOR_SIZE);
+	qsmp_logger_initialize(NULL);
+	qerr = qsmp_error_invalid_input;
+	pkss = (qsmp_kex_duplex_server_state*)qsc_memutils_malloc(sizeof(qsmp_kex_duplex_server_state));
 
-	if (buff != NULL && mstr != NULL)
+	if (pkss != NULL)
 	{
-		while (prcv->pcns->target.connection_status == qsc_socket_state_connected)
-		{
-			mlen = 0;
-			slen = 0;
-			plen = qsc_socket_peek(&prcv->pcns->target, hdr, sizeof(hdr));
+		qsc_memutils_clear((uint8_t*)pkss, sizeof(qsmp_kex_duplex_server_state));
+
+		/* initialize the kex */
+		listener_duplex_state_initialize(pkss, prcv, kset, key_query);
+		qerr = qsmp_kex_duplex_server_key_exchange(pkss, prcv->pcns);
 
-			if (plen == sizeof(hdr))
+		if (qerr == qsmp_error_none)
+		{
+#if defined(QSMP_ASYMMETRIC_RATCHET)
+			/* store the local signing key and the remote verify key for asymmetyric ratchet option */
+			qsc_memutils_copy(m_sigkeys.sigkey, kset->sigkey, QSMP_ASYMMETRIC_SIGNING_KEY_SIZE);
+			qsc_memutils_copy(m_sigkeys.verkey, pkss->rverkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
+#endif
+			/* the keep-alive is run by the shared timer service */
+			if (qsmp_timerwheel_start(true) == true)
 			{
-				qsmp_packet_header_deserialize(hdr, &pkt);
+				qsmp_timerwheel_schedule(&prcv->pcns->timer, QSMP_KEEPALIVE_TIMEOUT, &listener_keepalive_timer, prcv->pcns);
+			}
 
-				if (pkt.msglen > 0 && pkt.msglen <= QSMP_MESSAGE_MAX)
-				{
-					plen = pkt.msglen + QSMP_HEADER_SIZE + (QSC_SOCKET_TERMINATOR_SIZE * 2);
-					buff = (uint8_t*)qsc_memutils_realloc(buff, plen);
-				}
-
-				if (buff != NULL)
-				{
-					qsc_memutils_clear(buff, plen);
-					mlen = qsc_socket_receive(&prcv->pcns->target, buff, plen, qsc_socket_receive_flag_none);
-				}
-				else
-				{
-					/* close the connection on memory allocation failure */
-					qsmp_log_write(qsmp_messages_allocate_fail, (const char*)prcv->pcns->target.address);
-					qsmp_connection_close(prcv->pcns, qsmp_messages_allocate_fail, true);
-					break;
-				}
-			}
-
-			if (mlen > 0)
-			{
-				pkt.pmessage = buff + QSMP_HEADER_SIZE;
-
-				if (pkt.flag == qsmp_flag_encrypted_message)
-				{
-					slen = pkt.msglen + QSC_SOCKET_TERMINATOR_SIZE;
-					mstr = (uint8_t*)qsc_memutils_realloc(mstr, slen);
-
-					if (mstr != NULL)
-					{
-						qsc_memutils_clear(mstr, slen);
-						qerr = qsmp_decrypt_packet(prcv->pcns, mstr, &mlen, &pkt);
-
-						if (qerr == qsmp_error_none)
-						{
-							prcv->callback(prcv->pcns, mstr, mlen);
-						}
-						else
-						{
-							/* close the connection on authentication failure */
-							qsmp_log_write(qsmp_messages_decryption_fail, (const char*)prcv->pcns->target.address);
-							qsmp_connection_close(prcv->pcns, qsmp_error_authentication_failure, true);
-							break;
-						}
-					}
-					else
-					{
-						/* close the connection on memory allocation failure */
-						qsmp_log_write(qsmp_messages_allocate_fail, (const char*)prcv->pcns->target.address);
-						qsmp_connection_close(prcv->pcns, qsmp_messages_allocate_fail, true);
-						break;
-					}
-				}
-				else if (pkt.flag == qsmp_flag_connection_terminate)
-				{
-					qsmp_log_write(qsmp_messages_disconnect, (const char*)prcv->pcns->target.address);
-					qsmp_connection_close(prcv->pcns, qsmp_error_none, false);
-					break;
-				}
-				else if (pkt.flag == qsmp_flag_keep_alive_response)
-				{
-					/* test the keepalive */
-
-					if (pkt.sequence == prcv->pkpa->seqctr)
-					{
-						uint64_t tme;
-
-						tme = qsc_intutils_le8to64(pkt.pmessage);
-
-						if (prcv->pkpa->etime == tme)
-						{
-							prcv->pkpa->seqctr += 1;
-							prcv->pkpa->recd = true;
-						}
-						else
-						{
-							qsmp_log_write(qsmp_messages_keepalive_fail, (const char*)prcv->pcns->target.address);
-							qsmp_connection_close(prcv->pcns, qsmp_error_bad_keep_alive, true);
-							break;
-						}
-					}
-					else
-					{
-						qsmp_log_write(qsmp_messages_keepalive_timeout, (const char*)prcv->pcns->target.address);
-						qsmp_connection_close(prcv->pcns, qsmp_error_bad_keep_alive, true);
-						break;
-					}
-				}
-				else if (pkt.flag == qsmp_flag_symmetric_ratchet_request)
-				{
-					if (symmetric_ratchet_response(prcv->pcns, &pkt) == false)
-					{
-						qsmp_log_write(qsmp_messages_keepalive_timeout, (const char*)prcv->pcns->target.address);
-						qsmp_connection_close(prcv->pcns, qsmp_error_authentication_failure, true);
-						break;
-					}
-				}
-#if defined(QSMP_ASYMMETRIC_RATCHET)
-				else if (pkt.flag == qsmp_flag_asymmetric_ratchet_request)
-				{
-					if (asymmetric_ratchet_response(prcv->pcns, &pkt) == false)
-					{
-						qsmp_log_write(qsmp_messages_keepalive_timeout, (const char*)prcv->pcns->target.address);
-						qsmp_connection_close(prcv->pcns, qsmp_error_keychain_fail, true);
-						break;
-					}
-				}
-				else if (pkt.flag == qsmp_flag_asymmetric_ratchet_response)
-				{
-					if (asymmetric_ratchet_finalize(prcv->pcns, &pkt) == false)
-					{
-						qsmp_log_write(qsmp_messages_keepalive_timeout, (const char*)prcv->pcns->target.address);
-						qsmp_connection_close(prcv->pcns, qsmp_error_keychain_fail, true);
-						break;
-					}
-				}
-#endif
-				else
-				{
-					qsc_socket_exceptions err = qsc_socket_get_last_error();
-
-					if (err != qsc_socket_exception_success)
-					{
-						qsmp_log_error(qsmp_messages_receive_fail, err, prcv->pcns->target.address);
-
-						/* fatal socket errors */
-						if (err == qsc_socket_exception_circuit_reset ||
-							err == qsc_socket_exception_circuit_terminated ||
-							err == qsc_socket_exception_circuit_timeout ||
-							err == qsc_socket_exception_dropped_connection ||
-							err == qsc_socket_exception_network_failure ||
-							err == qsc_socket_exception_shut_down)
-						{
-							qsmp_log_write(qsmp_messages_connection_fail, (const char*)prcv->pcns->target.address);
-							qsmp_connection_close(prcv->pcns, qsmp_error_channel_down, false);
-							break;
-						}
-					}
-				}
-			}
-			else
-			{
-				if (qsc_socket_is_connected(&prcv->pcns->target) == false)
-				{
-					break;
-				}
-			}
-		}
-	}
-	else
-	{
-		/* close the connection on memory allocation failure */
-		qsmp_log_write(qsmp_messages_allocate_fail, (const char*)prcv->pcns->target.address);
-		qsmp_connection_close(prcv->pcns, qsmp_messages_allocate_fail, true);
-	}
-
-	/* dispose of resources */
-	qsmp_connection_state_dispose(prcv->pcns);
-	
-	if (buff != NULL)
-	{
-		qsc_memutils_alloc_free(buff);
-		buff = NULL;
-	}
-
-	if (mstr != NULL)
-	{
-		qsc_memutils_alloc_free(mstr);
-		mstr = NULL;
-	}
-
-	if (prcv != NULL)
-	{
-		if (prcv->pcns != NULL)
-		{
-			qsc_memutils_alloc_free(prcv->pcns);
-			prcv->pcns = NULL;
-		}
-
-		if (prcv->pkpa != NULL)
-		{
-			qsc_memutils_alloc_free(prcv->pkpa);
-			prcv->pkpa = NULL;
-		}
-
-		if (prcv->callback != NULL)
-		{
-			prcv->callback = NULL;
-		}
-
-		if (prcv != NULL)
-		{
-			qsc_memutils_alloc_free(prcv);
-			prcv = NULL;
-		}
-	}
-}
-
-static qsmp_errors listener_duplex_start(const qsmp_server_signature_key* kset, 
-	listener_receiver_state* prcv, 
-	void (*send_func)(qsmp_connection_state*),
-	bool (*key_query)(uint8_t* rvkey, const uint8_t* pkid))
-{
-	assert(kset != NULL);
-	assert(prcv != NULL);
-	assert(send_func != NULL);
-
-	qsmp_kex_duplex_server_state* pkss;
-	qsmp_errors qerr;
-
-	qsmp_logger_initialize(NULL);
-	qerr = qsmp_error_invalid_input;
-	pkss = (qsmp_kex_duplex_server_state*)qsc_memutils_malloc(sizeof(qsmp_kex_duplex_server_state));
-
-	if (pkss != NULL)
-	{
-		qsc_memutils_clear((uint8_t*)pkss, sizeof(qsmp_kex_duplex_server_state));
-
-		/* initialize the kex */
-		listener_duplex_state_initialize(pkss, prcv, kset, key_query);
-		qerr = qsmp_kex_duplex_server_key_exchange(pkss, prcv->pcns);
-
-		if (qerr == qsmp_error_none)
-		{
-#if defined(QSMP_ASYMMETRIC_RATCHET)
-			/* store the local signing key and the remote verify key for asymmetyric ratchet option */
-			qsc_memutils_copy(m_sigkeys.sigkey, kset->sigkey, QSMP_ASYMMETRIC_SIGNING_KEY_SIZE);
-			qsc_memutils_copy(m_sigkeys.verkey, pkss->rverkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
-#endif
-			/* start the keep-alive mechanism on a new thread */
-			qsc_async_thread_create((void*)&listener_keepalive_loop, prcv->pkpa);
-			/* initialize the receiver loop on a new thread */
-			qsc_async_thread_create((void*)&listener_receive_loop, prcv);
+			/* initialize the receiver loop on a new thread */
+			rthd = qsc_async_thread_create((void*)&listener_receive_loop, prcv);
 
 			/* start the send loop on the *main* thread */
 			send_func(prcv->pcns);
+
+			/* close the connection, and wait for the receive loop to exit */
+			qsmp_connection_close(prcv->pcns, qsmp_error_none, true);
+			qsc_async_thread_wait(rthd);
+			qsmp_timerwheel_cancel(&prcv->pcns->timer);
+			qsmp_timerwheel_stop();
 		}
 
 		qsc_memutils_alloc_free(pkss);
@@ -909,6 +727,7 @@ static qsmp_errors listener_simplex_start(const qsmp_server_signature_key* kset,
 
 	qsmp_kex_simplex_server_state* pkss;
 	qsmp_errors qerr;
+	qsc_thread rthd;
 
 	qsmp_logger_initialize(NULL);
 	qerr = qsmp_error_invalid_input;
@@ -927,15 +746,23 @@ static qsmp_errors listener_simplex_start(const qsmp_server_signature_key* kset,
 
 		if (qerr == qsmp_error_none)
 		{
-			/* start the keep-alive mechanism on a new thread */
-			qsc_async_thread_create((void*)&listener_keepalive_loop, prcv->pkpa);
+			/* the keep-alive is run by the shared timer service */
+			if (qsmp_timerwheel_start(true) == true)
+			{
+				qsmp_timerwheel_schedule(&prcv->pcns->timer, QSMP_KEEPALIVE_TIMEOUT, &listener_keepalive_timer, prcv->pcns);
+			}
+
 			/* initialize the receiver loop on a new thread */
-			qsc_async_thread_create((void*)&listener_receive_loop, prcv);
+			rthd = qsc_async_thread_create((void*)&listener_receive_loop, prcv);
 
 			/* start the send loop on the *main* thread */
 			send_func(prcv->pcns);
 
+			/* close the connection, and wait for the receive loop to exit */
 			qsmp_connection_close(prcv->pcns, qsmp_error_none, true);
+			qsc_async_thread_wait(rthd);
+			qsmp_timerwheel_cancel(&prcv->pcns->timer);
+			qsmp_timerwheel_stop();
 		}
 	}
 
@@ -962,8 +789,9 @@ bool qsmp_duplex_send_asymmetric_ratchet_request(qsmp_connection_state* cns)
 		uint8_t spct[QSMP_ASYMMETRIC_RATCHET_REQUEST_PACKET_SIZE] = { 0 };
 		size_t mlen;
 		size_t smlen;
-		size_t slen;
+		qsmp_errors qerr;
 
+		qsmp_connection_transmit_lock(cns);
 		cns->txseq += 1;
 		pkt.pmessage = spct + QSMP_HEADER_SIZE;
 		pkt.flag = qsmp_flag_asymmetric_ratchet_request;
@@ -993,10 +821,11 @@ bool qsmp_duplex_send_asymmetric_ratchet_request(qsmp_connection_state* cns)
 		qsc_rcs_transform(&cns->txcpr, pkt.pmessage, pmsg, sizeof(pmsg));
 		mlen += QSMP_DUPLEX_MACTAG_SIZE;
 
-		/* send the ratchet request */
-		slen = qsc_socket_send(&cns->target, spct, mlen, qsc_socket_send_flag_none);
+		/* send the ratchet request, in order behind any queued records */
+		qerr = qsmp_connection_send_locked(cns, spct, mlen + QSC_SOCKET_TERMINATOR_SIZE);
+		qsc_async_mutex_unlock(cns->txlock);
 
-		if (slen == mlen + QSC_SOCKET_TERMINATOR_SIZE)
+		if (qerr == qsmp_error_none)
 		{
 			res = true;
 		}
@@ -1012,7 +841,7 @@ bool qsmp_duplex_send_symmetric_ratchet_request(qsmp_connection_state* cns)
 	assert(cns->mode == qsmp_mode_duplex);
 
 	size_t plen;
-	size_t slen;
+	qsmp_errors qerr;
 	bool res;
 	
 	res = false;
@@ -1029,40 +858,150 @@ bool qsmp_duplex_send_symmetric_ratchet_request(qsmp_connection_state* cns)
 			uint8_t hdr[QSMP_HEADER_SIZE] = { 0 };
 			uint8_t spct[QSMP_HEADER_SIZE + QSMP_RTOK_SIZE + QSMP_DUPLEX_MACTAG_SIZE + QSC_SOCKET_TERMINATOR_SIZE] = { 0 };
 
-			cns->txseq += 1;
-			pkt.pmessage = pmsg;
-			pkt.flag = qsmp_flag_symmetric_ratchet_request;
-			pkt.msglen = QSMP_RTOK_SIZE + QSMP_DUPLEX_MACTAG_SIZE;
-			pkt.sequence = cns->txseq;
+			qsmp_connection_transmit_lock(cns);
 
-			/* serialize the header and add it to the ciphers associated data */
-			qsmp_packet_header_serialize(&pkt, hdr);
-			qsc_rcs_set_associated(&cns->txcpr, hdr, QSMP_HEADER_SIZE);
-			/* encrypt the message */
-			qsc_rcs_transform(&cns->txcpr, pkt.pmessage, rkey, sizeof(rkey));
+			/* one ratchet is in flight at a time */
+			if (cns->rtpend == false)
+			{
+				cns->txseq += 1;
+				pkt.pmessage = pmsg;
+				pkt.flag = qsmp_flag_symmetric_ratchet_request;
+				pkt.msglen = QSMP_RTOK_SIZE + QSMP_DUPLEX_MACTAG_SIZE;
+				pkt.sequence = cns->txseq;
 
-			/* convert the packet to bytes */
-			plen = qsmp_packet_to_stream(&pkt, spct);
+				/* serialize the header and add it to the ciphers associated data */
+				qsmp_packet_header_serialize(&pkt, hdr);
+				qsc_rcs_set_associated(&cns->txcpr, hdr, QSMP_HEADER_SIZE);
+				/* encrypt the message */
+				qsc_rcs_transform(&cns->txcpr, pkt.pmessage, rkey, sizeof(rkey));
 
-			/* send the ratchet request */
-			slen = qsc_socket_send(&cns->target, spct, plen, qsc_socket_send_flag_none);
+				/* convert the packet to bytes */
+				plen = qsmp_packet_to_stream(&pkt, spct);
 
-			if (slen == plen + QSC_SOCKET_TERMINATOR_SIZE)
-			{
-				symmetric_ratchet(cns, rkey, sizeof(rkey));
-				res = true;
+				/* send the ratchet request, in order behind any queued records */
+				qerr = qsmp_connection_send_locked(cns, spct, plen + QSC_SOCKET_TERMINATOR_SIZE);
+
+				if (qerr == qsmp_error_none)
+				{
+					uint8_t prnd[(QSC_KECCAK_512_RATE * 3)] = { 0 };
+
+					/* switch the transmit key now, the receive key is held until the peer acknowledges */
+					symmetric_ratchet_derive(cns, rkey, sizeof(rkey), prnd);
+					symmetric_ratchet_key(&cns->txcpr, prnd + symmetric_ratchet_txpos(cns), true);
+					qsc_memutils_copy(cns->rtrx, prnd + symmetric_ratchet_rxpos(cns), sizeof(cns->rtrx));
+					cns->rtpend = true;
+					qsc_memutils_clear(prnd, sizeof(prnd));
+					res = true;
+				}
 			}
+
+			qsc_async_mutex_unlock(cns->txlock);
 		}
 	}
 
 	return res;
 }
 
+static qsmp_errors client_simplex_fastopen(client_receiver_state* prcv, const qsmp_client_signature_key* pubk, qsmp_fastopen_key* fokey, void (*send_func)(qsmp_connection_state*))
+{
+	qsmp_kex_simplex_client_state* kcs;
+	qsmp_errors qerr;
+	qsc_thread rthd;
+
+	kcs = (qsmp_kex_simplex_client_state*)qsc_memutils_malloc(sizeof(qsmp_kex_simplex_client_state));
+
+	if (kcs != NULL)
+	{
+		qsc_memutils_clear(kcs, sizeof(qsmp_kex_simplex_client_state));
+		client_simplex_state_initialize(kcs, prcv->pcns, pubk);
+		/* send the encapsulation with the request if the cached key is current */
+		qerr = qsmp_kex_simplex_client_fastopen(kcs, fokey, prcv->pcns);
+		qsc_memutils_alloc_free(kcs);
+
+		if (qerr == qsmp_error_none)
+		{
+			/* start the receive loop on a new thread */
+			rthd = qsc_async_thread_create((void*)&client_receive_loop, prcv);
+
+			/* start the send loop on the main thread */
+			send_func(prcv->pcns);
+
+			/* close the connection, and wait for the receive loop to exit */
+			qsmp_connection_close(prcv->pcns, qsmp_error_none, true);
+			qsc_async_thread_wait(rthd);
+		}
+		else
+		{
+			qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
+		}
+	}
+	else
+	{
+		qsmp_log_message(qsmp_messages_allocate_fail);
+		qerr = qsmp_error_memory_allocation;
+	}
+
+	return qerr;
+}
+
+static qsmp_errors client_simplex_resume(client_receiver_state* prcv, const qsmp_session_ticket* ticket, void (*send_func)(qsmp_connection_state*))
+{
+	qsmp_errors qerr;
+	qsc_thread rthd;
+
+	/* present the ticket in place of the asymmetric key exchange */
+	client_resume_state_initialize(prcv->pcns);
+	qerr = qsmp_kex_simplex_client_resume(ticket, prcv->pcns);
+
+	if (qerr == qsmp_error_none)
+	{
+		/* start the receive loop on a new thread */
+		rthd = qsc_async_thread_create((void*)&client_receive_loop, prcv);
+
+		/* start the send loop on the main thread */
+		send_func(prcv->pcns);
+
+		/* close the connection, and wait for the receive loop to exit */
+		qsmp_connection_close(prcv->pcns, qsmp_error_none, true);
+		qsc_async_thread_wait(rthd);
+	}
+	else
+	{
+		qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
+	}
+
+	return qerr;
+}
+
+#if (QSMP_SYMMETRIC_RATCHET_INTERVAL != 0)
+static uint32_t client_ratchet_timer(void* state)
+{
+	qsmp_connection_state* cns;
+	uint32_t ival;
+
+	cns = (qsmp_connection_state*)state;
+	ival = 0;
+
+	/* the session keys are ratcheted on each interval while the connection is up,
+	the timer only sends the request and re-keys the transmit channel, the receive loop
+	switches the receive key when the peer acknowledges; an unacknowledged request skips an interval */
+	if (qsc_socket_is_connected(&cns->target) == true)
+	{
+		if (cns->rtpend == true || qsmp_duplex_send_symmetric_ratchet_request(cns) == true)
+		{
+			ival = QSMP_SYMMETRIC_RATCHET_INTERVAL;
+		}
+	}
+
+	return ival;
+}
+#endif
+
 qsmp_errors qsmp_client_duplex_connect_ipv4(const qsmp_server_signature_key* kset, 
 	const qsmp_client_signature_key* rverkey, 
 	const qsc_ipinfo_ipv4_address* address, uint16_t port,
 	void (*send_func)(qsmp_connection_state*), 
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t))
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
 {
 	assert(kset != NULL);
 	assert(rverkey != NULL);
@@ -1074,6 +1013,7 @@ qsmp_errors qsmp_client_duplex_connect_ipv4(const qsmp_server_signature_key* kse
 	client_receiver_state* prcv;
 	qsc_socket_exceptions serr;
 	qsmp_errors qerr;
+	qsc_thread rthd;
 
 	kcs = NULL;
 	prcv = NULL;
@@ -1096,6 +1036,7 @@ qsmp_errors qsmp_client_duplex_connect_ipv4(const qsmp_server_signature_key* kse
 
 				if (prcv->pcns != NULL)
 				{
+					qsc_memutils_clear(prcv->pcns, sizeof(qsmp_connection_state));
 					prcv->callback = receive_callback;
 					qsc_socket_client_initialize(&prcv->pcns->target);
 
@@ -1116,12 +1057,27 @@ qsmp_errors qsmp_client_duplex_connect_ipv4(const qsmp_server_signature_key* kse
 							/* store the local signing key and the remote verify key for asymmetyric ratchet option */
 							qsc_memutils_copy(m_sigkeys.sigkey, kset->sigkey, QSMP_ASYMMETRIC_SIGNING_KEY_SIZE);
 							qsc_memutils_copy(m_sigkeys.verkey, rverkey->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
+#endif
+#if (QSMP_SYMMETRIC_RATCHET_INTERVAL != 0)
+							/* the key ratchet schedule is run by the shared timer service */
+							if (qsmp_timerwheel_start(true) == true)
+							{
+								qsmp_timerwheel_schedule(&prcv->pcns->timer, QSMP_SYMMETRIC_RATCHET_INTERVAL, &client_ratchet_timer, prcv->pcns);
+							}
 #endif
 							/* start the receive loop on a new thread */
-							qsc_async_thread_create((void*)&client_receive_loop, prcv);
+							rthd = qsc_async_thread_create((void*)&client_receive_loop, prcv);
 
 							/* start the send loop on the main thread */
 							send_func(prcv->pcns);
+
+							/* close the connection, and wait for the receive loop to exit */
+							qsmp_connection_close(prcv->pcns, qsmp_error_none, true);
+							qsc_async_thread_wait(rthd);
+#if (QSMP_SYMMETRIC_RATCHET_INTERVAL != 0)
+							qsmp_timerwheel_cancel(&prcv->pcns->timer);
+							qsmp_timerwheel_stop();
+#endif
 						}
 						else
 						{
@@ -1165,32 +1121,488 @@ qsmp_errors qsmp_client_duplex_connect_ipv4(const qsmp_server_signature_key* kse
 		kcs = NULL;
 	}
 
+	if (prcv != NULL)
+	{
+		if (prcv->pcns != NULL)
+		{
+			qsmp_connection_state_dispose(prcv->pcns);
+			qsc_memutils_alloc_free(prcv->pcns);
+			prcv->pcns = NULL;
+		}
+
+		prcv->callback = NULL;
+		qsc_memutils_alloc_free(prcv);
+		prcv = NULL;
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_client_duplex_connect_ipv6(const qsmp_server_signature_key* kset, const qsmp_client_signature_key* rverkey,
+	const qsc_ipinfo_ipv6_address* address, uint16_t port,
+	void (*send_func)(qsmp_connection_state*),
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
+{
+	assert(kset != NULL);
+	assert(rverkey != NULL);
+	assert(send_func != NULL);
+	assert(send_func != NULL);
+	assert(receive_callback != NULL);
+
+	qsmp_kex_duplex_client_state* kcs;
+	client_receiver_state* prcv;
+	qsc_socket_exceptions serr;
+	qsmp_errors qerr;
+	qsc_thread rthd;
+
+	kcs = NULL;
+	prcv = NULL;
+	qsmp_logger_initialize(NULL);
+
+	if (kset != NULL && rverkey != NULL && address != NULL && send_func != NULL && receive_callback != NULL)
+	{
+		kcs = (qsmp_kex_duplex_client_state*)qsc_memutils_malloc(sizeof(qsmp_kex_duplex_client_state));
+
+		if (kcs != NULL)
+		{
+			prcv = (client_receiver_state*)qsc_memutils_malloc(sizeof(client_receiver_state));
+
+			if (prcv != NULL)
+			{
+				qsc_memutils_clear(kcs, sizeof(qsmp_kex_duplex_client_state));
+				qsc_memutils_clear(prcv, sizeof(client_receiver_state));
+
+				prcv->pcns = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state));
+
+				if (prcv->pcns != NULL)
+				{
+					qsc_memutils_clear(prcv->pcns, sizeof(qsmp_connection_state));
+					prcv->callback = receive_callback;
+					qsc_socket_client_initialize(&prcv->pcns->target);
+
+					serr = qsc_socket_client_connect_ipv6(&prcv->pcns->target, address, port);
+
+					if (serr == qsc_socket_exception_success)
+					{
+						/* initialize the client */
+						client_duplex_state_initialize(kcs, prcv->pcns, kset, rverkey);
+						/* perform the simplex key exchange */
+						qerr = qsmp_kex_duplex_client_key_exchange(kcs, prcv->pcns);
+						qsc_memutils_alloc_free(kcs);
+						kcs = NULL;
+
+						if (qerr == qsmp_error_none)
+						{
+#if defined(QSMP_ASYMMETRIC_RATCHET)
+							/* store the local signing key and the remote verify key for asymmetyric ratchet option */
+							qsc_memutils_copy(m_sigkeys.sigkey, kset->sigkey, QSMP_ASYMMETRIC_SIGNING_KEY_SIZE);
+							qsc_memutils_copy(m_sigkeys.verkey, rverkey->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
+#endif
+
+#if (QSMP_SYMMETRIC_RATCHET_INTERVAL != 0)
+							/* the key ratchet schedule is run by the shared timer service */
+							if (qsmp_timerwheel_start(true) == true)
+							{
+								qsmp_timerwheel_schedule(&prcv->pcns->timer, QSMP_SYMMETRIC_RATCHET_INTERVAL, &client_ratchet_timer, prcv->pcns);
+							}
+#endif
+							/* start the receive loop on a new thread */
+							rthd = qsc_async_thread_create((void*)&client_receive_loop, prcv);
+
+							/* start the send loop on the main thread */
+							send_func(prcv->pcns);
+
+							/* close the connection, and wait for the receive loop to exit */
+							qsmp_connection_close(prcv->pcns, qsmp_error_none, true);
+							qsc_async_thread_wait(rthd);
+#if (QSMP_SYMMETRIC_RATCHET_INTERVAL != 0)
+							qsmp_timerwheel_cancel(&prcv->pcns->timer);
+							qsmp_timerwheel_stop();
+#endif
+						}
+						else
+						{
+							qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
+							qerr = qsmp_error_exchange_failure;
+						}
+					}
+					else
+					{
+						qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
+						qerr = qsmp_error_connection_failure;
+					}
+				}
+				else
+				{
+					qsmp_log_message(qsmp_messages_allocate_fail);
+					qerr = qsmp_error_memory_allocation;
+				}
+			}
+			else
+			{
+				qsmp_log_message(qsmp_messages_allocate_fail);
+				qerr = qsmp_error_memory_allocation;
+			}
+		}
+		else
+		{
+			qsmp_log_message(qsmp_messages_allocate_fail);
+			qerr = qsmp_error_memory_allocation;
+		}
+	}
+	else
+	{
+		qsmp_log_message(qsmp_messages_invalid_request);
+		qerr = qsmp_error_invalid_input;
+	}
+
+	if (kcs != NULL)
+	{
+		qsc_memutils_alloc_free(kcs);
+		kcs = NULL;
+	}
+
+	if (prcv != NULL)
+	{
+		if (prcv->pcns != NULL)
+		{
+			qsmp_connection_state_dispose(prcv->pcns);
+			qsc_memutils_alloc_free(prcv->pcns);
+			prcv->pcns = NULL;
+		}
+
+		prcv->callback = NULL;
+		qsc_memutils_alloc_free(prcv);
+		prcv = NULL;
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_client_duplex_listen_ipv4(const qsmp_server_signature_key* kset, 
+	void (*send_func)(qsmp_connection_state*), 
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t), 
+	bool (*key_query)(uint8_t* rvkey, const uint8_t* pkid))
+{
+	assert(kset != NULL);
+	assert(send_func != NULL);
+	assert(receive_callback != NULL);
+
+	qsc_ipinfo_ipv4_address addt = { 0 };
+	listener_receiver_state* prcv;
+	qsc_socket srvs;
+	qsc_socket_exceptions serr;
+	qsmp_errors qerr;
+
+	qsmp_logger_initialize(NULL);
+	prcv = NULL;
+
+	if (kset != NULL && send_func != NULL && receive_callback != NULL)
+	{
+		prcv = (listener_receiver_state*)qsc_memutils_malloc(sizeof(listener_receiver_state));
+
+		if (prcv != NULL)
+		{
+			prcv->pcns = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state));
+
+			if (prcv->pcns != NULL)
+			{
+				prcv->callback = receive_callback;
+				qsc_memutils_clear((uint8_t*)prcv->pcns, sizeof(qsmp_connection_state));
+
+				addt = qsc_ipinfo_ipv4_address_any();
+				qsc_socket_server_initialize(&prcv->pcns->target);
+				qsc_socket_server_initialize(&srvs);
+
+				serr = qsc_socket_server_listen_ipv4(&srvs, &prcv->pcns->target, &addt, QSMP_CLIENT_PORT);
+
+				if (serr == qsc_socket_exception_success)
+				{
+					qerr = listener_duplex_start(kset, prcv, send_func, key_query);
+				}
+				else
+				{
+					qsmp_log_message(qsmp_messages_connection_fail);
+					qerr = qsmp_error_connection_failure;
+				}
+			}
+			else
+			{
+				/* release a partial allocation before the state is disposed */
+				if (prcv->pcns != NULL)
+				{
+					qsc_memutils_alloc_free(prcv->pcns);
+					prcv->pcns = NULL;
+				}
+
+				qsmp_log_message(qsmp_messages_allocate_fail);
+				qerr = qsmp_error_memory_allocation;
+			}
+		}
+		else
+		{
+			qsmp_log_message(qsmp_messages_allocate_fail);
+			qerr = qsmp_error_memory_allocation;
+		}
+	}
+	else
+	{
+		qsmp_log_message(qsmp_messages_invalid_request);
+		qerr = qsmp_error_invalid_input;
+	}
+
+	if (prcv != NULL)
+	{
+		if (prcv->pcns != NULL)
+		{
+			qsmp_connection_state_dispose(prcv->pcns);
+			qsc_memutils_alloc_free(prcv->pcns);
+			prcv->pcns = NULL;
+		}
+
+		prcv->callback = NULL;
+		qsc_memutils_alloc_free(prcv);
+		prcv = NULL;
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_client_duplex_listen_ipv6(const qsmp_server_signature_key* kset, 
+	void (*send_func)(qsmp_connection_state*),
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t),
+	bool (*key_query)(uint8_t* rvkey, const uint8_t* pkid))
+{
+	assert(kset != NULL);
+	assert(send_func != NULL);
+	assert(receive_callback != NULL);
+
+	qsc_ipinfo_ipv6_address addt = { 0 };
+	listener_receiver_state* prcv;
+	qsc_socket srvs;
+	qsc_socket_exceptions serr;
+	qsmp_errors qerr;
+
+	qsmp_logger_initialize(NULL);
+	prcv = NULL;
+
+	if (kset != NULL && send_func != NULL && receive_callback != NULL)
+	{
+		prcv = (listener_receiver_state*)qsc_memutils_malloc(sizeof(listener_receiver_state));
+
+		if (prcv != NULL)
+		{
+			prcv->pcns = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state));
+
+			if (prcv->pcns != NULL)
+			{
+				prcv->callback = receive_callback;
+				qsc_memutils_clear((uint8_t*)prcv->pcns, sizeof(qsmp_connection_state));
+
+				addt = qsc_ipinfo_ipv6_address_any();
+				qsc_socket_server_initialize(&prcv->pcns->target);
+				qsc_socket_server_initialize(&srvs);
+
+				serr = qsc_socket_server_listen_ipv6(&srvs, &prcv->pcns->target, &addt, QSMP_CLIENT_PORT);
+
+				if (serr == qsc_socket_exception_success)
+				{
+					qerr = listener_duplex_start(kset, prcv, send_func, key_query);
+				}
+				else
+				{
+					qsmp_log_message(qsmp_messages_connection_fail);
+					qerr = qsmp_error_connection_failure;
+				}
+			}
+			else
+			{
+				/* release a partial allocation before the state is disposed */
+				if (prcv->pcns != NULL)
+				{
+					qsc_memutils_alloc_free(prcv->pcns);
+					prcv->pcns = NULL;
+				}
+
+				qsmp_log_message(qsmp_messages_allocate_fail);
+				qerr = qsmp_error_memory_allocation;
+			}
+		}
+		else
+		{
+			qsmp_log_message(qsmp_messages_allocate_fail);
+			qerr = qsmp_error_memory_allocation;
+		}
+	}
+	else
+	{
+		qsmp_log_message(qsmp_messages_invalid_request);
+		qerr = qsmp_error_invalid_input;
+	}
+
+	if (prcv != NULL)
+	{
+		if (prcv->pcns != NULL)
+		{
+			qsmp_connection_state_dispose(prcv->pcns);
+			qsc_memutils_alloc_free(prcv->pcns);
+			prcv->pcns = NULL;
+		}
+
+		prcv->callback = NULL;
+		qsc_memutils_alloc_free(prcv);
+		prcv = NULL;
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_client_simplex_connect_ipv4(const qsmp_client_signature_key* pubk, 
+	const qsc_ipinfo_ipv4_address* address, uint16_t port, 
+	void (*send_func)(qsmp_connection_state*), 
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
+{
+	assert(pubk != NULL);
+	assert(send_func != NULL);
+	assert(send_func != NULL);
+	assert(receive_callback != NULL);
+
+	qsmp_kex_simplex_client_state* kcs;
+	client_receiver_state* prcv;
+	qsc_socket_exceptions serr;
+	qsmp_errors qerr;
+	qsc_thread rthd;
+
+	kcs = NULL;
+	prcv = NULL;
+	qsmp_logger_initialize(NULL);
+
+	if (address != NULL && send_func != NULL && receive_callback != NULL)
+	{
+		kcs = (qsmp_kex_simplex_client_state*)qsc_memutils_malloc(sizeof(qsmp_kex_simplex_client_state));
+
+		if (kcs != NULL)
+		{
+			prcv = (client_receiver_state*)qsc_memutils_malloc(sizeof(client_receiver_state));
+
+			if (prcv != NULL)
+			{
+				qsc_memutils_clear(kcs, sizeof(qsmp_kex_simplex_client_state));
+				qsc_memutils_clear(prcv, sizeof(client_receiver_state));
+
+				prcv->pcns = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state));
+
+				if (prcv->pcns != NULL)
+				{
+					qsc_memutils_clear(prcv->pcns, sizeof(qsmp_connection_state));
+					prcv->callback = receive_callback;
+					qsc_socket_client_initialize(&prcv->pcns->target);
+
+					serr = qsc_socket_client_connect_ipv4(&prcv->pcns->target, address, port);
+
+					if (serr == qsc_socket_exception_success)
+					{
+						/* initialize the client */
+						client_simplex_state_initialize(kcs, prcv->pcns, pubk);
+						/* perform the simplex key exchange */
+						qerr = qsmp_kex_simplex_client_key_exchange(kcs, prcv->pcns);
+						qsc_memutils_alloc_free(kcs);
+						kcs = NULL;
+
+						if (qerr == qsmp_error_none)
+						{
+							/* start the receive loop on a new thread */
+							rthd = qsc_async_thread_create((void*)&client_receive_loop, prcv);
+
+							/* start the send loop on the main thread */
+							send_func(prcv->pcns);
+
+							/* close the connection, and wait for the receive loop to exit */
+							qsmp_connection_close(prcv->pcns, qsmp_error_none, true);
+							qsc_async_thread_wait(rthd);
+						}
+						else
+						{
+							qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
+							qerr = qsmp_error_exchange_failure;
+						}
+					}
+					else
+					{
+						qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
+						qerr = qsmp_error_connection_failure;
+					}
+				}
+				else
+				{
+					qsmp_log_message(qsmp_messages_allocate_fail);
+					qerr = qsmp_error_memory_allocation;
+				}
+			}
+			else
+			{
+				qsmp_log_message(qsmp_messages_allocate_fail);
+				qerr = qsmp_error_memory_allocation;
+			}
+		}
+		else
+		{
+			qsmp_log_message(qsmp_messages_allocate_fail);
+			qerr = qsmp_error_memory_allocation;
+		}
+	}
+	else
+	{
+		qsmp_log_message(qsmp_messages_invalid_request);
+		qerr = qsmp_error_invalid_input;
+	}
+
+	if (kcs != NULL)
+	{
+		qsc_memutils_alloc_free(kcs);
+		kcs = NULL;
+	}
+
+	if (prcv != NULL)
+	{
+		if (prcv->pcns != NULL)
+		{
+			qsmp_connection_state_dispose(prcv->pcns);
+			qsc_memutils_alloc_free(prcv->pcns);
+			prcv->pcns = NULL;
+		}
+
+		prcv->callback = NULL;
+		qsc_memutils_alloc_free(prcv);
+		prcv = NULL;
+	}
+
 	return qerr;
 }
 
-qsmp_errors qsmp_client_duplex_connect_ipv6(const qsmp_server_signature_key* kset, const qsmp_client_signature_key* rverkey,
-	const qsc_ipinfo_ipv6_address* address, uint16_t port,
-	void (*send_func)(qsmp_connection_state*),
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t))
+qsmp_errors qsmp_client_simplex_connect_ipv6(const qsmp_client_signature_key* pubk, 
+	const qsc_ipinfo_ipv6_address* address, uint16_t port, 
+	void (*send_func)(qsmp_connection_state*), 
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
 {
-	assert(kset != NULL);
-	assert(rverkey != NULL);
+	assert(pubk != NULL);
 	assert(send_func != NULL);
 	assert(send_func != NULL);
 	assert(receive_callback != NULL);
 
-	qsmp_kex_duplex_client_state* kcs;
+	qsmp_kex_simplex_client_state* kcs;
 	client_receiver_state* prcv;
 	qsc_socket_exceptions serr;
 	qsmp_errors qerr;
+	qsc_thread rthd;
 
 	kcs = NULL;
 	prcv = NULL;
 	qsmp_logger_initialize(NULL);
 
-	if (kset != NULL && rverkey != NULL && address != NULL && send_func != NULL && receive_callback != NULL)
+	if (address != NULL && send_func != NULL && receive_callback != NULL)
 	{
-		kcs = (qsmp_kex_duplex_client_state*)qsc_memutils_malloc(sizeof(qsmp_kex_duplex_client_state));
+		kcs = (qsmp_kex_simplex_client_state*)qsc_memutils_malloc(sizeof(qsmp_kex_simplex_client_state));
 
 		if (kcs != NULL)
 		{
@@ -1198,13 +1610,14 @@ qsmp_errors qsmp_client_duplex_connect_ipv6(const qsmp_server_signature_key* kse
 
 			if (prcv != NULL)
 			{
-				qsc_memutils_clear(kcs, sizeof(qsmp_kex_duplex_client_state));
+				qsc_memutils_clear(kcs, sizeof(qsmp_kex_simplex_client_state));
 				qsc_memutils_clear(prcv, sizeof(client_receiver_state));
 
 				prcv->pcns = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state));
 
 				if (prcv->pcns != NULL)
 				{
+					qsc_memutils_clear(prcv->pcns, sizeof(qsmp_connection_state));
 					prcv->callback = receive_callback;
 					qsc_socket_client_initialize(&prcv->pcns->target);
 
@@ -1213,33 +1626,28 @@ qsmp_errors qsmp_client_duplex_connect_ipv6(const qsmp_server_signature_key* kse
 					if (serr == qsc_socket_exception_success)
 					{
 						/* initialize the client */
-						client_duplex_state_initialize(kcs, prcv->pcns, kset, rverkey);
-						/* perform the simplex key exchange */
-						qerr = qsmp_kex_duplex_client_key_exchange(kcs, prcv->pcns);
+						client_simplex_state_initialize(kcs, prcv->pcns, pubk);
+						qerr = qsmp_kex_simplex_client_key_exchange(kcs, prcv->pcns);
 						qsc_memutils_alloc_free(kcs);
 						kcs = NULL;
 
 						if (qerr == qsmp_error_none)
 						{
-#if defined(QSMP_ASYMMETRIC_RATCHET)
-							/* store the local signing key and the remote verify key for asymmetyric ratchet option */
-							qsc_memutils_copy(m_sigkeys.sigkey, kset->sigkey, QSMP_ASYMMETRIC_SIGNING_KEY_SIZE);
-							qsc_memutils_copy(m_sigkeys.verkey, rverkey->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
-#endif
-
 							/* start the receive loop on a new thread */
-							qsc_async_thread_create((void*)&client_receive_loop, prcv);
+							rthd = qsc_async_thread_create((void*)&client_receive_loop, prcv);
 
 							/* start the send loop on the main thread */
 							send_func(prcv->pcns);
+
+							/* close the connection, and wait for the receive loop to exit */
+							qsmp_connection_close(prcv->pcns, qsmp_error_none, true);
+							qsc_async_thread_wait(rthd);
 						}
 						else
 						{
 							qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
 							qerr = qsmp_error_exchange_failure;
 						}
-
-						qsmp_connection_close(prcv->pcns, qsmp_error_none, true);
 					}
 					else
 					{
@@ -1277,62 +1685,72 @@ qsmp_errors qsmp_client_duplex_connect_ipv6(const qsmp_server_signature_key* kse
 		kcs = NULL;
 	}
 
+	if (prcv != NULL)
+	{
+		if (prcv->pcns != NULL)
+		{
+			qsmp_connection_state_dispose(prcv->pcns);
+			qsc_memutils_alloc_free(prcv->pcns);
+			prcv->pcns = NULL;
+		}
+
+		prcv->callback = NULL;
+		qsc_memutils_alloc_free(prcv);
+		prcv = NULL;
+	}
+
 	return qerr;
 }
 
-qsmp_errors qsmp_client_duplex_listen_ipv4(const qsmp_server_signature_key* kset, 
+qsmp_errors qsmp_client_simplex_fastopen_ipv4(const qsmp_client_signature_key* pubk, 
+	qsmp_fastopen_key* fokey,
+	const qsc_ipinfo_ipv4_address* address, uint16_t port, 
 	void (*send_func)(qsmp_connection_state*), 
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t), 
-	bool (*key_query)(uint8_t* rvkey, const uint8_t* pkid))
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
 {
-	assert(kset != NULL);
+	assert(pubk != NULL);
+	assert(fokey != NULL);
+	assert(address != NULL);
 	assert(send_func != NULL);
 	assert(receive_callback != NULL);
 
-	qsc_ipinfo_ipv4_address addt = { 0 };
-	listener_receiver_state* prcv;
-	qsc_socket srvs;
+	client_receiver_state* prcv;
 	qsc_socket_exceptions serr;
 	qsmp_errors qerr;
 
-	qsmp_logger_initialize(NULL);
 	prcv = NULL;
+	qsmp_logger_initialize(NULL);
 
-	if (kset != NULL && send_func != NULL && receive_callback != NULL)
+	if (pubk != NULL && fokey != NULL && address != NULL && send_func != NULL && receive_callback != NULL)
 	{
-		prcv = (listener_receiver_state*)qsc_memutils_malloc(sizeof(listener_receiver_state));
+		prcv = (client_receiver_state*)qsc_memutils_malloc(sizeof(client_receiver_state));
 
 		if (prcv != NULL)
 		{
+			qsc_memutils_clear(prcv, sizeof(client_receiver_state));
 			prcv->pcns = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state));
-			prcv->pkpa = (qsmp_keep_alive_state*)qsc_memutils_malloc(sizeof(qsmp_keep_alive_state));
 
-			if (prcv->pcns != NULL && prcv->pkpa != NULL)
+			if (prcv->pcns != NULL)
 			{
+				qsc_memutils_clear(prcv->pcns, sizeof(qsmp_connection_state));
 				prcv->callback = receive_callback;
-				qsc_memutils_clear((uint8_t*)prcv->pcns, sizeof(qsmp_connection_state));
-				qsc_memutils_clear((uint8_t*)prcv->pkpa, sizeof(qsmp_keep_alive_state));
-
-				addt = qsc_ipinfo_ipv4_address_any();
-				qsc_socket_server_initialize(&prcv->pcns->target);
-				qsc_socket_server_initialize(&srvs);
+				qsc_socket_client_initialize(&prcv->pcns->target);
 
-				serr = qsc_socket_server_listen_ipv4(&srvs, &prcv->pcns->target, &addt, QSMP_CLIENT_PORT);
+				serr = qsc_socket_client_connect_ipv4(&prcv->pcns->target, address, port);
 
 				if (serr == qsc_socket_exception_success)
 				{
-					qerr = listener_duplex_start(kset, prcv, send_func, key_query);
+					qerr = client_simplex_fastopen(prcv, pubk, fokey, send_func);
 				}
 				else
 				{
-					qsmp_log_message(qsmp_messages_connection_fail);
+					qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
 					qerr = qsmp_error_connection_failure;
 				}
 			}
 			else
 			{
 				qsmp_log_message(qsmp_messages_allocate_fail);
-				qsc_memutils_alloc_free(prcv);
 				qerr = qsmp_error_memory_allocation;
 			}
 		}
@@ -1348,62 +1766,72 @@ qsmp_errors qsmp_client_duplex_listen_ipv4(const qsmp_server_signature_key* kset
 		qerr = qsmp_error_invalid_input;
 	}
 
+	if (prcv != NULL)
+	{
+		if (prcv->pcns != NULL)
+		{
+			qsmp_connection_state_dispose(prcv->pcns);
+			qsc_memutils_alloc_free(prcv->pcns);
+			prcv->pcns = NULL;
+		}
+
+		prcv->callback = NULL;
+		qsc_memutils_alloc_free(prcv);
+		prcv = NULL;
+	}
+
 	return qerr;
 }
 
-qsmp_errors qsmp_client_duplex_listen_ipv6(const qsmp_server_signature_key* kset, 
-	void (*send_func)(qsmp_connection_state*),
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t),
-	bool (*key_query)(uint8_t* rvkey, const uint8_t* pkid))
+qsmp_errors qsmp_client_simplex_fastopen_ipv6(const qsmp_client_signature_key* pubk, 
+	qsmp_fastopen_key* fokey,
+	const qsc_ipinfo_ipv6_address* address, uint16_t port, 
+	void (*send_func)(qsmp_connection_state*), 
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
 {
-	assert(kset != NULL);
+	assert(pubk != NULL);
+	assert(fokey != NULL);
+	assert(address != NULL);
 	assert(send_func != NULL);
 	assert(receive_callback != NULL);
 
-	qsc_ipinfo_ipv6_address addt = { 0 };
-	listener_receiver_state* prcv;
-	qsc_socket srvs;
+	client_receiver_state* prcv;
 	qsc_socket_exceptions serr;
 	qsmp_errors qerr;
 
-	qsmp_logger_initialize(NULL);
 	prcv = NULL;
+	qsmp_logger_initialize(NULL);
 
-	if (kset != NULL && send_func != NULL && receive_callback != NULL)
+	if (pubk != NULL && fokey != NULL && address != NULL && send_func != NULL && receive_callback != NULL)
 	{
-		prcv = (listener_receiver_state*)qsc_memutils_malloc(sizeof(listener_receiver_state));
+		prcv = (client_receiver_state*)qsc_memutils_malloc(sizeof(client_receiver_state));
 
 		if (prcv != NULL)
 		{
+			qsc_memutils_clear(prcv, sizeof(client_receiver_state));
 			prcv->pcns = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state));
-			prcv->pkpa = (qsmp_keep_alive_state*)qsc_memutils_malloc(sizeof(qsmp_keep_alive_state));
 
-			if (prcv->pcns != NULL && prcv->pkpa != NULL)
+			if (prcv->pcns != NULL)
 			{
+				qsc_memutils_clear(prcv->pcns, sizeof(qsmp_connection_state));
 				prcv->callback = receive_callback;
-				qsc_memutils_clear((uint8_t*)prcv->pcns, sizeof(qsmp_connection_state));
-				qsc_memutils_clear((uint8_t*)prcv->pkpa, sizeof(qsmp_keep_alive_state));
-
-				addt = qsc_ipinfo_ipv6_address_any();
-				qsc_socket_server_initialize(&prcv->pcns->target);
-				qsc_socket_server_initialize(&srvs);
+				qsc_socket_client_initialize(&prcv->pcns->target);
 
-				serr = qsc_socket_server_listen_ipv6(&srvs, &prcv->pcns->target, &addt, QSMP_CLIENT_PORT);
+				serr = qsc_socket_client_connect_ipv6(&prcv->pcns->target, address, port);
 
 				if (serr == qsc_socket_exception_success)
 				{
-					qerr = listener_duplex_start(kset, prcv, send_func, key_query);
+					qerr = client_simplex_fastopen(prcv, pubk, fokey, send_func);
 				}
 				else
 				{
-					qsmp_log_message(qsmp_messages_connection_fail);
+					qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
 					qerr = qsmp_error_connection_failure;
 				}
 			}
 			else
 			{
 				qsmp_log_message(qsmp_messages_allocate_fail);
-				qsc_memutils_alloc_free(prcv);
 				qerr = qsmp_error_memory_allocation;
 			}
 		}
@@ -1419,85 +1847,65 @@ qsmp_errors qsmp_client_duplex_listen_ipv6(const qsmp_server_signature_key* kset
 		qerr = qsmp_error_invalid_input;
 	}
 
+	if (prcv != NULL)
+	{
+		if (prcv->pcns != NULL)
+		{
+			qsmp_connection_state_dispose(prcv->pcns);
+			qsc_memutils_alloc_free(prcv->pcns);
+			prcv->pcns = NULL;
+		}
+
+		prcv->callback = NULL;
+		qsc_memutils_alloc_free(prcv);
+		prcv = NULL;
+	}
+
 	return qerr;
 }
 
-qsmp_errors qsmp_client_simplex_connect_ipv4(const qsmp_client_signature_key* pubk, 
+qsmp_errors qsmp_client_simplex_resume_ipv4(const qsmp_session_ticket* ticket, 
 	const qsc_ipinfo_ipv4_address* address, uint16_t port, 
 	void (*send_func)(qsmp_connection_state*), 
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t))
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
 {
-	assert(pubk != NULL);
-	assert(send_func != NULL);
+	assert(ticket != NULL);
+	assert(address != NULL);
 	assert(send_func != NULL);
 	assert(receive_callback != NULL);
 
-	qsmp_kex_simplex_client_state* kcs;
 	client_receiver_state* prcv;
 	qsc_socket_exceptions serr;
 	qsmp_errors qerr;
 
-	kcs = NULL;
 	prcv = NULL;
 	qsmp_logger_initialize(NULL);
 
-	if (address != NULL && send_func != NULL && receive_callback != NULL)
+	if (ticket != NULL && address != NULL && send_func != NULL && receive_callback != NULL)
 	{
-		kcs = (qsmp_kex_simplex_client_state*)qsc_memutils_malloc(sizeof(qsmp_kex_simplex_client_state));
+		prcv = (client_receiver_state*)qsc_memutils_malloc(sizeof(client_receiver_state));
 
-		if (kcs != NULL)
+		if (prcv != NULL)
 		{
-			prcv = (client_receiver_state*)qsc_memutils_malloc(sizeof(client_receiver_state));
+			qsc_memutils_clear(prcv, sizeof(client_receiver_state));
+			prcv->pcns = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state));
 
-			if (prcv != NULL)
+			if (prcv->pcns != NULL)
 			{
-				qsc_memutils_clear(kcs, sizeof(qsmp_kex_simplex_client_state));
-				qsc_memutils_clear(prcv, sizeof(client_receiver_state));
+				qsc_memutils_clear(prcv->pcns, sizeof(qsmp_connection_state));
+				prcv->callback = receive_callback;
+				qsc_socket_client_initialize(&prcv->pcns->target);
 
-				prcv->pcns = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state));
+				serr = qsc_socket_client_connect_ipv4(&prcv->pcns->target, address, port);
 
-				if (prcv->pcns != NULL)
+				if (serr == qsc_socket_exception_success)
 				{
-					prcv->callback = receive_callback;
-					qsc_socket_client_initialize(&prcv->pcns->target);
-
-					serr = qsc_socket_client_connect_ipv4(&prcv->pcns->target, address, port);
-
-					if (serr == qsc_socket_exception_success)
-					{
-						/* initialize the client */
-						client_simplex_state_initialize(kcs, prcv->pcns, pubk);
-						/* perform the simplex key exchange */
-						qerr = qsmp_kex_simplex_client_key_exchange(kcs, prcv->pcns);
-						qsc_memutils_alloc_free(kcs);
-						kcs = NULL;
-
-						if (qerr == qsmp_error_none)
-						{
-							/* start the receive loop on a new thread */
-							qsc_async_thread_create((void*)&client_receive_loop, prcv);
-
-							/* start the send loop on the main thread */
-							send_func(prcv->pcns);
-						}
-						else
-						{
-							qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
-							qerr = qsmp_error_exchange_failure;
-						}
-
-						qsmp_connection_close(prcv->pcns, qsmp_error_none, true);
-					}
-					else
-					{
-						qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
-						qerr = qsmp_error_connection_failure;
-					}
+					qerr = client_simplex_resume(prcv, ticket, send_func);
 				}
 				else
 				{
-					qsmp_log_message(qsmp_messages_allocate_fail);
-					qerr = qsmp_error_memory_allocation;
+					qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
+					qerr = qsmp_error_connection_failure;
 				}
 			}
 			else
@@ -1518,90 +1926,65 @@ qsmp_errors qsmp_client_simplex_connect_ipv4(const qsmp_client_signature_key* pu
 		qerr = qsmp_error_invalid_input;
 	}
 
-	if (kcs != NULL)
+	if (prcv != NULL)
 	{
-		qsc_memutils_alloc_free(kcs);
-		kcs = NULL;
+		if (prcv->pcns != NULL)
+		{
+			qsmp_connection_state_dispose(prcv->pcns);
+			qsc_memutils_alloc_free(prcv->pcns);
+			prcv->pcns = NULL;
+		}
+
+		prcv->callback = NULL;
+		qsc_memutils_alloc_free(prcv);
+		prcv = NULL;
 	}
 
 	return qerr;
 }
 
-qsmp_errors qsmp_client_simplex_connect_ipv6(const qsmp_client_signature_key* pubk, 
+qsmp_errors qsmp_client_simplex_resume_ipv6(const qsmp_session_ticket* ticket, 
 	const qsc_ipinfo_ipv6_address* address, uint16_t port, 
 	void (*send_func)(qsmp_connection_state*), 
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t))
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
 {
-	assert(pubk != NULL);
-	assert(send_func != NULL);
+	assert(ticket != NULL);
+	assert(address != NULL);
 	assert(send_func != NULL);
 	assert(receive_callback != NULL);
 
-	qsmp_kex_simplex_client_state* kcs;
 	client_receiver_state* prcv;
 	qsc_socket_exceptions serr;
 	qsmp_errors qerr;
 
-	kcs = NULL;
 	prcv = NULL;
 	qsmp_logger_initialize(NULL);
 
-	if (address != NULL && send_func != NULL && receive_callback != NULL)
+	if (ticket != NULL && address != NULL && send_func != NULL && receive_callback != NULL)
 	{
-		kcs = (qsmp_kex_simplex_client_state*)qsc_memutils_malloc(sizeof(qsmp_kex_simplex_client_state));
+		prcv = (client_receiver_state*)qsc_memutils_malloc(sizeof(client_receiver_state));
 
-		if (kcs != NULL)
+		if (prcv != NULL)
 		{
-			prcv = (client_receiver_state*)qsc_memutils_malloc(sizeof(client_receiver_state));
+			qsc_memutils_clear(prcv, sizeof(client_receiver_state));
+			prcv->pcns = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state));
 
-			if (prcv != NULL)
+			if (prcv->pcns != NULL)
 			{
-				qsc_memutils_clear(kcs, sizeof(qsmp_kex_simplex_client_state));
-				qsc_memutils_clear(prcv, sizeof(client_receiver_state));
+				qsc_memutils_clear(prcv->pcns, sizeof(qsmp_connection_state));
+				prcv->callback = receive_callback;
+				qsc_socket_client_initialize(&prcv->pcns->target);
 
-				prcv->pcns = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state));
+				serr = qsc_socket_client_connect_ipv6(&prcv->pcns->target, address, port);
 
-				if (prcv->pcns != NULL)
+				if (serr == qsc_socket_exception_success)
 				{
-					prcv->callback = receive_callback;
-					qsc_socket_client_initialize(&prcv->pcns->target);
-
-					serr = qsc_socket_client_connect_ipv6(&prcv->pcns->target, address, port);
-
-					if (serr == qsc_socket_exception_success)
-					{
-						/* initialize the client */
-						client_simplex_state_initialize(kcs, prcv->pcns, pubk);
-						qerr = qsmp_kex_simplex_client_key_exchange(kcs, prcv->pcns);
-						qsc_memutils_alloc_free(kcs);
-						kcs = NULL;
-
-						if (qerr == qsmp_error_none)
-						{
-							/* start the receive loop on a new thread */
-							qsc_async_thread_create((void*)&client_receive_loop, prcv);
-
-							/* start the send loop on the main thread */
-							send_func(prcv->pcns);
-						}
-						else
-						{
-							qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
-							qerr = qsmp_error_exchange_failure;
-						}
-
-						qsmp_connection_close(prcv->pcns, qsmp_error_none, true);
-					}
-					else
-					{
-						qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
-						qerr = qsmp_error_connection_failure;
-					}
+					qerr = client_simplex_resume(prcv, ticket, send_func);
 				}
 				else
 				{
-					qsmp_log_message(qsmp_messages_allocate_fail);
-					qerr = qsmp_error_memory_allocation;
+					qsmp_log_write(qsmp_messages_kex_fail, (const char*)prcv->pcns->target.address);
+					qerr = qsmp_error_connection_failure;
 				}
 			}
 			else
@@ -1622,10 +2005,18 @@ qsmp_errors qsmp_client_simplex_connect_ipv6(const qsmp_client_signature_key* pu
 		qerr = qsmp_error_invalid_input;
 	}
 
-	if (kcs != NULL)
+	if (prcv != NULL)
 	{
-		qsc_memutils_alloc_free(kcs);
-		kcs = NULL;
+		if (prcv->pcns != NULL)
+		{
+			qsmp_connection_state_dispose(prcv->pcns);
+			qsc_memutils_alloc_free(prcv->pcns);
+			prcv->pcns = NULL;
+		}
+
+		prcv->callback = NULL;
+		qsc_memutils_alloc_free(prcv);
+		prcv = NULL;
 	}
 
 	return qerr;
@@ -1633,7 +2024,7 @@ qsmp_errors qsmp_client_simplex_connect_ipv6(const qsmp_client_signature_key* pu
 
 qsmp_errors qsmp_client_simplex_listen_ipv4(const qsmp_server_signature_key* kset, 
 	void (*send_func)(qsmp_connection_state*), 
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t))
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
 {
 	assert(kset != NULL);
 	assert(send_func != NULL);
@@ -1650,18 +2041,16 @@ qsmp_errors qsmp_client_simplex_listen_ipv4(const qsmp_server_signature_key* kse
 
 	if (kset != NULL && send_func != NULL && receive_callback != NULL)
 	{
-		prcv = (listener_receiver_state*)qsc_memutils_malloc(sizeof(listener_receiver_state*));
+		prcv = (listener_receiver_state*)qsc_memutils_malloc(sizeof(listener_receiver_state));
 
 		if (prcv != NULL)
 		{
 			prcv->pcns = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state));
-			prcv->pkpa = (qsmp_keep_alive_state*)qsc_memutils_malloc(sizeof(qsmp_keep_alive_state));
 
-			if (prcv->pcns != NULL && prcv->pkpa != NULL)
+			if (prcv->pcns != NULL)
 			{
 				prcv->callback = receive_callback;
 				qsc_memutils_clear((uint8_t*)prcv->pcns, sizeof(qsmp_connection_state));
-				qsc_memutils_clear((uint8_t*)prcv->pkpa, sizeof(qsmp_keep_alive_state));
 
 				addt = qsc_ipinfo_ipv4_address_any();
 				qsc_socket_server_initialize(&prcv->pcns->target);
@@ -1681,8 +2070,14 @@ qsmp_errors qsmp_client_simplex_listen_ipv4(const qsmp_server_signature_key* kse
 			}
 			else
 			{
+				/* release a partial allocation before the state is disposed */
+				if (prcv->pcns != NULL)
+				{
+					qsc_memutils_alloc_free(prcv->pcns);
+					prcv->pcns = NULL;
+				}
+
 				qsmp_log_message(qsmp_messages_allocate_fail);
-				qsc_memutils_alloc_free(prcv);
 				qerr = qsmp_error_memory_allocation;
 			}
 		}
@@ -1702,6 +2097,7 @@ qsmp_errors qsmp_client_simplex_listen_ipv4(const qsmp_server_signature_key* kse
 	{
 		if (prcv->pcns != NULL)
 		{
+			qsmp_connection_state_dispose(prcv->pcns);
 			qsc_memutils_alloc_free(prcv->pcns);
 			prcv->pcns = NULL;
 		}
@@ -1716,7 +2112,7 @@ qsmp_errors qsmp_client_simplex_listen_ipv4(const qsmp_server_signature_key* kse
 
 qsmp_errors qsmp_client_simplex_listen_ipv6(const qsmp_server_signature_key* kset, 
 	void (*send_func)(qsmp_connection_state*), 
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t))
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
 {
 	assert(kset != NULL);
 	assert(send_func != NULL);
@@ -1732,18 +2128,16 @@ qsmp_errors qsmp_client_simplex_listen_ipv6(const qsmp_server_signature_key* kse
 
 	if (kset != NULL && send_func != NULL && receive_callback != NULL)
 	{
-		prcv = (listener_receiver_state*)qsc_memutils_malloc(sizeof(listener_receiver_state*));
+		prcv = (listener_receiver_state*)qsc_memutils_malloc(sizeof(listener_receiver_state));
 
 		if (prcv != NULL)
 		{
 			prcv->pcns = (qsmp_connection_state*)qsc_memutils_malloc(sizeof(qsmp_connection_state));
-			prcv->pkpa = (qsmp_keep_alive_state*)qsc_memutils_malloc(sizeof(qsmp_keep_alive_state));
 
-			if (prcv->pcns != NULL && prcv->pkpa != NULL)
+			if (prcv->pcns != NULL)
 			{
 				prcv->callback = receive_callback;
 				qsc_memutils_clear((uint8_t*)prcv->pcns, sizeof(qsmp_connection_state));
-				qsc_memutils_clear((uint8_t*)prcv->pkpa, sizeof(qsmp_keep_alive_state));
 
 				addt = qsc_ipinfo_ipv6_address_any();
 				qsc_socket_server_initialize(&prcv->pcns->target);
@@ -1763,8 +2157,14 @@ qsmp_errors qsmp_client_simplex_listen_ipv6(const qsmp_server_signature_key* kse
 			}
 			else
 			{
+				/* release a partial allocation before the state is disposed */
+				if (prcv->pcns != NULL)
+				{
+					qsc_memutils_alloc_free(prcv->pcns);
+					prcv->pcns = NULL;
+				}
+
 				qsmp_log_message(qsmp_messages_allocate_fail);
-				qsc_memutils_alloc_free(prcv);
 				qerr = qsmp_error_memory_allocation;
 			}
 		}
@@ -1784,6 +2184,7 @@ qsmp_errors qsmp_client_simplex_listen_ipv6(const qsmp_server_signature_key* kse
 	{
 		if (prcv->pcns != NULL)
 		{
+			qsmp_connection_state_dispose(prcv->pcns);
 			qsc_memutils_alloc_free(prcv->pcns);
 			prcv->pcns = NULL;
 		}
@@ -20,6 +20,8 @@
 * \file qsmp.h
 * \brief <b>QSMP Client functions</b> \n
 * Functions used to implement the client in the Quantum Secure Messaging Protocol (QSMP).
+* The receive callback of each function is passed the message as a binary array and length,
+* which is only valid for the duration of the callback; a message used after the callback returns must be copied.
 *
 * \author   John G. Underhill
 * \version  1.2a: 2022-05-01
@@ -46,7 +48,9 @@ QSMP_EXPORT_API bool qsmp_duplex_send_asymmetric_ratchet_request(qsmp_connection
 #endif
 
 /**
-* \brief Send a symmetric key-ratchet request to the remote host
+* \brief Send a symmetric key-ratchet request to the remote host.
+* The transmit key is switched when the request is sent, and the receive key when the remote host acknowledges it.
+* Only one request is in flight at a time, the function returns false while a request is unacknowledged.
 *
 * \param cns: A pointer to the connection state
 *
@@ -70,7 +74,7 @@ QSMP_EXPORT_API bool qsmp_duplex_send_symmetric_ratchet_request(qsmp_connection_
 QSMP_EXPORT_API qsmp_errors qsmp_client_duplex_connect_ipv4(const qsmp_server_signature_key* kset, const qsmp_client_signature_key* rverkey, 
 	const qsc_ipinfo_ipv4_address* address, uint16_t port, 
 	void (*send_func)(qsmp_connection_state*), 
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t));
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t));
 
 /**
 * \brief Connect to the remote host using IPv6, and run the Duplex key exchange function.
@@ -88,7 +92,7 @@ QSMP_EXPORT_API qsmp_errors qsmp_client_duplex_connect_ipv4(const qsmp_server_si
 QSMP_EXPORT_API qsmp_errors qsmp_client_duplex_connect_ipv6(const qsmp_server_signature_key* kset, const qsmp_client_signature_key* rverkey,
 	const qsc_ipinfo_ipv6_address* address, uint16_t port,
 	void (*send_func)(qsmp_connection_state*),
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t));
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t));
 
 /**
 * \brief Connect to the remote server using IPv4, and run the Simplex key exchange function.
@@ -105,7 +109,7 @@ QSMP_EXPORT_API qsmp_errors qsmp_client_duplex_connect_ipv6(const qsmp_server_si
 QSMP_EXPORT_API qsmp_errors qsmp_client_simplex_connect_ipv4(const qsmp_client_signature_key* pubk, 
 	const qsc_ipinfo_ipv4_address* address, uint16_t port, 
 	void (*send_func)(qsmp_connection_state*), 
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t));
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t));
 
 /**
 * \brief Connect to the remote server using IPv6, and run the networked simplex key exchange function.
@@ -122,7 +126,87 @@ QSMP_EXPORT_API qsmp_errors qsmp_client_simplex_connect_ipv4(const qsmp_client_s
 QSMP_EXPORT_API qsmp_errors qsmp_client_simplex_connect_ipv6(const qsmp_client_signature_key* pubk, 
 	const qsc_ipinfo_ipv6_address* address, uint16_t port, 
 	void (*send_func)(qsmp_connection_state*), 
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t));
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t));
+
+/**
+* \brief Connect to the remote server using IPv4, and run the simplex fast-open key exchange.
+* If the cached fast-open key is current, the key encapsulation is sent with the connection request, and the session is established in one round trip.
+* Otherwise the server sends its current fast-open key, which is verified and stored in the cache, and the exchange completes in two round trips.
+* An empty (zeroed) key structure is a valid input, the first connection fills the cache.
+*
+* \param pubk: [const] A pointer to the client's public signature verification key
+* \param fokey: A pointer to the cached fast-open key of the server
+* \param address: [const] The servers IPv4 network address
+* \param port: The QSMP application port number (QSMP_SERVER_PORT)
+* \param send_func: A pointer to the send callback function, that contains a message send loop
+* \param receive_callback: A pointer to the receive callback function, used to process the server data stream
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_client_simplex_fastopen_ipv4(const qsmp_client_signature_key* pubk, 
+	qsmp_fastopen_key* fokey,
+	const qsc_ipinfo_ipv4_address* address, uint16_t port, 
+	void (*send_func)(qsmp_connection_state*), 
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t));
+
+/**
+* \brief Connect to the remote server using IPv6, and run the simplex fast-open key exchange.
+* If the cached fast-open key is current, the key encapsulation is sent with the connection request, and the session is established in one round trip.
+* Otherwise the server sends its current fast-open key, which is verified and stored in the cache, and the exchange completes in two round trips.
+* An empty (zeroed) key structure is a valid input, the first connection fills the cache.
+*
+* \param pubk: [const] A pointer to the client's public signature verification key
+* \param fokey: A pointer to the cached fast-open key of the server
+* \param address: [const] The servers network IPv6 address
+* \param port: The QSMP application port number (QSMP_SERVER_PORT)
+* \param send_func: A pointer to the send callback function, that contains a message send loop
+* \param receive_callback: A pointer to the receive callback function, used to process the server data stream
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_client_simplex_fastopen_ipv6(const qsmp_client_signature_key* pubk, 
+	qsmp_fastopen_key* fokey,
+	const qsc_ipinfo_ipv6_address* address, uint16_t port, 
+	void (*send_func)(qsmp_connection_state*), 
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t));
+
+/**
+* \brief Connect to the remote server using IPv4, and resume a session with a ticket issued by the server in a previous session.
+* The resumption skips the asymmetric key exchange, the session keys are derived from the resumption secret and fresh nonces.
+* The server issues a replacement ticket, which is copied from the connection state before the connection is closed.
+* If the ticket is refused, the caller falls back to the simplex key exchange.
+*
+* \param ticket: [const] A pointer to the session ticket
+* \param address: [const] The servers IPv4 network address
+* \param port: The QSMP application port number (QSMP_SERVER_PORT)
+* \param send_func: A pointer to the send callback function, that contains a message send loop
+* \param receive_callback: A pointer to the receive callback function, used to process the server data stream
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_client_simplex_resume_ipv4(const qsmp_session_ticket* ticket, 
+	const qsc_ipinfo_ipv4_address* address, uint16_t port, 
+	void (*send_func)(qsmp_connection_state*), 
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t));
+
+/**
+* \brief Connect to the remote server using IPv6, and resume a session with a ticket issued by the server in a previous session.
+* The resumption skips the asymmetric key exchange, the session keys are derived from the resumption secret and fresh nonces.
+* The server issues a replacement ticket, which is copied from the connection state before the connection is closed.
+* If the ticket is refused, the caller falls back to the simplex key exchange.
+*
+* \param ticket: [const] A pointer to the session ticket
+* \param address: [const] The servers network IPv6 address
+* \param port: The QSMP application port number (QSMP_SERVER_PORT)
+* \param send_func: A pointer to the send callback function, that contains a message send loop
+* \param receive_callback: A pointer to the receive callback function, used to process the server data stream
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_client_simplex_resume_ipv6(const qsmp_session_ticket* ticket, 
+	const qsc_ipinfo_ipv6_address* address, uint16_t port, 
+	void (*send_func)(qsmp_connection_state*), 
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t));
 
 /**
 * \brief Start the server and run the IPv4 network listener function, 
@@ -137,7 +221,7 @@ QSMP_EXPORT_API qsmp_errors qsmp_client_simplex_connect_ipv6(const qsmp_client_s
 */
 QSMP_EXPORT_API qsmp_errors qsmp_client_simplex_listen_ipv4(const qsmp_server_signature_key* kset, 
 	void (*send_func)(qsmp_connection_state*), 
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t));
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t));
 
 /**
 * \brief Start the server, and run the IPv6 network listener function,
@@ -152,7 +236,7 @@ QSMP_EXPORT_API qsmp_errors qsmp_client_simplex_listen_ipv4(const qsmp_server_si
 */
 QSMP_EXPORT_API qsmp_errors qsmp_client_simplex_listen_ipv6(const qsmp_server_signature_key* kset, 
 	void (*send_func)(qsmp_connection_state*), 
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t));
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t));
 
 /**
 * \brief Start the server, and run the IPv4 network listener function,
@@ -168,7 +252,7 @@ QSMP_EXPORT_API qsmp_errors qsmp_client_simplex_listen_ipv6(const qsmp_server_si
 */
 QSMP_EXPORT_API qsmp_errors qsmp_client_duplex_listen_ipv4(const qsmp_server_signature_key* kset, 
 	void (*send_func)(qsmp_connection_state*),
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t),
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t),
 	bool (*key_query)(uint8_t* rvkey, const uint8_t* pkid));
 
 /**
@@ -185,7 +269,7 @@ QSMP_EXPORT_API qsmp_errors qsmp_client_duplex_listen_ipv4(const qsmp_server_sig
 */
 QSMP_EXPORT_API qsmp_errors qsmp_client_duplex_listen_ipv6(const qsmp_server_signature_key* kset, 
 	void (*send_func)(qsmp_connection_state*),
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t),
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t),
 	bool (*key_query)(uint8_t* rvkey, const uint8_t* pkid));
 
 #endif
\ No newline at end of file
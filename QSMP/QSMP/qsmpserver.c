@@ -1,4 +1,5 @@
 #include "qsmpserver.h"
+#include "bufferpool.h"
 #include "connections.h"
 #include "kex.h"
 #include "logger.h"
@@ -9,38 +10,1197 @@
 #include "../../QSC/QSC/memutils.h"
 #include "../../QSC/QSC/sha3.h"
 #include "../../QSC/QSC/stringutils.h"
+#include "../../QSC/QSC/timerex.h"
 #include "../../QSC/QSC/timestamp.h"
 
+#if defined(QSMP_SERVER_REACTOR)
+#	include <sys/epoll.h>
+#	include <sys/ioctl.h>
+#	include <unistd.h>
+#elif !defined(QSC_SYSTEM_OS_WINDOWS)
+#	include <sys/ioctl.h>
+#endif
+
 typedef struct server_receiver_state
 {
 	qsmp_connection_state* pcns;
 	const qsmp_server_signature_key* pprik;
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t);
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t);
 } server_receiver_state;
 
+#if defined(QSMP_SERVER_REACTOR)
+typedef struct server_reactor_worker
+{
+	qsc_thread thread;
+	int32_t epfd;
+} server_reactor_worker;
+
+typedef struct server_reactor_state
+{
+	server_reactor_worker workers[QSMP_SERVER_REACTOR_WORKERS_MAX];
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t);
+	size_t count;
+	volatile bool run;
+} server_reactor_state;
+
+static server_reactor_state m_server_reactor;
+#endif
+
+typedef struct server_broadcast_shard
+{
+	const uint8_t* message;
+	size_t msglen;
+	size_t first;
+	size_t last;
+	uint64_t delivered;
+	uint64_t dropped;
+	uint64_t busy;
+	uint64_t disconnected;
+} server_broadcast_shard;
+
+typedef struct server_broadcast_pool
+{
+	qsc_thread workers[QSMP_SERVER_BROADCAST_SHARDS_MAX];
+	server_broadcast_shard shards[QSMP_SERVER_BROADCAST_SHARDS_MAX];
+	qsc_mutex lock;
+	qsc_semaphore ready;
+	qsc_semaphore done;
+	size_t count;
+	volatile int32_t next;
+	volatile bool run;
+} server_broadcast_pool;
+
+typedef struct server_handshake_pool
+{
+	qsc_thread workers[QSMP_SERVER_HANDSHAKE_WORKERS_MAX];
+	server_receiver_state* queue[QSMP_SERVER_HANDSHAKE_QUEUE_SIZE];
+	qsmp_handshake_statistics stats;
+	qsc_mutex lock;
+	qsc_semaphore ready;
+	size_t head;
+} server_handshake_pool;
+
+typedef struct server_listener_state
+{
+	qsc_socket* source;
+	const qsmp_server_signature_key* pprik;
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t);
+	size_t shard;
+	qsmp_errors qerr;
+} server_listener_state;
+
+typedef struct server_listener_pool
+{
+	qsc_thread threads[QSMP_SERVER_LISTENERS_MAX];
+	server_listener_state listeners[QSMP_SERVER_LISTENERS_MAX];
+	size_t count;
+	volatile int32_t accepting;
+} server_listener_pool;
+
+static server_broadcast_pool m_server_broadcast;
+static server_handshake_pool m_server_handshake;
+static server_listener_pool m_server_listeners;
+static qsmp_broadcast_statistics m_server_broadcast_stats;
+static qsmp_broadcast_policies m_server_broadcast_policy;
+static const qsmp_server_signature_key* m_server_key;
+static qsmp_kex_fastopen_state m_server_fastopen;
+static uint8_t m_server_ticket_key[QSMP_SIMPLEX_SYMMETRIC_KEY_SIZE];
+#if !defined(QSMP_SERVER_REACTOR)
+static volatile int32_t m_server_receivers;
+#endif
 static bool m_server_pause;
 static bool m_server_run;
+static bool m_server_timers;
+
+static void server_state_initialize(qsmp_kex_simplex_server_state* kss, const server_receiver_state* prcv)
+{
+	qsc_memutils_copy(kss->keyid, prcv->pprik->keyid, QSMP_KEYID_SIZE);
+	qsc_memutils_copy(kss->sigkey, prcv->pprik->sigkey, QSMP_ASYMMETRIC_SIGNING_KEY_SIZE);
+	qsc_memutils_copy(kss->verkey, prcv->pprik->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
+	qsc_memutils_clear(&prcv->pcns->rtcs, QSMP_DUPLEX_SYMMETRIC_KEY_SIZE);
+	kss->expiration = prcv->pprik->expiration;
+	kss->tktkey = m_server_ticket_key;
+	kss->fostate = &m_server_fastopen;
+	qsc_rcs_dispose(&prcv->pcns->rxcpr);
+	qsc_rcs_dispose(&prcv->pcns->txcpr);
+	prcv->pcns->exflag = qsmp_flag_none;
+	prcv->pcns->rxseq = 0;
+	prcv->pcns->txseq = 0;
+}
+
+static qsmp_errors server_receive_control(qsmp_connection_state* cns, const qsmp_packet* packetin)
+{
+	assert(cns != NULL);
+	assert(packetin != NULL);
+
+	qsmp_errors qerr;
+
+	if (packetin->flag == qsmp_flag_keep_alive_response)
+	{
+		qerr = qsmp_connection_keepalive_response(cns, packetin);
+
+		if (qerr != qsmp_error_none)
+		{
+			qsmp_log_write(qsmp_messages_keepalive_fail, (const char*)cns->target.address);
+		}
+	}
+	else
+	{
+		/* unknown message type, we fail out of caution but could ignore */
+		qerr = qsmp_error_invalid_request;
+	}
+
+	return qerr;
+}
+
+static void server_connection_close(qsmp_connection_state* cns, qsmp_errors err)
+{
+	assert(cns != NULL);
+
+	if (cns != NULL)
+	{
+		if (qsc_socket_is_connected(&cns->target) == true)
+		{
+			/* the remote host is notified unless it closed the channel */
+			qsmp_connection_close(cns, (err == qsmp_error_channel_down) ? qsmp_error_none : err, (err != qsmp_error_channel_down));
+		}
+		else
+		{
+			qsc_socket_close_socket(&cns->target);
+		}
+	}
+}
+
+static size_t server_connection_pending(qsmp_connection_state* cns)
+{
+	assert(cns != NULL);
+
+	size_t plen;
+
+	/* the transmit queue is guarded by the connection transmit lock */
+	qsc_async_mutex_lock(cns->txlock);
+	plen = cns->txbuf.length;
+	qsc_async_mutex_unlock(cns->txlock);
+
+	return plen;
+}
+
+static bool server_socket_error_fatal(qsc_socket_exceptions err)
+{
+	bool res;
+
+	res = (err == qsc_socket_exception_circuit_reset ||
+		err == qsc_socket_exception_circuit_terminated ||
+		err == qsc_socket_exception_circuit_timeout ||
+		err == qsc_socket_exception_dropped_connection ||
+		err == qsc_socket_exception_network_failure ||
+		err == qsc_socket_exception_shut_down);
+
+	return res;
+}
+
+#if defined(QSMP_SERVER_REACTOR)
+static void server_reactor_close(server_reactor_worker* pwrk, qsmp_connection_state* cns, qsmp_errors err)
+{
+	assert(pwrk != NULL);
+	assert(cns != NULL);
+
+	if (pwrk != NULL && cns != NULL)
+	{
+		/* remove the descriptor before it is closed, so it can not be recycled while still registered */
+		epoll_ctl(pwrk->epfd, EPOLL_CTL_DEL, cns->target.connection, NULL);
+		server_connection_close(cns, err);
+		qsmp_connections_reset(cns->instance);
+	}
+}
+
+static void server_reactor_writable(qsmp_connection_state* cns, bool enable)
+{
+	assert(cns != NULL);
+
+	struct epoll_event evt = { 0 };
+	server_reactor_worker* pwrk;
+
+	if (cns != NULL && m_server_reactor.count != 0)
+	{
+		/* the write event is requested while the connection has queued records */
+		pwrk = &m_server_reactor.workers[cns->instance % m_server_reactor.count];
+		evt.events = (enable == true) ? (EPOLLIN | EPOLLOUT | EPOLLRDHUP) : (EPOLLIN | EPOLLRDHUP);
+		evt.data.u32 = cns->instance;
+		epoll_ctl(pwrk->epfd, EPOLL_CTL_MOD, cns->target.connection, &evt);
+	}
+}
+
+static bool server_reactor_send(server_reactor_worker* pwrk, qsmp_connection_state* cns)
+{
+	assert(pwrk != NULL);
+	assert(cns != NULL);
+
+	bool res;
+
+	res = true;
+
+	if (qsmp_connection_flush(cns) == qsmp_error_none)
+	{
+		if (server_connection_pending(cns) == 0)
+		{
+			/* a broadcast may queue a record after the flush, so the queue is checked again once the write event is removed */
+			server_reactor_writable(cns, false);
+
+			if (server_connection_pending(cns) != 0)
+			{
+				server_reactor_writable(cns, true);
+			}
+		}
+	}
+	else
+	{
+		qsmp_log_write(qsmp_messages_connection_fail, (const char*)cns->target.address);
+		server_reactor_close(pwrk, cns, qsmp_error_channel_down);
+		res = false;
+	}
+
+	return res;
+}
+
+static void server_reactor_receive(server_reactor_worker* pwrk, qsmp_connection_state* cns)
+{
+	assert(pwrk != NULL);
+	assert(cns != NULL);
+
+	qsc_socket_exceptions err;
+	qsmp_errors qerr;
+	size_t mlen;
+
+	mlen = qsmp_record_buffer_receive(&cns->rxbuf, &cns->target);
+
+	if (mlen != 0)
+	{
+		qerr = qsmp_connection_dispatch(cns, m_server_reactor.receive_callback, &server_receive_control);
+
+		if (qerr != qsmp_error_none)
+		{
+			server_reactor_close(pwrk, cns, qerr);
+		}
+		else if (server_connection_pending(cns) != 0)
+		{
+			/* a response the socket did not accept is sent when the socket is writable */
+			server_reactor_writable(cns, true);
+		}
+	}
+	else
+	{
+		err = qsc_socket_get_last_error();
+
+		/* a readable socket that returns no data has been closed by the remote host */
+		if (err != qsc_socket_exception_would_block && err != qsc_socket_exception_blocking_cancelled)
+		{
+			if (server_socket_error_fatal(err) == true)
+			{
+				qsmp_log_error(qsmp_messages_receive_fail, err, (const char*)cns->target.address);
+				qsmp_log_write(qsmp_messages_connection_fail, (const char*)cns->target.address);
+			}
+			else
+			{
+				qsmp_log_write(qsmp_messages_disconnect, (const char*)cns->target.address);
+			}
+
+			server_reactor_close(pwrk, cns, qsmp_error_channel_down);
+		}
+	}
+}
+
+static void server_reactor_worker_loop(server_reactor_worker* pwrk)
+{
+	assert(pwrk != NULL);
+
+	struct epoll_event evts[QSMP_SERVER_REACTOR_EVENTS];
+	qsmp_connection_state* cns;
+	int32_t ecnt;
+
+	while (m_server_reactor.run == true)
+	{
+		ecnt = epoll_wait(pwrk->epfd, evts, QSMP_SERVER_REACTOR_EVENTS, QSMP_SERVER_PAUSE_INTERVAL);
+
+		for (int32_t i = 0; i < ecnt; ++i)
+		{
+			cns = qsmp_connections_get(evts[i].data.u32);
+
+			if (cns != NULL)
+			{
+				if ((evts[i].events & EPOLLOUT) != 0 && server_reactor_send(pwrk, cns) == false)
+				{
+					continue;
+				}
+
+				if ((evts[i].events & EPOLLIN) != 0)
+				{
+					server_reactor_receive(pwrk, cns);
+				}
+				else if ((evts[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) != 0)
+				{
+					qsmp_log_write(qsmp_messages_connection_fail, (const char*)cns->target.address);
+					server_reactor_close(pwrk, cns, qsmp_error_channel_down);
+				}
+			}
+		}
+	}
+}
+
+static bool server_reactor_register(qsmp_connection_state* cns)
+{
+	assert(cns != NULL);
+
+	struct epoll_event evt = { 0 };
+	server_reactor_worker* pwrk;
+	uint32_t nblk;
+	bool res;
+
+	res = false;
+
+	if (cns != NULL && m_server_reactor.count != 0)
+	{
+		/* the socket is owned by a single worker for the lifetime of the session */
+		pwrk = &m_server_reactor.workers[cns->instance % m_server_reactor.count];
+		nblk = 1;
+
+		if (qsc_socket_ioctl(&cns->target, FIONBIO, &nblk) == qsc_socket_exception_success)
+		{
+			evt.events = EPOLLIN | EPOLLRDHUP;
+			evt.data.u32 = cns->instance;
+			res = (epoll_ctl(pwrk->epfd, EPOLL_CTL_ADD, cns->target.connection, &evt) == 0);
+		}
+	}
+
+	return res;
+}
+
+static void server_reactor_dispose()
+{
+	m_server_reactor.run = false;
+
+	for (size_t i = 0; i < m_server_reactor.count; ++i)
+	{
+		qsc_async_thread_wait(m_server_reactor.workers[i].thread);
+		close(m_server_reactor.workers[i].epfd);
+		m_server_reactor.workers[i].epfd = 0;
+	}
+
+	m_server_reactor.count = 0;
+	m_server_reactor.receive_callback = NULL;
+}
+
+static bool server_reactor_initialize(void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
+{
+	assert(receive_callback != NULL);
+
+	size_t wcnt;
+	bool res;
+
+	res = true;
+	wcnt = qsc_async_processor_count();
+	wcnt = qsc_intutils_min(wcnt, QSMP_SERVER_REACTOR_WORKERS_MAX);
+	m_server_reactor.count = 0;
+	m_server_reactor.receive_callback = receive_callback;
+	m_server_reactor.run = true;
+
+	for (size_t i = 0; i < wcnt; ++i)
+	{
+		m_server_reactor.workers[i].epfd = epoll_create1(0);
+
+		if (m_server_reactor.workers[i].epfd < 0)
+		{
+			res = false;
+			break;
+		}
+
+		m_server_reactor.workers[i].thread = qsc_async_thread_create((void*)&server_reactor_worker_loop, &m_server_reactor.workers[i]);
+		++m_server_reactor.count;
+	}
+
+	if (res == false)
+	{
+		server_reactor_dispose();
+	}
+
+	return res;
+}
+#endif
+
+static void server_broadcast_batch(server_broadcast_shard* pshd, qsmp_connection_state* cns[], size_t count)
+{
+	qsmp_errors qerr[QSMP_CONNECTION_QUEUE_MULTI_MAX];
+
+	/* the message is encrypted for the batch of sessions together, and queued without blocking on a slow peer */
+	qsmp_connection_queue_multi(cns, count, pshd->message, pshd->msglen, qerr);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (qerr[i] == qsmp_error_none)
+		{
+			++pshd->delivered;
+
+#if defined(QSMP_SERVER_REACTOR)
+			if (server_connection_pending(cns[i]) != 0)
+			{
+				server_reactor_writable(cns[i], true);
+			}
+#endif
+		}
+		else if (qerr[i] == qsmp_error_transmit_busy)
+		{
+			/* a session sending a stream transfer is healthy, the message is skipped rather than counted against the peer */
+			++pshd->busy;
+		}
+		else if (qerr[i] != qsmp_error_channel_down)
+		{
+			/* a session that closed while the batch was gathered is not counted as dropped */
+			++pshd->dropped;
+
+			if (m_server_broadcast_policy == qsmp_broadcast_policy_disconnect)
+			{
+				/* the thread servicing the session sees the shut down and releases the connection */
+				qsc_socket_shut_down_channels(&cns[i]->target, qsc_socket_shut_down_flag_both);
+				++pshd->disconnected;
+			}
+		}
+	}
+}
+
+static void server_broadcast_shard_run(server_broadcast_shard* pshd)
+{
+	assert(pshd != NULL);
+
+	qsmp_connection_state* cbat[QSMP_CONNECTION_QUEUE_MULTI_MAX];
+	qsmp_connection_state* cns;
+	size_t ccnt;
+
+	ccnt = 0;
+
+	for (size_t i = pshd->first; i < pshd->last; ++i)
+	{
+		cns = qsmp_connections_index(i);
+
+		if (cns != NULL && qsmp_connections_active(i) == true && 
+			qsc_socket_is_connected(&cns->target) == true && 
+			cns->exflag == qsmp_flag_session_established)
+		{
+			cbat[ccnt] = cns;
+			++ccnt;
+
+			if (ccnt == QSMP_CONNECTION_QUEUE_MULTI_MAX)
+			{
+				server_broadcast_batch(pshd, cbat, ccnt);
+				ccnt = 0;
+			}
+		}
+	}
+
+	if (ccnt != 0)
+	{
+		server_broadcast_batch(pshd, cbat, ccnt);
+	}
+}
+
+static void server_broadcast_worker(void* state)
+{
+	server_broadcast_shard* pshd;
+	int32_t sidx;
+
+	(void)state;
+
+	do
+	{
+		qsc_async_semaphore_wait(m_server_broadcast.ready);
+		pshd = NULL;
+
+		/* a wake after the pool is stopped is the stop signal */
+		if (m_server_broadcast.run == true)
+		{
+			/* each wake takes the next shard of the broadcast, the first is run by the caller */
+			sidx = qsc_async_atomic_add(&m_server_broadcast.next, 1) - 1;
+			pshd = &m_server_broadcast.shards[sidx];
+			server_broadcast_shard_run(pshd);
+			qsc_async_semaphore_post(m_server_broadcast.done);
+		}
+	} 
+	while (pshd != NULL);
+}
+
+static void server_broadcast_dispose()
+{
+	size_t wcnt;
+
+	if (m_server_broadcast.lock != NULL)
+	{
+		/* a broadcast in progress completes before the workers are stopped */
+		qsc_async_mutex_lock(m_server_broadcast.lock);
+		wcnt = m_server_broadcast.count;
+		m_server_broadcast.run = false;
+		m_server_broadcast.count = 0;
+
+		for (size_t i = 0; i < wcnt; ++i)
+		{
+			qsc_async_semaphore_post(m_server_broadcast.ready);
+		}
+
+		qsc_async_thread_wait_all(m_server_broadcast.workers, wcnt);
+		qsc_async_mutex_unlock(m_server_broadcast.lock);
+		qsc_async_semaphore_destroy(m_server_broadcast.done);
+		qsc_async_semaphore_destroy(m_server_broadcast.ready);
+		qsc_async_mutex_destroy(m_server_broadcast.lock);
+		m_server_broadcast.done = NULL;
+		m_server_broadcast.ready = NULL;
+		m_server_broadcast.lock = NULL;
+	}
+}
+
+static bool server_broadcast_initialize()
+{
+	size_t wcnt;
+	bool res;
+
+	res = false;
+	qsc_memutils_clear(&m_server_broadcast, sizeof(server_broadcast_pool));
+	m_server_broadcast.lock = qsc_async_mutex_create();
+	m_server_broadcast.ready = qsc_async_semaphore_create(0);
+	m_server_broadcast.done = qsc_async_semaphore_create(0);
+
+	if (m_server_broadcast.lock != NULL && m_server_broadcast.ready != NULL && m_server_broadcast.done != NULL)
+	{
+		/* the calling thread runs the first shard, a worker is started for each remaining core */
+		wcnt = qsc_intutils_min(qsc_async_processor_count(), (size_t)QSMP_SERVER_BROADCAST_SHARDS_MAX);
+		wcnt = (wcnt != 0) ? wcnt - 1 : 0;
+		m_server_broadcast.run = true;
+
+		for (size_t i = 0; i < wcnt; ++i)
+		{
+			m_server_broadcast.workers[i] = qsc_async_thread_create(&server_broadcast_worker, NULL);
+			m_server_broadcast.count += 1;
+		}
+
+		res = true;
+	}
+	else
+	{
+		if (m_server_broadcast.done != NULL)
+		{
+			qsc_async_semaphore_destroy(m_server_broadcast.done);
+			m_server_broadcast.done = NULL;
+		}
+
+		if (m_server_broadcast.ready != NULL)
+		{
+			qsc_async_semaphore_destroy(m_server_broadcast.ready);
+			m_server_broadcast.ready = NULL;
+		}
+
+		if (m_server_broadcast.lock != NULL)
+		{
+			qsc_async_mutex_destroy(m_server_broadcast.lock);
+			m_server_broadcast.lock = NULL;
+		}
+	}
+
+	return res;
+}
+
+#if !defined(QSMP_SERVER_REACTOR)
+static void server_receive_loop(server_receiver_state* prcv)
+{
+	assert(prcv != NULL);
+
+	struct timeval tv = { 0 };
+	qsc_socket_exceptions err;
+	qsmp_errors qerr;
+	size_t mlen;
+
+	tv.tv_usec = QSMP_SERVER_PAUSE_INTERVAL * 1000;
+
+	while (prcv->pcns->target.connection_status == qsc_socket_state_connected)
+	{
+		/* a receive that returns no data leaves the last error unchanged when the remote host has closed the channel,
+		   so the error left by a previous would block is cleared */
+		qsc_socket_set_last_error(qsc_socket_exception_success);
+		mlen = qsmp_record_buffer_receive(&prcv->pcns->rxbuf, &prcv->pcns->target);
+
+		if (mlen != 0)
+		{
+			qerr = qsmp_connection_dispatch(prcv->pcns, prcv->receive_callback, &server_receive_control);
+
+			if (qerr != qsmp_error_none)
+			{
+				server_connection_close(prcv->pcns, qerr);
+				break;
+			}
+		}
+		else
+		{
+			err = qsc_socket_get_last_error();
+
+			if (err == qsc_socket_exception_would_block)
+			{
+				if (server_connection_pending(prcv->pcns) == 0)
+				{
+					/* the session socket is non-blocking, the thread waits for the next record, or a shut down */
+					qsc_socket_receive_ready(&prcv->pcns->target, &tv);
+				}
+				else if (qsmp_connection_flush(prcv->pcns) == qsmp_error_none)
+				{
+					/* the records a broadcast left in the transmit queue are sent when the socket is writable */
+					if (server_connection_pending(prcv->pcns) != 0)
+					{
+						qsc_socket_send_ready(&prcv->pcns->target, &tv);
+					}
+				}
+				else
+				{
+					qsmp_log_write(qsmp_messages_connection_fail, (const char*)prcv->pcns->target.address);
+					server_connection_close(prcv->pcns, qsmp_error_channel_down);
+					break;
+				}
+			}
+			/* a receive that returns no data has been closed by the remote host */
+			else if (err != qsc_socket_exception_blocking_cancelled)
+			{
+				if (server_socket_error_fatal(err) == true)
+				{
+					qsmp_log_error(qsmp_messages_receive_fail, err, (const char*)prcv->pcns->target.address);
+					qsmp_log_write(qsmp_messages_connection_fail, (const char*)prcv->pcns->target.address);
+				}
+				else
+				{
+					qsmp_log_write(qsmp_messages_disconnect, (const char*)prcv->pcns->target.address);
+				}
+
+				server_connection_close(prcv->pcns, qsmp_error_channel_down);
+				break;
+			}
+		}
+	}
+
+	qsmp_connections_reset(prcv->pcns->instance);
+	qsc_memutils_alloc_free(prcv);
+	/* the server quit waits for the receive threads to release their sessions */
+	qsc_async_atomic_add(&m_server_receivers, -1);
+}
+#endif
+
+static uint32_t server_session_timer(void* state)
+{
+	qsmp_connection_state* cns;
+	qsmp_errors qerr;
+	uint32_t ival;
+
+	cns = (qsmp_connection_state*)state;
+	ival = 0;
+
+	if (qsc_socket_is_connected(&cns->target) == true && cns->exflag == qsmp_flag_session_established)
+	{
+		/* a session ends when the server key expires, or when the last keep alive was not answered */
+		if (m_server_key != NULL && qsc_timestamp_epochtime_seconds() > m_server_key->expiration)
+		{
+			qsmp_log_write(qsmp_messages_disconnect_fail, (const char*)cns->target.address);
+			qerr = qsmp_error_key_expired;
+		}
+		else
+		{
+			qerr = qsmp_connection_keepalive_request(cns);
+
+			if (qerr != qsmp_error_none)
+			{
+				qsmp_log_write(qsmp_messages_keepalive_timeout, (const char*)cns->target.address);
+			}
+		}
+
+		if (qerr == qsmp_error_none)
+		{
+			ival = QSMP_KEEPALIVE_TIMEOUT;
+		}
+		else
+		{
+			/* the thread servicing the session sees the shut down and releases the connection */
+			qsc_socket_shut_down_channels(&cns->target, qsc_socket_shut_down_flag_both);
+		}
+	}
+
+	return ival;
+}
+
+static void server_handshake_count(uint64_t* counter)
+{
+	qsc_async_mutex_lock(m_server_handshake.lock);
+	*counter += 1;
+	qsc_async_mutex_unlock(m_server_handshake.lock);
+}
+
+static void server_handshake_run(server_receiver_state* prcv)
+{
+	assert(prcv != NULL);
+
+	qsmp_kex_simplex_server_state* pkss;
+	qsmp_errors qerr;
+#if !defined(QSMP_SERVER_REACTOR)
+	uint32_t nblk;
+
+	nblk = 1;
+#endif
+
+	pkss = (qsmp_kex_simplex_server_state*)qsc_memutils_malloc(sizeof(qsmp_kex_simplex_server_state));
+
+	if (pkss != NULL)
+	{
+		server_state_initialize(pkss, prcv);
+		qerr = qsmp_kex_simplex_server_key_exchange(pkss, prcv->pcns);
+		qsc_memutils_alloc_free(pkss);
+
+		if (qerr == qsmp_error_none)
+		{
+			server_handshake_count(&m_server_handshake.stats.completed);
+			/* the session keep alive and key expiry checks are run by the timer service */
+			qsmp_timerwheel_schedule(&prcv->pcns->timer, QSMP_KEEPALIVE_TIMEOUT, &server_session_timer, prcv->pcns);
+
+#if defined(QSMP_SERVER_REACTOR)
+			/* hand the established session to a reactor worker, and release the handshake worker */
+			if (server_reactor_register(prcv->pcns) == true)
+			{
+				qsc_memutils_alloc_free(prcv);
+				prcv = NULL;
+			}
+#else
+			/* the send flush must not block, and the dont wait send flag is not supported on Windows,
+			   so the session socket is made non-blocking before the receive thread is started */
+			if (qsc_socket_ioctl(&prcv->pcns->target, FIONBIO, &nblk) == qsc_socket_exception_success)
+			{
+				qsc_async_atomic_add(&m_server_receivers, 1);
+
+				if (qsc_async_thread_create((void*)&server_receive_loop, prcv) != 0)
+				{
+					prcv = NULL;
+				}
+				else
+				{
+					qsc_async_atomic_add(&m_server_receivers, -1);
+				}
+			}
+#endif
+
+			if (prcv != NULL)
+			{
+				qsmp_log_write(qsmp_messages_connection_fail, (const char*)prcv->pcns->target.address);
+				qsmp_connection_close(prcv->pcns, qsmp_error_connection_failure, true);
+			}
+		}
+		else
+		{
+			server_handshake_count(&m_server_handshake.stats.failed);
+			qsmp_log_message(qsmp_messages_kex_fail);
+		}
+	}
+	else
+	{
+		qsmp_log_message(qsmp_messages_allocate_fail);
+	}
+
+	if (prcv != NULL)
+	{
+		qsmp_connections_reset(prcv->pcns->instance);
+		qsc_memutils_alloc_free(prcv);
+		prcv = NULL;
+	}
+}
+
+static void server_handshake_worker(void* state)
+{
+	server_receiver_state* prcv;
+
+	(void)state;
+
+	do
+	{
+		qsc_async_semaphore_wait(m_server_handshake.ready);
+		qsc_async_mutex_lock(m_server_handshake.lock);
+		prcv = NULL;
+
+		if (m_server_handshake.stats.depth != 0)
+		{
+			prcv = m_server_handshake.queue[m_server_handshake.head];
+			m_server_handshake.queue[m_server_handshake.head] = NULL;
+			m_server_handshake.head = (m_server_handshake.head + 1) % QSMP_SERVER_HANDSHAKE_QUEUE_SIZE;
+			m_server_handshake.stats.depth -= 1;
+		}
+
+		qsc_async_mutex_unlock(m_server_handshake.lock);
+
+		/* a wake with an empty queue is the stop signal */
+		if (prcv != NULL)
+		{
+			server_handshake_run(prcv);
+		}
+	} 
+	while (prcv != NULL);
+}
+
+static bool server_handshake_admit(server_receiver_state* prcv)
+{
+	assert(prcv != NULL);
+
+	size_t tail;
+	bool res;
+
+	res = false;
+	qsc_async_mutex_lock(m_server_handshake.lock);
+
+	/* the queue is bounded, so key exchanges are admitted no faster than the workers complete them */
+	if (m_server_handshake.stats.workers != 0 && m_server_handshake.stats.depth < QSMP_SERVER_HANDSHAKE_QUEUE_SIZE)
+	{
+		tail = (m_server_handshake.head + (size_t)m_server_handshake.stats.depth) % QSMP_SERVER_HANDSHAKE_QUEUE_SIZE;
+		m_server_handshake.queue[tail] = prcv;
+		m_server_handshake.stats.depth += 1;
+		m_server_handshake.stats.admitted += 1;
+
+		if (m_server_handshake.stats.depth > m_server_handshake.stats.depthmax)
+		{
+			m_server_handshake.stats.depthmax = m_server_handshake.stats.depth;
+		}
+
+		res = true;
+	}
+	else
+	{
+		m_server_handshake.stats.refused += 1;
+	}
+
+	qsc_async_mutex_unlock(m_server_handshake.lock);
+
+	if (res == true)
+	{
+		qsc_async_semaphore_post(m_server_handshake.ready);
+	}
+
+	return res;
+}
+
+static void server_handshake_clear()
+{
+	server_receiver_state* prcv;
+
+	if (m_server_handshake.lock != NULL)
+	{
+		qsc_async_mutex_lock(m_server_handshake.lock);
+
+		/* connections still waiting for a worker are released with the connection table */
+		while (m_server_handshake.stats.depth != 0)
+		{
+			prcv = m_server_handshake.queue[m_server_handshake.head];
+			m_server_handshake.queue[m_server_handshake.head] = NULL;
+			m_server_handshake.head = (m_server_handshake.head + 1) % QSMP_SERVER_HANDSHAKE_QUEUE_SIZE;
+			m_server_handshake.stats.depth -= 1;
+			qsc_memutils_alloc_free(prcv);
+		}
+
+		qsc_async_mutex_unlock(m_server_handshake.lock);
+	}
+}
+
+static void server_handshake_dispose()
+{
+	size_t wcnt;
+
+	if (m_server_handshake.lock != NULL)
+	{
+		server_handshake_clear();
+		qsc_async_mutex_lock(m_server_handshake.lock);
+		wcnt = (size_t)m_server_handshake.stats.workers;
+		m_server_handshake.stats.workers = 0;
+		qsc_async_mutex_unlock(m_server_handshake.lock);
+
+		for (size_t i = 0; i < wcnt; ++i)
+		{
+			qsc_async_semaphore_post(m_server_handshake.ready);
+		}
+
+		qsc_async_thread_wait_all(m_server_handshake.workers, wcnt);
+		qsc_async_semaphore_destroy(m_server_handshake.ready);
+		qsc_async_mutex_destroy(m_server_handshake.lock);
+		m_server_handshake.ready = NULL;
+		m_server_handshake.lock = NULL;
+		m_server_handshake.head = 0;
+	}
+}
+
+static bool server_handshake_initialize()
+{
+	size_t wcnt;
+	bool res;
+
+	res = false;
+	qsc_memutils_clear(&m_server_handshake, sizeof(server_handshake_pool));
+	m_server_handshake.lock = qsc_async_mutex_create();
+	m_server_handshake.ready = qsc_async_semaphore_create(0);
+
+	if (m_server_handshake.lock != NULL && m_server_handshake.ready != NULL)
+	{
+		/* one worker per core, the key exchange is processor bound */
+		wcnt = qsc_intutils_min(qsc_async_processor_count(), QSMP_SERVER_HANDSHAKE_WORKERS_MAX);
+
+		for (size_t i = 0; i < wcnt; ++i)
+		{
+			m_server_handshake.workers[i] = qsc_async_thread_create(&server_handshake_worker, NULL);
+			m_server_handshake.stats.workers += 1;
+		}
+
+		res = true;
+	}
+	else
+	{
+		if (m_server_handshake.ready != NULL)
+		{
+			qsc_async_semaphore_destroy(m_server_handshake.ready);
+			m_server_handshake.ready = NULL;
+		}
+
+		if (m_server_handshake.lock != NULL)
+		{
+			qsc_async_mutex_destroy(m_server_handshake.lock);
+			m_server_handshake.lock = NULL;
+		}
+	}
+
+	return res;
+}
+
+static void server_accept_loop(server_listener_state* plst)
+{
+	assert(plst != NULL);
+
+	qsc_socket target;
+	qsc_socket_exceptions res;
+
+	plst->qerr = qsmp_error_none;
+
+	while (m_server_run == true)
+	{
+		qsc_memutils_clear(&target, sizeof(qsc_socket));
+		res = qsc_socket_accept(plst->source, &target);
+
+		if (res == qsc_socket_exception_success)
+		{
+			/* the slot is taken after the accept, so a slot is never active without a connected socket,
+			   each listener takes slots from its own shard of the connection table,
+			   a slot is reset only by the thread that owns the session, the handshake worker, receiver or reactor */
+			qsmp_connection_state* cns = qsmp_connections_next_shard(plst->shard);
+
+			if (cns != NULL)
+			{
+				server_receiver_state* rctx = (server_receiver_state*)qsc_memutils_malloc(sizeof(server_receiver_state));
+
+				if (rctx != NULL)
+				{
+					qsc_memutils_copy(&cns->target, &target, sizeof(qsc_socket));
+					cns->target.connection_status = qsc_socket_state_connected;
+					rctx->pcns = cns;
+					rctx->pprik = plst->pprik;
+					rctx->receive_callback = plst->receive_callback;
+
+					/* the key exchange is queued to the handshake workers, a connection is refused when the queue is full */
+					if (server_handshake_admit(rctx) == true)
+					{
+						qsmp_log_write(qsmp_messages_connect_success, (const char*)cns->target.address);
+					}
+					else
+					{
+						qsmp_log_write(qsmp_messages_queue_empty, (const char*)cns->target.address);
+						qsc_socket_close_socket(&cns->target);
+						qsmp_connections_reset(cns->instance);
+						qsc_memutils_alloc_free(rctx);
+					}
+				}
+				else
+				{
+					qsc_socket_close_socket(&target);
+					qsmp_connections_reset(cns->instance);
+					plst->qerr = qsmp_error_memory_allocation;
+					qsmp_log_message(qsmp_messages_sockalloc_fail);
+				}
+			}
+			else
+			{
+				qsc_socket_close_socket(&target);
+				plst->qerr = qsmp_error_hosts_exceeded;
+				qsmp_log_message(qsmp_messages_queue_empty);
+			}
+		}
+		else
+		{
+			/* the listener is shut down when the server quits */
+			if (m_server_run == true)
+			{
+				plst->qerr = qsmp_error_accept_fail;
+				qsmp_log_message(qsmp_messages_accept_fail);
+			}
+		}
+
+		while (m_server_pause == true && m_server_run == true)
+		{
+			qsc_async_thread_sleep(QSMP_SERVER_PAUSE_INTERVAL);
+		}
+	}
+
+	/* the server quit waits for the accept loops to return before the connection table is released */
+	qsc_async_atomic_add(&m_server_listeners.accepting, -1);
+}
+
+static qsmp_errors server_listen_ipv4(qsc_socket* source, bool shared)
+{
+	assert(source != NULL);
+
+	qsc_ipinfo_ipv4_address addt = { 0 };
+	qsc_socket_exceptions res;
+	qsmp_errors qerr;
+
+	addt = qsc_ipinfo_ipv4_address_any();
+	qsc_socket_server_initialize(source);
+	res = qsc_socket_create(source, qsc_socket_address_family_ipv4, qsc_socket_transport_stream, qsc_socket_protocol_tcp);
+
+	if (res == qsc_socket_exception_success)
+	{
+		/* port sharing must be enabled on every listener before it is bound */
+		if (shared == true)
+		{
+			res = qsc_socket_set_reuse_port(source, true);
+		}
+
+		if (res == qsc_socket_exception_success)
+		{
+			res = qsc_socket_bind_ipv4(source, &addt, QSMP_SERVER_PORT);
+
+			if (res == qsc_socket_exception_success)
+			{
+				res = qsc_socket_listen(source, QSC_SOCKET_SERVER_LISTEN_BACKLOG);
+
+				if (res == qsc_socket_exception_success)
+				{
+					qerr = qsmp_error_none;
+				}
+				else
+				{
+					qerr = qsmp_error_listener_fail;
+					qsmp_log_message(qsmp_messages_listener_fail);
+				}
+			}
+			else
+			{
+				qerr = qsmp_error_connection_failure;
+				qsmp_log_message(qsmp_messages_bind_fail);
+			}
+		}
+		else
+		{
+			qerr = qsmp_error_listener_fail;
+			qsmp_log_message(qsmp_messages_listener_fail);
+		}
+
+		if (qerr != qsmp_error_none)
+		{
+			qsc_socket_close_socket(source);
+		}
+	}
+	else
+	{
+		qerr = qsmp_error_connection_failure;
+		qsmp_log_message(qsmp_messages_create_fail);
+	}
+
+	return qerr;
+}
+
+static qsmp_errors server_listen_ipv6(qsc_socket* source, bool shared)
+{
+	assert(source != NULL);
+
+	qsc_ipinfo_ipv6_address addt = { 0 };
+	qsc_socket_exceptions res;
+	qsmp_errors qerr;
+
+	addt = qsc_ipinfo_ipv6_address_any();
+	qsc_socket_server_initialize(source);
+	res = qsc_socket_create(source, qsc_socket_address_family_ipv6, qsc_socket_transport_stream, qsc_socket_protocol_tcp);
+
+	if (res == qsc_socket_exception_success)
+	{
+		/* port sharing must be enabled on every listener before it is bound */
+		if (shared == true)
+		{
+			res = qsc_socket_set_reuse_port(source, true);
+		}
+
+		if (res == qsc_socket_exception_success)
+		{
+			res = qsc_socket_bind_ipv6(source, &addt, QSMP_SERVER_PORT);
+
+			if (res == qsc_socket_exception_success)
+			{
+				res = qsc_socket_listen(source, QSC_SOCKET_SERVER_LISTEN_BACKLOG);
+
+				if (res == qsc_socket_exception_success)
+				{
+					qerr = qsmp_error_none;
+				}
+				else
+				{
+					qerr = qsmp_error_listener_fail;
+					qsmp_log_message(qsmp_messages_listener_fail);
+				}
+			}
+			else
+			{
+				qerr = qsmp_error_connection_failure;
+				qsmp_log_message(qsmp_messages_bind_fail);
+			}
+		}
+		else
+		{
+			qerr = qsmp_error_listener_fail;
+			qsmp_log_message(qsmp_messages_listener_fail);
+		}
+
+		if (qerr != qsmp_error_none)
+		{
+			qsc_socket_close_socket(source);
+		}
+	}
+	else
+	{
+		qerr = qsmp_error_connection_failure;
+		qsmp_log_message(qsmp_messages_create_fail);
+	}
 
-static void server_state_initialize(qsmp_kex_simplex_server_state* kss, const server_receiver_state* prcv)
-{
-	qsc_memutils_copy(kss->keyid, prcv->pprik->keyid, QSMP_KEYID_SIZE);
-	qsc_memutils_copy(kss->sigkey, prcv->pprik->sigkey, QSMP_ASYMMETRIC_SIGNING_KEY_SIZE);
-	qsc_memutils_copy(kss->verkey, prcv->pprik->verkey, QSMP_ASYMMETRIC_VERIFY_KEY_SIZE);
-	qsc_memutils_clear(&prcv->pcns->rtcs, QSMP_DUPLEX_SYMMETRIC_KEY_SIZE);
-	kss->expiration = prcv->pprik->expiration;
-	qsc_rcs_dispose(&prcv->pcns->rxcpr);
-	qsc_rcs_dispose(&prcv->pcns->txcpr);
-	prcv->pcns->exflag = qsmp_flag_none;
-	prcv->pcns->instance = 0;
-	prcv->pcns->rxseq = 0;
-	prcv->pcns->txseq = 0;
+	return qerr;
 }
 
-static void server_poll_sockets()
+static void server_dispose()
 {
 	size_t clen;
-	qsc_mutex mtx;
 
+	/* the broadcast workers are stopped before the sessions they queue to are released */
+	server_broadcast_dispose();
+
+	/* the handshake workers are joined first, a worker may hand a session to a receive thread or reactor worker */
+	server_handshake_dispose();
+
+#if defined(QSMP_SERVER_REACTOR)
+	/* stop the reactor workers before the sessions they service are released */
+	server_reactor_dispose();
+#else
+	/* each receive thread closes and resets its own session */
+	while (qsc_async_atomic_add(&m_server_receivers, 0) > 0)
+	{
+		qsc_async_thread_sleep(1);
+	}
+#endif
+
+	/* the remaining sessions have no thread servicing them, and are released here */
 	clen = qsmp_connections_size();
 
 	for (size_t i = 0; i < clen; ++i)
@@ -49,224 +1209,237 @@ static void server_poll_sockets()
 
 		if (cns != NULL && qsmp_connections_active(i) == true)
 		{
-			mtx = qsc_async_mutex_lock_ex();
+			/* wait for any send in progress before the socket is closed */
+			qsc_async_mutex_lock(cns->txlock);
 
-			if (qsc_socket_is_connected(&cns->target) == false)
+			if (qsc_socket_is_connected(&cns->target) == true)
 			{
-				qsmp_connections_reset(cns->instance);
+				qsc_socket_close_socket(&cns->target);
 			}
 
-			qsc_async_mutex_unlock_ex(mtx);
+			qsc_async_mutex_unlock(cns->txlock);
+			qsmp_connections_reset(cns->instance);
 		}
 	}
+
+	qsmp_kex_fastopen_dispose(&m_server_fastopen);
+	qsmp_connections_dispose();
+
+	/* the timer service is shared, and is only stopped if this server started it */
+	if (m_server_timers == true)
+	{
+		qsmp_timerwheel_stop();
+		m_server_timers = false;
+	}
+
+	qsmp_bufferpool_dispose();
+	qsc_memutils_clear(m_server_ticket_key, sizeof(m_server_ticket_key));
+	m_server_key = NULL;
 }
-// TODO: check buffer sizes, can we reduce buffer to MTU size?
-// do we need 3 buffers here?
-static void server_receive_loop(server_receiver_state* prcv)
+
+static qsmp_errors server_start(const qsmp_server_signature_key* kset, 
+	qsc_socket* sources, 
+	size_t count,
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
 {
-	assert(prcv != NULL);
+	assert(kset != NULL);
+	assert(sources != NULL);
+	assert(count != 0);
+	assert(receive_callback != NULL);
 
-	uint8_t buffer[QSMP_CONNECTION_MTU] = { 0 };
-	char mstr[QSMP_CONNECTION_MTU + 1] = { 0 };
-	uint8_t pmsg[QSMP_MESSAGE_MAX] = { 0 };
-	qsmp_packet pkt = { 0 };
-	qsmp_kex_simplex_server_state* pkss;
+	server_listener_state* plst;
 	qsmp_errors qerr;
-	size_t mlen;
 
-	pkss = (qsmp_kex_simplex_server_state*)qsc_memutils_malloc(sizeof(qsmp_kex_simplex_server_state));
+	qerr = qsmp_error_none;
+	m_server_pause = false;
+	m_server_run = true;
+	m_server_key = kset;
+	/* the ticket key lives for the lifetime of the server, tickets issued before a restart are refused */
+	qsc_acp_generate(m_server_ticket_key, sizeof(m_server_ticket_key));
+	qsmp_logger_initialize(NULL);
+	/* the connection table is divided into one shard per listener */
+	qsmp_connections_initialize_sharded(QSMP_CONNECTIONS_INIT, QSMP_CONNECTIONS_MAX, count);
 
-	if (pkss != NULL)
+	m_server_timers = qsmp_timerwheel_start(true);
+
+	if (m_server_timers == false || server_handshake_initialize() == false || server_broadcast_initialize() == false ||
+		qsmp_kex_fastopen_initialize(&m_server_fastopen) == false)
 	{
-		server_state_initialize(pkss, prcv);
-		qerr = qsmp_kex_simplex_server_key_exchange(pkss, prcv->pcns);
-		qsc_memutils_alloc_free(pkss);
+		qsmp_log_message(qsmp_messages_listener_fail);
+		qerr = qsmp_error_listener_fail;
+		m_server_run = false;
+	}
 
-		if (qerr == qsmp_error_none)
-		{
-			while (prcv->pcns->target.connection_status == qsc_socket_state_connected)
-			{
-				mlen = qsc_socket_receive(&prcv->pcns->target, buffer, sizeof(buffer), qsc_socket_receive_flag_none);
+#if defined(QSMP_SERVER_REACTOR)
+	if (m_server_run == true && server_reactor_initialize(receive_callback) == false)
+	{
+		qsmp_log_message(qsmp_messages_listener_fail);
+		qerr = qsmp_error_listener_fail;
+		m_server_run = false;
+	}
+#endif
 
-				if (mlen != 0)
-				{
-					/* convert the bytes to packet */
-					pkt.pmessage = pmsg;
-					qsmp_stream_to_packet(buffer, &pkt);
-					qsc_memutils_clear(buffer, mlen);
+	if (m_server_run == true)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			plst = &m_server_listeners.listeners[i];
+			plst->source = &sources[i];
+			plst->pprik = kset;
+			plst->receive_callback = receive_callback;
+			plst->shard = i;
+			plst->qerr = qsmp_error_none;
+		}
 
-					if (pkt.flag == qsmp_flag_encrypted_message)
-					{
-						qerr = qsmp_decrypt_packet(prcv->pcns, (uint8_t*)mstr, &mlen, &pkt);
-
-						if (qerr == qsmp_error_none)
-						{
-							mlen = qsc_stringutils_string_size(mstr);
-							prcv->receive_callback(prcv->pcns, mstr, mlen);
-							qsc_memutils_clear(mstr, mlen);
-						}
-						else
-						{
-							/* close the connection on authentication failure */
-							qsmp_log_write(qsmp_messages_decryption_fail, (const char*)prcv->pcns->target.address);
-							qsmp_connection_close(prcv->pcns, qsmp_error_authentication_failure, true);
-							break; 
-						}
-					}
-					else if (pkt.flag == qsmp_flag_connection_terminate)
-					{
-						qsmp_log_write(qsmp_messages_disconnect, (const char*)prcv->pcns->target.address);
-						qsmp_connection_close(prcv->pcns, qsmp_error_none, false);
-						break;
-					}
-					else
-					{
-						/* unknown message type, we fail out of caution but could ignore */
-						qsmp_log_write(qsmp_messages_receive_fail, (const char*)prcv->pcns->target.address);
-						qsmp_connection_close(prcv->pcns, qsmp_error_connection_failure, true);
-						break;
-					}
-				}
-				else
-				{
-					qsc_socket_exceptions err = qsc_socket_get_last_error();
+		m_server_listeners.count = count;
+		m_server_listeners.accepting = (int32_t)count;
 
-					if (err != qsc_socket_exception_success)
-					{
-						qsmp_log_error(qsmp_messages_receive_fail, err, (const char*)prcv->pcns->target.address);
-
-						/* fatal socket errors */
-						if (err == qsc_socket_exception_circuit_reset ||
-							err == qsc_socket_exception_circuit_terminated ||
-							err == qsc_socket_exception_circuit_timeout ||
-							err == qsc_socket_exception_dropped_connection ||
-							err == qsc_socket_exception_network_failure ||
-							err == qsc_socket_exception_shut_down)
-						{
-							qsmp_log_write(qsmp_messages_connection_fail, (const char*)prcv->pcns->target.address);
-							qsmp_connection_close(prcv->pcns, qsmp_error_channel_down, false);
-							break;
-						}
-					}
-				}
-			}
-		}
-		else
+		/* each listener has its own accept thread, the first is run on the calling thread */
+		for (size_t i = 1; i < count; ++i)
 		{
-			qsmp_log_message(qsmp_messages_kex_fail);
+			m_server_listeners.threads[i] = qsc_async_thread_create((void*)&server_accept_loop, &m_server_listeners.listeners[i]);
 		}
 
-		if (prcv != NULL)
+		server_accept_loop(&m_server_listeners.listeners[0]);
+
+		if (count > 1)
 		{
-			qsmp_connections_reset(prcv->pcns->instance);
-			qsc_memutils_alloc_free(prcv);
-			prcv = NULL;
+			qsc_async_thread_wait_all(m_server_listeners.threads + 1, count - 1);
 		}
+
+		qerr = m_server_listeners.listeners[0].qerr;
+		m_server_listeners.count = 0;
 	}
 	else
 	{
-		qsmp_log_message(qsmp_messages_allocate_fail);
+		/* undo the steps that succeeded, the teardown skips any step that was not reached */
+		server_dispose();
+
+		/* the listeners bound for this server are closed */
+		for (size_t i = 0; i < count; ++i)
+		{
+			qsc_socket_close_socket(&sources[i]);
+		}
 	}
+
+	return qerr;
 }
 
-static qsmp_errors server_start(const qsmp_server_signature_key* kset, 
-	const qsc_socket* source, 
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t))
-{
-	assert(kset != NULL);
-	assert(source != NULL);
-	assert(receive_callback != NULL);
+/* Public Functions */
 
-	qsc_socket_exceptions res;
-	qsmp_errors qerr;
+void qsmp_server_broadcast(const uint8_t* message, size_t msglen)
+{
+	assert(message != NULL);
 
-	qerr = qsmp_error_none;
-	m_server_pause = false;
-	m_server_run = true;
-	qsmp_logger_initialize(NULL);
-	qsmp_connections_initialize(QSMP_CONNECTIONS_INIT, QSMP_CONNECTIONS_MAX);
+	server_broadcast_shard* pshd;
+	qsc_mutex mtx;
+	uint64_t tlat;
+	uint64_t tstart;
+	size_t acnt;
+	size_t clen;
+	size_t scnt;
+	size_t slen;
 
-	do
+	/* the shard workers run while the server is started */
+	if (message != NULL && msglen != 0 && m_server_broadcast.lock != NULL)
 	{
-		qsmp_connection_state* cns = qsmp_connections_next();
+		/* broadcasts share the shard workers, and are run one at a time */
+		qsc_async_mutex_lock(m_server_broadcast.lock);
+		tstart = qsc_timerex_stopwatch_microseconds();
+		clen = qsmp_connections_size();
+
+		acnt = clen - qsc_intutils_min(qsmp_connections_available(), clen);
+
+		/* one shard per worker and one for the caller, a small number of sessions is not split below the minimum shard size */
+		scnt = m_server_broadcast.count + 1;
+		scnt = qsc_intutils_min(scnt, (acnt + QSMP_SERVER_BROADCAST_SHARD_MIN - 1) / QSMP_SERVER_BROADCAST_SHARD_MIN);
+		scnt = qsc_intutils_max(scnt, (size_t)1);
+		slen = (clen + scnt - 1) / scnt;
 
-		if (cns != NULL)
+		for (size_t i = 0; i < scnt; ++i)
 		{
-			res = qsc_socket_accept(source, &cns->target);
+			pshd = &m_server_broadcast.shards[i];
+			qsc_memutils_clear(pshd, sizeof(server_broadcast_shard));
+			pshd->message = message;
+			pshd->msglen = msglen;
+			pshd->first = qsc_intutils_min(i * slen, clen);
+			pshd->last = qsc_intutils_min(pshd->first + slen, clen);
+		}
 
-			if (res == qsc_socket_exception_success)
-			{
-				server_receiver_state* rctx = (server_receiver_state*)qsc_memutils_malloc(sizeof(server_receiver_state));
+		/* the remaining shards are handed to the workers, the first is run on the calling thread */
+		m_server_broadcast.next = 1;
 
-				if (rctx != NULL)
-				{
-					cns->target.connection_status = qsc_socket_state_connected;
-					rctx->pcns = cns;
-					rctx->pprik = kset;
-					rctx->receive_callback = receive_callback;
+		for (size_t i = 1; i < scnt; ++i)
+		{
+			qsc_async_semaphore_post(m_server_broadcast.ready);
+		}
 
-					qsmp_log_write(qsmp_messages_connect_success, (const char*)cns->target.address);
-					qsc_async_thread_create((void*)&server_receive_loop, rctx);
-					server_poll_sockets();
-				}
-				else
-				{
-					qsmp_connections_reset(cns->instance);
-					qerr = qsmp_error_memory_allocation;
-					qsmp_log_message(qsmp_messages_sockalloc_fail);
-				}
-			}
-			else
-			{
-				qsmp_connections_reset(cns->instance);
-				qerr = qsmp_error_accept_fail;
-				qsmp_log_message(qsmp_messages_accept_fail);
-			}
+		server_broadcast_shard_run(&m_server_broadcast.shards[0]);
+
+		for (size_t i = 1; i < scnt; ++i)
+		{
+			qsc_async_semaphore_wait(m_server_broadcast.done);
 		}
-		else
+
+		tlat = qsc_timerex_stopwatch_microseconds() - tstart;
+
+		mtx = qsc_async_mutex_lock_ex();
+		m_server_broadcast_stats.broadcasts += 1;
+
+		for (size_t i = 0; i < scnt; ++i)
 		{
-			qerr = qsmp_error_hosts_exceeded;
-			qsmp_log_message(qsmp_messages_queue_empty);
+			pshd = &m_server_broadcast.shards[i];
+			m_server_broadcast_stats.delivered += pshd->delivered;
+			m_server_broadcast_stats.dropped += pshd->dropped;
+			m_server_broadcast_stats.disconnected += pshd->disconnected;
+			m_server_broadcast_stats.busy += pshd->busy;
 		}
 
-		while (m_server_pause == true)
+		m_server_broadcast_stats.latency = tlat;
+
+		if (tlat > m_server_broadcast_stats.latencymax)
 		{
-			qsc_async_thread_sleep(QSMP_SERVER_PAUSE_INTERVAL);
+			m_server_broadcast_stats.latencymax = tlat;
 		}
-	} 
-	while (m_server_run == true);
 
-	return qerr;
+		m_server_broadcast_stats.latencytotal += tlat;
+		qsc_async_mutex_unlock_ex(mtx);
+		qsc_async_mutex_unlock(m_server_broadcast.lock);
+	}
 }
 
-/* Public Functions */
+void qsmp_server_broadcast_policy(qsmp_broadcast_policies policy)
+{
+	m_server_broadcast_policy = policy;
+}
 
-void qsmp_server_broadcast(const uint8_t* message, size_t msglen)
+void qsmp_server_broadcast_statistics(qsmp_broadcast_statistics* stats)
 {
-	size_t clen;
-	size_t mlen;
-	qsc_mutex mtx;
-	qsmp_packet pkt = { 0 };
-	uint8_t msgstr[QSMP_MESSAGE_MAX] = { 0 };
+	assert(stats != NULL);
 
-	clen = qsmp_connections_size();
+	qsc_mutex mtx;
 
-	for (size_t i = 0; i < clen; ++i)
+	if (stats != NULL)
 	{
-		qsmp_connection_state* cns = qsmp_connections_index(i);
+		mtx = qsc_async_mutex_lock_ex();
+		qsc_memutils_copy(stats, &m_server_broadcast_stats, sizeof(qsmp_broadcast_statistics));
+		qsc_async_mutex_unlock_ex(mtx);
+	}
+}
 
-		if (cns != NULL && qsmp_connections_active(i) == true)
-		{
-			mtx = qsc_async_mutex_lock_ex();
+void qsmp_server_handshake_statistics(qsmp_handshake_statistics* stats)
+{
+	assert(stats != NULL);
 
-			if (qsc_socket_is_connected(&cns->target) == true)
-			{
-				qsmp_encrypt_packet(cns, &pkt, message, msglen);
-				mlen = qsmp_packet_to_stream(&pkt, msgstr);
-				qsc_socket_send(&cns->target, msgstr, mlen, qsc_socket_send_flag_none);
-			}
+	if (stats != NULL)
+	{
+		qsc_memutils_clear(stats, sizeof(qsmp_handshake_statistics));
 
-			qsc_async_mutex_unlock_ex(mtx);
+		if (m_server_handshake.lock != NULL)
+		{
+			qsc_async_mutex_lock(m_server_handshake.lock);
+			qsc_memutils_copy(stats, &m_server_handshake.stats, sizeof(qsmp_handshake_statistics));
+			qsc_async_mutex_unlock(m_server_handshake.lock);
 		}
 	}
 }
@@ -279,31 +1452,38 @@ void qsmp_server_pause()
 void qsmp_server_quit()
 {
 	size_t clen;
-	qsc_mutex mtx;
 
+	m_server_run = false;
+
+	/* shutting down the listeners returns each accept loop */
+	for (size_t i = 0; i < m_server_listeners.count; ++i)
+	{
+		qsc_socket_shut_down_channels(m_server_listeners.listeners[i].source, qsc_socket_shut_down_flag_both);
+	}
+
+	/* no connection is accepted once the accept loops have returned */
+	while (qsc_async_atomic_add(&m_server_listeners.accepting, 0) > 0)
+	{
+		qsc_async_thread_sleep(1);
+	}
+
+	/* connections waiting for a key exchange are released, and no more are admitted */
+	server_handshake_clear();
 	clen = qsmp_connections_size();
 
+	/* shutting down the sessions ends any key exchange in progress, and returns each receive thread */
 	for (size_t i = 0; i < clen; ++i)
 	{
 		const qsmp_connection_state* cns = qsmp_connections_index(i);
 
-		if (cns != NULL && qsmp_connections_active(i) == true)
+		if (cns != NULL && qsmp_connections_active(i) == true && qsc_socket_is_connected(&cns->target) == true)
 		{
-			mtx = qsc_async_mutex_lock_ex();
-
-			if (qsc_socket_is_connected(&cns->target) == true)
-			{
-				qsc_socket_close_socket(&cns->target);
-			}
-
-			qsmp_connections_reset(cns->instance);
-
-			qsc_async_mutex_unlock_ex(mtx);
+			qsc_socket_shut_down_channels(&cns->target, qsc_socket_shut_down_flag_both);
 		}
 	}
 
-	qsmp_connections_dispose();
-	m_server_run = false;
+	/* the threads and sessions are released with the same teardown as a failed start */
+	server_dispose();
 }
 
 void qsmp_server_resume()
@@ -313,96 +1493,142 @@ void qsmp_server_resume()
 
 qsmp_errors qsmp_server_start_ipv4(qsc_socket* source, 
 	const qsmp_server_signature_key* kset,
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t))
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
 {
+	assert(source != NULL);
 	assert(kset != NULL);
 	assert(receive_callback != NULL);
 
-	qsc_ipinfo_ipv4_address addt = { 0 };
-	qsc_socket_exceptions res;
 	qsmp_errors qerr;
 
-	addt = qsc_ipinfo_ipv4_address_any();
-	qsc_socket_server_initialize(source);
-	res = qsc_socket_create(source, qsc_socket_address_family_ipv4, qsc_socket_transport_stream, qsc_socket_protocol_tcp);
+	qerr = server_listen_ipv4(source, false);
 
-	if (res == qsc_socket_exception_success)
+	if (qerr == qsmp_error_none)
 	{
-		res = qsc_socket_bind_ipv4(source, &addt, QSMP_SERVER_PORT);
+		qerr = server_start(kset, source, 1, receive_callback);
+	}
 
-		if (res == qsc_socket_exception_success)
+	return qerr;
+}
+
+qsmp_errors qsmp_server_start_ipv6(qsc_socket* source,
+	const qsmp_server_signature_key* kset,
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
+{
+	assert(source != NULL);
+	assert(kset != NULL);
+	assert(receive_callback != NULL);
+
+	qsmp_errors qerr;
+
+	qerr = server_listen_ipv6(source, false);
+
+	if (qerr == qsmp_error_none)
+	{
+		qerr = server_start(kset, source, 1, receive_callback);
+	}
+
+	return qerr;
+}
+
+qsmp_errors qsmp_server_start_sharded_ipv4(qsc_socket* sources, 
+	size_t count,
+	const qsmp_server_signature_key* kset,
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
+{
+	assert(sources != NULL);
+	assert(count != 0);
+	assert(kset != NULL);
+	assert(receive_callback != NULL);
+
+	size_t lcnt;
+	qsmp_errors qerr;
+
+	lcnt = 0;
+	qerr = qsmp_error_invalid_input;
+
+	if (sources != NULL && count != 0)
+	{
+		count = qsc_intutils_min(count, (size_t)QSMP_SERVER_LISTENERS_MAX);
+
+		/* without port sharing a single listener is opened */
+		for (size_t i = 0; i < count; ++i)
 		{
-			res = qsc_socket_listen(source, QSC_SOCKET_SERVER_LISTEN_BACKLOG);
+			qerr = server_listen_ipv4(&sources[i], (count > 1));
 
-			if (res == qsc_socket_exception_success)
-			{
-				qerr = server_start(kset, source, receive_callback);
-			}
-			else
+			if (qerr != qsmp_error_none)
 			{
-				qerr = qsmp_error_listener_fail;
-				qsmp_log_message(qsmp_messages_listener_fail);
+				if (i == 0 && count > 1)
+				{
+					count = 1;
+					qerr = server_listen_ipv4(&sources[i], false);
+				}
+
+				if (qerr != qsmp_error_none)
+				{
+					break;
+				}
 			}
+
+			++lcnt;
 		}
-		else
+
+		if (lcnt != 0)
 		{
-			qerr = qsmp_error_connection_failure;
-			qsmp_log_message(qsmp_messages_bind_fail);
+			qerr = server_start(kset, sources, lcnt, receive_callback);
 		}
 	}
-	else
-	{
-		qerr = qsmp_error_connection_failure;
-		qsmp_log_message(qsmp_messages_create_fail);
-	}
 
 	return qerr;
 }
 
-qsmp_errors qsmp_server_start_ipv6(qsc_socket* source,
+qsmp_errors qsmp_server_start_sharded_ipv6(qsc_socket* sources,
+	size_t count,
 	const qsmp_server_signature_key* kset,
-	void (*receive_callback)(qsmp_connection_state*, const char*, size_t))
+	void (*receive_callback)(qsmp_connection_state*, const uint8_t*, size_t))
 {
+	assert(sources != NULL);
+	assert(count != 0);
 	assert(kset != NULL);
 	assert(receive_callback != NULL);
 
-	qsc_ipinfo_ipv6_address addt = { 0 };
-	qsc_socket_exceptions res;
+	size_t lcnt;
 	qsmp_errors qerr;
 
-	addt = qsc_ipinfo_ipv6_address_any();
-	qsc_socket_server_initialize(source);
-	res = qsc_socket_create(source, qsc_socket_address_family_ipv6, qsc_socket_transport_stream, qsc_socket_protocol_tcp);
+	lcnt = 0;
+	qerr = qsmp_error_invalid_input;
 
-	if (res == qsc_socket_exception_success)
+	if (sources != NULL && count != 0)
 	{
-		res = qsc_socket_bind_ipv6(source, &addt, QSMP_SERVER_PORT);
+		count = qsc_intutils_min(count, (size_t)QSMP_SERVER_LISTENERS_MAX);
 
-		if (res == qsc_socket_exception_success)
+		/* without port sharing a single listener is opened */
+		for (size_t i = 0; i < count; ++i)
 		{
-			res = qsc_socket_listen(source, QSC_SOCKET_SERVER_LISTEN_BACKLOG);
+			qerr = server_listen_ipv6(&sources[i], (count > 1));
 
-			if (res == qsc_socket_exception_success)
+			if (qerr != qsmp_error_none)
 			{
-				qerr = server_start(kset, source, receive_callback);
-			}
-			else
-			{
-				qerr = qsmp_error_listener_fail;
-				qsmp_log_message(qsmp_messages_listener_fail);
+				if (i == 0 && count > 1)
+				{
+					count = 1;
+					qerr = server_listen_ipv6(&sources[i], false);
+				}
+
+				if (qerr != qsmp_error_none)
+				{
+					break;
+				}
 			}
+
+			++lcnt;
 		}
-		else
+
+		if (lcnt != 0)
 		{
-			qerr = qsmp_error_connection_failure;
-			qsmp_log_message(qsmp_messages_bind_fail);
+			qerr = server_start(kset, sources, lcnt, receive_callback);
 		}
 	}
-	else
-	{
-		qerr = qsmp_error_connection_failure;
-		qsmp_log_message(qsmp_messages_create_fail);
-	}
 
 	return qerr;
 }
@@ -20,6 +20,8 @@
 * \file qserver.h
 * \brief <b>QSMP Server functions</b> \n
 * Functions used to implement the server in the Quantum Secure Messaging Protocol (QSMP).
+* The receive callback of each function is passed the message as a binary array and length,
+* which is only valid for the duration of the callback; a message used after the callback returns must be copied.
 *
 * \author   John G. Underhill
 * \version  1.2a: 2022-05-01
@@ -40,21 +42,142 @@
 */
 #define QSMP_SERVER_PAUSE_INTERVAL 100
 
+#if defined(QSC_SYSTEM_OS_LINUX)
+/*!
+* \def QSMP_SERVER_REACTOR
+* \brief Enables the epoll event-loop server core.
+* Established sessions are switched to non-blocking mode and multiplexed over a fixed set of worker threads,
+* instead of each connection holding a dedicated receive thread.
+* Without the reactor, established sessions are also switched to non-blocking mode, and each is serviced by its own receive thread.
+*/
+#	define QSMP_SERVER_REACTOR
+#endif
+
+/*!
+* \def QSMP_SERVER_REACTOR_EVENTS
+* \brief The maximum number of socket events processed by a reactor worker per wait cycle
+*/
+#define QSMP_SERVER_REACTOR_EVENTS 64
+
+/*!
+* \def QSMP_SERVER_REACTOR_WORKERS_MAX
+* \brief The maximum number of reactor worker threads, by default one worker is started per processor core
+*/
+#define QSMP_SERVER_REACTOR_WORKERS_MAX 64
+
+/*!
+* \def QSMP_SERVER_HANDSHAKE_QUEUE_SIZE
+* \brief The maximum number of accepted connections waiting for a handshake worker, further connections are refused
+*/
+#define QSMP_SERVER_HANDSHAKE_QUEUE_SIZE 1024
+
+/*!
+* \def QSMP_SERVER_HANDSHAKE_WORKERS_MAX
+* \brief The maximum number of key exchange worker threads, by default one worker is started per processor core
+*/
+#define QSMP_SERVER_HANDSHAKE_WORKERS_MAX 64
+
+/*!
+* \def QSMP_SERVER_BROADCAST_SHARDS_MAX
+* \brief The maximum number of shards a broadcast is divided across, by default one shard is run per processor core
+*/
+#define QSMP_SERVER_BROADCAST_SHARDS_MAX 64
+
+/*!
+* \def QSMP_SERVER_BROADCAST_SHARD_MIN
+* \brief The minimum number of connection slots assigned to a broadcast shard, smaller tables use fewer threads
+*/
+#define QSMP_SERVER_BROADCAST_SHARD_MIN 64
+
+/*!
+* \def QSMP_SERVER_LISTENERS_MAX
+* \brief The maximum number of listening sockets opened by the sharded server
+*/
+#define QSMP_SERVER_LISTENERS_MAX 64
+
+/*!
+* \enum qsmp_broadcast_policies
+* \brief The action taken when a connection transmit queue can not hold a broadcast message
+*/
+QSMP_EXPORT_API typedef enum qsmp_broadcast_policies
+{
+	qsmp_broadcast_policy_drop = 0x00,				/*!< The message is not delivered to the slow connection */
+	qsmp_broadcast_policy_disconnect = 0x01,		/*!< The slow connection is shut down */
+} qsmp_broadcast_policies;
+
+/*!
+* \struct qsmp_broadcast_statistics
+* \brief The server broadcast counters
+*/
+QSMP_EXPORT_API typedef struct qsmp_broadcast_statistics
+{
+	uint64_t broadcasts;							/*!< The number of broadcast calls */
+	uint64_t delivered;								/*!< The number of messages accepted by connection transmit queues */
+	uint64_t dropped;								/*!< The number of messages not delivered to a connection */
+	uint64_t busy;									/*!< The number of messages skipped for a connection with a stream transfer in progress */
+	uint64_t disconnected;							/*!< The number of connections shut down by the disconnect policy */
+	uint64_t latency;								/*!< The fan-out latency of the last broadcast in microseconds */
+	uint64_t latencymax;							/*!< The largest fan-out latency in microseconds */
+	uint64_t latencytotal;							/*!< The sum of all fan-out latencies in microseconds */
+} qsmp_broadcast_statistics;
+
+/*!
+* \struct qsmp_handshake_statistics
+* \brief The server key exchange executor counters
+*/
+QSMP_EXPORT_API typedef struct qsmp_handshake_statistics
+{
+	uint64_t admitted;								/*!< The number of connections queued for a key exchange */
+	uint64_t completed;								/*!< The number of key exchanges that established a session */
+	uint64_t failed;								/*!< The number of key exchanges that failed */
+	uint64_t refused;								/*!< The number of connections refused because the queue was full */
+	uint64_t depth;									/*!< The number of connections waiting for a handshake worker */
+	uint64_t depthmax;								/*!< The largest number of connections waiting for a handshake worker */
+	uint64_t workers;								/*!< The number of handshake worker threads */
+} qsmp_handshake_statistics;
+
 /**
-* \brief Broadcast a message to all connected hosts
+* \brief Broadcast a message to all connected hosts.
+* The connection table is divided into shards that are encrypted and queued in parallel,
+* by shard worker threads that are started with the server; broadcasts are run one at a time.
+* Each message is added to the bounded connection transmit queue without blocking,
+* a connection whose queue is full is handled by the broadcast policy, and a connection sending a stream transfer is skipped.
 *
 * \param message: [const] The message to broadcast
 * \param msglen: The length of the message
 */
 QSMP_EXPORT_API void qsmp_server_broadcast(const uint8_t* message, size_t msglen);
 
+/**
+* \brief Set the action taken when a connection can not accept a broadcast message, the default is to drop the message
+*
+* \param policy: The broadcast policy
+*/
+QSMP_EXPORT_API void qsmp_server_broadcast_policy(qsmp_broadcast_policies policy);
+
+/**
+* \brief Copy the server broadcast counters
+*
+* \param stats: A pointer to the output statistics structure
+*/
+QSMP_EXPORT_API void qsmp_server_broadcast_statistics(qsmp_broadcast_statistics* stats);
+
+/**
+* \brief Copy the server key exchange executor counters, including the current handshake queue depth
+*
+* \param stats: A pointer to the output statistics structure
+*/
+QSMP_EXPORT_API void qsmp_server_handshake_statistics(qsmp_handshake_statistics* stats);
+
 /**
 * \brief Pause the server, suspending new joins
 */
 QSMP_EXPORT_API void qsmp_server_pause(void);
 
 /**
-* \brief Quit the server, closing all connections
+* \brief Quit the server, closing all connections.
+* The accept loops, key exchange workers and session threads are stopped and joined before the connections are released,
+* so the function must not be called from a server receive callback, or while a broadcast is in progress.
 */
 QSMP_EXPORT_API void qsmp_server_quit(void);
 
@@ -75,7 +198,7 @@ QSMP_EXPORT_API void qsmp_server_resume(void);
 QSMP_EXPORT_API qsmp_errors qsmp_server_start_ipv4(qsc_socket* source,
 	const qsmp_server_signature_key* kset,
 	void (*receive_callback)(qsmp_connection_state*, 
-		const char*, 
+		const uint8_t*, 
 		size_t));
 
 /**
@@ -90,7 +213,47 @@ QSMP_EXPORT_API qsmp_errors qsmp_server_start_ipv4(qsc_socket* source,
 QSMP_EXPORT_API qsmp_errors qsmp_server_start_ipv6(qsc_socket* source,
 	const qsmp_server_signature_key* kset,
 	void (*receive_callback)(qsmp_connection_state*, 
-		const char*, 
+		const uint8_t*, 
+		size_t));
+
+/**
+* \brief Start the IPv4 multi-threaded server with several listeners sharing the server port.
+* Each listener is bound with SO_REUSEPORT so the kernel spreads incoming connections between them,
+* and runs its own accept thread that takes connection slots from its own shard of the connection table.
+* If port sharing is not supported by the platform, a single listener is opened.
+*
+* \param sources: An array of listener server sockets, one for each listener
+* \param count: The number of listeners, a maximum of QSMP_SERVER_LISTENERS_MAX
+* \param kset: [const] A pointer to the QSMP private key
+* \param receive_callback: A pointer to the receive callback function, used to process client data streams
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_server_start_sharded_ipv4(qsc_socket* sources,
+	size_t count,
+	const qsmp_server_signature_key* kset,
+	void (*receive_callback)(qsmp_connection_state*, 
+		const uint8_t*, 
+		size_t));
+
+/**
+* \brief Start the IPv6 multi-threaded server with several listeners sharing the server port.
+* Each listener is bound with SO_REUSEPORT so the kernel spreads incoming connections between them,
+* and runs its own accept thread that takes connection slots from its own shard of the connection table.
+* If port sharing is not supported by the platform, a single listener is opened.
+*
+* \param sources: An array of listener server sockets, one for each listener
+* \param count: The number of listeners, a maximum of QSMP_SERVER_LISTENERS_MAX
+* \param kset: [const] A pointer to the QSMP private key
+* \param receive_callback: A pointer to the receive callback function, used to process client data streams
+*
+* \return: Returns the function error state
+*/
+QSMP_EXPORT_API qsmp_errors qsmp_server_start_sharded_ipv6(qsc_socket* sources,
+	size_t count,
+	const qsmp_server_signature_key* kset,
+	void (*receive_callback)(qsmp_connection_state*, 
+		const uint8_t*, 
 		size_t));
 
 #endif
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "selftest.h"
+#include "bufferpool.h"
+#include "connections.h"
+#include "datagram.h"
+#include "kex.h"
+#include "timerwheel.h"
+
+bool qsmp_selftest_run(void)
+{
+	bool res;
+
+	res = true;
+
+	if (qsmp_bufferpool_self_test() == false)
+	{
+		res = false;
+	}
+	else if (qsmp_connections_self_test() == false)
+	{
+		res = false;
+	}
+	else if (qsmp_timerwheel_self_test() == false)
+	{
+		res = false;
+	}
+	else if (qsmp_datagram_self_test() == false)
+	{
+		res = false;
+	}
+	else if (qsmp_kex_test() == false)
+	{
+		res = false;
+	}
+	else if (qsmp_kex_resume_test() == false)
+	{
+		res = false;
+	}
+	else if (qsmp_kex_fastopen_test() == false)
+	{
+		res = false;
+	}
+
+	return res;
+}
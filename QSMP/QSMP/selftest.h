@@ -0,0 +1,39 @@
+/* 2023 Quantum Secure Cryptographic Solutions QSCS Corp. (QSCS.ca)
+* All Rights Reserved.
+*
+* NOTICE:  All information contained herein is, and remains
+* the property of the QSCS Corporation.
+* The intellectual and technical concepts contained
+* herein are proprietary to the QSCS Corporation
+* and its suppliers and may be covered by U.S. and Foreign Patents,
+* patents in process, and are protected by trade secret or copyright law.
+* Dissemination of this information or reproduction of this material
+* is strictly forbidden unless prior written permission is obtained
+* from the QSCS Corporation.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+/**
+* \file selftest.h
+* \brief The QSMP library self-tests.
+* Runs the internal tests of the buffer pool, connection table, timer wheel,
+* datagram channel and key exchange.
+*/
+
+#ifndef QSMP_SELFTEST_H
+#define QSMP_SELFTEST_H
+
+#include "common.h"
+
+/**
+* \brief Runs the library self tests.
+* Each test cleans up its own state, and the run stops at the first failure.
+*
+* \return Returns true if all tests pass successfully
+*/
+QSMP_EXPORT_API bool qsmp_selftest_run(void);
+
+#endif
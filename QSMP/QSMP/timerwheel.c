@@ -0,0 +1,355 @@
+#include "timerwheel.h"
+#include "../../QSC/QSC/async.h"
+#include "../../QSC/QSC/memutils.h"
+#include "../../QSC/QSC/timerex.h"
+
+#define TIMERWHEEL_SLOT_MASK (QSMP_TIMERWHEEL_SLOTS - 1)
+#define TIMERWHEEL_RANGE (1ULL << (QSMP_TIMERWHEEL_SLOT_BITS * QSMP_TIMERWHEEL_LEVELS))
+
+typedef struct qsmp_timerwheel_state
+{
+	qsmp_timer* slots[QSMP_TIMERWHEEL_LEVELS * QSMP_TIMERWHEEL_SLOTS];
+	qsmp_timer* running;
+	qsc_mutex lock;
+	qsc_thread thread;
+	uint64_t tick;
+	size_t users;
+	volatile bool run;
+	bool threaded;
+} qsmp_timerwheel_state;
+
+static qsmp_timerwheel_state m_timer_wheel;
+
+static uint64_t timerwheel_ticks(uint32_t msec)
+{
+	uint64_t ticks;
+
+	ticks = ((uint64_t)msec + (QSMP_TIMERWHEEL_RESOLUTION - 1)) / QSMP_TIMERWHEEL_RESOLUTION;
+
+	return (ticks != 0) ? ticks : 1;
+}
+
+static void timerwheel_link(qsmp_timer* timer)
+{
+	uint64_t delta;
+	uint64_t expiry;
+	size_t lvl;
+
+	/* a timer beyond the range of the wheel is parked in the top level, and placed again when it is cascaded */
+	delta = timer->expiry - m_timer_wheel.tick;
+	expiry = (delta < TIMERWHEEL_RANGE) ? timer->expiry : m_timer_wheel.tick + (TIMERWHEEL_RANGE - 1);
+	delta = expiry - m_timer_wheel.tick;
+	lvl = 0;
+
+	/* the level is the first whose span holds the delay, the slot is indexed by the expiry bits of that level */
+	while (lvl < QSMP_TIMERWHEEL_LEVELS - 1 && delta >= (1ULL << (QSMP_TIMERWHEEL_SLOT_BITS * (lvl + 1))))
+	{
+		++lvl;
+	}
+
+	timer->slot = (uint32_t)((lvl * QSMP_TIMERWHEEL_SLOTS) + ((expiry >> (QSMP_TIMERWHEEL_SLOT_BITS * lvl)) & TIMERWHEEL_SLOT_MASK));
+	timer->prev = NULL;
+	timer->next = m_timer_wheel.slots[timer->slot];
+
+	if (timer->next != NULL)
+	{
+		timer->next->prev = timer;
+	}
+
+	m_timer_wheel.slots[timer->slot] = timer;
+	timer->pending = true;
+}
+
+static void timerwheel_unlink(qsmp_timer* timer)
+{
+	if (timer->prev != NULL)
+	{
+		timer->prev->next = timer->next;
+	}
+	else
+	{
+		m_timer_wheel.slots[timer->slot] = timer->next;
+	}
+
+	if (timer->next != NULL)
+	{
+		timer->next->prev = timer->prev;
+	}
+
+	timer->next = NULL;
+	timer->prev = NULL;
+	timer->pending = false;
+}
+
+static void timerwheel_cascade(size_t level)
+{
+	qsmp_timer* timer;
+	size_t idx;
+
+	idx = (level * QSMP_TIMERWHEEL_SLOTS) + ((m_timer_wheel.tick >> (QSMP_TIMERWHEEL_SLOT_BITS * level)) & TIMERWHEEL_SLOT_MASK);
+
+	/* the timers of an upper level slot are moved down to the level that now holds their delay */
+	while (m_timer_wheel.slots[idx] != NULL)
+	{
+		timer = m_timer_wheel.slots[idx];
+		timerwheel_unlink(timer);
+		timerwheel_link(timer);
+	}
+}
+
+static void timerwheel_expire()
+{
+	qsmp_timer* timer;
+	uint32_t ival;
+	size_t idx;
+
+	idx = (size_t)(m_timer_wheel.tick & TIMERWHEEL_SLOT_MASK);
+
+	/* callbacks run without the lock held, and can schedule or cancel any other timer */
+	while (m_timer_wheel.slots[idx] != NULL)
+	{
+		timer = m_timer_wheel.slots[idx];
+		timerwheel_unlink(timer);
+		m_timer_wheel.running = timer;
+		qsc_async_mutex_unlock(m_timer_wheel.lock);
+
+		ival = timer->callback(timer->state);
+
+		qsc_async_mutex_lock(m_timer_wheel.lock);
+		m_timer_wheel.running = NULL;
+
+		/* a periodic timer is scheduled again, unless it was already rescheduled by the callback */
+		if (ival != 0 && timer->pending == false)
+		{
+			timer->expiry = m_timer_wheel.tick + timerwheel_ticks(ival);
+			timerwheel_link(timer);
+		}
+	}
+}
+
+static void timerwheel_thread(void* state)
+{
+	(void)state;
+
+	uint64_t done;
+	uint64_t elapsed;
+	uint64_t start;
+
+	done = 0;
+	start = qsc_timerex_stopwatch_microseconds();
+
+	while (m_timer_wheel.run == true)
+	{
+		qsc_async_thread_sleep(QSMP_TIMERWHEEL_RESOLUTION);
+
+		/* the wheel follows the monotonic clock, so a late wake-up runs the missed ticks */
+		elapsed = (qsc_timerex_stopwatch_microseconds() - start) / (QSMP_TIMERWHEEL_RESOLUTION * 1000ULL);
+
+		if (elapsed > done && m_timer_wheel.run == true)
+		{
+			qsmp_timerwheel_advance(elapsed - done);
+			done = elapsed;
+		}
+	}
+}
+
+void qsmp_timerwheel_advance(uint64_t ticks)
+{
+	if (m_timer_wheel.lock != NULL)
+	{
+		qsc_async_mutex_lock(m_timer_wheel.lock);
+
+		for (uint64_t i = 0; i < ticks; ++i)
+		{
+			m_timer_wheel.tick += 1;
+
+			/* when a level completes a rotation, the next slot of the level above is cascaded */
+			for (size_t j = 1; j < QSMP_TIMERWHEEL_LEVELS; ++j)
+			{
+				if ((m_timer_wheel.tick & ((1ULL << (QSMP_TIMERWHEEL_SLOT_BITS * j)) - 1)) != 0)
+				{
+					break;
+				}
+
+				timerwheel_cascade(j);
+			}
+
+			timerwheel_expire();
+		}
+
+		qsc_async_mutex_unlock(m_timer_wheel.lock);
+	}
+}
+
+void qsmp_timerwheel_cancel(qsmp_timer* timer)
+{
+	assert(timer != NULL);
+
+	if (timer != NULL && m_timer_wheel.lock != NULL)
+	{
+		qsc_async_mutex_lock(m_timer_wheel.lock);
+
+		/* wait for a running callback to return before the timer can be released */
+		while (m_timer_wheel.running == timer)
+		{
+			qsc_async_mutex_unlock(m_timer_wheel.lock);
+			qsc_async_thread_sleep(1);
+			qsc_async_mutex_lock(m_timer_wheel.lock);
+		}
+
+		if (timer->pending == true)
+		{
+			timerwheel_unlink(timer);
+		}
+
+		qsc_async_mutex_unlock(m_timer_wheel.lock);
+	}
+}
+
+bool qsmp_timerwheel_schedule(qsmp_timer* timer, uint32_t msec, uint32_t (*callback)(void*), void* state)
+{
+	assert(timer != NULL);
+	assert(callback != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (timer != NULL && callback != NULL && m_timer_wheel.lock != NULL)
+	{
+		qsc_async_mutex_lock(m_timer_wheel.lock);
+
+		if (timer->pending == true)
+		{
+			timerwheel_unlink(timer);
+		}
+
+		timer->callback = callback;
+		timer->state = state;
+		timer->expiry = m_timer_wheel.tick + timerwheel_ticks(msec);
+		timerwheel_link(timer);
+		qsc_async_mutex_unlock(m_timer_wheel.lock);
+		res = true;
+	}
+
+	return res;
+}
+
+bool qsmp_timerwheel_start(bool threaded)
+{
+	qsc_mutex mtx;
+	bool res;
+
+	res = true;
+	mtx = qsc_async_mutex_lock_ex();
+
+	if (m_timer_wheel.users == 0)
+	{
+		qsc_memutils_clear(&m_timer_wheel, sizeof(qsmp_timerwheel_state));
+		m_timer_wheel.lock = qsc_async_mutex_create();
+		res = (m_timer_wheel.lock != NULL);
+
+		if (res == true && threaded == true)
+		{
+			m_timer_wheel.run = true;
+			m_timer_wheel.threaded = true;
+			m_timer_wheel.thread = qsc_async_thread_create(&timerwheel_thread, NULL);
+		}
+	}
+
+	if (res == true)
+	{
+		m_timer_wheel.users += 1;
+	}
+
+	qsc_async_mutex_unlock_ex(mtx);
+
+	return res;
+}
+
+void qsmp_timerwheel_stop()
+{
+	qsc_mutex mtx;
+
+	mtx = qsc_async_mutex_lock_ex();
+
+	if (m_timer_wheel.users != 0)
+	{
+		m_timer_wheel.users -= 1;
+
+		if (m_timer_wheel.users == 0)
+		{
+			if (m_timer_wheel.threaded == true)
+			{
+				m_timer_wheel.run = false;
+				qsc_async_thread_wait(m_timer_wheel.thread);
+				m_timer_wheel.threaded = false;
+			}
+
+			/* the timers still pending are released */
+			qsc_async_mutex_lock(m_timer_wheel.lock);
+
+			for (size_t i = 0; i < QSMP_TIMERWHEEL_LEVELS * QSMP_TIMERWHEEL_SLOTS; ++i)
+			{
+				while (m_timer_wheel.slots[i] != NULL)
+				{
+					timerwheel_unlink(m_timer_wheel.slots[i]);
+				}
+			}
+
+			qsc_async_mutex_unlock(m_timer_wheel.lock);
+			qsc_async_mutex_destroy(m_timer_wheel.lock);
+			m_timer_wheel.lock = NULL;
+		}
+	}
+
+	qsc_async_mutex_unlock_ex(mtx);
+}
+
+static uint32_t timerwheel_test_once(void* state)
+{
+	/* record the tick the timer expired on */
+	*(uint64_t*)state = m_timer_wheel.tick;
+
+	return 0;
+}
+
+static uint32_t timerwheel_test_periodic(void* state)
+{
+	*(uint64_t*)state += 1;
+
+	return 5 * QSMP_TIMERWHEEL_RESOLUTION;
+}
+
+bool qsmp_timerwheel_self_test()
+{
+	qsmp_timer tmrs[5] = { 0 };
+	uint64_t exps[5] = { 0 };
+	bool res;
+
+	res = false;
+
+	if (qsmp_timerwheel_start(false) == true)
+	{
+		/* one tick, a level one delay, a level two delay, a periodic timer, and a cancelled timer */
+		qsmp_timerwheel_schedule(&tmrs[0], QSMP_TIMERWHEEL_RESOLUTION, &timerwheel_test_once, &exps[0]);
+		qsmp_timerwheel_schedule(&tmrs[1], 100 * QSMP_TIMERWHEEL_RESOLUTION, &timerwheel_test_once, &exps[1]);
+		qsmp_timerwheel_schedule(&tmrs[2], 10000 * QSMP_TIMERWHEEL_RESOLUTION, &timerwheel_test_once, &exps[2]);
+		qsmp_timerwheel_schedule(&tmrs[3], 5 * QSMP_TIMERWHEEL_RESOLUTION, &timerwheel_test_periodic, &exps[3]);
+		qsmp_timerwheel_schedule(&tmrs[4], 50 * QSMP_TIMERWHEEL_RESOLUTION, &timerwheel_test_once, &exps[4]);
+
+		qsmp_timerwheel_advance(10);
+		qsmp_timerwheel_cancel(&tmrs[4]);
+		qsmp_timerwheel_advance(9990);
+
+		/* each timer fires on its expiry tick, the periodic timer fires every five ticks until cancelled */
+		res = (exps[0] == 1 && exps[1] == 100 && exps[2] == 10000 && exps[3] == 2000 && exps[4] == 0 &&
+			tmrs[0].pending == false && tmrs[3].pending == true);
+
+		qsmp_timerwheel_cancel(&tmrs[3]);
+		res = (res == true && tmrs[3].pending == false);
+		qsmp_timerwheel_stop();
+	}
+
+	return res;
+}
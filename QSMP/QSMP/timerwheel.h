@@ -0,0 +1,123 @@
+/* 2023 Quantum Secure Cryptographic Solutions QSCS Corp. (QSCS.ca)
+* All Rights Reserved.
+*
+* NOTICE:  All information contained herein is, and remains
+* the property of the QSCS Corporation.
+* The intellectual and technical concepts contained
+* herein are proprietary to the QSCS Corporation
+* and its suppliers and may be covered by U.S. and Foreign Patents,
+* patents in process, and are protected by trade secret or copyright law.
+* Dissemination of this information or reproduction of this material
+* is strictly forbidden unless prior written permission is obtained
+* from the QSCS Corporation.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+/**
+* \file timerwheel.h
+* \brief The session timer service.
+* A hierarchical timer wheel driven by a single thread, that runs the keep alive,
+* session expiry and key ratchet schedules of every connection.
+* Timers are embedded in the structure they serve, and are scheduled and cancelled in constant time.
+* \note These are internal non-exportable functions.
+*/
+
+#ifndef QSMP_TIMERWHEEL_H
+#define QSMP_TIMERWHEEL_H
+
+#include "common.h"
+
+/*!
+* \def QSMP_TIMERWHEEL_RESOLUTION
+* \brief The duration of one timer wheel tick in milliseconds
+*/
+#define QSMP_TIMERWHEEL_RESOLUTION 100
+
+/*!
+* \def QSMP_TIMERWHEEL_LEVELS
+* \brief The number of timer wheel levels, each level counts one rotation of the level below it
+*/
+#define QSMP_TIMERWHEEL_LEVELS 4
+
+/*!
+* \def QSMP_TIMERWHEEL_SLOT_BITS
+* \brief The number of index bits for each timer wheel level
+*/
+#define QSMP_TIMERWHEEL_SLOT_BITS 6
+
+/*!
+* \def QSMP_TIMERWHEEL_SLOTS
+* \brief The number of slots in each timer wheel level
+*/
+#define QSMP_TIMERWHEEL_SLOTS (1ULL << QSMP_TIMERWHEEL_SLOT_BITS)
+
+/*!
+* \struct qsmp_timer
+* \brief A timer wheel entry.
+* The callback returns the interval in milliseconds before it is run again, or zero to stop the timer
+*/
+typedef struct qsmp_timer
+{
+	struct qsmp_timer* next;						/*!< The next timer in the slot */
+	struct qsmp_timer* prev;						/*!< The previous timer in the slot */
+	uint32_t (*callback)(void*);					/*!< The timer callback function */
+	void* state;									/*!< The state passed to the callback */
+	uint64_t expiry;								/*!< The tick the timer expires on */
+	uint32_t slot;									/*!< The wheel slot index the timer is linked into */
+	bool pending;									/*!< The timer is scheduled */
+} qsmp_timer;
+
+/**
+* \brief Cancel a timer.
+* If the callback is running on the timer thread, the function waits for it to return.
+* Must not be called for a timer from inside its own callback, the callback returns zero instead.
+*
+* \param timer: A pointer to the timer
+*/
+void qsmp_timerwheel_cancel(qsmp_timer* timer);
+
+/**
+* \brief Advance the timer wheel by a number of ticks, running the callbacks of every expired timer.
+* This is called by the timer thread, and is exposed for testing with a stopped wheel.
+*
+* \param ticks: The number of ticks to advance
+*/
+void qsmp_timerwheel_advance(uint64_t ticks);
+
+/**
+* \brief Schedule a timer, a pending timer is moved to the new expiry
+*
+* \param timer: A pointer to the timer
+* \param msec: The delay in milliseconds, rounded up to the timer resolution
+* \param callback: The callback function, returns the next interval or zero
+* \param state: The state passed to the callback
+*
+* \return: Returns true if the timer was scheduled
+*/
+bool qsmp_timerwheel_schedule(qsmp_timer* timer, uint32_t msec, uint32_t (*callback)(void*), void* state);
+
+/**
+* \brief Start the timer service, the service is shared and counts each start
+*
+* \param threaded: Run the timer thread, false initializes the wheel for testing with qsmp_timerwheel_advance
+*
+* \return: Returns true if the service is running
+*/
+bool qsmp_timerwheel_start(bool threaded);
+
+/**
+* \brief Release a start of the timer service, the last release stops the thread and cancels all pending timers
+*/
+void qsmp_timerwheel_stop(void);
+
+/**
+* \brief Run the timer wheel self-test
+*
+* \return: Returns true if the test succeeded
+*/
+bool qsmp_timerwheel_self_test(void);
+
+#endif